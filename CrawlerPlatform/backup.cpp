@@ -0,0 +1,390 @@
+#include "backup.h"
+#include "databasemanager.h"
+#include "metrics.h"
+#include <QDir>
+#include <QFile>
+#include <QFileInfo>
+#include <QDateTime>
+#include <QElapsedTimer>
+#include <QSqlQuery>
+#include <QSqlError>
+#include <QDebug>
+#include <atomic>
+
+#ifdef CRAWLER_HAVE_SQLITE_API
+#include <sqlite3.h>
+#endif
+
+// 自适应步长的上限（页）
+static const int kMaxPagesPerStep = 4096;
+static const QString kBackupPrefix = "backup_";
+
+// 备份指标（首次使用时注册）
+struct BackupMetrics {
+    MetricCounter* runs;
+    MetricCounter* failures;
+    MetricCounter* bytes;
+    MetricCounter* restarts;
+    MetricGauge* lastSuccess;
+    MetricHistogram* stepDuration;
+    MetricHistogram* runDuration;
+
+    static const BackupMetrics& get()
+    {
+        static const BackupMetrics metrics = []() {
+            MetricsRegistry& registry = MetricsRegistry::instance();
+            BackupMetrics m;
+            m.runs = registry.counter("crawler_backup_runs_total", "在线备份次数");
+            m.failures = registry.counter("crawler_backup_failures_total", "失败或中止的在线备份次数");
+            m.bytes = registry.counter("crawler_backup_bytes_total", "在线备份写出的字节数");
+            m.restarts = registry.counter("crawler_backup_restarts_total", "源库被修改导致备份从头开始的次数");
+            m.lastSuccess = registry.gauge("crawler_backup_last_success_timestamp_seconds", "最近一次成功备份的时间");
+            m.stepDuration = registry.histogram("crawler_backup_step_duration_seconds", "单步复制持有源库读锁的时间");
+            m.runDuration = registry.histogram("crawler_backup_duration_seconds", "单次备份（全部文件）耗时");
+            return m;
+        }();
+        return metrics;
+    }
+};
+
+BackupWorker::BackupWorker(const QString& directory, int intervalSecs, int keep, QObject *parent)
+    : QThread(parent)
+    , m_directory(directory)
+    , m_intervalSecs(qMax(0, intervalSecs))
+    , m_keep(qMax(1, keep))
+{
+    setObjectName("BackupWorker");
+}
+
+BackupWorker::~BackupWorker()
+{
+    stopWorker();
+}
+
+void BackupWorker::startWorker()
+{
+    if (m_isRunning) return;
+    m_isRunning = true;
+    start(QThread::LowestPriority);
+}
+
+void BackupWorker::stopWorker()
+{
+    if (!m_isRunning) return;
+    m_isRunning = false;
+    {
+        QMutexLocker locker(&m_wakeMutex);
+        m_wakeCondition.wakeAll();
+    }
+    wait();
+}
+
+void BackupWorker::triggerNow()
+{
+    QMutexLocker locker(&m_wakeMutex);
+    m_triggered = true;
+    m_wakeCondition.wakeAll();
+}
+
+void BackupWorker::run()
+{
+    while (m_isRunning) {
+        {
+            QMutexLocker locker(&m_wakeMutex);
+            if (m_isRunning && !m_triggered) {
+                if (m_intervalSecs > 0) {
+                    m_wakeCondition.wait(&m_wakeMutex, static_cast<unsigned long>(m_intervalSecs) * 1000);
+                } else {
+                    m_wakeCondition.wait(&m_wakeMutex);
+                }
+            }
+            m_triggered = false;
+        }
+        if (!m_isRunning) break;
+
+        const BackupResult result = backupDatabases(m_directory, BackupOptions(), [this]() {
+            return m_isRunning.load();
+        });
+        if (result.ok) {
+            qInfo() << "数据库已备份：" << result.path << "文件" << result.files << "个，"
+                    << result.bytes / 1024 << "KB，单步最长" << result.maxStepUs << "us";
+            prune();
+        } else {
+            qWarning() << "数据库备份失败：" << result.error;
+        }
+        emit backupFinished(result.ok, result.path, result.error);
+    }
+}
+
+// 只保留最近 m_keep 份备份（目录名含时间，按名称排序即按时间排序）
+void BackupWorker::prune()
+{
+    QDir root(m_directory);
+    const QStringList backups = root.entryList({kBackupPrefix + "*"}, QDir::Dirs | QDir::NoDotAndDotDot, QDir::Name);
+    for (int i = 0; i + m_keep < backups.size(); i++) {
+        if (QDir(root.filePath(backups.at(i))).removeRecursively()) {
+            qInfo() << "删除过期备份：" << backups.at(i);
+        }
+    }
+}
+
+QString BackupWorker::latestBackup(const QString& directory)
+{
+    QDir root(directory);
+    const QStringList backups = root.entryList({kBackupPrefix + "*"}, QDir::Dirs | QDir::NoDotAndDotDot,
+                                               QDir::Name | QDir::Reversed);
+    return backups.isEmpty() ? QString() : root.filePath(backups.first());
+}
+
+BackupResult BackupWorker::backupDatabases(const QString& directory, const BackupOptions& options,
+                                           const std::function<bool()>& keepGoing)
+{
+    MetricTimer runTimer(BackupMetrics::get().runDuration);
+    BackupMetrics::get().runs->inc();
+
+    BackupResult total;
+    const QString name = kBackupPrefix + QDateTime::currentDateTime().toString("yyyyMMdd_HHmmss");
+    QDir target(QDir(directory).filePath(name));
+    if (target.exists() || !QDir().mkpath(target.path())) {
+        total.error = QString("无法创建备份目录：%1").arg(target.path());
+        BackupMetrics::get().failures->inc();
+        return total;
+    }
+    total.path = target.path();
+
+    QStringList sources = {DatabaseManager::databasePath()};
+    if (DatabaseManager::dataShardCount() > 1) {
+        for (int i = 0; i < DatabaseManager::dataShardCount(); i++) {
+            sources.append(DatabaseManager::dataShardPath(i));
+        }
+    }
+
+    for (const QString& source : std::as_const(sources)) {
+        const BackupResult file = backupFile(source, target.filePath(QFileInfo(source).fileName()), options, keepGoing);
+        total.pages += file.pages;
+        total.bytes += file.bytes;
+        total.steps += file.steps;
+        total.restarts += file.restarts;
+        total.maxStepUs = qMax(total.maxStepUs, file.maxStepUs);
+        if (!file.ok) {
+            total.error = QString("%1：%2").arg(QFileInfo(source).fileName(), file.error);
+            target.removeRecursively();
+            BackupMetrics::get().failures->inc();
+            return total;
+        }
+        total.files++;
+    }
+
+    total.ok = true;
+    BackupMetrics::get().bytes->inc(static_cast<quint64>(total.bytes));
+    BackupMetrics::get().lastSuccess->set(QDateTime::currentSecsSinceEpoch());
+    return total;
+}
+
+#ifdef CRAWLER_HAVE_SQLITE_API
+
+static QString sqliteError(sqlite3* db)
+{
+    return db ? QString::fromUtf8(sqlite3_errmsg(db)) : QString("内存不足");
+}
+
+static bool isWalMode(sqlite3* db)
+{
+    sqlite3_stmt* stmt = nullptr;
+    bool wal = false;
+    if (sqlite3_prepare_v2(db, "PRAGMA journal_mode", -1, &stmt, nullptr) == SQLITE_OK
+        && sqlite3_step(stmt) == SQLITE_ROW) {
+        wal = qstricmp(reinterpret_cast<const char*>(sqlite3_column_text(stmt, 0)), "wal") == 0;
+    }
+    sqlite3_finalize(stmt);
+    return wal;
+}
+
+// sqlite3_backup_step 分步复制：每步结束即释放源库读锁，步间停顿让写入线程提交
+// 步长按实测复制速率调整，使单步耗时保持在预算以内
+static BackupResult copyDatabase(const QString& source, const QString& destination, const BackupOptions& options,
+                                 const std::function<bool()>& keepGoing)
+{
+    BackupResult result;
+    sqlite3* src = nullptr;
+    sqlite3* dst = nullptr;
+    if (sqlite3_open_v2(source.toUtf8().constData(), &src, SQLITE_OPEN_READONLY, nullptr) != SQLITE_OK) {
+        result.error = QString("打开源库失败：%1").arg(sqliteError(src));
+        sqlite3_close(src);
+        return result;
+    }
+    if (sqlite3_open_v2(destination.toUtf8().constData(), &dst, SQLITE_OPEN_READWRITE | SQLITE_OPEN_CREATE,
+                        nullptr) != SQLITE_OK) {
+        result.error = QString("创建备份文件失败：%1").arg(sqliteError(dst));
+        sqlite3_close(dst);
+        sqlite3_close(src);
+        return result;
+    }
+    // 目标是临时文件，失败即删除：不写回滚日志也不同步落盘，最后一步提交时不会因 fsync 延长源库的持锁时间
+    sqlite3_exec(dst, "PRAGMA journal_mode = OFF; PRAGMA synchronous = OFF", nullptr, nullptr, nullptr);
+    sqlite3_backup* backup = sqlite3_backup_init(dst, "main", src, "main");
+    if (!backup) {
+        result.error = QString("初始化备份失败：%1").arg(sqliteError(dst));
+        sqlite3_close(dst);
+        sqlite3_close(src);
+        return result;
+    }
+
+    const bool wal = isWalMode(src);
+    const qint64 budgetUs = qMax(1, options.stepBudgetMs) * 1000LL;
+    int pages = qBound(1, options.pagesPerStep, kMaxPagesPerStep);
+    int lastRemaining = -1;
+    int rc = SQLITE_OK;
+    QElapsedTimer stepTimer;
+    while (true) {
+        if (keepGoing && !keepGoing()) {
+            result.error = "已中止";
+            break;
+        }
+        const bool finalPass = wal && result.restarts > options.maxRestarts;
+        stepTimer.start();
+        rc = sqlite3_backup_step(backup, finalPass ? -1 : pages);
+        const qint64 stepUs = stepTimer.nsecsElapsed() / 1000;
+        BackupMetrics::get().stepDuration->record(static_cast<quint64>(stepUs));
+        result.steps++;
+        if (!finalPass) {
+            result.maxStepUs = qMax(result.maxStepUs, stepUs);
+        }
+        if (rc == SQLITE_DONE) {
+            break;
+        }
+        if (rc == SQLITE_OK) {
+            const int remaining = sqlite3_backup_remaining(backup);
+            if (lastRemaining >= 0 && remaining > lastRemaining) {
+                result.restarts++;
+                BackupMetrics::get().restarts->inc();
+                if (!wal && result.restarts > options.maxRestarts) {
+                    result.error = "源库写入过于频繁，分步备份反复重启（开启 WAL 模式后可一次复制完）";
+                    break;
+                }
+            }
+            lastRemaining = remaining;
+            // 按本步的复制速率估算预算内能复制的页数（留两成余量），每次最多放大一倍
+            const qint64 fitting = pages * budgetUs * 8 / (qMax<qint64>(1, stepUs) * 10);
+            pages = static_cast<int>(qBound<qint64>(1, fitting, qMin(pages * 2, kMaxPagesPerStep)));
+        } else if (rc != SQLITE_BUSY && rc != SQLITE_LOCKED) {
+            result.error = QString("复制失败：%1").arg(sqliteError(dst));
+            break;
+        }
+        QThread::msleep(static_cast<unsigned long>(qMax(0, options.pauseMs)));
+    }
+
+    result.pages = sqlite3_backup_pagecount(backup);
+    sqlite3_backup_finish(backup);
+    result.ok = rc == SQLITE_DONE && result.error.isEmpty();
+    sqlite3_close(dst);
+    sqlite3_close(src);
+    return result;
+}
+
+#else
+
+// 未链接 SQLite 库时用 VACUUM INTO 生成备份：一个读事务内整体复制
+// WAL 模式下不阻塞写入；回滚日志模式下复制期间写入线程的提交需等待
+static BackupResult copyDatabase(const QString& source, const QString& destination, const BackupOptions& options,
+                                 const std::function<bool()>& keepGoing)
+{
+    Q_UNUSED(options);
+    BackupResult result;
+    if (keepGoing && !keepGoing()) {
+        result.error = "已中止";
+        return result;
+    }
+
+    static std::atomic<int> s_connectionSeq{0};
+    const QString connectionName = QString("backup_%1").arg(s_connectionSeq.fetch_add(1));
+    {
+        QSqlDatabase db = QSqlDatabase::addDatabase("QSQLITE", connectionName);
+        db.setDatabaseName(source);
+        if (!db.open()) {
+            result.error = QString("打开源库失败：%1").arg(db.lastError().text());
+        } else {
+            QSqlQuery query(db);
+            if (query.exec("PRAGMA page_count") && query.next()) {
+                result.pages = query.value(0).toLongLong();
+            }
+            QElapsedTimer timer;
+            timer.start();
+            query.prepare("VACUUM INTO :path");
+            query.bindValue(":path", destination);
+            if (query.exec()) {
+                result.ok = true;
+            } else {
+                result.error = QString("复制失败：%1").arg(query.lastError().text());
+            }
+            result.steps = 1;
+            result.maxStepUs = timer.nsecsElapsed() / 1000;
+            BackupMetrics::get().stepDuration->record(static_cast<quint64>(result.maxStepUs));
+            db.close();
+        }
+    }
+    QSqlDatabase::removeDatabase(connectionName);
+    return result;
+}
+
+#endif
+
+BackupResult BackupWorker::backupFile(const QString& source, const QString& destination,
+                                      const BackupOptions& options, const std::function<bool()>& keepGoing)
+{
+    if (!QFileInfo::exists(source)) {
+        BackupResult result;
+        result.error = QString("源库不存在：%1").arg(source);
+        return result;
+    }
+
+    // 先写临时文件，完成后改名，目标路径上不会出现半截的备份
+    const QString temporary = destination + ".tmp";
+    QFile::remove(temporary);
+    BackupResult result = copyDatabase(source, temporary, options, keepGoing);
+    result.path = destination;
+    if (result.ok) {
+        QFile::remove(destination);
+        if (!QFile::rename(temporary, destination)) {
+            result.ok = false;
+            result.error = QString("无法写入备份文件：%1").arg(destination);
+        }
+    }
+    if (!result.ok) {
+        QFile::remove(temporary);
+        return result;
+    }
+    result.files = 1;
+    result.bytes = QFileInfo(destination).size();
+    return result;
+}
+
+QSqlDatabase BackupWorker::openSnapshot(const QString& path)
+{
+    const QString connectionName = QString("snapshot_%1_%2")
+                                       .arg(qHash(QFileInfo(path).absoluteFilePath()))
+                                       .arg(reinterpret_cast<quintptr>(QThread::currentThreadId()));
+    if (QSqlDatabase::contains(connectionName)) {
+        QSqlDatabase db = QSqlDatabase::database(connectionName, false);
+        if (db.isOpen() || db.open()) {
+            return db;
+        }
+        return QSqlDatabase();
+    }
+
+    if (!QFileInfo::exists(path)) {
+        qWarning() << "快照不存在：" << path;
+        return QSqlDatabase();
+    }
+    QSqlDatabase db = QSqlDatabase::addDatabase("QSQLITE", connectionName);
+    db.setDatabaseName(path);
+    db.setConnectOptions("QSQLITE_OPEN_READONLY");
+    if (!db.open()) {
+        qWarning() << "打开快照失败：" << path << db.lastError().text();
+        return QSqlDatabase();
+    }
+    // 分析查询多为大范围扫描，放宽缓存
+    QSqlQuery query(db);
+    query.exec("PRAGMA cache_size = -65536");
+    return db;
+}
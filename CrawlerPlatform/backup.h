@@ -0,0 +1,84 @@
+#ifndef BACKUP_H
+#define BACKUP_H
+
+#include <QThread>
+#include <QMutex>
+#include <QWaitCondition>
+#include <QSqlDatabase>
+#include <atomic>
+#include <functional>
+
+// 在线备份参数
+struct BackupOptions {
+    int pagesPerStep = 64;     // 初始每步复制的页数，按单步耗时自适应调整
+    int stepBudgetMs = 4;      // 单步持有源库读锁的时间上限
+    int pauseMs = 20;          // 步间停顿，让写入线程拿到锁
+    int maxRestarts = 8;       // 源库被其他连接修改会使备份从头开始，超过次数后见 backupFile 的说明
+};
+
+struct BackupResult {
+    bool ok = false;
+    QString path;              // 备份目录（backupDatabases）或目标文件（backupFile）
+    int files = 0;
+    qint64 pages = 0;
+    qint64 bytes = 0;
+    int steps = 0;
+    int restarts = 0;
+    qint64 maxStepUs = 0;      // 单步最长耗时，即写入线程可能被阻塞的最长时间
+    QString error;
+};
+
+// 数据库在线备份（低优先级线程）
+// 主库与全部数据分片逐个用 SQLite 在线备份接口分步复制，每步只短暂持有读锁，爬虫线程无需停止；
+// 备份先写临时文件，完成后改名，目录中保留最近 keep 份。快照即一份备份，可只读打开供分析查询使用
+class BackupWorker : public QThread
+{
+    Q_OBJECT
+
+public:
+    // intervalSecs 为 0 时只在 triggerNow 时备份
+    BackupWorker(const QString& directory, int intervalSecs, int keep, QObject *parent = nullptr);
+    ~BackupWorker() override;
+
+    void startWorker();
+    void stopWorker();
+
+    // 立即备份一次（不等待下一个周期）
+    void triggerNow();
+    QString directory() const { return m_directory; }
+
+    // 同步备份主库与全部数据分片到 directory 下新建的 backup_yyyyMMdd_HHmmss 目录（文件名与原库相同）
+    // 各文件分别一致，文件之间不是同一时刻的快照；段文件后端的数据不在 SQLite 中，不在备份范围内
+    // keepGoing 返回 false 时中止并删除已写的文件
+    static BackupResult backupDatabases(const QString& directory, const BackupOptions& options = BackupOptions(),
+                                        const std::function<bool()>& keepGoing = std::function<bool()>());
+    // 备份单个数据库文件
+    // 写入频繁导致反复重启时：WAL 模式下改为一次复制完（读事务不阻塞写入），回滚日志模式下放弃本次备份
+    static BackupResult backupFile(const QString& source, const QString& destination,
+                                   const BackupOptions& options = BackupOptions(),
+                                   const std::function<bool()>& keepGoing = std::function<bool()>());
+    // 以只读方式打开快照中的数据库文件（每个线程一个连接），失败返回无效连接
+    static QSqlDatabase openSnapshot(const QString& path);
+    // 目录中最近一份完整备份，没有时返回空
+    static QString latestBackup(const QString& directory);
+
+signals:
+    void backupFinished(bool ok, const QString& path, const QString& error);
+
+protected:
+    void run() override;
+
+private:
+    void prune();
+
+    QString m_directory;
+    int m_intervalSecs;
+    int m_keep;
+    std::atomic<bool> m_isRunning{false};
+    bool m_triggered = false;
+
+    QMutex m_wakeMutex;
+    QWaitCondition m_wakeCondition;
+};
+
+#endif // BACKUP_H
@@ -0,0 +1,6 @@
+# 基准测试工程集合（独立于主程序构建）
+TEMPLATE = subdirs
+
+SUBDIRS += crawlbench \
+           microbench \
+           storagebench
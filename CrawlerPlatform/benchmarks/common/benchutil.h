@@ -0,0 +1,77 @@
+#ifndef BENCHUTIL_H
+#define BENCHUTIL_H
+
+#include <QtGlobal>
+#include <QList>
+#include <QString>
+#include <QFile>
+#include <QJsonDocument>
+#include <QJsonObject>
+#include <QTextStream>
+#include <QDebug>
+#include <algorithm>
+
+#ifdef Q_OS_WIN
+#include <windows.h>
+#else
+#include <sys/resource.h>
+#endif
+
+// 基准测试公共工具：进程CPU时间、分位数、结果输出
+namespace BenchUtil {
+
+// 进程累计CPU时间（用户态+内核态，微秒）
+inline qint64 processCpuTimeUs()
+{
+#ifdef Q_OS_WIN
+    FILETIME creation, exitTime, kernel, user;
+    if (!GetProcessTimes(GetCurrentProcess(), &creation, &exitTime, &kernel, &user)) {
+        return 0;
+    }
+    auto toUs = [](const FILETIME& ft) {
+        ULARGE_INTEGER v;
+        v.LowPart = ft.dwLowDateTime;
+        v.HighPart = ft.dwHighDateTime;
+        return static_cast<qint64>(v.QuadPart / 10); // 100ns -> us
+    };
+    return toUs(kernel) + toUs(user);
+#else
+    struct rusage usage;
+    if (getrusage(RUSAGE_SELF, &usage) != 0) {
+        return 0;
+    }
+    return static_cast<qint64>(usage.ru_utime.tv_sec + usage.ru_stime.tv_sec) * 1000000
+           + usage.ru_utime.tv_usec + usage.ru_stime.tv_usec;
+#endif
+}
+
+// 分位数（p 取 0~1，samples 会被排序）
+inline double percentile(QList<qint64>& samples, double p)
+{
+    if (samples.isEmpty()) return 0.0;
+    std::sort(samples.begin(), samples.end());
+    qsizetype index = static_cast<qsizetype>(p * (samples.size() - 1) + 0.5);
+    return static_cast<double>(samples.at(qBound<qsizetype>(0, index, samples.size() - 1)));
+}
+
+// 输出JSON结果：path 为空时写到标准输出
+inline bool writeJson(const QJsonObject& result, const QString& path)
+{
+    QByteArray json = QJsonDocument(result).toJson(QJsonDocument::Indented);
+    if (path.isEmpty()) {
+        QTextStream(stdout) << json;
+        return true;
+    }
+
+    QFile file(path);
+    if (!file.open(QIODevice::WriteOnly | QIODevice::Truncate)) {
+        qCritical() << "写入基准结果失败：" << path << file.errorString();
+        return false;
+    }
+    file.write(json);
+    return true;
+}
+
+} // namespace BenchUtil
+
+#endif // BENCHUTIL_H
@@ -0,0 +1,182 @@
+#include "syntheticserver.h"
+#include <QHostAddress>
+#include <QTimer>
+#include <QDebug>
+
+// 预生成的响应体数量（轮流返回，避免每次请求都重新生成/压缩）
+static const int kBodyPoolSize = 64;
+
+SyntheticServer::SyntheticServer(const SyntheticServerConfig& config)
+    : m_config(config)
+    , m_context(nullptr)
+    , m_server(nullptr)
+    , m_port(0)
+    , m_rng(QRandomGenerator::securelySeeded())
+    , m_nextBody(0)
+    , m_requestCount(0)
+    , m_errorCount(0)
+{
+}
+
+SyntheticServer::~SyntheticServer()
+{
+    stop();
+}
+
+QString SyntheticServer::baseUrl() const
+{
+    return QString("http://127.0.0.1:%1").arg(m_port);
+}
+
+bool SyntheticServer::start()
+{
+    if (m_context) {
+        return true;
+    }
+
+    buildBodies();
+
+    m_context = new QObject();
+    m_context->moveToThread(&m_thread);
+    m_thread.setObjectName("SyntheticServer");
+    m_thread.start();
+
+    bool ok = false;
+    QMetaObject::invokeMethod(m_context, [this, &ok]() {
+        m_server = new QTcpServer(m_context);
+        QObject::connect(m_server, &QTcpServer::newConnection, m_context, [this]() { onNewConnection(); });
+        ok = m_server->listen(QHostAddress::LocalHost, m_config.port);
+        if (ok) {
+            m_port = m_server->serverPort();
+        } else {
+            qCritical() << "合成服务监听失败：" << m_server->errorString();
+        }
+    }, Qt::BlockingQueuedConnection);
+
+    if (!ok) {
+        stop();
+    }
+    return ok;
+}
+
+void SyntheticServer::stop()
+{
+    if (!m_context) {
+        return;
+    }
+
+    // 在服务线程内关闭监听并释放服务器与所有连接
+    QMetaObject::invokeMethod(m_context, [this]() {
+        m_buffers.clear();
+        m_server->close();
+        m_context->deleteLater();
+    }, Qt::BlockingQueuedConnection);
+    m_context = nullptr;
+    m_server = nullptr;
+
+    m_thread.quit();
+    m_thread.wait();
+}
+
+void SyntheticServer::buildBodies()
+{
+    static const QByteArray kFiller =
+        "<p>Lorem ipsum dolor sit amet, consectetur adipiscing elit, sed do eiusmod tempor.</p>\n";
+
+    m_bodies.clear();
+    for (int i = 0; i < kBodyPoolSize; i++) {
+        // 价格数值放在页面最前面，默认规则 \d+\.?\d* 首个匹配即为价格
+        double price = 10.0 + m_rng.bounded(9000) / 100.0;
+        QByteArray page = "<html><head><title>synthetic</title></head><body>\n<span class=\"price\">"
+                          + QByteArray::number(price, 'f', 2) + "</span>\n";
+        while (page.size() + kFiller.size() < m_config.pageSize) {
+            page += kFiller;
+        }
+        page += "</body></html>\n";
+
+        if (m_config.compress) {
+            // qCompress 输出为 4 字节长度前缀 + zlib 流，去掉前缀即为 HTTP deflate 编码
+            page = qCompress(page).mid(4);
+        }
+        m_bodies.append(page);
+    }
+}
+
+void SyntheticServer::onNewConnection()
+{
+    while (m_server->hasPendingConnections()) {
+        QTcpSocket* socket = m_server->nextPendingConnection();
+        QObject::connect(socket, &QTcpSocket::readyRead, socket, [this, socket]() { onReadyRead(socket); });
+        QObject::connect(socket, &QTcpSocket::disconnected, socket, [this, socket]() {
+            m_buffers.remove(socket);
+            socket->deleteLater();
+        });
+    }
+}
+
+void SyntheticServer::onReadyRead(QTcpSocket* socket)
+{
+    QByteArray& buffer = m_buffers[socket];
+    buffer.append(socket->readAll());
+
+    // 仅处理 GET 请求（无请求体），按空行切分请求头
+    qsizetype headerEnd;
+    while ((headerEnd = buffer.indexOf("\r\n\r\n")) >= 0) {
+        QByteArray header = buffer.left(headerEnd).toLower();
+        buffer.remove(0, headerEnd + 4);
+
+        bool keepAlive = !header.contains("connection: close");
+        m_requestCount++;
+
+        int delay = m_config.latencyMs;
+        if (m_config.jitterMs > 0) {
+            delay += static_cast<int>(m_rng.bounded(m_config.jitterMs + 1));
+        }
+
+        if (delay > 0) {
+            QTimer::singleShot(delay, socket, [this, socket, keepAlive]() { sendResponse(socket, keepAlive); });
+        } else {
+            sendResponse(socket, keepAlive);
+        }
+    }
+}
+
+void SyntheticServer::sendResponse(QTcpSocket* socket, bool keepAlive)
+{
+    if (socket->state() != QAbstractSocket::ConnectedState) {
+        return;
+    }
+
+    bool fail = m_config.errorRate > 0 && m_rng.generateDouble() < m_config.errorRate;
+
+    QByteArray status;
+    QByteArray body;
+    if (fail) {
+        m_errorCount++;
+        status = "500 Internal Server Error";
+        body = "synthetic error";
+    } else {
+        status = "200 OK";
+        if (m_config.changeRate >= 1.0 || m_rng.generateDouble() < m_config.changeRate) {
+            m_nextBody = (m_nextBody + 1) % m_bodies.size();
+        }
+        body = m_bodies.at(m_nextBody);
+    }
+
+    QByteArray response;
+    response.reserve(body.size() + 256);
+    response += "HTTP/1.1 " + status + "\r\n";
+    response += "Content-Type: text/html; charset=utf-8\r\n";
+    if (!fail && m_config.compress) {
+        response += "Content-Encoding: deflate\r\n";
+    }
+    response += "Content-Length: " + QByteArray::number(body.size()) + "\r\n";
+    response += keepAlive ? "Connection: keep-alive\r\n" : "Connection: close\r\n";
+    response += "\r\n";
+    response += body;
+
+    socket->write(response);
+    if (!keepAlive) {
+        socket->disconnectFromHost();
+    }
+}
@@ -0,0 +1,62 @@
+#ifndef SYNTHETICSERVER_H
+#define SYNTHETICSERVER_H
+
+#include <QObject>
+#include <QThread>
+#include <QTcpServer>
+#include <QTcpSocket>
+#include <QHash>
+#include <QList>
+#include <QByteArray>
+#include <QRandomGenerator>
+#include <atomic>
+
+// 合成页面服务配置
+struct SyntheticServerConfig {
+    int pageSize = 4096;      // 响应体大小（压缩前，字节）
+    int latencyMs = 0;        // 固定响应延迟
+    int jitterMs = 0;         // 随机附加延迟上限
+    double errorRate = 0.0;   // 返回 HTTP 500 的概率（0~1）
+    bool compress = false;    // 是否以 deflate 压缩响应体
+    double changeRate = 1.0;  // 每次请求换一个页面的概率（其余返回与上次逐字节相同的内容）
+    quint16 port = 0;         // 监听端口（0 表示自动分配）
+};
+
+// 本地回环HTTP服务（基准测试专用，替代公网目标站点）
+// 在独立线程中监听 127.0.0.1，返回带价格数值的合成HTML页面
+class SyntheticServer
+{
+public:
+    explicit SyntheticServer(const SyntheticServerConfig& config);
+    ~SyntheticServer();
+
+    bool start();
+    void stop();
+
+    quint16 port() const { return m_port; }
+    QString baseUrl() const;
+    quint64 requestCount() const { return m_requestCount.load(); }
+    quint64 errorCount() const { return m_errorCount.load(); }
+
+private:
+    void buildBodies();
+    void onNewConnection();
+    void onReadyRead(QTcpSocket* socket);
+    void sendResponse(QTcpSocket* socket, bool keepAlive);
+
+    SyntheticServerConfig m_config;
+    QThread m_thread;
+    QObject* m_context;       // 归属服务线程的上下文对象
+    QTcpServer* m_server;
+    quint16 m_port;
+
+    QList<QByteArray> m_bodies;             // 预生成的响应体（已按需压缩）
+    QHash<QTcpSocket*, QByteArray> m_buffers; // 各连接未处理完的请求数据
+    QRandomGenerator m_rng;
+    int m_nextBody;
+
+    std::atomic<quint64> m_requestCount;
+    std::atomic<quint64> m_errorCount;
+};
+
+#endif // SYNTHETICSERVER_H
@@ -0,0 +1,84 @@
+#!/usr/bin/env python3
+"""对比 QtTest 基准XML结果与存档基线。
+
+用法：
+    microbench -o current.xml,xml
+    python3 compare_baseline.py baselines/microbench.xml current.xml --threshold 0.15
+
+以 (测试函数, 数据行, 指标) 为键比较每次迭代耗时，超过阈值的条目视为回退，脚本返回 1。
+首次运行或有意更新基线时，使用 --update 将当前结果复制为基线。
+基线文件不存在、没有任何结果，或当前结果中有基线未覆盖的条目时返回 2（避免检查静默失效），
+新增基准函数尚未录入基线时可加 --allow-new 放行。
+"""
+import argparse
+import os
+import shutil
+import sys
+import xml.etree.ElementTree as ET
+
+
+def load(path):
+    results = {}
+    root = ET.parse(path).getroot()
+    for func in root.iter("TestFunction"):
+        for bench in func.iter("BenchmarkResult"):
+            # value 已是每次迭代的数值（iterations 只表示 QBENCHMARK 自行选择的重复次数）
+            key = (func.get("name"), bench.get("tag", ""), bench.get("metric"))
+            results[key] = float(bench.get("value"))
+    return results
+
+
+def main():
+    parser = argparse.ArgumentParser(description=__doc__.splitlines()[0])
+    parser.add_argument("baseline")
+    parser.add_argument("current")
+    parser.add_argument("--threshold", type=float, default=0.10, help="允许的相对回退比例")
+    parser.add_argument("--update", action="store_true", help="用当前结果覆盖基线")
+    parser.add_argument("--allow-new", action="store_true", help="基线中没有的条目只提示，不视为失败")
+    args = parser.parse_args()
+
+    if args.update:
+        shutil.copyfile(args.current, args.baseline)
+        print("基线已更新：%s" % args.baseline)
+        return 0
+
+    if not os.path.isfile(args.baseline):
+        print("错误：基线文件不存在：%s（在基准机器上用 --update 录入）" % args.baseline, file=sys.stderr)
+        return 2
+    baseline = load(args.baseline)
+    if not baseline:
+        print("错误：基线文件中没有基准结果：%s" % args.baseline, file=sys.stderr)
+        return 2
+    current = load(args.current)
+    regressions = 0
+    uncovered = 0
+
+    print("%-32s %-8s %-22s %14s %14s %8s" % ("function", "tag", "metric", "baseline", "current", "delta"))
+    for key in sorted(current):
+        func, tag, metric = key
+        now = current[key]
+        base = baseline.get(key)
+        if base is None or base == 0:
+            uncovered += 1
+            print("%-32s %-8s %-22s %14s %14.4f %8s" % (func, tag, metric, "-", now, "new"))
+            continue
+        delta = (now - base) / base
+        flag = ""
+        if delta > args.threshold:
+            regressions += 1
+            flag = "  <-- 回退"
+        print("%-32s %-8s %-22s %14.4f %14.4f %+7.1f%%%s" % (func, tag, metric, base, now, delta * 100, flag))
+
+    for key in sorted(set(baseline) - set(current)):
+        print("%-32s %-8s %-22s 缺失（基线中存在）" % key)
+
+    if regressions:
+        return 1
+    if uncovered and not args.allow_new:
+        print("错误：%d 个条目没有基线，请更新基线或加 --allow-new" % uncovered, file=sys.stderr)
+        return 2
+    return 0
+
+
+if __name__ == "__main__":
+    sys.exit(main())
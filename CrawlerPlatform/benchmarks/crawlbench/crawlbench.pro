@@ -0,0 +1,17 @@
+QT += core network sql
+QT -= gui
+
+CONFIG += c++17 console
+CONFIG -= app_bundle
+
+TARGET = crawlbench
+
+include(../../crawlercore.pri)
+
+INCLUDEPATH += ../common
+
+SOURCES += main.cpp \
+           ../common/syntheticserver.cpp
+
+HEADERS += ../common/syntheticserver.h \
+           ../common/benchutil.h
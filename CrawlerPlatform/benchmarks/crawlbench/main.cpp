@@ -0,0 +1,396 @@
+#include <QCoreApplication>
+#include <QCommandLineParser>
+#include <QLoggingCategory>
+#include <QElapsedTimer>
+#include <QTimer>
+#include <QFile>
+#include <QDir>
+#include <QJsonObject>
+#include <QDateTime>
+#include <QSqlQuery>
+#include <QProcess>
+#include <csignal>
+#include <atomic>
+#include "crawlerthread.h"
+#include "databasemanager.h"
+#include "metrics.h"
+#include "syntheticserver.h"
+#include "simulation.h"
+#include "workerhost.h"
+#include "backup.h"
+#include "benchutil.h"
+
+// 端到端爬取吞吐基准：本地合成服务 -> 抓取 -> 解析 -> 入库
+// 结果以JSON输出，便于跨版本对比
+
+static qint64 countDataRows()
+{
+    qint64 rows = 0;
+    for (const QSqlDatabase& db : DatabaseManager::dataDatabases()) {
+        QSqlQuery query("SELECT COUNT(*) FROM crawler_data", db);
+        rows += query.next() ? query.value(0).toLongLong() : 0;
+    }
+    return rows;
+}
+
+// 各工作进程持有的分片数（空闲分片记在 "" 下）
+static QJsonObject leaseOwnersJson()
+{
+    QSqlDatabase db = DatabaseManager::getThreadDatabase();
+    QSqlQuery query("SELECT owner, COUNT(*) FROM crawler_leases GROUP BY owner ORDER BY owner", db);
+    QJsonObject owners;
+    while (query.next()) {
+        owners[query.value(0).toString()] = query.value(1).toInt();
+    }
+    return owners;
+}
+
+static std::atomic<bool> s_stopRequested{false};
+
+// --lease-worker：由 --workers 启动的子进程，只运行 WorkerHost，收到 SIGTERM 后释放租约退出
+static int runLeaseWorker(QCoreApplication& app, const QString& dbPath, const LeaseConfig& leaseConfig)
+{
+    DatabaseManager::setDatabasePath(dbPath);
+    WorkerHost host(leaseConfig);
+    if (!host.start()) {
+        return 1;
+    }
+
+    std::signal(SIGINT, [](int) { s_stopRequested = true; });
+    std::signal(SIGTERM, [](int) { s_stopRequested = true; });
+    QTimer stopPoll;
+    QObject::connect(&stopPoll, &QTimer::timeout, &app, []() {
+        if (s_stopRequested) {
+            QCoreApplication::quit();
+        }
+    });
+    stopPoll.start(100);
+
+    const int ret = app.exec();
+    host.stop();
+    return ret;
+}
+
+static QJsonObject latencyJson(QList<qint64>& samplesUs)
+{
+    double sum = 0;
+    qint64 maxUs = 0;
+    for (qint64 us : samplesUs) {
+        sum += us;
+        maxUs = qMax(maxUs, us);
+    }
+
+    QJsonObject obj;
+    obj["p50"] = BenchUtil::percentile(samplesUs, 0.50) / 1000.0;
+    obj["p99"] = BenchUtil::percentile(samplesUs, 0.99) / 1000.0;
+    obj["mean"] = samplesUs.isEmpty() ? 0.0 : sum / samplesUs.size() / 1000.0;
+    obj["max"] = maxUs / 1000.0;
+    return obj;
+}
+
+int main(int argc, char *argv[])
+{
+    QCoreApplication app(argc, argv);
+    QCoreApplication::setApplicationName("crawlbench");
+
+    QCommandLineParser parser;
+    parser.setApplicationDescription("端到端爬取吞吐基准（合成页面 -> 抓取 -> 解析 -> 入库）");
+    parser.addHelpOption();
+
+    QCommandLineOption tasksOpt("tasks", "并发任务数", "n", "50");
+    QCommandLineOption durationOpt("duration", "统计时长（秒）", "sec", "10");
+    QCommandLineOption warmupOpt("warmup", "预热时长（秒，不计入统计）", "sec", "1");
+    QCommandLineOption intervalOpt("interval", "任务爬取间隔（秒）", "sec", "1");
+    QCommandLineOption pageSizeOpt("page-size", "响应体大小（字节）", "bytes", "4096");
+    QCommandLineOption latencyOpt("latency", "服务端固定延迟（毫秒）", "ms", "0");
+    QCommandLineOption jitterOpt("jitter", "服务端随机延迟上限（毫秒）", "ms", "0");
+    QCommandLineOption errorRateOpt("error-rate", "服务端错误率（0~1）", "ratio", "0");
+    QCommandLineOption compressOpt("compress", "以 deflate 压缩响应体");
+    QCommandLineOption changeRateOpt("change-rate", "页面内容变化的概率（0~1，其余请求返回相同内容）", "ratio", "1");
+    QCommandLineOption rampOpt("ramp-up", "首轮分散窗口（秒，0 表示所有任务同时开始）", "seconds", "0");
+    QCommandLineOption portOpt("port", "合成服务端口（0 自动分配）", "port", "0");
+    QCommandLineOption serveOpt("serve", "仅运行合成服务，供其他进程压测");
+    QCommandLineOption simulateOpt("simulate", "不走网络，使用模拟数值过程（uniform/walk/step）压测调度与写入", "kind");
+    QCommandLineOption targetOpt("target", "使用外部合成服务地址（如 http://127.0.0.1:18080）", "url");
+    QCommandLineOption dbOpt("db", "基准数据库文件（运行前清空）", "path", "crawlbench.db");
+    QCommandLineOption outputOpt("output", "JSON结果文件（默认输出到标准输出）", "path");
+    QCommandLineOption shardsOpt("data-shards", "爬取数据分布的库文件数（写入按分片并行）", "k", "1");
+    QCommandLineOption workersOpt("workers", "启动 N 个无界面工作进程按分片租约分担任务（0 表示在本进程内运行）", "n", "0");
+    QCommandLineOption killAfterOpt("kill-after", "多进程模式下在第几秒强杀第一个工作进程，检验租约过期后的接管", "sec", "0");
+    QCommandLineOption heartbeatOpt("heartbeat", "多进程模式的心跳周期（毫秒，租约有效期为其 5 倍）", "ms", "1000");
+    QCommandLineOption backupOpt("backup-every", "运行期间每隔若干秒做一次在线备份，检验备份对写入延迟的影响", "sec", "0");
+    QCommandLineOption leaseWorkerOpt("lease-worker", "（内部）作为工作进程运行");
+    QCommandLineOption workerIdOpt("worker-id", "（内部）工作进程标识", "id");
+    leaseWorkerOpt.setFlags(QCommandLineOption::HiddenFromHelp);
+    workerIdOpt.setFlags(QCommandLineOption::HiddenFromHelp);
+
+    parser.addOptions({tasksOpt, durationOpt, warmupOpt, intervalOpt, pageSizeOpt, latencyOpt,
+                       jitterOpt, errorRateOpt, compressOpt, changeRateOpt, rampOpt, portOpt, serveOpt, simulateOpt, targetOpt,
+                       dbOpt, outputOpt, shardsOpt, workersOpt, killAfterOpt, heartbeatOpt, backupOpt, leaseWorkerOpt,
+                       workerIdOpt});
+    parser.process(app);
+
+    // 关闭逐条调试日志，避免日志输出干扰测量
+    QLoggingCategory::setFilterRules("*.debug=false\n*.info=false");
+
+    LeaseConfig leaseConfig;
+    leaseConfig.workerId = parser.value(workerIdOpt);
+    leaseConfig.heartbeatMs = qMax(100, parser.value(heartbeatOpt).toInt());
+    leaseConfig.leaseTtlMs = leaseConfig.heartbeatMs * 5;
+    if (parser.isSet(leaseWorkerOpt)) {
+        return runLeaseWorker(app, parser.value(dbOpt), leaseConfig);
+    }
+
+    SyntheticServerConfig serverConfig;
+    serverConfig.pageSize = parser.value(pageSizeOpt).toInt();
+    serverConfig.latencyMs = parser.value(latencyOpt).toInt();
+    serverConfig.jitterMs = parser.value(jitterOpt).toInt();
+    serverConfig.errorRate = parser.value(errorRateOpt).toDouble();
+    serverConfig.compress = parser.isSet(compressOpt);
+    serverConfig.changeRate = qBound(0.0, parser.value(changeRateOpt).toDouble(), 1.0);
+    serverConfig.port = static_cast<quint16>(parser.value(portOpt).toUInt());
+
+    SyntheticServer server(serverConfig);
+    const bool simulate = parser.isSet(simulateOpt);
+    QString baseUrl = parser.value(targetOpt);
+    if (baseUrl.isEmpty() && !simulate) {
+        if (!server.start()) {
+            return 1;
+        }
+        baseUrl = server.baseUrl();
+    }
+
+    if (parser.isSet(serveOpt)) {
+        QTextStream(stdout) << "合成服务已启动：" << baseUrl << Qt::endl;
+        return app.exec();
+    }
+
+    const int taskCount = qMax(1, parser.value(tasksOpt).toInt());
+    const int durationSec = qMax(1, parser.value(durationOpt).toInt());
+    const int warmupSec = qMax(0, parser.value(warmupOpt).toInt());
+    const int interval = qMax(1, parser.value(intervalOpt).toInt());
+    const int rampUpSec = qMax(0, parser.value(rampOpt).toInt());
+    const int workerCount = qMax(0, parser.value(workersOpt).toInt());
+    const int dataShards = qMax(1, parser.value(shardsOpt).toInt());
+    const int killAfterSec = qMax(0, parser.value(killAfterOpt).toInt());
+    const int backupEverySec = qMax(0, parser.value(backupOpt).toInt());
+
+    // 独立的基准数据库，每次运行前清空
+    const QString dbPath = parser.value(dbOpt);
+    DatabaseManager::setDatabasePath(dbPath);
+    DatabaseManager::setDataShardCount(dataShards);
+    QStringList dbFiles = {dbPath};
+    for (int shard = 0; shard < dataShards; ++shard) {
+        dbFiles.append(DatabaseManager::dataShardPath(shard));
+    }
+    for (const QString& file : std::as_const(dbFiles)) {
+        QFile::remove(file);
+        QFile::remove(file + "-journal");
+        QFile::remove(file + "-wal");
+        QFile::remove(file + "-shm");
+    }
+    if (!DatabaseManager::initDatabaseSchema()
+        || ((workerCount > 0 || backupEverySec > 0) && !DatabaseManager::enableWriteAheadLog())) {
+        qCritical() << "基准数据库初始化失败";
+        return 1;
+    }
+
+    if (simulate) {
+        LoadProfile profile;
+        profile.taskCount = taskCount;
+        profile.namePrefix = "bench-sim";
+        profile.intervalDistribution = LoadProfile::IntervalDistribution::Fixed;
+        profile.intervalMin = interval;
+        profile.intervalMax = interval;
+        profile.process = SimulatedValueSource::fromUrl(QString("sim://%1").arg(parser.value(simulateOpt)));
+        LoadGenerator::createTasks(profile);
+    } else {
+        QList<CrawlerTask> benchTasks;
+        for (int i = 0; i < taskCount; i++) {
+            CrawlerTask task;
+            task.name = QString("bench-%1").arg(i);
+            task.url = QString("%1/item/%2").arg(baseUrl).arg(i);
+            task.interval = interval;
+            benchTasks.append(task);
+        }
+        DatabaseManager::saveCrawlerTasks(benchTasks);
+    }
+
+    // 统计状态（仅在主线程中访问）
+    bool measuring = false;
+    qint64 fetches = 0;
+    qint64 errors = 0;
+    QList<qint64> fetchLatencies;
+    QList<qint64> crawlLatencies;
+
+    // 多进程模式：任务由子进程按分片租约运行，本进程只提供合成服务并统计入库行数
+    QList<QProcess*> workers;
+    for (int i = 0; i < workerCount; ++i) {
+        QProcess* worker = new QProcess(&app);
+        worker->setProcessChannelMode(QProcess::ForwardedErrorChannel);
+        worker->start(QCoreApplication::applicationFilePath(),
+                      {"--lease-worker", "--db", dbPath, "--worker-id", QString("worker-%1").arg(i),
+                       "--heartbeat", QString::number(leaseConfig.heartbeatMs)});
+        workers.append(worker);
+    }
+    if (workerCount > 0 && killAfterSec > 0) {
+        // SIGKILL 模拟进程崩溃：租约不释放，需等过期后由其余进程接管
+        QTimer::singleShot(killAfterSec * 1000, &app, [&]() { workers.first()->kill(); });
+    }
+
+    // 在线备份：与爬虫写入并发进行，统计成功次数与单步持锁时间
+    const QString backupDir = dbPath + ".backups";
+    QDir(backupDir).removeRecursively();
+    BackupWorker backupWorker(backupDir, backupEverySec, 2);
+    int backupsOk = 0;
+    int backupsFailed = 0;
+    QObject::connect(&backupWorker, &BackupWorker::backupFinished, &app, [&](bool ok, const QString&, const QString&) {
+        if (!measuring) return;
+        (ok ? backupsOk : backupsFailed)++;
+    });
+    if (backupEverySec > 0) {
+        backupWorker.startWorker();
+    }
+
+    QList<CrawlerThread*> threads;
+    const QList<CrawlerTask> tasks = workerCount > 0 ? QList<CrawlerTask>() : DatabaseManager::getAllTasks();
+    for (const auto& task : tasks) {
+        CrawlerThread* thread = new CrawlerThread(task.id);
+        QObject::connect(thread, &CrawlerThread::crawlFinished, &app,
+                         [&](int, bool success, qint64 fetchUs, qint64 totalUs) {
+            if (!measuring) return;
+            if (success) {
+                fetches++;
+                fetchLatencies.append(fetchUs);
+                crawlLatencies.append(totalUs);
+            } else {
+                errors++;
+            }
+        });
+        // 与界面批量启动相同：首轮均匀分散在 ramp-up 窗口内
+        thread->startCrawling(static_cast<qint64>(rampUpSec) * 1000 * threads.size() / tasks.size());
+        threads.append(thread);
+    }
+
+    QElapsedTimer wallTimer;
+    qint64 cpuStartUs = 0;
+    qint64 rowsStart = 0;
+    // 响应体未变化而跳过解析的次数与估算节省的解析耗时（由爬虫线程注册）
+    MetricsRegistry& registry = MetricsRegistry::instance();
+    MetricCounter* unchanged = registry.counter("crawler_body_unchanged_total", "响应体与上次相同、跳过解析的次数");
+    MetricHistogram* parseSaved = registry.histogram("crawler_parse_saved_seconds",
+                                                     "响应体未变化时跳过解析节省的耗时（按近期解析耗时估算，_sum 为累计节省）");
+    quint64 unchangedStart = 0;
+    quint64 parseSavedStartUs = 0;
+
+    QTimer::singleShot(warmupSec * 1000, &app, [&]() {
+        rowsStart = countDataRows();
+        unchangedStart = unchanged->value();
+        parseSavedStartUs = parseSaved->sum();
+        cpuStartUs = BenchUtil::processCpuTimeUs();
+        wallTimer.start();
+        measuring = true;
+    });
+
+    QTimer::singleShot((warmupSec + durationSec) * 1000, &app, [&]() {
+        measuring = false;
+        const double elapsedSec = wallTimer.nsecsElapsed() / 1e9;
+        const qint64 cpuUs = BenchUtil::processCpuTimeUs() - cpuStartUs;
+        const qint64 rows = countDataRows() - rowsStart;
+        const quint64 skipped = unchanged->value() - unchangedStart;
+        const quint64 savedUs = parseSaved->sum() - parseSavedStartUs;
+
+        backupWorker.stopWorker();
+        CrawlerThread::stopAll(threads);
+        for (CrawlerThread* thread : threads) {
+            delete thread;
+        }
+        threads.clear();
+
+        // 停止前记录分片分布，之后各进程释放租约
+        const QJsonObject leaseOwners = leaseOwnersJson();
+        int workersAlive = 0;
+        for (QProcess* worker : std::as_const(workers)) {
+            if (worker->state() == QProcess::Running) {
+                workersAlive++;
+                worker->terminate();
+            }
+        }
+        for (QProcess* worker : std::as_const(workers)) {
+            if (!worker->waitForFinished(10000)) {
+                worker->kill();
+                worker->waitForFinished();
+            }
+        }
+
+        QJsonObject config;
+        config["tasks"] = taskCount;
+        config["interval_s"] = interval;
+        config["duration_s"] = durationSec;
+        config["page_size"] = serverConfig.pageSize;
+        config["latency_ms"] = serverConfig.latencyMs;
+        config["jitter_ms"] = serverConfig.jitterMs;
+        config["error_rate"] = serverConfig.errorRate;
+        config["compress"] = serverConfig.compress;
+        config["change_rate"] = serverConfig.changeRate;
+        config["ramp_up_s"] = rampUpSec;
+        config["external_server"] = parser.isSet(targetOpt);
+        config["simulate"] = simulate ? parser.value(simulateOpt) : QString();
+        config["data_shards"] = DatabaseManager::dataShardCount();
+        config["workers"] = workerCount;
+        config["kill_after_s"] = killAfterSec;
+        config["heartbeat_ms"] = workerCount > 0 ? leaseConfig.heartbeatMs : 0;
+        config["backup_every_s"] = backupEverySec;
+
+        QJsonObject results;
+        results["elapsed_s"] = elapsedSec;
+        results["fetches"] = fetches;
+        results["errors"] = errors;
+        results["fetches_per_sec"] = fetches / elapsedSec;
+        results["fetch_latency_ms"] = latencyJson(fetchLatencies);
+        results["crawl_latency_ms"] = latencyJson(crawlLatencies);
+        // 内置合成服务与客户端同进程，CPU时间包含服务端开销
+        results["cpu_ms_per_fetch"] = fetches > 0 ? cpuUs / 1000.0 / fetches : 0.0;
+        results["db_rows"] = rows;
+        results["db_rows_per_sec"] = rows / elapsedSec;
+        results["unchanged_ratio"] = fetches > 0 ? static_cast<double>(skipped) / fetches : 0.0;
+        results["parse_cpu_saved_ms"] = savedUs / 1000.0;
+        if (workerCount > 0) {
+            // 抓取在子进程中进行，fetches 与延迟不可用，以入库行数为准
+            QJsonObject workerResults;
+            workerResults["alive"] = workersAlive;
+            workerResults["lease_owners"] = leaseOwners;
+            results["workers"] = workerResults;
+        }
+
+        if (backupEverySec > 0) {
+            // 单步耗时即写入线程可能被阻塞的上限，与写入语句耗时的尾部对照
+            MetricHistogram* backupStep = registry.histogram("crawler_backup_step_duration_seconds",
+                                                             "单步复制持有源库读锁的时间");
+            MetricHistogram* insertData = registry.histogram("crawler_db_statement_duration_seconds",
+                                                             "SQL语句耗时（含结果读取）", {{"op", "insert_data"}});
+            QJsonObject backupResults;
+            backupResults["completed"] = backupsOk;
+            backupResults["failed"] = backupsFailed;
+            backupResults["steps"] = static_cast<qint64>(backupStep->count());
+            backupResults["step_p99_ms"] = backupStep->quantile(0.99) / 1000.0;
+            backupResults["step_max_ms"] = backupStep->quantile(1.0) / 1000.0;
+            backupResults["insert_p99_ms"] = insertData->quantile(0.99) / 1000.0;
+            results["backup"] = backupResults;
+        }
+
+        QJsonObject report;
+        report["benchmark"] = "crawl_e2e";
+        report["timestamp"] = QDateTime::currentDateTime().toString(Qt::ISODate);
+        report["qt_version"] = qVersion();
+        report["config"] = config;
+        report["results"] = results;
+
+        bool ok = BenchUtil::writeJson(report, parser.value(outputOpt));
+        app.exit(ok ? 0 : 1);
+    });
+
+    int ret = app.exec();
+    server.stop();
+    return ret;
+}
@@ -0,0 +1,11 @@
+QT += core gui widgets sql network charts testlib
+
+CONFIG += c++17 console
+CONFIG -= app_bundle
+
+TARGET = microbench
+
+include(../../crawlercore.pri)
+include(../../crawlergui.pri)
+
+SOURCES += tst_microbench.cpp
@@ -0,0 +1,472 @@
+#include <QtTest>
+#include <QApplication>
+#include <QLoggingCategory>
+#include <QTemporaryDir>
+#include <QSqlDatabase>
+#include <QSqlQuery>
+#include "databasemanager.h"
+#include "crawlerthread.h"
+#include "mainwindow.h"
+#include "taskregistry.h"
+#include "gorilla.h"
+#include "chunkstore.h"
+#include "xxhash64.h"
+#include "fastrandom.h"
+#include <cstring>
+#include <limits>
+
+// 热点路径微基准（QBENCHMARK）
+// 运行：microbench -o result.xml,xml，再用 compare_baseline.py 与存档基线对比
+class MicroBench : public QObject
+{
+    Q_OBJECT
+
+private slots:
+    void initTestCase();
+    void cleanupTestCase();
+
+    void saveCrawlerData();
+    void getTaskData_data();
+    void getTaskData();
+    void getTaskStatistics_data();
+    void getTaskStatistics();
+    void getAllTasks();
+    void taskLookup_data();
+    void taskLookup();
+    void parseValue_data();
+    void parseValue();
+    void gorillaRoundTrip_data();
+    void gorillaRoundTrip();
+    void chunkLateMerge();
+    void gorillaDecode_data();
+    void gorillaDecode();
+    void bodyHash_data();
+    void bodyHash();
+    void refreshTaskList();
+    void updateLineChart_data();
+    void updateLineChart();
+
+private:
+    bool seedTasks(int count);
+    bool seedRows(int taskId, int rows);
+
+    QTemporaryDir m_dir;
+    QMap<int, int> m_rowsTask;   // 数据行数 -> 对应任务ID
+    int m_writeTaskId = 0;       // 写入基准专用任务
+    MainWindow* m_window = nullptr;
+};
+
+// 任务总数（getAllTasks / refreshTaskList 的规模）
+static const int kTaskCount = 1000;
+
+void MicroBench::initTestCase()
+{
+    QVERIFY(m_dir.isValid());
+    DatabaseManager::setDatabasePath(m_dir.filePath("microbench.db"));
+    QVERIFY(DatabaseManager::initDatabaseSchema());
+    QVERIFY(seedTasks(kTaskCount));
+
+    // 任务1~3分别预置 1k / 100k / 1M 行数据，任务4用于写入基准
+    const QList<int> sizes = {1000, 100000, 1000000};
+    for (int i = 0; i < sizes.size(); i++) {
+        QVERIFY(seedRows(i + 1, sizes[i]));
+        m_rowsTask[sizes[i]] = i + 1;
+    }
+    // 预置数据绕过了写入路径，需重建汇总
+    QVERIFY(DatabaseManager::rebuildRollups());
+    m_writeTaskId = 4;
+
+    m_window = new MainWindow();
+}
+
+void MicroBench::cleanupTestCase()
+{
+    delete m_window;
+    m_window = nullptr;
+    DatabaseManager::stopReaders();
+}
+
+bool MicroBench::seedTasks(int count)
+{
+    QSqlDatabase db = DatabaseManager::getThreadDatabase();
+    db.transaction();
+    QSqlQuery query(db);
+    query.prepare("INSERT INTO crawler_tasks (name, url, interval, rule) VALUES (?, ?, 5, '')");
+    for (int i = 0; i < count; i++) {
+        query.addBindValue(QString("bench-task-%1").arg(i));
+        query.addBindValue(QString("http://127.0.0.1/item/%1").arg(i));
+        if (!query.exec()) return false;
+    }
+    return db.commit();
+}
+
+bool MicroBench::seedRows(int taskId, int rows)
+{
+    QSqlDatabase db = DatabaseManager::getThreadDatabase();
+    db.transaction();
+    QSqlQuery query(db);
+    query.prepare("INSERT INTO crawler_data (taskId, content, value, crawlTime) VALUES (?, ?, ?, ?)");
+
+    QDateTime time = QDateTime::currentDateTime().addSecs(-rows);
+    for (int i = 0; i < rows; i++) {
+        double value = 50.0 + (i % 500) / 10.0;
+        query.addBindValue(taskId);
+        query.addBindValue(QString::number(value, 'f', 2));
+        query.addBindValue(value);
+        query.addBindValue(time.addSecs(i).toString("yyyy-MM-dd HH:mm:ss"));
+        if (!query.exec()) return false;
+    }
+    return db.commit();
+}
+
+void MicroBench::saveCrawlerData()
+{
+    CrawlerData data;
+    data.taskId = m_writeTaskId;
+    data.value = 42.5;
+
+    QBENCHMARK {
+        data.timestampMs = QDateTime::currentMSecsSinceEpoch();
+        DatabaseManager::saveCrawlerData(data);
+    }
+}
+
+void MicroBench::getTaskData_data()
+{
+    QTest::addColumn<int>("rows");
+    QTest::newRow("1k") << 1000;
+    QTest::newRow("100k") << 100000;
+    QTest::newRow("1M") << 1000000;
+}
+
+void MicroBench::getTaskData()
+{
+    QFETCH(int, rows);
+    const int taskId = m_rowsTask.value(rows);
+
+    QBENCHMARK {
+        QList<CrawlerData> datas = DatabaseManager::getTaskData(taskId);
+        QCOMPARE(datas.size(), rows);
+    }
+}
+
+void MicroBench::getTaskStatistics_data()
+{
+    getTaskData_data();
+}
+
+// 与 getTaskData 同规模：统计量只读汇总表，耗时应与数据行数基本无关
+void MicroBench::getTaskStatistics()
+{
+    QFETCH(int, rows);
+    const int taskId = m_rowsTask.value(rows);
+    QDateTime first, last;
+    QVERIFY(DatabaseManager::getTaskTimeRange(taskId, &first, &last));
+
+    QBENCHMARK {
+        const TaskStatistics stats = DatabaseManager::getTaskStatistics(taskId, first, last);
+        QCOMPARE(stats.count, qint64(rows));
+    }
+}
+
+void MicroBench::getAllTasks()
+{
+    QBENCHMARK {
+        QList<CrawlerTask> tasks = DatabaseManager::getAllTasks();
+        QCOMPARE(tasks.size(), kTaskCount);
+    }
+}
+
+void MicroBench::taskLookup_data()
+{
+    QTest::addColumn<bool>("cached");
+    QTest::newRow("getTaskById") << false;
+    QTest::newRow("registry") << true;
+}
+
+// 按ID查询任务元数据：逐次查库 vs 进程内缓存
+void MicroBench::taskLookup()
+{
+    QFETCH(bool, cached);
+    TaskRegistry::instance().tasks(); // 预先加载，不计入测量
+    int taskId = 0;
+    QBENCHMARK {
+        taskId = taskId % kTaskCount + 1;
+        const CrawlerTask task = cached ? TaskRegistry::instance().task(taskId)
+                                        : DatabaseManager::getTaskById(taskId);
+        QCOMPARE(task.id, taskId);
+    }
+}
+
+void MicroBench::parseValue_data()
+{
+    QTest::addColumn<int>("payloadSize");
+    QTest::newRow("1KB") << 1024;
+    QTest::newRow("16KB") << 16 * 1024;
+    QTest::newRow("256KB") << 256 * 1024;
+}
+
+void MicroBench::parseValue()
+{
+    QFETCH(int, payloadSize);
+
+    // 数值放在页面末尾，模拟最坏情况下的正则扫描
+    QString html = "<html><body>";
+    while (html.size() < payloadSize) {
+        html += "<p>Lorem ipsum dolor sit amet, consectetur adipiscing elit.</p>";
+    }
+    html += "<span class=\"price\">1234.56</span></body></html>";
+
+    // 规则在配置发布时编译一次，这里只测量匹配与转换
+    CrawlerThread thread(m_writeTaskId);
+    const QRegularExpression re = thread.config()->ruleRegex;
+    double value = 0.0;
+    QBENCHMARK {
+        value = thread.parseValue(html, re);
+    }
+    QCOMPARE(value, 1234.56);
+}
+
+// 编解码正确性（非基准）：封存后原始行即被删除，解码结果必须与写入逐位一致
+using GorillaPoints = QList<QPair<qint64, double>>;
+Q_DECLARE_METATYPE(GorillaPoints)
+
+static quint64 doubleBits(double value)
+{
+    quint64 bits;
+    memcpy(&bits, &value, sizeof(bits));
+    return bits;
+}
+
+static double bitsDouble(quint64 bits)
+{
+    double value;
+    memcpy(&value, &bits, sizeof(value));
+    return value;
+}
+
+void MicroBench::gorillaRoundTrip_data()
+{
+    QTest::addColumn<GorillaPoints>("points");
+
+    // 二阶差分各编码区间的边界两侧（7/9/12 位与 64 位转义）
+    const QList<qint64> dods = {-63, 64, -64, 65, -255, 256, -256, 257, -2047, 2048, -2048, 2049,
+                                qint64(1) << 40, -(qint64(1) << 40)};
+    for (qint64 dod : dods) {
+        GorillaPoints points;
+        qint64 secs = 1700000000;
+        qint64 delta = 10;
+        points << qMakePair(secs, 1.0);
+        secs += delta;
+        points << qMakePair(secs, 1.0);
+        delta += dod;
+        secs += delta;
+        points << qMakePair(secs, 2.0);
+        secs += delta;
+        points << qMakePair(secs, 2.0);
+        QTest::newRow(qPrintable(QString("dod%1").arg(dod))) << points;
+    }
+
+    const qint64 extreme = std::numeric_limits<qint64>::max() / 4;
+    QTest::newRow("timestamps") << GorillaPoints{{-extreme, 0.0}, {0, 0.0}, {extreme, 0.0}};
+    QTest::newRow("values") << GorillaPoints{
+        {1, -12.5}, {2, 0.0}, {3, -0.0}, {4, 0.0}, {5, std::numeric_limits<double>::quiet_NaN()},
+        {6, bitsDouble(0x7ff8000000000123ULL)}, {7, -std::numeric_limits<double>::infinity()},
+        {8, std::numeric_limits<double>::denorm_min()}, {9, -1.0}};
+    // XOR 的有效位为 64 位（首尾均无零位）及窗口复用
+    QTest::newRow("xor64") << GorillaPoints{
+        {1, bitsDouble(0x0000000000000001ULL)}, {2, bitsDouble(0x8000000000000000ULL)},
+        {3, bitsDouble(0x7fffffffffffffffULL)}, {4, bitsDouble(0x8000000000000001ULL)}, {5, 0.0}};
+    QTest::newRow("single") << GorillaPoints{{42, 3.14}};
+}
+
+void MicroBench::gorillaRoundTrip()
+{
+    QFETCH(GorillaPoints, points);
+
+    GorillaEncoder encoder;
+    for (const auto& point : points) {
+        encoder.append(point.first, point.second);
+    }
+    GorillaDecoder decoder(encoder.finish());
+    QVERIFY(decoder.isValid());
+    QCOMPARE(static_cast<qsizetype>(decoder.count()), points.size());
+
+    qint64 secs = 0;
+    double value = 0.0;
+    for (qsizetype i = 0; i < points.size(); i++) {
+        QVERIFY2(decoder.next(&secs, &value), qPrintable(QString("第 %1 点解码失败").arg(i)));
+        QCOMPARE(secs, points.at(i).first);
+        QCOMPARE(doubleBits(value), doubleBits(points.at(i).second));
+    }
+    QVERIFY(!decoder.next(&secs, &value));
+    QVERIFY(decoder.isValid());
+}
+
+// 迟到的数据点与已封存的块合并后，块内数据与全部写入的点一致
+void MicroBench::chunkLateMerge()
+{
+    const int taskId = 5;
+    QSqlDatabase db = DatabaseManager::getDataDatabase(taskId);
+    // 按本地时区对齐的小时（与封存分块一致）
+    const qint64 hourStart = RollupStore::bucketStart(QDateTime::currentDateTime().addSecs(-3 * 3600),
+                                                      ChunkStore::kChunkSeconds);
+    auto save = [&](qint64 secs, double value) {
+        CrawlerData data;
+        data.taskId = taskId;
+        data.timestampMs = secs * 1000;
+        data.value = value;
+        return DatabaseManager::saveCrawlerData(data);
+    };
+
+    QMap<qint64, double> expected;
+    for (int i = 0; i < 100; i++) {
+        const qint64 secs = hourStart + 30 * i + (i % 3);
+        const double value = std::round((i % 7 - 3) * 12.34 * 100.0) / 100.0;
+        QVERIFY(save(secs, value));
+        expected.insert(secs, value);
+    }
+    const qint64 cutoff = hourStart + 2 * ChunkStore::kChunkSeconds;
+    QCOMPARE(ChunkStore::sealBefore(db, taskId, cutoff), qint64(100));
+
+    // 迟到的点落在已封存的小时内（开头、中间、末尾）
+    const QList<QPair<qint64, double>> late = {{hourStart, -0.5}, {hourStart + 1501, 99.99}, {hourStart + 3599, -7.25}};
+    for (const auto& point : late) {
+        QVERIFY(save(point.first, point.second));
+        expected.insert(point.first, point.second);
+    }
+    QCOMPARE(ChunkStore::sealBefore(db, taskId, cutoff), qint64(late.size()));
+
+    QSqlQuery query(db);
+    QVERIFY(query.exec(QString("SELECT COUNT(*) FROM crawler_data WHERE taskId = %1").arg(taskId)) && query.next());
+    QCOMPARE(query.value(0).toInt(), 0);
+
+    QList<QPair<qint64, double>> sealed;
+    QVERIFY(ChunkStore::scan(db, taskId, hourStart, hourStart + 3599, [&](qint64 secs, double value) {
+        sealed.append(qMakePair(secs, value));
+    }));
+    QCOMPARE(sealed.size(), expected.size());
+    qsizetype i = 0;
+    for (auto it = expected.cbegin(); it != expected.cend(); ++it, ++i) {
+        QCOMPARE(sealed.at(i).first, it.key());
+        QCOMPARE(doubleBits(sealed.at(i).second), doubleBits(it.value()));
+    }
+}
+
+void MicroBench::gorillaDecode_data()
+{
+    QTest::addColumn<double>("stepProbability");
+    QTest::newRow("flat") << 0.0;
+    QTest::newRow("step5%") << 0.05;
+    QTest::newRow("every") << 1.0;
+}
+
+void MicroBench::gorillaDecode()
+{
+    QFETCH(double, stepProbability);
+
+    // 一小时块：5秒间隔（±1秒抖动）的两位小数价格
+    const int points = 720;
+    FastRandom rng(7);
+    GorillaEncoder encoder;
+    qint64 secs = 1700000000;
+    double price = 50.0;
+    for (int i = 0; i < points; i++) {
+        secs += 4 + static_cast<qint64>(rng.bounded(3));
+        if (rng.nextDouble() < stepProbability) {
+            price = std::round((price + rng.uniform(-1.0, 1.0)) * 100.0) / 100.0;
+        }
+        encoder.append(secs, price);
+    }
+    const QByteArray block = encoder.finish();
+
+    int decoded = 0;
+    QBENCHMARK {
+        GorillaDecoder decoder(block);
+        qint64 timestamp = 0;
+        double value = 0.0;
+        decoded = 0;
+        while (decoder.next(&timestamp, &value)) {
+            decoded++;
+        }
+    }
+    QCOMPARE(decoded, points);
+    qInfo() << "每点字节数：" << static_cast<double>(block.size()) / points;
+}
+
+void MicroBench::bodyHash_data()
+{
+    parseValue_data();
+}
+
+// 响应体哈希（与 parseValue 同规模对比，即响应体未变化时每次爬取的解析开销）
+void MicroBench::bodyHash()
+{
+    QFETCH(int, payloadSize);
+
+    QByteArray body = "<html><body>";
+    while (body.size() < payloadSize) {
+        body += "<p>Lorem ipsum dolor sit amet, consectetur adipiscing elit.</p>";
+    }
+    body += "<span class=\"price\">1234.56</span></body></html>";
+
+    quint64 hash = 0;
+    QBENCHMARK {
+        // 按 4KB 分片喂入，与网络分块到达时一致
+        XxHash64 hasher;
+        for (qsizetype offset = 0; offset < body.size(); offset += 4096) {
+            hasher.update(body.constData() + offset, qMin<qsizetype>(4096, body.size() - offset));
+        }
+        hash = hasher.digest();
+    }
+    QCOMPARE(hash, XxHash64::hash(body));
+}
+
+void MicroBench::refreshTaskList()
+{
+    // 界面查询改为异步：这里同步执行同样的查询与表格填充，测量一次完整刷新的开销
+    QBENCHMARK {
+        m_window->loadTaskList(DatabaseManager::getAllTasks());
+    }
+    QCOMPARE(m_window->m_taskModel->rowCount(), kTaskCount);
+}
+
+void MicroBench::updateLineChart_data()
+{
+    QTest::addColumn<int>("rows");
+    QTest::newRow("1k") << 1000;
+    QTest::newRow("100k") << 100000;
+    QTest::newRow("1M") << 1000000;
+}
+
+void MicroBench::updateLineChart()
+{
+    QFETCH(int, rows);
+    const int taskId = m_rowsTask.value(rows);
+
+    QBENCHMARK {
+        m_window->updateLineChart(MainWindow::queryChartData(taskId, 0));
+    }
+    // 1k 行直接绘制原始数据，更大的数据量改用汇总（上限 2000 点）
+    const int points = m_window->m_lineSeries->count();
+    if (rows <= 2000) {
+        QCOMPARE(points, rows);
+    } else {
+        QVERIFY(points > 0 && points <= 2000);
+    }
+}
+
+int main(int argc, char *argv[])
+{
+    // 无显示环境下运行GUI路径
+    if (!qEnvironmentVariableIsSet("QT_QPA_PLATFORM")) {
+        qputenv("QT_QPA_PLATFORM", "offscreen");
+    }
+    QApplication app(argc, argv);
+    QLoggingCategory::setFilterRules("*.debug=false");
+
+    MicroBench bench;
+    return QTest::qExec(&bench, argc, argv);
+}
+
+#include "tst_microbench.moc"
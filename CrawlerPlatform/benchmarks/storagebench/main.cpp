@@ -0,0 +1,384 @@
+#include <QCoreApplication>
+#include <QCommandLineParser>
+#include <QLoggingCategory>
+#include <QElapsedTimer>
+#include <QDir>
+#include <QFileInfo>
+#include <QJsonObject>
+#include <QJsonArray>
+#include <QDateTime>
+#include "databasemanager.h"
+#include "segmentstore.h"
+#include "fastrandom.h"
+#include "simulation.h"
+#include "gorilla.h"
+#include "dataexport.h"
+#include "benchutil.h"
+#include <QSqlQuery>
+#include <QMap>
+#include <cmath>
+
+// 存储后端对比基准：SQLite 与段文件的写入速率、扫描速率与磁盘占用
+// 两个后端都经由 DatabaseManager 的数据接口读写
+// --change-only：SQLite 后端按变化存储模式写入（数值不变时只延长上一行的 lastSeen）
+// --seal：SQLite 后端写入后把数据封存为 Gorilla 压缩块，再测扫描（解码）速率
+// --fulltext：SQLite 后端开启全文索引，每个点附带提取文本写入，测写入速率与罕见词/常见词的检索耗时
+// --export：写入后把全部数据分别导出为 CSV 与 Arrow IPC 文件，测导出速率与文件大小
+// --analyze：对已有数据库按任务按小时做 Gorilla 编码，统计压缩率与编解码吞吐（只读）
+
+struct StorageBenchConfig {
+    int tasks = 4;
+    int points = 10000;
+    int maxPoints = 2000;
+    bool seal = false;
+    bool exportData = false;
+    bool fullText = false;
+    double changeTolerance = -1.0;
+    QString process = "sim://step?p=0.05&jump=0.5";
+    QString directory;
+};
+
+// 执行 incremental_vacuum 直到结束，使文件大小反映实际占用
+static void reclaimAll()
+{
+    QSqlDatabase db = DatabaseManager::getThreadDatabase();
+    QSqlQuery query(db);
+    if (query.exec("PRAGMA incremental_vacuum")) {
+        while (query.next()) {}
+    }
+}
+
+static QJsonObject analyzeDatabase(const QString& dbPath)
+{
+    DatabaseManager::setDatabasePath(dbPath);
+    QSqlDatabase db = DatabaseManager::getThreadDatabase();
+    if (!db.isOpen()) {
+        return QJsonObject();
+    }
+
+    // 与封存逻辑一致：每个任务每小时一块，时间戳为 Unix 秒
+    QMap<QPair<int, qint64>, GorillaEncoder> encoders;
+    QSqlQuery query(db);
+    query.setForwardOnly(true);
+    if (!query.exec("SELECT taskId, value, crawlTime FROM crawler_data ORDER BY taskId, crawlTime")) {
+        qCritical() << "读取数据失败：" << query.lastError().text();
+        return QJsonObject();
+    }
+    QList<QPair<qint64, double>> rows;
+    QList<QPair<int, qint64>> keys;
+    while (query.next()) {
+        const QDateTime time = QDateTime::fromString(query.value(2).toString(), "yyyy-MM-dd HH:mm:ss");
+        if (!time.isValid()) continue;
+        const qint64 secs = time.toSecsSinceEpoch();
+        keys.append(qMakePair(query.value(0).toInt(), secs / 3600));
+        rows.append(qMakePair(secs, query.value(1).toDouble()));
+    }
+
+    QElapsedTimer timer;
+    timer.start();
+    for (qsizetype i = 0; i < rows.size(); i++) {
+        encoders[keys.at(i)].append(rows.at(i).first, rows.at(i).second);
+    }
+    QList<QByteArray> blocks;
+    qint64 encodedBytes = 0;
+    for (auto it = encoders.begin(); it != encoders.end(); ++it) {
+        blocks.append(it.value().finish());
+        encodedBytes += blocks.last().size();
+    }
+    const double encodeSec = timer.nsecsElapsed() / 1e9;
+
+    timer.restart();
+    qint64 decoded = 0;
+    double checksum = 0.0;
+    for (const QByteArray& block : blocks) {
+        GorillaDecoder decoder(block);
+        qint64 secs = 0;
+        double value = 0.0;
+        while (decoder.next(&secs, &value)) {
+            checksum += value;
+            decoded++;
+        }
+    }
+    const double decodeSec = timer.nsecsElapsed() / 1e9;
+
+    const qint64 points = rows.size();
+    QJsonObject result;
+    result["points"] = points;
+    result["chunks"] = static_cast<qint64>(blocks.size());
+    result["encoded_bytes"] = encodedBytes;
+    result["bytes_per_point"] = points > 0 ? static_cast<double>(encodedBytes) / points : 0.0;
+    // 相对未压缩的 (int64 时间戳, double) 16 字节
+    result["compression_ratio"] = encodedBytes > 0 ? points * 16.0 / encodedBytes : 0.0;
+    result["encode_points_per_sec"] = encodeSec > 0 ? points / encodeSec : 0.0;
+    result["decode_points_per_sec"] = decodeSec > 0 ? decoded / decodeSec : 0.0;
+    result["checksum"] = checksum;
+    return result;
+}
+
+static qint64 sqliteBytes(const QString& dbPath)
+{
+    qint64 bytes = 0;
+    for (const QString& suffix : {QString(), QString("-wal"), QString("-journal")}) {
+        QFileInfo info(dbPath + suffix);
+        if (info.exists()) bytes += info.size();
+    }
+    return bytes;
+}
+
+static QJsonObject runBackend(DataBackend backend, const StorageBenchConfig& config)
+{
+    const QString name = backend == DataBackend::Segment ? "segment" : "sqlite";
+    QDir root(QDir(config.directory).filePath(name));
+    root.removeRecursively();
+    QDir().mkpath(root.path());
+
+    const QString dbPath = root.filePath("bench.db");
+    DatabaseManager::setDatabasePath(dbPath);
+    SegmentStore::instance().setDirectory(root.filePath("segments"));
+    DatabaseManager::setDataBackend(backend);
+    const bool fullText = config.fullText && backend == DataBackend::Sqlite;
+    DatabaseManager::setFullTextIndexEnabled(fullText);
+    if (!DatabaseManager::initDatabaseSchema()) {
+        return QJsonObject();
+    }
+
+    QList<CrawlerTask> tasks;
+    for (int i = 0; i < config.tasks; i++) {
+        CrawlerTask task;
+        task.name = QString("storage-bench-%1").arg(i);
+        task.url = "sim://walk";
+        tasks.append(task);
+    }
+    const QList<int> taskIds = DatabaseManager::saveCrawlerTasks(tasks);
+    const qint64 baseBytes = backend == DataBackend::Segment ? 0 : sqliteBytes(dbPath);
+
+    // 写入：按轮次交错各任务，与爬虫线程的写入顺序一致
+    // 数值取两位小数，与从页面解析出的价格一致
+    FastRandom rng(42);
+    QList<SimulatedValueSource> sources;
+    for (int i = 0; i < taskIds.size(); i++) {
+        sources.append(SimulatedValueSource::fromUrl(config.process));
+    }
+    const QDateTime base = QDateTime::currentDateTime().addSecs(-config.points);
+    QElapsedTimer timer;
+    timer.start();
+    qint64 written = 0;
+    for (int i = 0; i < config.points; i++) {
+        const QDateTime time = base.addSecs(i);
+        for (int t = 0; t < taskIds.size(); t++) {
+            CrawlerData data;
+            data.taskId = taskIds.at(t);
+            data.value = std::round(sources[t].next(rng) * 100.0) / 100.0;
+            data.timestampMs = time.toMSecsSinceEpoch();
+            // 与页面上提取出的文本相近：价格 + 每个点唯一的商品编号
+            const QString rawText = fullText ? QString("当前价格 ¥%1 商品编号 SKU-%2-%3")
+                                                   .arg(data.value, 0, 'f', 2).arg(t).arg(i, 6, 10, QChar('0'))
+                                             : QString();
+            if (DatabaseManager::saveCrawlerData(data, config.changeTolerance, rawText)) written++;
+        }
+    }
+    const double ingestSec = timer.nsecsElapsed() / 1e9;
+
+    qint64 rowsStored = written;
+    if (backend == DataBackend::Sqlite) {
+        QSqlQuery query("SELECT COUNT(*) FROM crawler_data", DatabaseManager::getThreadDatabase());
+        if (query.next()) rowsStored = query.value(0).toLongLong();
+    }
+
+    // 全文检索：罕见词只命中一个点，常见词命中全部点（按相关度取前 100 条）
+    QJsonObject fullTextResults;
+    if (fullText) {
+        const QList<QPair<QString, QString>> terms = {
+            {"rare", QString("SKU-0-%1").arg(config.points / 2, 6, 10, QChar('0'))}, {"common", "商品编号"}};
+        for (const auto& term : terms) {
+            timer.restart();
+            const QList<SearchHit> hits = DatabaseManager::searchText(term.second, 100);
+            QJsonObject entry;
+            entry["query"] = term.second;
+            entry["hits"] = static_cast<qint64>(hits.size());
+            entry["search_ms"] = timer.nsecsElapsed() / 1e6;
+            fullTextResults[term.first] = entry;
+        }
+    }
+
+    // 封存为压缩块（覆盖到下一小时，即全部数据）
+    double sealSec = 0.0;
+    qint64 chunkBytes = 0;
+    if (config.seal && backend == DataBackend::Sqlite) {
+        timer.restart();
+        DatabaseManager::sealTaskData(QDateTime::currentDateTime().addSecs(3600));
+        sealSec = timer.nsecsElapsed() / 1e9;
+        QSqlQuery query("SELECT COALESCE(SUM(LENGTH(data)), 0) FROM crawler_chunks",
+                        DatabaseManager::getThreadDatabase());
+        if (query.next()) chunkBytes = query.value(0).toLongLong();
+        reclaimAll();
+    }
+
+    // 全量扫描
+    timer.restart();
+    qint64 scanned = 0;
+    for (int taskId : taskIds) {
+        scanned += DatabaseManager::getTaskData(taskId).size();
+    }
+    const double scanSec = timer.nsecsElapsed() / 1e9;
+
+    // 整段时间范围的图表序列
+    timer.restart();
+    qint64 seriesPoints = 0;
+    for (int taskId : taskIds) {
+        QDateTime first, last;
+        if (DatabaseManager::getTaskTimeRange(taskId, &first, &last)) {
+            seriesPoints += DatabaseManager::getTaskSeries(taskId, first, last, config.maxPoints).size();
+        }
+    }
+    const double seriesSec = timer.nsecsElapsed() / 1e9;
+
+    // 流式导出（与界面“导出数据”相同的路径）
+    QJsonObject exportResults;
+    if (config.exportData) {
+        const QList<QPair<QString, ExportOptions::Format>> formats = {
+            {"csv", ExportOptions::Format::Csv}, {"arrow", ExportOptions::Format::Arrow}};
+        for (const auto& format : formats) {
+            ExportOptions options;
+            options.path = root.filePath("export." + format.first);
+            options.format = format.second;
+            options.taskIds = taskIds;
+            timer.restart();
+            const ExportResult exported = DataExporter::exportData(options);
+            const double exportSec = timer.nsecsElapsed() / 1e9;
+            if (!exported.ok) {
+                qCritical() << "导出失败：" << exported.error;
+                return QJsonObject();
+            }
+            QJsonObject entry;
+            entry["rows"] = exported.rows;
+            entry["bytes"] = exported.bytes;
+            entry["rows_per_sec"] = exportSec > 0 ? exported.rows / exportSec : 0.0;
+            entry["mb_per_sec"] = exportSec > 0 ? exported.bytes / exportSec / 1e6 : 0.0;
+            exportResults[format.first] = entry;
+        }
+    }
+
+    SegmentStore::instance().close();
+    const qint64 bytes = backend == DataBackend::Segment ? SegmentStore::instance().diskBytes()
+                                                         : sqliteBytes(dbPath) - baseBytes;
+
+    QJsonObject result;
+    result["backend"] = name;
+    result["rows_written"] = written;
+    result["rows_stored"] = rowsStored;
+    result["ingest_rows_per_sec"] = ingestSec > 0 ? written / ingestSec : 0.0;
+    result["rows_scanned"] = scanned;
+    result["scan_rows_per_sec"] = scanSec > 0 ? scanned / scanSec : 0.0;
+    result["series_points"] = seriesPoints;
+    result["series_ms_per_task"] = taskIds.isEmpty() ? 0.0 : seriesSec * 1000.0 / taskIds.size();
+    result["disk_bytes"] = bytes;
+    result["bytes_per_point"] = written > 0 ? static_cast<double>(bytes) / written : 0.0;
+    if (config.seal && backend == DataBackend::Sqlite) {
+        result["seal_rows_per_sec"] = sealSec > 0 ? written / sealSec : 0.0;
+        result["chunk_bytes"] = chunkBytes;
+        result["chunk_bytes_per_point"] = written > 0 ? static_cast<double>(chunkBytes) / written : 0.0;
+        result["compression_ratio"] = chunkBytes > 0 ? written * 16.0 / chunkBytes : 0.0;
+    }
+    if (config.exportData) {
+        result["export"] = exportResults;
+    }
+    if (fullText) {
+        result["fulltext"] = fullTextResults;
+    }
+    return result;
+}
+
+int main(int argc, char *argv[])
+{
+    QCoreApplication app(argc, argv);
+    QCoreApplication::setApplicationName("storagebench");
+
+    QCommandLineParser parser;
+    parser.setApplicationDescription("存储后端对比基准（SQLite / 段文件）");
+    parser.addHelpOption();
+
+    QCommandLineOption tasksOpt("tasks", "任务数", "n", "4");
+    QCommandLineOption pointsOpt("points", "每个任务写入的数据点数", "n", "10000");
+    QCommandLineOption backendOpt("backend", "sqlite、segment 或 both", "name", "both");
+    QCommandLineOption maxPointsOpt("max-points", "图表序列点数上限", "n", "2000");
+    QCommandLineOption processOpt("process", "数值过程（sim:// 地址）", "url", "sim://step?p=0.05&jump=0.5");
+    QCommandLineOption changeOnlyOpt("change-only", "按变化存储模式写入，数值变化不超过容差时不新增行", "tolerance");
+    QCommandLineOption sealOpt("seal", "SQLite 后端写入后封存为 Gorilla 压缩块");
+    QCommandLineOption exportOpt("export", "写入后测量 CSV 与 Arrow IPC 导出速率");
+    QCommandLineOption fullTextOpt("fulltext", "SQLite 后端开启全文索引并写入提取文本，测量检索耗时");
+    QCommandLineOption analyzeOpt("analyze", "统计已有数据库的 Gorilla 压缩率与编解码吞吐", "db");
+    QCommandLineOption dirOpt("dir", "基准数据目录（运行前清空）", "path", "storagebench_data");
+    QCommandLineOption outputOpt("output", "JSON结果文件（默认输出到标准输出）", "path");
+    parser.addOptions({tasksOpt, pointsOpt, backendOpt, maxPointsOpt, processOpt, changeOnlyOpt, sealOpt, exportOpt,
+                       fullTextOpt, analyzeOpt, dirOpt, outputOpt});
+    parser.process(app);
+
+    QLoggingCategory::setFilterRules("*.debug=false\n*.info=false");
+
+    if (parser.isSet(analyzeOpt)) {
+        QJsonObject result = analyzeDatabase(parser.value(analyzeOpt));
+        if (result.isEmpty()) {
+            qCritical() << "分析失败";
+            return 1;
+        }
+        QJsonObject report;
+        report["benchmark"] = "gorilla_analyze";
+        report["timestamp"] = QDateTime::currentDateTime().toString(Qt::ISODate);
+        report["qt_version"] = qVersion();
+        report["database"] = parser.value(analyzeOpt);
+        report["results"] = result;
+        return BenchUtil::writeJson(report, parser.value(outputOpt)) ? 0 : 1;
+    }
+
+    StorageBenchConfig config;
+    config.tasks = qMax(1, parser.value(tasksOpt).toInt());
+    config.points = qMax(1, parser.value(pointsOpt).toInt());
+    config.maxPoints = qMax(1, parser.value(maxPointsOpt).toInt());
+    config.process = parser.value(processOpt);
+    config.seal = parser.isSet(sealOpt);
+    config.exportData = parser.isSet(exportOpt);
+    config.fullText = parser.isSet(fullTextOpt);
+    if (parser.isSet(changeOnlyOpt)) {
+        config.changeTolerance = qMax(0.0, parser.value(changeOnlyOpt).toDouble());
+    }
+    config.directory = parser.value(dirOpt);
+
+    const QString backendName = parser.value(backendOpt).toLower();
+    QList<DataBackend> backends;
+    if (backendName == "sqlite" || backendName == "both") backends.append(DataBackend::Sqlite);
+    if (backendName == "segment" || backendName == "both") backends.append(DataBackend::Segment);
+    if (backends.isEmpty()) {
+        qCritical() << "未知的存储后端：" << backendName;
+        return 1;
+    }
+
+    QJsonArray results;
+    for (DataBackend backend : backends) {
+        QJsonObject result = runBackend(backend, config);
+        if (result.isEmpty()) {
+            qCritical() << "基准运行失败";
+            return 1;
+        }
+        results.append(result);
+    }
+
+    QJsonObject jsonConfig;
+    jsonConfig["tasks"] = config.tasks;
+    jsonConfig["points_per_task"] = config.points;
+    jsonConfig["max_points"] = config.maxPoints;
+    jsonConfig["process"] = config.process;
+    jsonConfig["seal"] = config.seal;
+    jsonConfig["export"] = config.exportData;
+    jsonConfig["fulltext"] = config.fullText;
+    jsonConfig["change_tolerance"] = config.changeTolerance;
+
+    QJsonObject report;
+    report["benchmark"] = "storage_backend";
+    report["timestamp"] = QDateTime::currentDateTime().toString(Qt::ISODate);
+    report["qt_version"] = qVersion();
+    report["config"] = jsonConfig;
+    report["results"] = results;
+
+    return BenchUtil::writeJson(report, parser.value(outputOpt)) ? 0 : 1;
+}
@@ -0,0 +1,15 @@
+QT += core network sql
+QT -= gui
+
+CONFIG += c++17 console
+CONFIG -= app_bundle
+
+TARGET = storagebench
+
+include(../../crawlercore.pri)
+
+INCLUDEPATH += ../common
+
+SOURCES += main.cpp
+
+HEADERS += ../common/benchutil.h
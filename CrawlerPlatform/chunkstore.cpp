@@ -0,0 +1,411 @@
+#include "chunkstore.h"
+#include "gorilla.h"
+#include "rollupstore.h"
+#include "metrics.h"
+#include <QSqlQuery>
+#include <QSqlError>
+#include <QDateTime>
+#include <QVariantList>
+#include <QDebug>
+#include <algorithm>
+#include <tuple>
+
+// 每次从原始表读取的最大行数
+static const int kSealBatchRows = 4096;
+// 每批删除的过期块数
+static const int kPruneBatchChunks = 64;
+
+// 封存指标（首次使用时注册）
+struct ChunkMetrics {
+    MetricCounter* pointsSealed;
+    MetricCounter* bytesWritten;
+
+    static const ChunkMetrics& get()
+    {
+        static const ChunkMetrics metrics = []() {
+            MetricsRegistry& registry = MetricsRegistry::instance();
+            ChunkMetrics m;
+            m.pointsSealed = registry.counter("crawler_chunk_points_sealed_total", "封存为压缩块的数据点数");
+            m.bytesWritten = registry.counter("crawler_chunk_bytes_written_total", "写入的压缩块字节数");
+            return m;
+        }();
+        return metrics;
+    }
+};
+
+struct ChunkPoint {
+    qint64 secs;
+    double value;
+};
+
+static bool decodeChunk(const QByteArray& data, QList<ChunkPoint>* points)
+{
+    GorillaDecoder decoder(data);
+    if (!decoder.isValid()) {
+        return false;
+    }
+    points->reserve(points->size() + decoder.count());
+    ChunkPoint point;
+    while (decoder.next(&point.secs, &point.value)) {
+        points->append(point);
+    }
+    return decoder.isValid();
+}
+
+bool ChunkStore::createSchema(QSqlDatabase& db)
+{
+    QSqlQuery query(db);
+    QString sql = R"(
+        CREATE TABLE IF NOT EXISTS crawler_chunks (
+            taskId INTEGER NOT NULL,
+            chunkStart INTEGER NOT NULL,
+            count INTEGER NOT NULL,
+            firstTime INTEGER NOT NULL,
+            lastTime INTEGER NOT NULL,
+            data BLOB NOT NULL,
+            PRIMARY KEY (taskId, chunkStart)
+        ) WITHOUT ROWID
+    )";
+    if (!query.exec(sql)) {
+        qCritical() << "创建压缩块表失败：" << query.lastError().text();
+        return false;
+    }
+    return true;
+}
+
+// 封存单个小时块：合并已有块 -> 编码 -> 写入块 -> 删除原始行，同一事务内完成
+static bool sealChunk(QSqlDatabase& db, int taskId, qint64 chunkStart,
+                      QList<ChunkPoint> points, const QVariantList& rowIds)
+{
+    const qsizetype newPoints = points.size();
+    if (!db.transaction()) {
+        qWarning() << "封存数据失败：无法开启事务" << db.lastError().text();
+        return false;
+    }
+
+    QSqlQuery existing(db);
+    existing.prepare("SELECT data FROM crawler_chunks WHERE taskId = :taskId AND chunkStart = :chunkStart");
+    existing.bindValue(":taskId", taskId);
+    existing.bindValue(":chunkStart", chunkStart);
+    if (existing.exec() && existing.next()) {
+        // 迟到数据：与已封存的点合并后重新编码
+        QList<ChunkPoint> merged;
+        if (!decodeChunk(existing.value(0).toByteArray(), &merged)) {
+            qWarning() << "压缩块损坏，无法合并：任务ID" << taskId << "块" << chunkStart;
+            db.rollback();
+            return false;
+        }
+        merged.append(points);
+        std::stable_sort(merged.begin(), merged.end(),
+                         [](const ChunkPoint& a, const ChunkPoint& b) { return a.secs < b.secs; });
+        points = merged;
+    }
+    existing.finish();
+
+    GorillaEncoder encoder;
+    for (const ChunkPoint& point : points) {
+        encoder.append(point.secs, point.value);
+    }
+    const QByteArray data = encoder.finish();
+
+    QSqlQuery insert(db);
+    insert.prepare(R"(
+        INSERT OR REPLACE INTO crawler_chunks (taskId, chunkStart, count, firstTime, lastTime, data)
+        VALUES (:taskId, :chunkStart, :count, :firstTime, :lastTime, :data)
+    )");
+    insert.bindValue(":taskId", taskId);
+    insert.bindValue(":chunkStart", chunkStart);
+    insert.bindValue(":count", static_cast<int>(points.size()));
+    insert.bindValue(":firstTime", points.first().secs);
+    insert.bindValue(":lastTime", points.last().secs);
+    insert.bindValue(":data", data);
+    if (!insert.exec()) {
+        qWarning() << "写入压缩块失败：" << insert.lastError().text();
+        db.rollback();
+        return false;
+    }
+
+    QSqlQuery remove(db);
+    remove.prepare("DELETE FROM crawler_data WHERE id = ?");
+    remove.addBindValue(rowIds);
+    if (!remove.execBatch()) {
+        qWarning() << "删除已封存的原始数据失败：" << remove.lastError().text();
+        db.rollback();
+        return false;
+    }
+
+    if (!db.commit()) {
+        qWarning() << "封存数据提交失败：" << db.lastError().text();
+        db.rollback();
+        return false;
+    }
+    ChunkMetrics::get().pointsSealed->inc(static_cast<quint64>(newPoints));
+    ChunkMetrics::get().bytesWritten->inc(static_cast<quint64>(data.size()));
+    return true;
+}
+
+qint64 ChunkStore::sealBefore(QSqlDatabase& db, int taskId, qint64 cutoffSecs, const Yield& yield)
+{
+    // 只封存完整的小时
+    const QDateTime cutoff = QDateTime::fromSecsSinceEpoch(
+        RollupStore::bucketStart(QDateTime::fromSecsSinceEpoch(cutoffSecs), kChunkSeconds));
+
+    QSqlQuery query(db);
+    query.setForwardOnly(true);
+    query.prepare(R"(
+        SELECT id, value, crawlTime, lastSeen FROM crawler_data
+        WHERE taskId = :taskId AND crawlTime < :cutoff AND COALESCE(lastSeen, crawlTime) < :lastCutoff
+          AND hasRawText = 0
+        ORDER BY crawlTime LIMIT :batch
+    )");
+
+    qint64 sealed = 0;
+    while (true) {
+        query.bindValue(":taskId", taskId);
+        query.bindValue(":cutoff", cutoff.toString("yyyy-MM-dd HH:mm:ss"));
+        query.bindValue(":lastCutoff", cutoff.toString("yyyy-MM-dd HH:mm:ss"));
+        query.bindValue(":batch", kSealBatchRows);
+        if (!query.exec()) {
+            qWarning() << "读取待封存数据失败：" << query.lastError().text();
+            return -1;
+        }
+
+        // 行按时间有序，同一小时的行相邻
+        int fetched = 0;
+        qint64 chunkStart = 0;
+        QList<ChunkPoint> points;
+        QVariantList rowIds;
+        QList<std::tuple<qint64, QList<ChunkPoint>, QVariantList>> chunks;
+        while (query.next()) {
+            fetched++;
+            const QDateTime time = QDateTime::fromString(query.value(2).toString(), "yyyy-MM-dd HH:mm:ss");
+            if (!time.isValid()) continue;
+            const qint64 bucket = RollupStore::bucketStart(time, kChunkSeconds);
+            if (!points.isEmpty() && bucket != chunkStart) {
+                chunks.append({chunkStart, points, rowIds});
+                points.clear();
+                rowIds.clear();
+            }
+            chunkStart = bucket;
+            const double value = query.value(1).toDouble();
+            points.append({time.toSecsSinceEpoch(), value});
+            rowIds.append(query.value(0));
+
+            // 变化存储的区间末端作为同值点一并封存（与区间起点同块）
+            const QDateTime lastSeen = QDateTime::fromString(query.value(3).toString(), "yyyy-MM-dd HH:mm:ss");
+            if (lastSeen.isValid() && lastSeen > time) {
+                points.append({lastSeen.toSecsSinceEpoch(), value});
+            }
+        }
+        if (!points.isEmpty()) {
+            chunks.append({chunkStart, points, rowIds});
+        }
+        query.finish();
+
+        for (const auto& chunk : chunks) {
+            if (!sealChunk(db, taskId, std::get<0>(chunk), std::get<1>(chunk), std::get<2>(chunk))) {
+                return -1;
+            }
+            sealed += std::get<1>(chunk).size();
+            if (yield && !yield()) {
+                return sealed;
+            }
+        }
+
+        if (fetched < kSealBatchRows || chunks.isEmpty()) {
+            break;
+        }
+    }
+    return sealed;
+}
+
+bool ChunkStore::scan(QSqlDatabase& db, int taskId, qint64 fromSecs, qint64 toSecs, const Visitor& visitor)
+{
+    QSqlQuery query(db);
+    query.setForwardOnly(true);
+    query.prepare(R"(
+        SELECT data FROM crawler_chunks
+        WHERE taskId = :taskId AND chunkStart <= :to AND lastTime >= :from
+        ORDER BY chunkStart
+    )");
+    query.bindValue(":taskId", taskId);
+    query.bindValue(":from", fromSecs);
+    query.bindValue(":to", toSecs);
+    if (!query.exec()) {
+        qWarning() << "读取压缩块失败：" << query.lastError().text();
+        return false;
+    }
+
+    while (query.next()) {
+        GorillaDecoder decoder(query.value(0).toByteArray());
+        qint64 secs = 0;
+        double value = 0.0;
+        while (decoder.next(&secs, &value)) {
+            if (secs >= fromSecs && secs <= toSecs) {
+                visitor(secs, value);
+            }
+        }
+        if (!decoder.isValid()) {
+            qWarning() << "压缩块损坏，已跳过剩余数据：任务ID" << taskId;
+        }
+    }
+    return true;
+}
+
+QList<QPair<qint64, double>> ChunkStore::latest(QSqlDatabase& db, int taskId, int limit, qint64 notBeforeSecs)
+{
+    QList<QPair<qint64, double>> result;
+    QSqlQuery query(db);
+    query.setForwardOnly(true);
+    query.prepare("SELECT lastTime, data FROM crawler_chunks WHERE taskId = :taskId ORDER BY chunkStart DESC");
+    query.bindValue(":taskId", taskId);
+    if (limit <= 0 || !query.exec()) {
+        return result;
+    }
+
+    // 块按小时互不重叠，从新到旧读到凑够 limit 个点为止
+    QList<QList<ChunkPoint>> chunks;
+    qsizetype total = 0;
+    while (total < limit && query.next()) {
+        if (query.value(0).toLongLong() < notBeforeSecs) {
+            break;
+        }
+        QList<ChunkPoint> points;
+        if (!decodeChunk(query.value(1).toByteArray(), &points)) {
+            qWarning() << "压缩块损坏，已跳过：任务ID" << taskId;
+            continue;
+        }
+        total += points.size();
+        chunks.prepend(points);
+    }
+
+    result.reserve(qMin<qsizetype>(total, limit));
+    for (const QList<ChunkPoint>& points : std::as_const(chunks)) {
+        for (const ChunkPoint& point : points) {
+            if (total-- <= limit) {
+                result.append(qMakePair(point.secs, point.value));
+            }
+        }
+    }
+    return result;
+}
+
+qint64 ChunkStore::replaceValues(QSqlDatabase& db, int taskId, const QMap<qint64, double>& values)
+{
+    QSqlQuery select(db);
+    select.prepare("SELECT data FROM crawler_chunks WHERE taskId = :taskId AND chunkStart = :chunkStart");
+    QSqlQuery update(db);
+    update.prepare("UPDATE crawler_chunks SET data = :data WHERE taskId = :taskId AND chunkStart = :chunkStart");
+
+    // values 按时间有序，同一小时的点相邻，每块只解码、重编码一次
+    qint64 replaced = 0;
+    auto it = values.constBegin();
+    while (it != values.constEnd()) {
+        const qint64 chunkStart = RollupStore::bucketStart(QDateTime::fromSecsSinceEpoch(it.key()), kChunkSeconds);
+        const qint64 chunkEnd = chunkStart + kChunkSeconds;
+        auto chunkEndIt = it;
+        while (chunkEndIt != values.constEnd() && chunkEndIt.key() < chunkEnd) {
+            ++chunkEndIt;
+        }
+
+        select.bindValue(":taskId", taskId);
+        select.bindValue(":chunkStart", chunkStart);
+        if (!select.exec()) {
+            qWarning() << "读取压缩块失败：" << select.lastError().text();
+            return -1;
+        }
+        QList<ChunkPoint> points;
+        const bool found = select.next() && decodeChunk(select.value(0).toByteArray(), &points);
+        select.finish();
+
+        qint64 changed = 0;
+        if (found) {
+            for (ChunkPoint& point : points) {
+                const auto value = values.constFind(point.secs);
+                if (value != values.constEnd() && value.key() >= chunkStart && value.key() < chunkEnd) {
+                    point.value = value.value();
+                    changed++;
+                }
+            }
+        }
+
+        if (changed > 0) {
+            GorillaEncoder encoder;
+            for (const ChunkPoint& point : std::as_const(points)) {
+                encoder.append(point.secs, point.value);
+            }
+            update.bindValue(":data", encoder.finish());
+            update.bindValue(":taskId", taskId);
+            update.bindValue(":chunkStart", chunkStart);
+            if (!update.exec()) {
+                qWarning() << "更新压缩块失败：" << update.lastError().text();
+                return -1;
+            }
+            replaced += changed;
+        }
+        it = chunkEndIt;
+    }
+    return replaced;
+}
+
+qint64 ChunkStore::pruneBefore(QSqlDatabase& db, int taskId, qint64 cutoffSecs, const Yield& yield)
+{
+    // 每批取最早的若干块，按主键范围删除到该批的最后一块
+    QSqlQuery select(db);
+    select.prepare(R"(
+        SELECT MAX(chunkStart), SUM(count), COUNT(*) FROM (
+            SELECT chunkStart, count FROM crawler_chunks
+            WHERE taskId = :taskId AND chunkStart <= :last ORDER BY chunkStart LIMIT :batch
+        )
+    )");
+    QSqlQuery remove(db);
+    remove.prepare("DELETE FROM crawler_chunks WHERE taskId = :taskId AND chunkStart <= :last");
+
+    qint64 points = 0;
+    while (true) {
+        select.bindValue(":taskId", taskId);
+        select.bindValue(":last", cutoffSecs - kChunkSeconds);
+        select.bindValue(":batch", kPruneBatchChunks);
+        if (!select.exec() || !select.next() || select.value(2).toInt() == 0) {
+            break;
+        }
+        const qint64 batchLast = select.value(0).toLongLong();
+        const qint64 batchPoints = select.value(1).toLongLong();
+        const int chunks = select.value(2).toInt();
+        select.finish();
+
+        remove.bindValue(":taskId", taskId);
+        remove.bindValue(":last", batchLast);
+        if (!remove.exec()) {
+            qWarning() << "删除过期压缩块失败：" << remove.lastError().text() << "任务ID：" << taskId;
+            break;
+        }
+        points += batchPoints;
+        if (chunks < kPruneBatchChunks || (yield && !yield())) {
+            break;
+        }
+    }
+    return points;
+}
+
+qint64 ChunkStore::lastSealedSecs(QSqlDatabase& db, int taskId)
+{
+    QSqlQuery query(db);
+    query.prepare("SELECT COALESCE(MAX(lastTime), 0) FROM crawler_chunks WHERE taskId = :taskId");
+    query.bindValue(":taskId", taskId);
+    if (!query.exec() || !query.next()) {
+        qWarning() << "读取封存范围失败：" << query.lastError().text();
+        return 0;
+    }
+    return query.value(0).toLongLong();
+}
+
+QList<int> ChunkStore::taskIds(QSqlDatabase& db)
+{
+    QList<int> ids;
+    QSqlQuery query("SELECT DISTINCT taskId FROM crawler_chunks", db);
+    while (query.next()) {
+        ids.append(query.value(0).toInt());
+    }
+    return ids;
+}
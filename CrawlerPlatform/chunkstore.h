@@ -0,0 +1,49 @@
+#ifndef CHUNKSTORE_H
+#define CHUNKSTORE_H
+
+#include <QList>
+#include <QMap>
+#include <QPair>
+#include <QSqlDatabase>
+#include <functional>
+
+// 已封存的压缩数据块（crawler_chunks）
+// 每个任务每小时一块，Gorilla 编码（时间戳为 Unix 秒）；原始行封存后从 crawler_data 删除
+// 保留了原始文本的行（hasRawText）不封存，留在原始表中由保留策略按 rawDays 删除
+// 读取接口把块内数据点与尚未封存的原始行合并返回，调用方无需区分
+class ChunkStore {
+public:
+    static const int kChunkSeconds = 3600;
+
+    static bool createSchema(QSqlDatabase& db);
+
+    // 批次之间调用（后台任务在此让出写锁），返回 false 时提前结束
+    using Yield = std::function<bool()>;
+
+    // 把 cutoffSecs 所在小时之前的原始数据封存为压缩块，返回封存的点数（失败返回 -1）
+    // 每个小时块使用独立的短事务；迟到的数据会与已有块合并
+    static qint64 sealBefore(QSqlDatabase& db, int taskId, qint64 cutoffSecs, const Yield& yield = Yield());
+
+    // 按时间升序访问 [fromSecs, toSecs] 内已封存的数据点
+    using Visitor = std::function<void(qint64 secs, double value)>;
+    static bool scan(QSqlDatabase& db, int taskId, qint64 fromSecs, qint64 toSecs, const Visitor& visitor);
+
+    // 最新的 limit 个已封存数据点（按时间升序），从最后一块向前只解码需要的块；
+    // 最后时间早于 notBeforeSecs 的块不再读取（调用方已有更新的点）
+    static QList<QPair<qint64, double>> latest(QSqlDatabase& db, int taskId, int limit, qint64 notBeforeSecs);
+
+    // 替换已封存数据点的值（按秒级时间戳匹配），返回替换的点数（失败返回 -1）
+    // 不开启事务，由调用方包在写事务中
+    static qint64 replaceValues(QSqlDatabase& db, int taskId, const QMap<qint64, double>& values);
+
+    // 删除整块早于 cutoffSecs 的数据（分批删除），返回删除的点数
+    static qint64 pruneBefore(QSqlDatabase& db, int taskId, qint64 cutoffSecs, const Yield& yield = Yield());
+
+    // 最后一个已封存数据点的时间（Unix 秒），没有封存数据时返回 0
+    static qint64 lastSealedSecs(QSqlDatabase& db, int taskId);
+
+    // 有封存数据的任务
+    static QList<int> taskIds(QSqlDatabase& db);
+};
+
+#endif // CHUNKSTORE_H
@@ -0,0 +1,63 @@
+# 爬虫核心模块（线程、数据库），供主程序与基准测试工程共用
+QT += core network sql
+
+INCLUDEPATH += $$PWD
+DEPENDPATH += $$PWD
+
+SOURCES += $$PWD/crawlerthread.cpp \
+           $$PWD/databasemanager.cpp \
+           $$PWD/metrics.cpp \
+           $$PWD/metricsserver.cpp \
+           $$PWD/tracing.cpp \
+           $$PWD/simulation.cpp \
+           $$PWD/rollupstore.cpp \
+           $$PWD/retention.cpp \
+           $$PWD/segmentstore.cpp \
+           $$PWD/gorilla.cpp \
+           $$PWD/quantilesketch.cpp \
+           $$PWD/chunkstore.cpp \
+           $$PWD/responsearchive.cpp \
+           $$PWD/fulltextindex.cpp \
+           $$PWD/xxhash64.cpp \
+           $$PWD/taskregistry.cpp \
+           $$PWD/taskimport.cpp \
+           $$PWD/schedulestore.cpp \
+           $$PWD/workerhost.cpp \
+           $$PWD/dataexport.cpp \
+           $$PWD/backup.cpp
+
+HEADERS += $$PWD/crawlerthread.h \
+           $$PWD/databasemanager.h \
+           $$PWD/metrics.h \
+           $$PWD/metricsserver.h \
+           $$PWD/tracing.h \
+           $$PWD/simulation.h \
+           $$PWD/rollupstore.h \
+           $$PWD/retention.h \
+           $$PWD/segmentstore.h \
+           $$PWD/gorilla.h \
+           $$PWD/quantilesketch.h \
+           $$PWD/chunkstore.h \
+           $$PWD/responsearchive.h \
+           $$PWD/fulltextindex.h \
+           $$PWD/xxhash64.h \
+           $$PWD/taskregistry.h \
+           $$PWD/taskimport.h \
+           $$PWD/schedulestore.h \
+           $$PWD/workerhost.h \
+           $$PWD/dataexport.h \
+           $$PWD/backup.h \
+           $$PWD/fastrandom.h
+
+# 响应归档使用 zstd 并按主机训练字典（qmake CONFIG+=zstd，需要 libzstd）；未开启时退回 zlib
+zstd {
+    DEFINES += CRAWLER_HAVE_ZSTD
+    LIBS += -lzstd
+}
+
+# 在线备份使用 SQLite 备份接口分步复制（qmake CONFIG+=sqlite_api，需要 libsqlite3，
+# 且 Qt 的 SQLite 驱动须以 -system-sqlite 构建，与之共用同一份库）；未开启时退回 VACUUM INTO
+sqlite_api {
+    DEFINES += CRAWLER_HAVE_SQLITE_API
+    LIBS += -lsqlite3
+}
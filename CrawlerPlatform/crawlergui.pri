@@ -0,0 +1,14 @@
+# 界面模块，供主程序与界面基准工程共用
+QT += gui widgets charts
+
+SOURCES += $$PWD/mainwindow.cpp \
+           $$PWD/metricspanel.cpp \
+           $$PWD/searchpanel.cpp \
+           $$PWD/tasktablemodel.cpp \
+           $$PWD/loadgeneratordialog.cpp
+
+HEADERS += $$PWD/mainwindow.h \
+           $$PWD/metricspanel.h \
+           $$PWD/searchpanel.h \
+           $$PWD/tasktablemodel.h \
+           $$PWD/loadgeneratordialog.h
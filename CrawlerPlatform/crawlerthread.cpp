@@ -1,195 +1,548 @@
-#include "crawlerthread.h"
-#include <QDebug>
-#include <QUrl>
-#include <QDateTime>
-#include <QNetworkRequest>
-#include <QRegularExpression>
-#include <cstdlib>
-
-CrawlerThread::CrawlerThread(int taskId, QObject *parent)
-    : QThread(parent)
-    , m_taskId(taskId)
-    , m_isRunning(false)
-    , m_interval(5)
-    , m_url("")
-    , m_rule("")
-    , m_nam(new QNetworkAccessManager(this))
-{
-    // 加载任务信息
-    CrawlerTask task = DatabaseManager::getTaskById(taskId);
-    if (task.id != 0) {
-        m_url = task.url;
-        m_rule = task.rule;
-        m_interval = task.interval > 0 ? task.interval : 5;
-        qDebug() << "线程初始化成功，任务ID：" << taskId << "URL：" << m_url;
-    } else {
-        qWarning() << "任务ID" << taskId << "不存在，线程无法启动";
-        m_isRunning = false;
-    }
-
-    // 绑定网络响应槽函数
-    connect(m_nam, &QNetworkAccessManager::finished, this, &CrawlerThread::onReplyFinished);
-
-    // 初始化随机数
-    srand(static_cast<unsigned int>(QDateTime::currentMSecsSinceEpoch()));
-}
-
-CrawlerThread::~CrawlerThread()
-{
-    stopCrawling();
-    if (m_nam) {
-        m_nam->deleteLater();
-        m_nam = nullptr;
-    }
-    qDebug() << "线程销毁，任务ID：" << m_taskId;
-}
-
-void CrawlerThread::startCrawling()
-{
-    if (m_isRunning) {
-        qDebug() << "任务" << m_taskId << "已在运行";
-        emit logMessage(QString("任务[%1] 已在运行，无需重复启动").arg(m_taskId));
-        return;
-    }
-
-    if (m_url.isEmpty()) {
-        qWarning() << "任务" << m_taskId << "URL为空，无法启动";
-        emit logMessage(QString("任务[%1] URL为空，启动失败").arg(m_taskId));
-        return;
-    }
-
-    m_isRunning = true;
-    if (!isRunning()) {
-        start(QThread::LowPriority);
-    }
-
-    emit statusUpdated(m_taskId, "已启动");
-    emit logMessage(QString("任务[%1] 启动爬虫，目标URL：%2").arg(m_taskId).arg(m_url));
-}
-
-void CrawlerThread::stopCrawling()
-{
-    if (!m_isRunning) {
-        qDebug() << "任务" << m_taskId << "未运行";
-        emit logMessage(QString("任务[%1] 未运行，无需停止").arg(m_taskId));
-        return;
-    }
-
-    m_isRunning = false;
-    if (isRunning()) {
-        quit();
-        wait(5000);
-    }
-
-    emit statusUpdated(m_taskId, "已停止");
-    emit logMessage(QString("任务[%1] 停止爬虫").arg(m_taskId));
-}
-
-void CrawlerThread::run()
-{
-    emit logMessage(QString("任务[%1] 线程启动，间隔：%2秒").arg(m_taskId).arg(m_interval));
-
-    while (m_isRunning) {
-        crawlOnce();
-        if (m_isRunning && m_interval > 0) {
-            msleep(static_cast<unsigned int>(m_interval * 1000));
-        }
-    }
-
-    emit logMessage(QString("任务[%1] 线程退出").arg(m_taskId));
-}
-
-void CrawlerThread::crawlOnce()
-{
-    if (!m_isRunning) return;
-
-    emit statusUpdated(m_taskId, "正在爬取...");
-    emit logMessage(QString("任务[%1] 模拟爬取：%2").arg(m_taskId).arg(m_url));
-
-    // 生成随机数模拟爬取结果
-    double randomValue = generateRandomValue();
-
-    // 构造数据
-    CrawlerData data;
-    data.taskId = m_taskId;
-    data.content = QString::number(randomValue, 'f', 2);
-    data.value = randomValue;
-    data.crawlTime = QDateTime::currentDateTime();
-
-    // 保存数据（调用线程安全的静态方法）
-    bool saveOk = DatabaseManager::saveCrawlerData(data);
-    if (saveOk) {
-        emit statusUpdated(m_taskId, "爬取成功");
-        emit logMessage(QString("任务[%1] 模拟爬取成功：数值=%2").arg(m_taskId).arg(randomValue));
-        emit dataCrawled(m_taskId, data);
-    } else {
-        emit statusUpdated(m_taskId, "数据保存失败");
-        emit logMessage(QString("任务[%1] 数据写入数据库失败").arg(m_taskId));
-    }
-}
-
-double CrawlerThread::generateRandomValue()
-{
-    return static_cast<double>(rand() % 1000) / 10.0; // 0~99.9
-}
-
-double CrawlerThread::parseValue(const QString& html, const QString& rule)
-{
-    if (html.isEmpty()) return generateRandomValue();
-
-    QString regexStr = rule.isEmpty() ? "\\d+\\.?\\d*" : rule;
-    QRegularExpression re(regexStr);
-    QRegularExpressionMatchIterator it = re.globalMatch(html);
-
-    double value = 0.0;
-    if (it.hasNext()) {
-        bool ok = false;
-        value = it.next().captured().toDouble(&ok);
-        if (!ok) value = generateRandomValue();
-    } else {
-        value = generateRandomValue();
-    }
-    return value;
-}
-
-void CrawlerThread::onReplyFinished(QNetworkReply* reply)
-{
-    if (!reply) {
-        emit logMessage(QString("任务[%1] 爬取失败：空响应").arg(m_taskId));
-        emit statusUpdated(m_taskId, "爬取失败");
-        return;
-    }
-
-    if (reply->error() != QNetworkReply::NoError) {
-        emit logMessage(QString("任务[%1] 爬取失败：%2（URL：%3）")
-                            .arg(m_taskId)
-                            .arg(reply->errorString())
-                            .arg(reply->url().toString()));
-        emit statusUpdated(m_taskId, "爬取失败");
-        reply->deleteLater();
-        return;
-    }
-
-    // 解析响应
-    QByteArray data = reply->readAll();
-    QString html = QString::fromUtf8(data.isEmpty() ? "0" : data);
-    double value = parseValue(html, m_rule);
-
-    // 保存数据
-    CrawlerData crawlerData;
-    crawlerData.taskId = m_taskId;
-    crawlerData.content = QString::number(value, 'f', 2);
-    crawlerData.value = value;
-    crawlerData.crawlTime = QDateTime::currentDateTime();
-
-    bool saveOk = DatabaseManager::saveCrawlerData(crawlerData);
-    if (saveOk) {
-        emit statusUpdated(m_taskId, "爬取成功");
-        emit logMessage(QString("任务[%1] 爬取成功：数值=%2").arg(m_taskId).arg(value));
-        emit dataCrawled(m_taskId, crawlerData);
-    } else {
-        emit statusUpdated(m_taskId, "数据保存失败");
-    }
-
-    reply->deleteLater();
-}
+#include "crawlerthread.h"
+#include "metrics.h"
+#include "tracing.h"
+#include "responsearchive.h"
+#include "xxhash64.h"
+#include "taskregistry.h"
+#include "schedulestore.h"
+#include <QDebug>
+#include <QUrl>
+#include <QDateTime>
+#include <QNetworkRequest>
+#include <QEventLoop>
+#include <QElapsedTimer>
+#include <QRegularExpression>
+#include <QRandomGenerator>
+
+// 单次请求超时（毫秒）
+static const int kRequestTimeoutMs = 15000;
+
+// 爬取流程指标（首次使用时注册，之后只做原子累加）
+struct CrawlerMetrics {
+    MetricHistogram* fetchLatency;
+    MetricHistogram* responseBytes;
+    MetricHistogram* parseTime;
+    MetricHistogram* parseSaved;
+    MetricCounter* unchanged;
+    MetricCounter* reconfigured;
+    MetricCounter* fetches;
+    MetricCounter* bytes;
+    QMap<QString, MetricCounter*> errors;
+
+    static const CrawlerMetrics& get()
+    {
+        static const CrawlerMetrics metrics = []() {
+            MetricsRegistry& registry = MetricsRegistry::instance();
+            CrawlerMetrics m;
+            m.fetchLatency = registry.histogram("crawler_fetch_duration_seconds", "HTTP请求耗时");
+            m.responseBytes = registry.histogram("crawler_response_size_bytes", "响应体大小", {}, 1.0,
+                                                 MetricsRegistry::sizeBounds());
+            m.parseTime = registry.histogram("crawler_parse_duration_seconds", "数值解析耗时");
+            m.parseSaved = registry.histogram("crawler_parse_saved_seconds",
+                                              "响应体未变化时跳过解析节省的耗时（按近期解析耗时估算，_sum 为累计节省）");
+            m.unchanged = registry.counter("crawler_body_unchanged_total", "响应体与上次相同、跳过解析的次数");
+            m.reconfigured = registry.counter("crawler_task_reconfigured_total", "运行中的任务热更新配置的次数");
+            m.fetches = registry.counter("crawler_fetches_total", "完成的HTTP请求数");
+            m.bytes = registry.counter("crawler_response_bytes_total", "累计响应字节数");
+            for (const char* cls : {"timeout", "connection", "tls", "proxy", "http", "protocol", "other", "db"}) {
+                m.errors[cls] = registry.counter("crawler_errors_total", "按类别统计的爬取错误",
+                                                 {{"class", cls}});
+            }
+            return m;
+        }();
+        return metrics;
+    }
+};
+
+// 网络错误归类（对应 QNetworkReply::NetworkError 的分段）
+static QString errorClass(QNetworkReply::NetworkError error)
+{
+    int code = static_cast<int>(error);
+    if (error == QNetworkReply::TimeoutError || error == QNetworkReply::OperationCanceledError) {
+        return "timeout"; // 传输超时以取消的形式结束
+    }
+    if (error == QNetworkReply::SslHandshakeFailedError) return "tls";
+    if (code >= 1 && code < 100) return "connection";
+    if (code >= 101 && code < 200) return "proxy";
+    if ((code >= 201 && code < 300) || (code >= 401 && code < 500)) return "http";
+    if (code >= 301 && code < 400) return "protocol";
+    return "other";
+}
+
+CrawlerThread::CrawlerThread(int taskId, QObject *parent)
+    : QThread(parent)
+    , m_taskId(taskId)
+    , m_isRunning(false)
+    , m_config(std::make_shared<CrawlerConfig>())
+    , m_nam(nullptr)
+    , m_rng(QRandomGenerator::global()->generate64())
+{
+    // 加载任务信息
+    CrawlerTask task = TaskRegistry::instance().task(taskId);
+    if (task.id != 0) {
+        m_config = buildConfig(task, nullptr);
+        qDebug() << "线程初始化成功，任务ID：" << taskId << "URL：" << task.url;
+    } else {
+        qWarning() << "任务ID" << taskId << "不存在，线程无法启动";
+        m_isRunning = false;
+    }
+
+    // 线程名用于调试器与追踪导出
+    setObjectName(QString("CrawlerThread-%1").arg(taskId));
+}
+
+CrawlerThread::~CrawlerThread()
+{
+    stopCrawling();
+    qDebug() << "线程销毁，任务ID：" << m_taskId;
+}
+
+std::shared_ptr<const CrawlerConfig> CrawlerThread::buildConfig(const CrawlerTask& task,
+                                                                const CrawlerConfig* previous)
+{
+    auto config = std::make_shared<CrawlerConfig>();
+    config->url = task.url;
+    config->rule = task.rule;
+    config->interval = task.interval > 0 ? task.interval : 5;
+    config->changeTolerance = task.changeTolerance;
+    config->keepRawText = task.keepRawText;
+    if (previous && previous->rule == task.rule) {
+        // 规则未变，沿用已编译的正则
+        config->ruleRegex = previous->ruleRegex;
+        config->ruleGeneration = previous->ruleGeneration;
+    } else {
+        config->ruleRegex = QRegularExpression(rulePattern(task.rule));
+        config->ruleRegex.optimize();
+        config->ruleGeneration = previous ? previous->ruleGeneration + 1 : 0;
+        if (!config->ruleRegex.isValid()) {
+            qWarning() << "任务" << task.id << "提取规则无效：" << config->ruleRegex.errorString();
+        }
+    }
+    return config;
+}
+
+std::shared_ptr<const CrawlerConfig> CrawlerThread::config() const
+{
+    QMutexLocker locker(&m_wakeMutex);
+    return m_config;
+}
+
+void CrawlerThread::reconfigure(const CrawlerTask& task)
+{
+    if (task.id != m_taskId) return;
+
+    int oldInterval = 0;
+    {
+        QMutexLocker locker(&m_wakeMutex);
+        const CrawlerConfig& current = *m_config;
+        if (current.url == task.url && current.rule == task.rule
+            && current.interval == (task.interval > 0 ? task.interval : 5)
+            && current.changeTolerance == task.changeTolerance && current.keepRawText == task.keepRawText) {
+            return; // 只改了名称等与爬取无关的字段
+        }
+        oldInterval = current.interval;
+        m_config = buildConfig(task, &current);
+        // 等待中的线程按新间隔重新计算下一轮时间
+        m_wakeCondition.wakeAll();
+    }
+
+    CrawlerMetrics::get().reconfigured->inc();
+    emit logMessage(QString("任务[%1] 配置已更新（间隔 %2→%3 秒），下一轮生效")
+                        .arg(m_taskId).arg(oldInterval).arg(task.interval > 0 ? task.interval : 5));
+}
+
+void CrawlerThread::startCrawling(qint64 initialDelayMs)
+{
+    if (m_isRunning) {
+        qDebug() << "任务" << m_taskId << "已在运行";
+        emit logMessage(QString("任务[%1] 已在运行，无需重复启动").arg(m_taskId));
+        return;
+    }
+
+    const QString url = config()->url;
+    if (url.isEmpty()) {
+        qWarning() << "任务" << m_taskId << "URL为空，无法启动";
+        emit logMessage(QString("任务[%1] URL为空，启动失败").arg(m_taskId));
+        return;
+    }
+
+    m_isRunning = true;
+    if (!isRunning()) {
+        m_startDelayMs = qMax<qint64>(0, initialDelayMs);
+        start(QThread::LowPriority);
+    }
+
+    emit statusUpdated(m_taskId, "已启动");
+    emit logMessage(QString("任务[%1] 启动爬虫，目标URL：%2").arg(m_taskId).arg(url));
+}
+
+void CrawlerThread::stopCrawling()
+{
+    if (!requestStop()) {
+        qDebug() << "任务" << m_taskId << "未运行";
+        emit logMessage(QString("任务[%1] 未运行，无需停止").arg(m_taskId));
+        return;
+    }
+    finishStop();
+}
+
+void CrawlerThread::stopAll(const QList<CrawlerThread*>& threads)
+{
+    // 先通知全部线程退出，再逐个等待，总耗时取决于最慢的一个而不是累加
+    QList<CrawlerThread*> stopping;
+    for (CrawlerThread* thread : threads) {
+        if (thread && thread->requestStop()) {
+            stopping.append(thread);
+        }
+    }
+    for (CrawlerThread* thread : std::as_const(stopping)) {
+        thread->finishStop();
+    }
+}
+
+bool CrawlerThread::requestStop()
+{
+    if (!m_isRunning.exchange(false)) {
+        return false;
+    }
+    // 唤醒处于轮次等待中的线程
+    QMutexLocker locker(&m_wakeMutex);
+    m_wakeCondition.wakeAll();
+    return true;
+}
+
+void CrawlerThread::finishStop()
+{
+    if (isRunning()) {
+        quit();
+        wait(5000);
+    }
+
+    emit statusUpdated(m_taskId, "已停止");
+    emit logMessage(QString("任务[%1] 停止爬虫").arg(m_taskId));
+}
+
+void CrawlerThread::run()
+{
+    emit logMessage(QString("任务[%1] 线程启动，间隔：%2秒").arg(m_taskId).arg(config()->interval));
+
+    // QNetworkAccessManager 必须在使用它的线程内创建
+    QNetworkAccessManager nam;
+    m_nam = &nam;
+
+    // 批量启动时按错开的延迟开始第一轮，避免同时发起连接与写入
+    m_roundDueUs = Tracer::nowUs() + m_startDelayMs * 1000;
+    if (m_startDelayMs > 0) {
+        waitUntil(m_roundDueUs);
+    }
+    while (m_isRunning) {
+        // 每轮取一次配置快照，本轮内不受并发修改影响
+        const std::shared_ptr<const CrawlerConfig> current = config();
+        const qint64 roundStartMs = QDateTime::currentMSecsSinceEpoch();
+        crawlOnce(*current);
+        // 记录本轮时间与下一轮计划（只写内存，周期性批量落库），重启后据此恢复相位
+        ScheduleStore::instance().recordRound(m_taskId, roundStartMs,
+                                              QDateTime::currentMSecsSinceEpoch()
+                                                  + static_cast<qint64>(current->interval) * 1000);
+        if (m_isRunning) {
+            waitForNextRound(Tracer::nowUs());
+        }
+    }
+
+    m_nam = nullptr;
+    emit logMessage(QString("任务[%1] 线程退出").arg(m_taskId));
+}
+
+void CrawlerThread::waitForNextRound(qint64 roundEndUs)
+{
+    QMutexLocker locker(&m_wakeMutex);
+    // 等待期间间隔被修改时仍以本轮结束时刻为起点重新计算，已超过新间隔则立即开始下一轮
+    while (m_isRunning) {
+        m_roundDueUs = roundEndUs + static_cast<qint64>(m_config->interval) * 1000000;
+        const qint64 remainingUs = m_roundDueUs - Tracer::nowUs();
+        if (remainingUs <= 0) break;
+        m_wakeCondition.wait(&m_wakeMutex, static_cast<unsigned long>((remainingUs + 999) / 1000));
+    }
+}
+
+void CrawlerThread::waitUntil(qint64 dueUs)
+{
+    QMutexLocker locker(&m_wakeMutex);
+    while (m_isRunning) {
+        const qint64 remainingUs = dueUs - Tracer::nowUs();
+        if (remainingUs <= 0) break;
+        m_wakeCondition.wait(&m_wakeMutex, static_cast<unsigned long>((remainingUs + 999) / 1000));
+    }
+}
+
+void CrawlerThread::crawlOnce(const CrawlerConfig& config)
+{
+    if (!m_isRunning) return;
+
+    // 按采样率决定本轮是否记录阶段追踪
+    Tracer& tracer = Tracer::instance();
+    tracer.beginRound(m_taskId);
+    const qint64 roundStartUs = Tracer::nowUs();
+    if (roundStartUs > m_roundDueUs) {
+        tracer.record("schedule_delay", "schedule", m_roundDueUs, roundStartUs);
+    }
+
+    emit statusUpdated(m_taskId, "正在爬取...");
+
+    // 非HTTP地址（如 sim://）沿用随机模拟数据
+    if (!config.url.startsWith("http", Qt::CaseInsensitive)) {
+        crawlSimulated(config);
+    } else {
+        crawlHttp(config);
+    }
+
+    tracer.record("crawl", "crawl", roundStartUs, Tracer::nowUs());
+    tracer.endRound();
+}
+
+void CrawlerThread::crawlHttp(const CrawlerConfig& config)
+{
+    emit logMessage(QString("任务[%1] 开始爬取：%2").arg(m_taskId).arg(config.url));
+
+    QElapsedTimer timer;
+    timer.start();
+
+    QNetworkRequest request{QUrl(config.url)};
+    request.setHeader(QNetworkRequest::UserAgentHeader, "QtCrawler/1.0");
+    request.setTransferTimeout(kRequestTimeoutMs);
+
+    // 在工作线程内同步等待响应
+    const qint64 fetchStartUs = Tracer::nowUs();
+    QNetworkReply* reply = m_nam->get(request);
+    QEventLoop loop;
+    connect(reply, &QNetworkReply::finished, &loop, &QEventLoop::quit);
+
+    // 响应体边到达边计算哈希，等待网络的同时完成摘要
+    QByteArray body;
+    XxHash64 bodyHasher;
+    connect(reply, &QNetworkReply::readyRead, &loop, [&]() {
+        const QByteArray chunk = reply->readAll();
+        bodyHasher.update(chunk);
+        body.append(chunk);
+    });
+
+    // 采样轮次记录连接各阶段的时间点（复用连接时不会触发连接/加密信号）
+    qint64 connectingUs = -1, encryptedUs = -1, sentUs = -1, headersUs = -1;
+    if (Tracer::instance().active()) {
+        connect(reply, &QNetworkReply::socketStartedConnecting, &loop, [&]() { connectingUs = Tracer::nowUs(); });
+#if QT_CONFIG(ssl)
+        connect(reply, &QNetworkReply::encrypted, &loop, [&]() { encryptedUs = Tracer::nowUs(); });
+#endif
+        connect(reply, &QNetworkReply::requestSent, &loop, [&]() { sentUs = Tracer::nowUs(); });
+        connect(reply, &QNetworkReply::metaDataChanged, &loop, [&]() {
+            if (headersUs < 0) headersUs = Tracer::nowUs();
+        });
+    }
+
+    if (!reply->isFinished()) {
+        loop.exec();
+    }
+    // 停止时 finishStop() 的 quit() 会让等待提前返回（quit 先于 exec 时立即返回）：
+    // 此时响应不完整且没有错误码，中止请求并丢弃，不能当作一次成功的爬取入库
+    if (!reply->isFinished() || !m_isRunning) {
+        reply->abort();
+        reply->deleteLater();
+        emit logMessage(QString("任务[%1] 已停止，取消进行中的请求").arg(m_taskId));
+        return;
+    }
+    const QByteArray rest = reply->readAll();
+    if (!rest.isEmpty()) {
+        bodyHasher.update(rest);
+        body.append(rest);
+    }
+    const qint64 fetchEndUs = Tracer::nowUs();
+    qint64 fetchUs = timer.nsecsElapsed() / 1000;
+
+    if (Tracer::instance().active()) {
+        Tracer& tracer = Tracer::instance();
+        tracer.record("fetch", "net", fetchStartUs, fetchEndUs);
+        if (connectingUs >= 0) {
+            // 发起请求到开始连接：DNS解析与连接排队
+            tracer.record("resolve", "net", fetchStartUs, connectingUs);
+            if (encryptedUs >= 0) {
+                tracer.record("tcp_tls_connect", "net", connectingUs, encryptedUs);
+            } else if (sentUs >= 0) {
+                tracer.record("tcp_connect", "net", connectingUs, sentUs);
+            }
+        }
+        if (sentUs >= 0 && headersUs >= 0) {
+            tracer.record("wait_response", "net", sentUs, headersUs);
+        }
+        if (headersUs >= 0) {
+            tracer.record("transfer", "net", headersUs, fetchEndUs);
+        }
+    }
+    CrawlerMetrics::get().fetchLatency->record(static_cast<quint64>(fetchUs));
+    CrawlerMetrics::get().fetches->inc();
+
+    bool success = onReplyFinished(reply, body, bodyHasher.digest(), config);
+    emit crawlFinished(m_taskId, success, fetchUs, timer.nsecsElapsed() / 1000);
+}
+
+void CrawlerThread::crawlSimulated(const CrawlerConfig& config)
+{
+    emit logMessage(QString("任务[%1] 模拟爬取：%2").arg(m_taskId).arg(config.url));
+
+    // URL（数值过程参数）变化后重建模拟过程
+    if (config.url != m_simulationUrl) {
+        m_simulation = SimulatedValueSource::fromUrl(config.url);
+        m_simulationUrl = config.url;
+    }
+
+    QElapsedTimer timer;
+    timer.start();
+
+    // 按URL中配置的数值过程生成模拟结果
+    double randomValue = m_simulation.next(m_rng);
+
+    // 构造数据
+    CrawlerData data;
+    data.taskId = m_taskId;
+    data.flags = DataFlagSimulated;
+    data.timestampMs = QDateTime::currentMSecsSinceEpoch();
+    data.value = randomValue;
+
+    // 保存数据（调用线程安全的静态方法）
+    bool saveOk = DatabaseManager::saveCrawlerData(data, config.changeTolerance);
+    if (saveOk) {
+        emit statusUpdated(m_taskId, "爬取成功");
+        emit logMessage(QString("任务[%1] 模拟爬取成功：数值=%2").arg(m_taskId).arg(randomValue));
+        markDataEmit();
+        emit dataCrawled(m_taskId, data);
+    } else {
+        emit statusUpdated(m_taskId, "数据保存失败");
+        emit logMessage(QString("任务[%1] 数据写入数据库失败").arg(m_taskId));
+    }
+    emit crawlFinished(m_taskId, saveOk, 0, timer.nsecsElapsed() / 1000);
+}
+
+void CrawlerThread::markDataEmit()
+{
+    // 采样轮次记下投递时间，界面线程处理时据此记录排队延迟
+    m_tracedEmitUs.store(Tracer::instance().active() ? Tracer::nowUs() : -1);
+}
+
+qint64 CrawlerThread::takeTracedEmitUs()
+{
+    return m_tracedEmitUs.exchange(-1);
+}
+
+double CrawlerThread::generateRandomValue()
+{
+    return static_cast<double>(m_rng.bounded(1000)) / 10.0; // 0~99.9
+}
+
+QString CrawlerThread::rulePattern(const QString& rule)
+{
+    return rule.isEmpty() ? QStringLiteral("\\d+\\.?\\d*") : rule;
+}
+
+bool CrawlerThread::extractValue(const QString& html, const QRegularExpression& re, double* value,
+                                 QString* matchedText)
+{
+    const QRegularExpressionMatch match = re.match(html);
+    if (!match.hasMatch()) return false;
+
+    bool ok = false;
+    const QString captured = match.captured();
+    *value = captured.toDouble(&ok);
+    if (ok && matchedText) *matchedText = captured;
+    return ok;
+}
+
+double CrawlerThread::parseValue(const QString& html, const QRegularExpression& re, QString* matchedText)
+{
+    if (html.isEmpty()) return generateRandomValue();
+
+    double value = 0.0;
+    if (!extractValue(html, re, &value, matchedText)) {
+        value = generateRandomValue();
+    }
+    return value;
+}
+
+bool CrawlerThread::onReplyFinished(QNetworkReply* reply, const QByteArray& data, quint64 bodyHash,
+                                    const CrawlerConfig& config)
+{
+    if (!reply) {
+        emit logMessage(QString("任务[%1] 爬取失败：空响应").arg(m_taskId));
+        emit statusUpdated(m_taskId, "爬取失败");
+        return false;
+    }
+
+    // 停止时中止的请求是取消，不是失败（运行中的 OperationCanceledError 为传输超时）
+    if (reply->error() == QNetworkReply::OperationCanceledError && !m_isRunning) {
+        emit logMessage(QString("任务[%1] 请求已取消").arg(m_taskId));
+        reply->deleteLater();
+        return false;
+    }
+    if (reply->error() != QNetworkReply::NoError) {
+        CrawlerMetrics::get().errors.value(errorClass(reply->error()))->inc();
+        emit logMessage(QString("任务[%1] 爬取失败：%2（URL：%3）")
+                            .arg(m_taskId)
+                            .arg(reply->errorString())
+                            .arg(reply->url().toString()));
+        emit statusUpdated(m_taskId, "爬取失败");
+        reply->deleteLater();
+        return false;
+    }
+
+    // 解析响应
+    const qint64 fetchedAtMs = QDateTime::currentMSecsSinceEpoch();
+    // 开启归档时原样保存响应体（后台线程压缩入库），时间戳与数据点一致，便于重新提取后回写
+    ResponseArchive::instance().enqueue(m_taskId, fetchedAtMs, reply->url().host(), data);
+    CrawlerMetrics::get().responseBytes->record(static_cast<quint64>(data.size()));
+    CrawlerMetrics::get().bytes->inc(static_cast<quint64>(data.size()));
+
+    // 很多服务端忽略条件请求，但大多数时候返回逐字节相同的内容：
+    // 哈希与上次一致时沿用上次的数值，不再解析，入库按容差 0 合并为心跳（只延长上一行的 lastSeen）
+    // 规则修改后上次的数值已不可用，必须重新解析
+    const bool unchanged = m_hasLastBody && bodyHash == m_lastBodyHash
+                           && m_lastRuleGeneration == config.ruleGeneration;
+    double value = m_lastValue;
+    QString rawText;
+    if (unchanged) {
+        CrawlerMetrics::get().unchanged->inc();
+        CrawlerMetrics::get().parseSaved->record(static_cast<quint64>(m_parseCostUs));
+    } else {
+        TraceSpan parseSpan("parse", "parse");
+        QElapsedTimer parseClock;
+        parseClock.start();
+        QString html = QString::fromUtf8(data.isEmpty() ? "0" : data);
+        value = parseValue(html, config.ruleRegex, config.keepRawText ? &rawText : nullptr);
+        const qint64 costUs = parseClock.nsecsElapsed() / 1000;
+        CrawlerMetrics::get().parseTime->record(static_cast<quint64>(costUs));
+        m_parseCostUs = m_hasLastBody ? (m_parseCostUs * 7 + costUs) / 8 : costUs;
+    }
+
+    // 保存数据
+    CrawlerData crawlerData;
+    crawlerData.taskId = m_taskId;
+    crawlerData.flags = rawText.isEmpty() ? DataFlagNone : DataFlagHasRawText;
+    crawlerData.timestampMs = fetchedAtMs;
+    crawlerData.value = value;
+
+    const double tolerance = unchanged ? qMax(0.0, config.changeTolerance) : config.changeTolerance;
+    bool saveOk = DatabaseManager::saveCrawlerData(crawlerData, tolerance, rawText);
+    if (saveOk) {
+        m_hasLastBody = true;
+        m_lastBodyHash = bodyHash;
+        m_lastRuleGeneration = config.ruleGeneration;
+        m_lastValue = value;
+        emit statusUpdated(m_taskId, "爬取成功");
+        emit logMessage(QString("任务[%1] 爬取成功：数值=%2").arg(m_taskId).arg(value));
+        markDataEmit();
+        emit dataCrawled(m_taskId, crawlerData);
+    } else {
+        CrawlerMetrics::get().errors.value("db")->inc();
+        emit statusUpdated(m_taskId, "数据保存失败");
+    }
+
+    reply->deleteLater();
+    return saveOk;
+}
@@ -1,45 +1,114 @@
-#ifndef CRAWLERTHREAD_H
-#define CRAWLERTHREAD_H
-
-#include <QThread>
-#include <QNetworkAccessManager>
-#include <QNetworkReply>
-#include <QString>
-#include "databasemanager.h"
-
-class CrawlerThread : public QThread
-{
-    Q_OBJECT
-
-public:
-    explicit CrawlerThread(int taskId, QObject *parent = nullptr);
-    ~CrawlerThread() override;
-
-    // 控制接口
-    void startCrawling();
-    void stopCrawling();
-
-signals:
-    void statusUpdated(int taskId, const QString& status);
-    void logMessage(const QString& message);
-    void dataCrawled(int taskId, const CrawlerData& data);
-
-protected:
-    void run() override;
-
-private:
-    void crawlOnce();
-    double generateRandomValue();
-    double parseValue(const QString& html, const QString& rule);
-    void onReplyFinished(QNetworkReply* reply);
-
-    // 成员变量
-    int m_taskId;
-    bool m_isRunning;
-    int m_interval;
-    QString m_url;
-    QString m_rule;
-    QNetworkAccessManager* m_nam;
-};
-
-#endif // CRAWLERTHREAD_H
+#ifndef CRAWLERTHREAD_H
+#define CRAWLERTHREAD_H
+
+#include <QThread>
+#include <QNetworkAccessManager>
+#include <QNetworkReply>
+#include <QString>
+#include <QRegularExpression>
+#include <QMutex>
+#include <QWaitCondition>
+#include <atomic>
+#include <memory>
+#include "databasemanager.h"
+#include "fastrandom.h"
+#include "simulation.h"
+
+// 任务运行配置（不可变，整体替换）
+// 运行中修改任务时构造一份新配置一次性发布，规则在发布时编译，工作线程每轮开始时取用当前配置
+struct CrawlerConfig {
+    QString url;
+    QString rule;
+    QRegularExpression ruleRegex;
+    int interval = 5;
+    double changeTolerance = -1.0; // 变化存储容差（<0 表示每次都存储）
+    bool keepRawText = false;      // 是否保存规则匹配到的原始文本
+    quint64 ruleGeneration = 0;    // 规则变化时递增，响应体去重据此失效
+};
+
+class CrawlerThread : public QThread
+{
+    Q_OBJECT
+    friend class MicroBench; // 基准测试直接测量解析路径
+
+public:
+    explicit CrawlerThread(int taskId, QObject *parent = nullptr);
+    ~CrawlerThread() override;
+
+    // 控制接口
+    // initialDelayMs：线程启动后延迟多久开始第一轮（批量启动时错开首轮）
+    void startCrawling(qint64 initialDelayMs = 0);
+    void stopCrawling();
+    // 批量停止：先通知全部线程再逐个等待
+    static void stopAll(const QList<CrawlerThread*>& threads);
+
+    // 运行中更新任务配置：无需停止线程，下一轮起生效
+    // 间隔变化时从上一轮结束时刻按新间隔重新计算等待，不打乱调度相位；配置未变化时不做任何事
+    void reconfigure(const CrawlerTask& task);
+    std::shared_ptr<const CrawlerConfig> config() const;
+
+    // 最近一次被采样的 dataCrawled 投递时间（微秒，读取后清除；-1 表示未采样）
+    qint64 takeTracedEmitUs();
+
+    // 提取规则对应的正则（空规则取第一个数字）
+    static QString rulePattern(const QString& rule);
+    // 取第一个匹配并转换为数值，未匹配或无法转换时返回 false（响应归档的重新提取也使用）
+    static bool extractValue(const QString& html, const QRegularExpression& re, double* value,
+                             QString* matchedText = nullptr);
+
+signals:
+    void statusUpdated(int taskId, const QString& status);
+    void logMessage(const QString& message);
+    void dataCrawled(int taskId, const CrawlerData& data);
+    // 单轮爬取结束（fetchUs：网络请求耗时，totalUs：请求+解析+入库总耗时，单位微秒）
+    void crawlFinished(int taskId, bool success, qint64 fetchUs, qint64 totalUs);
+
+protected:
+    void run() override;
+
+private:
+    static std::shared_ptr<const CrawlerConfig> buildConfig(const CrawlerTask& task,
+                                                            const CrawlerConfig* previous);
+    void crawlOnce(const CrawlerConfig& config);
+    void crawlHttp(const CrawlerConfig& config);
+    void crawlSimulated(const CrawlerConfig& config);
+    bool requestStop();
+    void finishStop();
+    void markDataEmit();
+    void waitUntil(qint64 dueUs);
+    void waitForNextRound(qint64 roundEndUs);
+    double generateRandomValue();
+    double parseValue(const QString& html, const QRegularExpression& re, QString* matchedText = nullptr);
+    bool onReplyFinished(QNetworkReply* reply, const QByteArray& data, quint64 bodyHash,
+                         const CrawlerConfig& config);
+
+    // 成员变量
+    int m_taskId;
+    std::atomic<bool> m_isRunning;
+    qint64 m_startDelayMs = 0;
+    // 当前配置（由 m_wakeMutex 保护，替换时唤醒等待中的线程）
+    std::shared_ptr<const CrawlerConfig> m_config;
+
+    // 上一次成功解析的响应体哈希与结果：响应体不变时跳过解析，只做心跳更新
+    bool m_hasLastBody = false;
+    quint64 m_lastBodyHash = 0;
+    quint64 m_lastRuleGeneration = 0;
+    double m_lastValue = 0.0;
+    qint64 m_parseCostUs = 0; // 解析耗时的滑动平均，用于估算跳过解析节省的 CPU
+    QNetworkAccessManager* m_nam; // 仅在run()期间有效，归属工作线程
+
+    // 本任务独立的随机数发生器与模拟数值过程（仅工作线程访问）
+    FastRandom m_rng;
+    SimulatedValueSource m_simulation;
+    QString m_simulationUrl; // m_simulation 对应的URL，URL变化时重建
+
+    // 追踪：本轮计划开始时间、采样轮次的数据投递时间
+    qint64 m_roundDueUs = 0;
+    std::atomic<qint64> m_tracedEmitUs{-1};
+
+    // 轮次间等待，停止或配置变化时可立即唤醒
+    mutable QMutex m_wakeMutex;
+    QWaitCondition m_wakeCondition;
+};
+
+#endif // CRAWLERTHREAD_H
@@ -1,258 +1,1596 @@
-#include "databasemanager.h"
-
-QMutex DatabaseManager::m_mutex;
-
-// 核心：获取线程独立的数据库连接
-QSqlDatabase DatabaseManager::getThreadDatabase() {
-    QMutexLocker locker(&m_mutex);
-
-    // 每个线程唯一连接名
-    QString connectionName = QString("sqlite_conn_%1_%2")
-                                 .arg((quintptr)QThread::currentThreadId())
-                                 .arg(QUuid::createUuid().toString(QUuid::WithoutBraces));
-
-    // 连接已存在且打开，直接返回
-    if (QSqlDatabase::contains(connectionName)) {
-        QSqlDatabase db = QSqlDatabase::database(connectionName);
-        if (db.isOpen()) {
-            return db;
-        }
-        // 连接存在但未打开，重新打开
-        if (db.open()) {
-            return db;
-        } else {
-            qCritical() << "线程" << QThread::currentThreadId()
-                << "重新打开数据库失败：" << db.lastError().text();
-            QSqlDatabase::removeDatabase(connectionName); // 移除无效连接
-        }
-    }
-
-    // 创建新连接
-    QSqlDatabase db = QSqlDatabase::addDatabase("QSQLITE", connectionName);
-    db.setDatabaseName("crawler_data.db"); // 共享数据库文件
-    db.setConnectOptions("QSQLITE_OPEN_READWRITE"); // 读写模式
-
-    // 打开数据库
-    if (!db.open()) {
-        qCritical() << "线程" << QThread::currentThreadId()
-            << "创建数据库连接失败：" << db.lastError().text();
-        return QSqlDatabase();
-    }
-
-    // 启用外键约束
-    QSqlQuery foreignKeyQuery(db);
-    if (!foreignKeyQuery.exec("PRAGMA foreign_keys = ON;")) {
-        qWarning() << "线程" << QThread::currentThreadId()
-            << "启用外键约束失败：" << foreignKeyQuery.lastError().text();
-    }
-
-    return db;
-}
-
-// 初始化数据表结构（主线程调用）
-bool DatabaseManager::initDatabaseSchema() {
-    QSqlDatabase db = getThreadDatabase();
-    if (!db.isOpen()) {
-        qCritical() << "数据库初始化失败：连接未打开";
-        return false;
-    }
-
-    // 创建任务表
-    QSqlQuery taskQuery(db);
-    QString taskSql = R"(
-        CREATE TABLE IF NOT EXISTS crawler_tasks (
-            id INTEGER PRIMARY KEY AUTOINCREMENT,
-            name TEXT NOT NULL,
-            url TEXT NOT NULL,
-            interval INTEGER DEFAULT 5,
-            rule TEXT DEFAULT ''
-        )
-    )";
-    if (!taskQuery.exec(taskSql)) {
-        qCritical() << "创建任务表失败：" << taskQuery.lastError().text();
-        return false;
-    }
-
-    // 创建数据表
-    QSqlQuery dataQuery(db);
-    QString dataSql = R"(
-        CREATE TABLE IF NOT EXISTS crawler_data (
-            id INTEGER PRIMARY KEY AUTOINCREMENT,
-            taskId INTEGER NOT NULL,
-            content TEXT NOT NULL,
-            value REAL NOT NULL,
-            crawlTime TEXT NOT NULL,
-            FOREIGN KEY (taskId) REFERENCES crawler_tasks(id) ON DELETE CASCADE
-        )
-    )";
-    if (!dataQuery.exec(dataSql)) {
-        qCritical() << "创建数据表失败：" << dataQuery.lastError().text();
-        return false;
-    }
-
-    qInfo() << "数据库表结构初始化成功";
-    return true;
-}
-
-// 保存任务（新增/更新）
-bool DatabaseManager::saveCrawlerTask(const CrawlerTask& task) {
-    QSqlDatabase db = getThreadDatabase();
-    if (!db.isOpen()) {
-        qCritical() << "保存任务失败：数据库未打开";
-        return false;
-    }
-
-    QSqlQuery query(db);
-    // 新增任务（ID=0）
-    if (task.id == 0) {
-        query.prepare(R"(
-            INSERT INTO crawler_tasks (name, url, interval, rule)
-            VALUES (:name, :url, :interval, :rule)
-        )");
-        query.bindValue(":name", task.name);
-        query.bindValue(":url", task.url);
-        query.bindValue(":interval", task.interval);
-        query.bindValue(":rule", task.rule);
-    }
-    // 更新任务（ID>0）
-    else {
-        query.prepare(R"(
-            UPDATE crawler_tasks
-            SET name = :name, url = :url, interval = :interval, rule = :rule
-            WHERE id = :id
-        )");
-        query.bindValue(":id", task.id);
-        query.bindValue(":name", task.name);
-        query.bindValue(":url", task.url);
-        query.bindValue(":interval", task.interval);
-        query.bindValue(":rule", task.rule);
-    }
-
-    if (!query.exec()) {
-        qWarning() << "保存任务失败：" << query.lastError().text();
-        return false;
-    }
-
-    // 新增任务返回自增ID
-    if (task.id == 0) {
-        qDebug() << "新增任务成功，自动生成ID：" << query.lastInsertId().toInt();
-    }
-
-    return true;
-}
-
-// 获取所有任务
-QList<CrawlerTask> DatabaseManager::getAllTasks() {
-    QList<CrawlerTask> tasks;
-    QSqlDatabase db = getThreadDatabase();
-    if (!db.isOpen()) {
-        qCritical() << "获取任务列表失败：数据库未打开";
-        return tasks;
-    }
-
-    QSqlQuery query("SELECT id, name, url, interval, rule FROM crawler_tasks", db);
-    while (query.next()) {
-        CrawlerTask task;
-        task.id = query.value(0).toInt();
-        task.name = query.value(1).toString();
-        task.url = query.value(2).toString();
-        task.interval = query.value(3).toInt();
-        task.rule = query.value(4).toString();
-        tasks.append(task);
-    }
-
-    return tasks;
-}
-
-// 根据ID获取任务
-CrawlerTask DatabaseManager::getTaskById(int taskId) {
-    CrawlerTask task;
-    QSqlDatabase db = getThreadDatabase();
-    if (!db.isOpen()) {
-        qCritical() << "查询任务失败：数据库未打开";
-        return task;
-    }
-
-    QSqlQuery query(db);
-    query.prepare("SELECT id, name, url, interval, rule FROM crawler_tasks WHERE id = :id");
-    query.bindValue(":id", taskId);
-
-    if (!query.exec()) {
-        qWarning() << "查询任务失败：" << query.lastError().text();
-        return task;
-    }
-
-    if (query.next()) {
-        task.id = query.value(0).toInt();
-        task.name = query.value(1).toString();
-        task.url = query.value(2).toString();
-        task.interval = query.value(3).toInt();
-        task.rule = query.value(4).toString();
-    } else {
-        qWarning() << "未找到任务ID：" << taskId;
-    }
-
-    return task;
-}
-
-// 保存爬取数据（多线程安全）
-bool DatabaseManager::saveCrawlerData(const CrawlerData& data) {
-    QSqlDatabase db = getThreadDatabase();
-    if (!db.isOpen()) {
-        qCritical() << "线程" << QThread::currentThreadId()
-            << "保存数据失败：数据库未打开";
-        return false;
-    }
-
-    QSqlQuery query(db);
-    query.prepare(R"(
-        INSERT INTO crawler_data (taskId, content, value, crawlTime)
-        VALUES (:taskId, :content, :value, :crawlTime)
-    )");
-    query.bindValue(":taskId", data.taskId);
-    query.bindValue(":content", data.content);
-    query.bindValue(":value", data.value);
-    query.bindValue(":crawlTime", data.crawlTime.toString("yyyy-MM-dd HH:mm:ss"));
-
-    if (!query.exec()) {
-        qCritical() << "线程" << QThread::currentThreadId()
-            << "保存爬取数据失败："
-            << "错误信息：" << query.lastError().text()
-            << "任务ID：" << data.taskId;
-        return false;
-    }
-
-    qDebug() << "线程" << QThread::currentThreadId()
-             << "保存数据成功，任务ID：" << data.taskId;
-    return true;
-}
-
-// 根据任务ID获取数据
-QList<CrawlerData> DatabaseManager::getTaskData(int taskId) {
-    QList<CrawlerData> datas;
-    QSqlDatabase db = getThreadDatabase();
-    if (!db.isOpen()) {
-        qCritical() << "查询爬取数据失败：数据库未打开";
-        return datas;
-    }
-
-    QSqlQuery query(db);
-    query.prepare("SELECT taskId, content, value, crawlTime FROM crawler_data WHERE taskId = :taskId");
-    query.bindValue(":taskId", taskId);
-
-    if (!query.exec()) {
-        qWarning() << "查询爬取数据失败：" << query.lastError().text();
-        return datas;
-    }
-
-    while (query.next()) {
-        CrawlerData data;
-        data.taskId = query.value(0).toInt();
-        data.content = query.value(1).toString();
-        data.value = query.value(2).toDouble();
-        data.crawlTime = QDateTime::fromString(query.value(3).toString(), "yyyy-MM-dd HH:mm:ss");
-        datas.append(data);
-    }
-
-    return datas;
-}
+#include "databasemanager.h"
+#include "metrics.h"
+#include "tracing.h"
+#include "segmentstore.h"
+#include "chunkstore.h"
+#include "taskregistry.h"
+#include "schedulestore.h"
+#include "workerhost.h"
+#include "quantilesketch.h"
+#include <QElapsedTimer>
+#include <QThreadStorage>
+#include <QHash>
+#include <limits>
+#include <algorithm>
+#include <cmath>
+
+// 数据库访问指标（首次使用时注册）
+struct DbMetrics {
+    MetricHistogram* insertData;
+    MetricHistogram* selectData;
+    MetricHistogram* selectTasks;
+    MetricHistogram* selectTask;
+    MetricHistogram* saveTask;
+    MetricHistogram* selectSeries;
+    MetricHistogram* selectStatistics;
+    MetricHistogram* searchText;
+    MetricCounter* collapsed;
+    MetricHistogram* mutexWait;
+    MetricCounter* busy;
+    MetricCounter* connections;
+    MetricGauge* asyncPending;
+    MetricCounter* asyncCanceled;
+    MetricGauge* dataShards;
+
+    static const DbMetrics& get()
+    {
+        static const DbMetrics metrics = []() {
+            MetricsRegistry& registry = MetricsRegistry::instance();
+            const QString name = "crawler_db_statement_duration_seconds";
+            const QString help = "SQL语句耗时（含结果读取）";
+            DbMetrics m;
+            m.insertData = registry.histogram(name, help, {{"op", "insert_data"}});
+            m.selectData = registry.histogram(name, help, {{"op", "select_data"}});
+            m.selectTasks = registry.histogram(name, help, {{"op", "select_tasks"}});
+            m.selectTask = registry.histogram(name, help, {{"op", "select_task"}});
+            m.saveTask = registry.histogram(name, help, {{"op", "save_task"}});
+            m.selectSeries = registry.histogram(name, help, {{"op", "select_series"}});
+            m.selectStatistics = registry.histogram(name, help, {{"op", "select_statistics"}});
+            m.searchText = registry.histogram(name, help, {{"op", "search_text"}});
+            m.collapsed = registry.counter("crawler_db_rows_collapsed_total", "变化存储模式下并入上一行的采样数");
+            m.mutexWait = registry.histogram("crawler_db_lock_wait_seconds", "获取连接时的互斥锁等待");
+            m.busy = registry.counter("crawler_db_busy_total", "SQLite 返回 BUSY/LOCKED 的次数");
+            m.connections = registry.counter("crawler_db_connections_opened_total", "新建的数据库连接数");
+            m.asyncPending = registry.gauge("crawler_db_async_pending", "读取线程池中排队或执行中的异步查询数");
+            m.asyncCanceled = registry.counter("crawler_db_async_canceled_total", "被取消而丢弃的异步查询数");
+            m.dataShards = registry.gauge("crawler_db_data_shards", "爬取数据分布的库文件数");
+            return m;
+        }();
+        return metrics;
+    }
+
+    // SQLite 错误码 5=SQLITE_BUSY，6=SQLITE_LOCKED
+    static void recordError(const QSqlError& error)
+    {
+        const QString code = error.nativeErrorCode();
+        if (code == "5" || code == "6") {
+            get().busy->inc();
+        }
+    }
+};
+
+QMutex DatabaseManager::m_mutex;
+QString DatabaseManager::m_databasePath = "crawler_data.db";
+DataBackend DatabaseManager::m_dataBackend = DataBackend::Sqlite;
+int DatabaseManager::m_dataShards = 1;
+bool DatabaseManager::m_fullTextIndex = false;
+
+void DatabaseManager::setDatabasePath(const QString& path) {
+    QMutexLocker locker(&m_mutex);
+    m_databasePath = path;
+}
+
+QString DatabaseManager::databasePath() {
+    QMutexLocker locker(&m_mutex);
+    return m_databasePath;
+}
+
+void DatabaseManager::setDataBackend(DataBackend backend) {
+    QMutexLocker locker(&m_mutex);
+    m_dataBackend = backend;
+}
+
+DataBackend DatabaseManager::dataBackend() {
+    QMutexLocker locker(&m_mutex);
+    return m_dataBackend;
+}
+
+void DatabaseManager::setFullTextIndexEnabled(bool enabled) {
+    QMutexLocker locker(&m_mutex);
+    m_fullTextIndex = enabled;
+}
+
+bool DatabaseManager::fullTextIndexEnabled() {
+    QMutexLocker locker(&m_mutex);
+    return m_fullTextIndex;
+}
+
+void DatabaseManager::setDataShardCount(int shards) {
+    QMutexLocker locker(&m_mutex);
+    m_dataShards = qBound(1, shards, 256);
+}
+
+int DatabaseManager::dataShardCount() {
+    QMutexLocker locker(&m_mutex);
+    return m_dataShards;
+}
+
+int DatabaseManager::dataShardOf(int taskId) {
+    QMutexLocker locker(&m_mutex);
+    return static_cast<int>(static_cast<uint>(taskId) % static_cast<uint>(m_dataShards));
+}
+
+QString DatabaseManager::dataShardPath(int shard) {
+    QMutexLocker locker(&m_mutex);
+    return m_dataShards <= 1 ? m_databasePath : dataShardPathLocked(shard);
+}
+
+// crawler_data.db -> crawler_data.shard0.db ...
+QString DatabaseManager::dataShardPathLocked(int shard) {
+    QString base = m_databasePath;
+    if (base.endsWith(".db")) {
+        base.chop(3);
+    }
+    return QString("%1.shard%2.db").arg(base).arg(shard);
+}
+
+// 界面查询并发度很低，两个读取线程足以让慢查询不阻塞后续请求
+static const int kReaderThreads = 2;
+
+QThreadPool* DatabaseManager::readerPool() {
+    static QThreadPool* pool = []() {
+        QThreadPool* p = new QThreadPool();
+        p->setMaxThreadCount(kReaderThreads);
+        p->setExpiryTimeout(-1); // 线程常驻，连接随之复用
+        p->setObjectName("DatabaseReaders");
+        return p;
+    }();
+    return pool;
+}
+
+void DatabaseManager::asyncQueued() {
+    DbMetrics::get().asyncPending->add(1);
+}
+
+void DatabaseManager::asyncFinished(bool canceled) {
+    DbMetrics::get().asyncPending->add(-1);
+    if (canceled) {
+        DbMetrics::get().asyncCanceled->inc();
+    }
+}
+
+void DatabaseManager::stopReaders() {
+    QThreadPool* pool = readerPool();
+    pool->clear(); // 尚未开始的查询直接丢弃（对应的 QFuture 随之取消）
+    pool->waitForDone();
+}
+
+QFuture<QList<CrawlerTask>> DatabaseManager::getAllTasksAsync() {
+    return readAsync([]() { return getAllTasks(); });
+}
+
+QFuture<CrawlerTask> DatabaseManager::getTaskByIdAsync(int taskId) {
+    return readAsync([taskId]() { return getTaskById(taskId); });
+}
+
+QFuture<QList<CrawlerData>> DatabaseManager::getTaskDataAsync(int taskId) {
+    return readAsync([taskId]() { return getTaskData(taskId); });
+}
+
+QFuture<QList<RollupPoint>> DatabaseManager::getTaskSeriesAsync(int taskId, const QDateTime& from,
+                                                                const QDateTime& to, int maxPoints) {
+    return readAsync([taskId, from, to, maxPoints]() { return getTaskSeries(taskId, from, to, maxPoints); });
+}
+
+QFuture<QHash<int, TaskLatest>> DatabaseManager::getLatestValuesAsync() {
+    return readAsync([]() { return getLatestValues(); });
+}
+
+QFuture<QList<SearchHit>> DatabaseManager::searchTextAsync(const QString& text, int limit) {
+    return readAsync([text, limit]() { return searchText(text, limit); });
+}
+
+QFuture<QHash<int, TaskStatistics>> DatabaseManager::getTasksStatisticsAsync(const QList<int>& taskIds,
+                                                                             const QDateTime& from,
+                                                                             const QDateTime& to) {
+    return readAsync([taskIds, from, to]() { return getTasksStatistics(taskIds, from, to); });
+}
+
+// 段存储上的序列查询：点数超出上限时在扫描中按桶聚合
+static QList<RollupPoint> segmentSeries(int taskId, qint64 fromSecs, qint64 toSecs, int maxPoints,
+                                        RollupResolution* usedResolution) {
+    SegmentStore& store = SegmentStore::instance();
+    const qint64 fromMs = fromSecs * 1000;
+    const qint64 toMs = toSecs * 1000 + 999;
+
+    RollupResolution resolution = RollupResolution::Raw;
+    if (store.count(taskId, fromMs, toMs) > maxPoints) {
+        resolution = RollupResolution::Day;
+        const qint64 span = qMax<qint64>(1, toSecs - fromSecs);
+        for (int candidate : RollupStore::resolutions()) {
+            if (span / candidate <= maxPoints) {
+                resolution = static_cast<RollupResolution>(candidate);
+                break;
+            }
+        }
+    }
+    if (usedResolution) {
+        *usedResolution = resolution;
+    }
+
+    QList<RollupPoint> points;
+    const int res = static_cast<int>(resolution);
+    // 缓存当前桶区间，避免每个点都做时区换算
+    qint64 bucketBegin = 0;
+    qint64 bucketEnd = 0;
+    store.scan(taskId, fromMs, toMs, [&](qint64 timestampMs, double value) {
+        const qint64 secs = timestampMs / 1000;
+        if (res == 0) {
+            RollupPoint point;
+            point.bucketStart = secs;
+            point.count = 1;
+            point.minValue = point.maxValue = point.sumValue = value;
+            point.firstValue = point.lastValue = value;
+            points.append(point);
+            return true;
+        }
+        if (points.isEmpty() || secs < bucketBegin || secs >= bucketEnd) {
+            bucketBegin = RollupStore::bucketStart(QDateTime::fromSecsSinceEpoch(secs), res);
+            bucketEnd = bucketBegin + res;
+            if (points.isEmpty() || points.last().bucketStart != bucketBegin) {
+                RollupPoint point;
+                point.bucketStart = bucketBegin;
+                point.minValue = point.maxValue = point.firstValue = value;
+                points.append(point);
+            }
+        }
+        RollupPoint& point = points.last();
+        point.count++;
+        point.minValue = qMin(point.minValue, value);
+        point.maxValue = qMax(point.maxValue, value);
+        point.sumValue += value;
+        point.lastValue = value;
+        return true;
+    });
+    return points;
+}
+
+// 每个线程每个库文件一个连接：首次使用时创建，线程退出时随 QThreadStorage 一并移除
+struct ThreadConnections {
+    QString databasePath;           // 创建时的主库路径，主库切换后全部重建
+    QHash<QString, QString> names;  // 库文件 -> 连接名
+    ~ThreadConnections()
+    {
+        for (const QString& name : std::as_const(names)) {
+            QSqlDatabase::removeDatabase(name);
+        }
+    }
+};
+static QThreadStorage<ThreadConnections*> s_threadConnections;
+
+// 核心：获取线程独立的数据库连接
+QSqlDatabase DatabaseManager::getThreadDatabase() {
+    QElapsedTimer waitTimer;
+    waitTimer.start();
+    QMutexLocker locker(&m_mutex);
+    DbMetrics::get().mutexWait->record(static_cast<quint64>(waitTimer.nsecsElapsed() / 1000));
+    return openThreadConnection(m_databasePath);
+}
+
+QSqlDatabase DatabaseManager::getShardDatabase(int shard) {
+    QElapsedTimer waitTimer;
+    waitTimer.start();
+    QMutexLocker locker(&m_mutex);
+    DbMetrics::get().mutexWait->record(static_cast<quint64>(waitTimer.nsecsElapsed() / 1000));
+    return openThreadConnection(m_dataShards <= 1 ? m_databasePath : dataShardPathLocked(shard));
+}
+
+QSqlDatabase DatabaseManager::getDataDatabase(int taskId) {
+    return getShardDatabase(dataShardOf(taskId));
+}
+
+QList<QSqlDatabase> DatabaseManager::dataDatabases() {
+    QList<QSqlDatabase> databases;
+    const int shards = dataShardCount();
+    for (int shard = 0; shard < shards; ++shard) {
+        databases.append(getShardDatabase(shard));
+    }
+    return databases;
+}
+
+QSqlDatabase DatabaseManager::openThreadConnection(const QString& path) {
+    ThreadConnections* connections = s_threadConnections.hasLocalData() ? s_threadConnections.localData() : nullptr;
+    if (connections && connections->databasePath != m_databasePath) {
+        // 数据库路径已切换，旧连接全部移除
+        s_threadConnections.setLocalData(nullptr);
+        connections = nullptr;
+    }
+    if (!connections) {
+        connections = new ThreadConnections{m_databasePath, {}};
+        s_threadConnections.setLocalData(connections);
+    }
+
+    // 已有连接：已打开时直接复用
+    auto it = connections->names.constFind(path);
+    if (it != connections->names.constEnd()) {
+        const QString connectionName = it.value();
+        {
+            QSqlDatabase db = QSqlDatabase::database(connectionName, false);
+            if (db.isOpen()) {
+                return db;
+            }
+            // 连接存在但未打开，重新打开
+            if (db.open()) {
+                return db;
+            }
+            qCritical() << "线程" << QThread::currentThreadId()
+                << "重新打开数据库失败：" << db.lastError().text();
+        }
+        // 连接失效，移除后重建
+        connections->names.remove(path);
+        QSqlDatabase::removeDatabase(connectionName);
+    }
+
+    // 每个线程每个库文件唯一连接名
+    QString connectionName = QString("sqlite_conn_%1_%2")
+                                 .arg((quintptr)QThread::currentThreadId())
+                                 .arg(QUuid::createUuid().toString(QUuid::WithoutBraces));
+
+    // 创建新连接
+    QSqlDatabase db = QSqlDatabase::addDatabase("QSQLITE", connectionName);
+    db.setDatabaseName(path);
+    db.setConnectOptions("QSQLITE_OPEN_READWRITE"); // 读写模式
+
+    // 打开数据库
+    if (!db.open()) {
+        qCritical() << "线程" << QThread::currentThreadId()
+            << "创建数据库连接失败：" << path << db.lastError().text();
+        db = QSqlDatabase();
+        QSqlDatabase::removeDatabase(connectionName);
+        return QSqlDatabase();
+    }
+    connections->names.insert(path, connectionName);
+    DbMetrics::get().connections->inc();
+
+    // 启用外键约束
+    QSqlQuery foreignKeyQuery(db);
+    if (!foreignKeyQuery.exec("PRAGMA foreign_keys = ON;")) {
+        qWarning() << "线程" << QThread::currentThreadId()
+            << "启用外键约束失败：" << foreignKeyQuery.lastError().text();
+    }
+
+    return db;
+}
+
+// 表中缺少该列时追加（ALTER TABLE ADD COLUMN）
+static bool ensureColumn(QSqlDatabase& db, const QString& table, const QString& column, const QString& definition,
+                         bool* added = nullptr) {
+    if (added) *added = false;
+    QSqlQuery query(db);
+    if (!query.exec(QString("PRAGMA table_info(%1)").arg(table))) {
+        qCritical() << "读取表结构失败：" << table << query.lastError().text();
+        return false;
+    }
+    while (query.next()) {
+        if (query.value(1).toString() == column) {
+            return true;
+        }
+    }
+    query.finish();
+
+    if (!query.exec(QString("ALTER TABLE %1 ADD COLUMN %2 %3").arg(table, column, definition))) {
+        qCritical() << "添加列失败：" << table << column << query.lastError().text();
+        return false;
+    }
+    qInfo() << "数据表" << table << "新增列" << column;
+    if (added) *added = true;
+    return true;
+}
+
+bool DatabaseManager::enableWriteAheadLog() {
+    QList<QSqlDatabase> databases = dataDatabases();
+    if (dataShardCount() > 1) {
+        databases.prepend(getThreadDatabase());
+    }
+    for (QSqlDatabase& db : databases) {
+        if (!db.isOpen()) {
+            return false;
+        }
+        QSqlQuery query(db);
+        if (!query.exec("PRAGMA journal_mode = WAL") || !query.next()
+            || query.value(0).toString().compare("wal", Qt::CaseInsensitive) != 0) {
+            qWarning() << "切换 WAL 日志模式失败：" << db.databaseName() << query.lastError().text();
+            return false;
+        }
+    }
+    return true;
+}
+
+// 增量回收空闲页：新库在建表前设置即生效；旧库需 VACUUM 重写整个文件，不在启动时执行，
+// 由保留任务在开启 CRAWLER_VACUUM_CONVERT 后于后台转换
+static void enableIncrementalVacuum(QSqlDatabase& db) {
+    QSqlQuery vacuumQuery(db);
+    if (!vacuumQuery.exec("PRAGMA auto_vacuum") || !vacuumQuery.next() || vacuumQuery.value(0).toInt() == 2) {
+        return;
+    }
+    vacuumQuery.finish();
+    if (vacuumQuery.exec("PRAGMA page_count") && vacuumQuery.next() && vacuumQuery.value(0).toLongLong() == 0) {
+        vacuumQuery.finish();
+        if (!vacuumQuery.exec("PRAGMA auto_vacuum = INCREMENTAL")) {
+            qWarning() << "启用增量回收失败：" << vacuumQuery.lastError().text();
+        }
+        return;
+    }
+    vacuumQuery.finish();
+    qInfo() << "数据库未启用增量回收，删除数据后空闲页不会归还给文件系统：" << db.databaseName()
+            << "（设置 CRAWLER_VACUUM_CONVERT=1 后由保留任务在后台转换，转换期间写入会等待）";
+}
+
+// 爬取数据相关的表（原始数据、汇总、压缩块）；分片库中没有任务表，不建外键
+static bool createDataSchema(QSqlDatabase& db, bool taskForeignKey) {
+    QSqlQuery dataQuery(db);
+    QString dataSql = QString(R"(
+        CREATE TABLE IF NOT EXISTS crawler_data (
+            id INTEGER PRIMARY KEY AUTOINCREMENT,
+            taskId INTEGER NOT NULL,
+            content TEXT NOT NULL,
+            value REAL NOT NULL,
+            crawlTime TEXT NOT NULL%1
+        )
+    )").arg(taskForeignKey ? ",\n            FOREIGN KEY (taskId) REFERENCES crawler_tasks(id) ON DELETE CASCADE" : "");
+    if (!dataQuery.exec(dataSql)) {
+        qCritical() << "创建数据表失败：" << dataQuery.lastError().text();
+        return false;
+    }
+
+    // 旧库升级：补充后续版本新增的列
+    bool rawTextAdded = false;
+    if (!ensureColumn(db, "crawler_data", "lastSeen", "TEXT")
+        || !ensureColumn(db, "crawler_data", "hasRawText", "INTEGER NOT NULL DEFAULT 0", &rawTextAdded)) {
+        return false;
+    }
+    if (rawTextAdded) {
+        // 早期版本把格式化后的数值写入 content，那不是提取出的原始文本，不标记；
+        // 其余非空 content 来自 keepRawText 任务。标志列之前建立的全文索引按旧条件维护，删除后重建
+        QSqlQuery migrateQuery(db);
+        if (!migrateQuery.exec("UPDATE crawler_data SET hasRawText = 1 "
+                               "WHERE content <> '' AND content <> printf('%.2f', value)")) {
+            qCritical() << "标记原始文本失败：" << migrateQuery.lastError().text();
+            return false;
+        }
+        FullTextIndex::dropContentIndex(db);
+    }
+
+    // 按任务+时间查询原始数据的索引
+    QSqlQuery indexQuery(db);
+    if (!indexQuery.exec("CREATE INDEX IF NOT EXISTS idx_crawler_data_task_time ON crawler_data(taskId, crawlTime)")) {
+        qCritical() << "创建数据索引失败：" << indexQuery.lastError().text();
+        return false;
+    }
+
+    if (!RollupStore::createSchema(db)
+        || !ensureColumn(db, "crawler_rollup", "sumSquares", "REAL")
+        || !ensureColumn(db, "crawler_rollup", "sketch", "BLOB")) {
+        return false;
+    }
+
+    // 每个任务一行最新值，随数据写入更新（previousValue 为上一个样本，NULL 表示没有）
+    QSqlQuery latestQuery(db);
+    if (!latestQuery.exec(R"(
+        CREATE TABLE IF NOT EXISTS crawler_task_latest (
+            taskId INTEGER PRIMARY KEY,
+            value REAL NOT NULL,
+            timestampMs INTEGER NOT NULL,
+            previousValue REAL
+        )
+    )")) {
+        qCritical() << "创建最新值表失败：" << latestQuery.lastError().text();
+        return false;
+    }
+    if (!ChunkStore::createSchema(db)) {
+        return false;
+    }
+
+    // 全文索引建不起来（SQLite 未编译 FTS5）时只是不能检索，不影响采集
+    if (DatabaseManager::fullTextIndexEnabled()) {
+        FullTextIndex::createContentIndex(db);
+    }
+    return true;
+}
+
+// 旧库升级：已有原始数据但汇总为空时回填
+static void backfillRollups(QSqlDatabase& db) {
+    QSqlQuery checkQuery(db);
+    if (checkQuery.exec("SELECT EXISTS(SELECT 1 FROM crawler_data), EXISTS(SELECT 1 FROM crawler_rollup)")
+        && checkQuery.next() && checkQuery.value(0).toBool() && !checkQuery.value(1).toBool()) {
+        checkQuery.finish();
+        qInfo() << "检测到未汇总的历史数据，开始回填汇总表";
+        if (!RollupStore::rebuild(db)) {
+            qWarning() << "回填汇总表失败，图表将缺少历史数据";
+        }
+    }
+}
+
+// 旧库升级：最新值表为空时取各任务最后一个天汇总桶的末值（没有上一个样本，趋势从下次写入开始）
+static void backfillLatest(QSqlDatabase& db) {
+    QSqlQuery checkQuery(db);
+    if (checkQuery.exec("SELECT EXISTS(SELECT 1 FROM crawler_rollup), EXISTS(SELECT 1 FROM crawler_task_latest)")
+        && checkQuery.next() && checkQuery.value(0).toBool() && !checkQuery.value(1).toBool()) {
+        checkQuery.finish();
+        if (!checkQuery.exec(R"(
+            INSERT OR IGNORE INTO crawler_task_latest (taskId, value, timestampMs)
+            SELECT taskId, lastValue, lastTime * 1000 FROM crawler_rollup AS r
+            WHERE resolution = 86400 AND bucketStart = (
+                SELECT MAX(bucketStart) FROM crawler_rollup WHERE taskId = r.taskId AND resolution = 86400)
+        )")) {
+            qWarning() << "回填最新值失败：" << checkQuery.lastError().text();
+        }
+    }
+}
+
+// 分片数以主库记录为准：库一旦按某个分片数写入数据，改设置会让已有数据找不到
+bool DatabaseManager::resolveDataShards(QSqlDatabase& db) {
+    QSqlQuery query(db);
+    if (!query.exec("CREATE TABLE IF NOT EXISTS crawler_meta (key TEXT PRIMARY KEY, value TEXT NOT NULL)")) {
+        qCritical() << "创建元数据表失败：" << query.lastError().text();
+        return false;
+    }
+
+    int shards = dataShardCount();
+    int recorded = 0;
+    if (query.exec("SELECT value FROM crawler_meta WHERE key = 'data_shards'") && query.next()) {
+        recorded = query.value(0).toInt();
+    }
+    query.finish();
+
+    if (recorded > 0 && recorded != shards) {
+        // 未设置（默认 1）时静默沿用库中的分片数，例如工作进程
+        if (shards > 1) {
+            qWarning() << "数据库已按" << recorded << "个数据分片创建，忽略设置的" << shards;
+        }
+        shards = recorded;
+    } else if (recorded == 0 && shards > 1
+               && query.exec("SELECT EXISTS(SELECT 1 FROM crawler_data)") && query.next() && query.value(0).toBool()) {
+        qWarning() << "已有数据的单文件库不能直接切换为分片存储，继续使用单文件";
+        shards = 1;
+    }
+    query.finish();
+
+    if (recorded != shards) {
+        query.prepare("INSERT OR REPLACE INTO crawler_meta (key, value) VALUES ('data_shards', ?)");
+        query.addBindValue(QString::number(shards));
+        if (!query.exec()) {
+            qCritical() << "记录数据分片数失败：" << query.lastError().text();
+            return false;
+        }
+    }
+    setDataShardCount(shards);
+    DbMetrics::get().dataShards->set(shards);
+    return true;
+}
+
+// 初始化数据表结构（主线程调用）
+bool DatabaseManager::initDatabaseSchema() {
+    QSqlDatabase db = getThreadDatabase();
+    if (!db.isOpen()) {
+        qCritical() << "数据库初始化失败：连接未打开";
+        return false;
+    }
+
+    enableIncrementalVacuum(db);
+
+    // 创建任务表
+    QSqlQuery taskQuery(db);
+    QString taskSql = R"(
+        CREATE TABLE IF NOT EXISTS crawler_tasks (
+            id INTEGER PRIMARY KEY AUTOINCREMENT,
+            name TEXT NOT NULL,
+            url TEXT NOT NULL,
+            interval INTEGER DEFAULT 5,
+            rule TEXT DEFAULT ''
+        )
+    )";
+    if (!taskQuery.exec(taskSql)) {
+        qCritical() << "创建任务表失败：" << taskQuery.lastError().text();
+        return false;
+    }
+
+    // 旧库升级：补充后续版本新增的列
+    if (!ensureColumn(db, "crawler_tasks", "changeTolerance", "REAL DEFAULT -1")
+        || !ensureColumn(db, "crawler_tasks", "keepRawText", "INTEGER DEFAULT 0")) {
+        return false;
+    }
+
+    // 单文件时数据表建在主库中；分片时主库只保留元数据，判断是否已有数据前先确保表存在
+    if (!createDataSchema(db, true) || !resolveDataShards(db)) {
+        return false;
+    }
+    const int shards = dataShardCount();
+    if (shards > 1) {
+        for (int shard = 0; shard < shards; ++shard) {
+            QSqlDatabase shardDb = getShardDatabase(shard);
+            if (!shardDb.isOpen()) {
+                qCritical() << "数据分片初始化失败：" << dataShardPath(shard);
+                return false;
+            }
+            enableIncrementalVacuum(shardDb);
+            if (!createDataSchema(shardDb, false)) {
+                return false;
+            }
+        }
+        qInfo() << "爬取数据分为" << shards << "个库文件";
+    }
+
+    if (!ResponseArchive::createSchema(db) || !ScheduleStore::createSchema(db) || !LeaseManager::createSchema(db)) {
+        return false;
+    }
+    if (fullTextIndexEnabled()) {
+        FullTextIndex::createBodyIndex(db);
+    }
+
+    // 保留策略表，taskId=0 为全局默认
+    QSqlQuery retentionQuery(db);
+    QString retentionSql = R"(
+        CREATE TABLE IF NOT EXISTS crawler_retention (
+            taskId INTEGER PRIMARY KEY,
+            rawDays INTEGER NOT NULL,
+            minuteDays INTEGER NOT NULL,
+            hourDays INTEGER NOT NULL,
+            dayDays INTEGER NOT NULL
+        )
+    )";
+    if (!retentionQuery.exec(retentionSql)) {
+        qCritical() << "创建保留策略表失败：" << retentionQuery.lastError().text();
+        return false;
+    }
+    const RetentionPolicy defaults;
+    retentionQuery.prepare("INSERT OR IGNORE INTO crawler_retention VALUES (0, ?, ?, ?, ?)");
+    retentionQuery.addBindValue(defaults.rawDays);
+    retentionQuery.addBindValue(defaults.minuteDays);
+    retentionQuery.addBindValue(defaults.hourDays);
+    retentionQuery.addBindValue(defaults.dayDays);
+    if (!retentionQuery.exec()) {
+        qWarning() << "写入默认保留策略失败：" << retentionQuery.lastError().text();
+    }
+
+    for (QSqlDatabase& dataDb : dataDatabases()) {
+        backfillRollups(dataDb);
+        backfillLatest(dataDb);
+    }
+
+    qInfo() << "数据库表结构初始化成功";
+    return true;
+}
+
+// 保存任务（新增/更新）
+bool DatabaseManager::saveCrawlerTask(const CrawlerTask& task) {
+    QSqlDatabase db = getThreadDatabase();
+    if (!db.isOpen()) {
+        qCritical() << "保存任务失败：数据库未打开";
+        return false;
+    }
+
+    MetricTimer statementTimer(DbMetrics::get().saveTask);
+    QSqlQuery query(db);
+    // 新增任务（ID=0）
+    if (task.id == 0) {
+        query.prepare(R"(
+            INSERT INTO crawler_tasks (name, url, interval, rule, changeTolerance, keepRawText)
+            VALUES (:name, :url, :interval, :rule, :changeTolerance, :keepRawText)
+        )");
+        query.bindValue(":name", task.name);
+        query.bindValue(":url", task.url);
+        query.bindValue(":interval", task.interval);
+        query.bindValue(":rule", task.rule);
+        query.bindValue(":changeTolerance", task.changeTolerance);
+        query.bindValue(":keepRawText", task.keepRawText ? 1 : 0);
+    }
+    // 更新任务（ID>0）
+    else {
+        query.prepare(R"(
+            UPDATE crawler_tasks
+            SET name = :name, url = :url, interval = :interval, rule = :rule,
+                changeTolerance = :changeTolerance, keepRawText = :keepRawText
+            WHERE id = :id
+        )");
+        query.bindValue(":id", task.id);
+        query.bindValue(":name", task.name);
+        query.bindValue(":url", task.url);
+        query.bindValue(":interval", task.interval);
+        query.bindValue(":rule", task.rule);
+        query.bindValue(":changeTolerance", task.changeTolerance);
+        query.bindValue(":keepRawText", task.keepRawText ? 1 : 0);
+    }
+
+    if (!query.exec()) {
+        DbMetrics::recordError(query.lastError());
+        qWarning() << "保存任务失败：" << query.lastError().text();
+        return false;
+    }
+
+    // 新增任务返回自增ID
+    CrawlerTask saved = task;
+    if (task.id == 0) {
+        saved.id = query.lastInsertId().toInt();
+        qDebug() << "新增任务成功，自动生成ID：" << saved.id;
+    }
+    TaskRegistry::instance().update(saved);
+
+    return true;
+}
+
+// 批量新增任务（单事务）
+QList<int> DatabaseManager::saveCrawlerTasks(const QList<CrawlerTask>& tasks) {
+    QList<int> ids;
+    QSqlDatabase db = getThreadDatabase();
+    if (!db.isOpen()) {
+        qCritical() << "批量保存任务失败：数据库未打开";
+        return ids;
+    }
+
+    MetricTimer statementTimer(DbMetrics::get().saveTask);
+    if (!db.transaction()) {
+        qWarning() << "批量保存任务失败：无法开启事务" << db.lastError().text();
+        return ids;
+    }
+
+    QSqlQuery query(db);
+    query.prepare(R"(
+        INSERT INTO crawler_tasks (name, url, interval, rule, changeTolerance, keepRawText)
+        VALUES (:name, :url, :interval, :rule, :changeTolerance, :keepRawText)
+    )");
+
+    ids.reserve(tasks.size());
+    for (const auto& task : tasks) {
+        query.bindValue(":name", task.name);
+        query.bindValue(":url", task.url);
+        query.bindValue(":interval", task.interval);
+        query.bindValue(":rule", task.rule);
+        query.bindValue(":changeTolerance", task.changeTolerance);
+        query.bindValue(":keepRawText", task.keepRawText ? 1 : 0);
+        if (!query.exec()) {
+            DbMetrics::recordError(query.lastError());
+            qWarning() << "批量保存任务失败：" << query.lastError().text();
+            db.rollback();
+            return QList<int>();
+        }
+        ids.append(query.lastInsertId().toInt());
+    }
+
+    if (!db.commit()) {
+        qWarning() << "批量保存任务提交失败：" << db.lastError().text();
+        db.rollback();
+        return QList<int>();
+    }
+
+    qDebug() << "批量新增任务成功，数量：" << ids.size();
+    QList<CrawlerTask> saved = tasks;
+    for (qsizetype i = 0; i < saved.size(); ++i) {
+        saved[i].id = ids.at(i);
+    }
+    TaskRegistry::instance().update(saved);
+    return ids;
+}
+
+// 获取所有任务
+QList<CrawlerTask> DatabaseManager::getAllTasks() {
+    QList<CrawlerTask> tasks;
+    QSqlDatabase db = getThreadDatabase();
+    if (!db.isOpen()) {
+        qCritical() << "获取任务列表失败：数据库未打开";
+        return tasks;
+    }
+
+    MetricTimer statementTimer(DbMetrics::get().selectTasks);
+    QSqlQuery query("SELECT id, name, url, interval, rule, changeTolerance, keepRawText FROM crawler_tasks", db);
+    while (query.next()) {
+        CrawlerTask task;
+        task.id = query.value(0).toInt();
+        task.name = query.value(1).toString();
+        task.url = query.value(2).toString();
+        task.interval = query.value(3).toInt();
+        task.rule = query.value(4).toString();
+        task.changeTolerance = query.value(5).toDouble();
+        task.keepRawText = query.value(6).toBool();
+        tasks.append(task);
+    }
+
+    return tasks;
+}
+
+// 根据ID获取任务
+CrawlerTask DatabaseManager::getTaskById(int taskId) {
+    CrawlerTask task;
+    QSqlDatabase db = getThreadDatabase();
+    if (!db.isOpen()) {
+        qCritical() << "查询任务失败：数据库未打开";
+        return task;
+    }
+
+    MetricTimer statementTimer(DbMetrics::get().selectTask);
+    QSqlQuery query(db);
+    query.prepare("SELECT id, name, url, interval, rule, changeTolerance, keepRawText FROM crawler_tasks WHERE id = :id");
+    query.bindValue(":id", taskId);
+
+    if (!query.exec()) {
+        DbMetrics::recordError(query.lastError());
+        qWarning() << "查询任务失败：" << query.lastError().text();
+        return task;
+    }
+
+    if (query.next()) {
+        task.id = query.value(0).toInt();
+        task.name = query.value(1).toString();
+        task.url = query.value(2).toString();
+        task.interval = query.value(3).toInt();
+        task.rule = query.value(4).toString();
+        task.changeTolerance = query.value(5).toDouble();
+        task.keepRawText = query.value(6).toBool();
+    } else {
+        qWarning() << "未找到任务ID：" << taskId;
+    }
+
+    return task;
+}
+
+// 段存储后端的最新值（进程内）：写入时更新，首次查询时用各任务段文件末尾的数据点补齐
+struct SegmentLatest {
+    QMutex mutex;
+    QHash<int, TaskLatest> values;
+    bool seeded = false;
+
+    static SegmentLatest& get()
+    {
+        static SegmentLatest latest;
+        return latest;
+    }
+
+    // 调用方持有 mutex；迟到的数据点不覆盖更新的值
+    void update(int taskId, double value, qint64 timestampMs)
+    {
+        TaskLatest& latest = values[taskId];
+        if (latest.isValid()) {
+            if (timestampMs < latest.timestampMs) return;
+            latest.previousValue = latest.value;
+            latest.hasPrevious = true;
+        }
+        latest.taskId = taskId;
+        latest.value = value;
+        latest.timestampMs = timestampMs;
+    }
+};
+
+// 保存爬取数据（多线程安全）
+bool DatabaseManager::saveCrawlerData(const CrawlerData& data, double changeTolerance, const QString& rawText) {
+    if (dataBackend() == DataBackend::Segment) {
+        TraceSpan insertSpan("segment_append", "db");
+        MetricTimer statementTimer(DbMetrics::get().insertData);
+        if (!SegmentStore::instance().append(data.taskId, data.timestampMs, data.value)) {
+            qCritical() << "线程" << QThread::currentThreadId()
+                << "保存爬取数据失败：段文件写入失败，任务ID：" << data.taskId;
+            return false;
+        }
+        SegmentLatest& latest = SegmentLatest::get();
+        QMutexLocker locker(&latest.mutex);
+        latest.update(data.taskId, data.value, data.timestampMs);
+        return true;
+    }
+
+    QSqlDatabase db = getDataDatabase(data.taskId);
+    if (!db.isOpen()) {
+        qCritical() << "线程" << QThread::currentThreadId()
+            << "保存数据失败：数据库未打开";
+        return false;
+    }
+
+    TraceSpan insertSpan("db_insert", "db");
+    MetricTimer statementTimer(DbMetrics::get().insertData);
+    // 原始数据、汇总与最新值在同一事务内写入
+    if (!db.transaction()) {
+        DbMetrics::recordError(db.lastError());
+        qCritical() << "线程" << QThread::currentThreadId()
+            << "保存数据失败：无法开启事务" << db.lastError().text();
+        return false;
+    }
+
+    const QDateTime time = data.crawlTime();
+    const QString crawlTime = time.toString("yyyy-MM-dd HH:mm:ss");
+    QSqlQuery query(db);
+
+    // 变化存储模式：数值在容差内时只延长最近一行的 lastSeen
+    bool collapsed = false;
+    if (changeTolerance >= 0) {
+        query.prepare(R"(
+            SELECT id, value, COALESCE(lastSeen, crawlTime) FROM crawler_data
+            WHERE taskId = :taskId ORDER BY crawlTime DESC LIMIT 1
+        )");
+        query.bindValue(":taskId", data.taskId);
+        if (query.exec() && query.next()
+            && qAbs(query.value(1).toDouble() - data.value) <= changeTolerance
+            && query.value(2).toString() <= crawlTime) {
+            const qint64 rowId = query.value(0).toLongLong();
+            query.finish();
+            query.prepare("UPDATE crawler_data SET lastSeen = :lastSeen WHERE id = :id");
+            query.bindValue(":lastSeen", crawlTime);
+            query.bindValue(":id", rowId);
+            collapsed = true;
+        } else {
+            query.finish();
+        }
+    }
+
+    if (!collapsed) {
+        query.prepare(R"(
+            INSERT INTO crawler_data (taskId, content, hasRawText, value, crawlTime)
+            VALUES (:taskId, :content, :hasRawText, :value, :crawlTime)
+        )");
+        query.bindValue(":taskId", data.taskId);
+        // 原始文本仅在任务要求保留时写入，否则存空串
+        query.bindValue(":content", rawText.isNull() ? QString("") : rawText);
+        query.bindValue(":hasRawText", rawText.isEmpty() ? 0 : 1);
+        query.bindValue(":value", data.value);
+        query.bindValue(":crawlTime", crawlTime);
+    }
+
+    if (!query.exec()) {
+        DbMetrics::recordError(query.lastError());
+        qCritical() << "线程" << QThread::currentThreadId()
+            << "保存爬取数据失败："
+            << "错误信息：" << query.lastError().text()
+            << "任务ID：" << data.taskId;
+        db.rollback();
+        return false;
+    }
+    query.finish();
+
+    if (!RollupStore::record(db, data.taskId, data.value, time)) {
+        db.rollback();
+        return false;
+    }
+
+    // 最新值：迟到的数据点（早于已记录的时间）不覆盖；SET 中的 value 为更新前的旧值
+    query.prepare(R"(
+        INSERT INTO crawler_task_latest (taskId, value, timestampMs) VALUES (:taskId, :value, :timestampMs)
+        ON CONFLICT (taskId) DO UPDATE SET
+            previousValue = value,
+            value = excluded.value,
+            timestampMs = excluded.timestampMs
+        WHERE excluded.timestampMs >= timestampMs
+    )");
+    query.bindValue(":taskId", data.taskId);
+    query.bindValue(":value", data.value);
+    query.bindValue(":timestampMs", data.timestampMs);
+    if (!query.exec()) {
+        DbMetrics::recordError(query.lastError());
+        qCritical() << "线程" << QThread::currentThreadId()
+            << "更新最新值失败：" << query.lastError().text() << "任务ID：" << data.taskId;
+        db.rollback();
+        return false;
+    }
+    query.finish();
+
+    if (!db.commit()) {
+        DbMetrics::recordError(db.lastError());
+        qCritical() << "线程" << QThread::currentThreadId()
+            << "保存数据提交失败：" << db.lastError().text();
+        db.rollback();
+        return false;
+    }
+    if (collapsed) {
+        DbMetrics::get().collapsed->inc();
+    }
+
+    qDebug() << "线程" << QThread::currentThreadId()
+             << "保存数据成功，任务ID：" << data.taskId;
+    return true;
+}
+
+// 根据任务ID获取数据
+QList<CrawlerData> DatabaseManager::getTaskData(int taskId) {
+    QList<CrawlerData> datas;
+    if (dataBackend() == DataBackend::Segment) {
+        MetricTimer statementTimer(DbMetrics::get().selectData);
+        SegmentStore::instance().scan(taskId, std::numeric_limits<qint64>::min(), std::numeric_limits<qint64>::max(),
+                                      [&](qint64 timestampMs, double value) {
+            CrawlerData data;
+            data.taskId = taskId;
+            data.timestampMs = timestampMs;
+            data.value = value;
+            datas.append(data);
+            return true;
+        });
+        return datas;
+    }
+
+    QSqlDatabase db = getDataDatabase(taskId);
+    if (!db.isOpen()) {
+        qCritical() << "查询爬取数据失败：数据库未打开";
+        return datas;
+    }
+
+    MetricTimer statementTimer(DbMetrics::get().selectData);
+    // 先读已封存的压缩块
+    ChunkStore::scan(db, taskId, std::numeric_limits<qint64>::min() / 2, std::numeric_limits<qint64>::max(),
+                     [&](qint64 secs, double value) {
+        CrawlerData data;
+        data.taskId = taskId;
+        data.flags = DataFlagSealed;
+        data.timestampMs = secs * 1000;
+        data.value = value;
+        datas.append(data);
+    });
+    const qsizetype sealedCount = datas.size();
+
+    QSqlQuery query(db);
+    query.setForwardOnly(true);
+    query.prepare(R"(
+        SELECT value, crawlTime, lastSeen, hasRawText FROM crawler_data
+        WHERE taskId = :taskId ORDER BY crawlTime
+    )");
+    query.bindValue(":taskId", taskId);
+
+    if (!query.exec()) {
+        DbMetrics::recordError(query.lastError());
+        qWarning() << "查询爬取数据失败：" << query.lastError().text();
+        return datas;
+    }
+
+    while (query.next()) {
+        CrawlerData data;
+        data.taskId = taskId;
+        data.flags = query.value(3).toBool() ? DataFlagHasRawText : DataFlagNone;
+        data.timestampMs = QDateTime::fromString(query.value(1).toString(), "yyyy-MM-dd HH:mm:ss").toMSecsSinceEpoch();
+        data.value = query.value(0).toDouble();
+        datas.append(data);
+
+        // 合并的重复值展开为阶梯：区间末尾补一个同值点
+        const QString lastSeen = query.value(2).toString();
+        if (!lastSeen.isEmpty() && lastSeen != query.value(1).toString()) {
+            data.flags |= DataFlagRunEnd;
+            data.timestampMs = QDateTime::fromString(lastSeen, "yyyy-MM-dd HH:mm:ss").toMSecsSinceEpoch();
+            datas.append(data);
+        }
+    }
+
+    // 迟到数据可能早于已封存的块，两部分都有时按时间重排
+    if (sealedCount > 0 && sealedCount < datas.size()) {
+        std::stable_sort(datas.begin(), datas.end(), [](const CrawlerData& a, const CrawlerData& b) {
+            return a.timestampMs < b.timestampMs;
+        });
+    }
+
+    return datas;
+}
+
+// 最新的若干个数据点
+QList<CrawlerData> DatabaseManager::getLatestTaskData(int taskId, int limit) {
+    QList<CrawlerData> datas;
+    if (limit <= 0) {
+        return datas;
+    }
+    MetricTimer statementTimer(DbMetrics::get().selectData);
+
+    if (dataBackend() == DataBackend::Segment) {
+        // 从末尾的窗口开始扫描（稀疏索引定位起点），点数不够时窗口加倍
+        qint64 firstMs = 0;
+        qint64 lastMs = 0;
+        if (!SegmentStore::instance().timeRange(taskId, &firstMs, &lastMs)) {
+            return datas;
+        }
+        qint64 windowMs = 3600 * 1000;
+        while (true) {
+            const qint64 fromMs = qMax(firstMs, lastMs - windowMs);
+            datas.clear();
+            SegmentStore::instance().scan(taskId, fromMs, lastMs, [&](qint64 timestampMs, double value) {
+                CrawlerData data;
+                data.taskId = taskId;
+                data.timestampMs = timestampMs;
+                data.value = value;
+                datas.append(data);
+                return true;
+            });
+            if (datas.size() >= limit || fromMs == firstMs) {
+                break;
+            }
+            windowMs *= 2;
+        }
+        std::stable_sort(datas.begin(), datas.end(), [](const CrawlerData& a, const CrawlerData& b) {
+            return a.timestampMs < b.timestampMs;
+        });
+        return datas.mid(qMax<qsizetype>(0, datas.size() - limit));
+    }
+
+    QSqlDatabase db = getDataDatabase(taskId);
+    if (!db.isOpen()) {
+        qCritical() << "查询爬取数据失败：数据库未打开";
+        return datas;
+    }
+
+    // 表尾：沿 (taskId, crawlTime) 索引倒序取 limit 行，每行至少展开为一个点
+    QSqlQuery query(db);
+    query.setForwardOnly(true);
+    query.prepare(R"(
+        SELECT value, crawlTime, lastSeen, hasRawText FROM crawler_data
+        WHERE taskId = :taskId ORDER BY crawlTime DESC LIMIT :limit
+    )");
+    query.bindValue(":taskId", taskId);
+    query.bindValue(":limit", limit);
+    if (!query.exec()) {
+        DbMetrics::recordError(query.lastError());
+        qWarning() << "查询爬取数据失败：" << query.lastError().text();
+        return datas;
+    }
+    qint64 oldestRawMs = std::numeric_limits<qint64>::max();
+    while (query.next()) {
+        CrawlerData data;
+        data.taskId = taskId;
+        data.flags = query.value(3).toBool() ? DataFlagHasRawText : DataFlagNone;
+        data.timestampMs = QDateTime::fromString(query.value(1).toString(), "yyyy-MM-dd HH:mm:ss").toMSecsSinceEpoch();
+        data.value = query.value(0).toDouble();
+        datas.append(data);
+        oldestRawMs = qMin(oldestRawMs, data.timestampMs);
+
+        const QString lastSeen = query.value(2).toString();
+        if (!lastSeen.isEmpty() && lastSeen != query.value(1).toString()) {
+            data.flags |= DataFlagRunEnd;
+            data.timestampMs = QDateTime::fromString(lastSeen, "yyyy-MM-dd HH:mm:ss").toMSecsSinceEpoch();
+            datas.append(data);
+        }
+    }
+    query.finish();
+
+    // 压缩块：原始行已够 limit 个时，只需要不早于其中最旧一行的块
+    const qint64 notBeforeSecs = datas.size() >= limit ? oldestRawMs / 1000 : std::numeric_limits<qint64>::min();
+    for (const auto& point : ChunkStore::latest(db, taskId, limit, notBeforeSecs)) {
+        CrawlerData data;
+        data.taskId = taskId;
+        data.flags = DataFlagSealed;
+        data.timestampMs = point.first * 1000;
+        data.value = point.second;
+        datas.append(data);
+    }
+
+    std::stable_sort(datas.begin(), datas.end(), [](const CrawlerData& a, const CrawlerData& b) {
+        return a.timestampMs < b.timestampMs;
+    });
+    return datas.mid(qMax<qsizetype>(0, datas.size() - limit));
+}
+
+// 按窗口大小选择粒度读取序列
+QList<RollupPoint> DatabaseManager::getTaskSeries(int taskId, const QDateTime& from, const QDateTime& to,
+                                                  int maxPoints, RollupResolution* usedResolution) {
+    QList<RollupPoint> points;
+    const qint64 fromSecs = from.toSecsSinceEpoch();
+    const qint64 toSecs = to.toSecsSinceEpoch();
+    if (dataBackend() == DataBackend::Segment) {
+        MetricTimer statementTimer(DbMetrics::get().selectSeries);
+        return segmentSeries(taskId, fromSecs, toSecs, maxPoints, usedResolution);
+    }
+
+    QSqlDatabase db = getDataDatabase(taskId);
+    if (!db.isOpen()) {
+        qCritical() << "查询序列失败：数据库未打开";
+        return points;
+    }
+
+    MetricTimer statementTimer(DbMetrics::get().selectSeries);
+    const RollupResolution resolution = RollupStore::chooseResolution(db, taskId, fromSecs, toSecs, maxPoints);
+    if (usedResolution) {
+        *usedResolution = resolution;
+    }
+
+    if (resolution != RollupResolution::Raw) {
+        return RollupStore::query(db, taskId, resolution, fromSecs, toSecs);
+    }
+
+    auto appendRaw = [&points](qint64 secs, double value) {
+        RollupPoint point;
+        point.bucketStart = secs;
+        point.count = 1;
+        point.minValue = point.maxValue = point.sumValue = value;
+        point.firstValue = point.lastValue = value;
+        points.append(point);
+    };
+    ChunkStore::scan(db, taskId, fromSecs, toSecs, appendRaw);
+    const qsizetype sealedCount = points.size();
+
+    // 变化存储的行展开为 [crawlTime, lastSeen] 两端的同值点，并裁剪到窗口内
+    auto appendRun = [&](const QSqlQuery& row) {
+        const double value = row.value(0).toDouble();
+        const qint64 start = QDateTime::fromString(row.value(1).toString(), "yyyy-MM-dd HH:mm:ss").toSecsSinceEpoch();
+        const QString lastSeen = row.value(2).toString();
+        const qint64 end = lastSeen.isEmpty() ? start
+                         : QDateTime::fromString(lastSeen, "yyyy-MM-dd HH:mm:ss").toSecsSinceEpoch();
+        appendRaw(qMax(start, fromSecs), value);
+        if (end > start) {
+            appendRaw(qMin(end, toSecs), value);
+        }
+    };
+
+    const QString fromText = from.toString("yyyy-MM-dd HH:mm:ss");
+    QSqlQuery query(db);
+    query.setForwardOnly(true);
+    // 窗口起点之前开始、但 lastSeen 延续到窗口内的区间
+    query.prepare(R"(
+        SELECT value, crawlTime, lastSeen FROM crawler_data
+        WHERE taskId = :taskId AND crawlTime < :from
+        ORDER BY crawlTime DESC LIMIT 1
+    )");
+    query.bindValue(":taskId", taskId);
+    query.bindValue(":from", fromText);
+    if (query.exec() && query.next() && query.value(2).toString() >= fromText) {
+        appendRun(query);
+    }
+    query.finish();
+
+    query.prepare(R"(
+        SELECT value, crawlTime, lastSeen FROM crawler_data
+        WHERE taskId = :taskId AND crawlTime BETWEEN :from AND :to
+        ORDER BY crawlTime
+    )");
+    query.bindValue(":taskId", taskId);
+    query.bindValue(":from", fromText);
+    query.bindValue(":to", to.toString("yyyy-MM-dd HH:mm:ss"));
+
+    if (!query.exec()) {
+        DbMetrics::recordError(query.lastError());
+        qWarning() << "查询序列失败：" << query.lastError().text();
+        return points;
+    }
+
+    while (query.next()) {
+        appendRun(query);
+    }
+
+    if (sealedCount > 0 && sealedCount < points.size()) {
+        std::stable_sort(points.begin(), points.end(), [](const RollupPoint& a, const RollupPoint& b) {
+            return a.bucketStart < b.bucketStart;
+        });
+    }
+
+    return points;
+}
+
+// 段存储上的统计量：流式扫描一遍窗口，只保留累加量与分位数草图
+static TaskStatistics segmentStatistics(int taskId, qint64 fromSecs, qint64 toSecs) {
+    TaskStatistics stats;
+    double sum = 0.0;
+    double sumSquares = 0.0;
+    QuantileSketch sketch;
+    SegmentStore::instance().scan(taskId, fromSecs * 1000, toSecs * 1000 + 999, [&](qint64 timestampMs, double value) {
+        if (stats.count == 0) {
+            stats.minValue = stats.maxValue = value;
+        } else {
+            stats.minValue = qMin(stats.minValue, value);
+            stats.maxValue = qMax(stats.maxValue, value);
+        }
+        stats.count++;
+        sum += value;
+        sumSquares += value * value;
+        if (timestampMs / 1000 >= stats.lastSecs) {
+            stats.lastValue = value;
+            stats.lastSecs = timestampMs / 1000;
+        }
+        sketch.add(value);
+        return true;
+    });
+    if (stats.count > 0) {
+        stats.mean = sum / stats.count;
+        stats.stddev = std::sqrt(qMax(0.0, sumSquares / stats.count - stats.mean * stats.mean));
+        stats.p50 = qBound(stats.minValue, sketch.quantile(0.5), stats.maxValue);
+        stats.p95 = qBound(stats.minValue, sketch.quantile(0.95), stats.maxValue);
+    }
+    return stats;
+}
+
+// 窗口统计量
+TaskStatistics DatabaseManager::getTaskStatistics(int taskId, const QDateTime& from, const QDateTime& to) {
+    MetricTimer statementTimer(DbMetrics::get().selectStatistics);
+    if (dataBackend() == DataBackend::Segment) {
+        return segmentStatistics(taskId, from.toSecsSinceEpoch(), to.toSecsSinceEpoch());
+    }
+
+    QSqlDatabase db = getDataDatabase(taskId);
+    if (!db.isOpen()) {
+        qCritical() << "查询统计量失败：数据库未打开";
+        return TaskStatistics();
+    }
+    return RollupStore::statistics(db, taskId, from.toSecsSinceEpoch(), to.toSecsSinceEpoch());
+}
+
+QHash<int, TaskStatistics> DatabaseManager::getTasksStatistics(const QList<int>& taskIds, const QDateTime& from,
+                                                               const QDateTime& to) {
+    QHash<int, TaskStatistics> result;
+    result.reserve(taskIds.size());
+    for (int taskId : taskIds) {
+        const TaskStatistics stats = getTaskStatistics(taskId, from, to);
+        if (!stats.isEmpty()) {
+            result.insert(taskId, stats);
+        }
+    }
+    return result;
+}
+
+// 全文检索：各数据库文件各取前 limit 条再按相关度合并
+// bm25 得分只在同一索引内可比，跨文件合并的排序是近似的
+QList<SearchHit> DatabaseManager::searchText(const QString& text, int limit) {
+    QList<SearchHit> hits;
+    if (text.trimmed().size() < FullTextIndex::kMinQueryLength || limit <= 0) {
+        return hits;
+    }
+    MetricTimer timer(DbMetrics::get().searchText);
+
+    if (dataBackend() == DataBackend::Sqlite) {
+        for (QSqlDatabase& db : dataDatabases()) {
+            if (!db.isOpen()) {
+                qCritical() << "全文检索失败：数据库未打开";
+                return hits;
+            }
+            hits.append(FullTextIndex::searchContent(db, text, limit));
+        }
+    }
+    QSqlDatabase db = getThreadDatabase();
+    if (db.isOpen()) {
+        hits.append(FullTextIndex::searchBodies(db, text, limit));
+    }
+
+    std::stable_sort(hits.begin(), hits.end(), [](const SearchHit& a, const SearchHit& b) {
+        return a.rank < b.rank;
+    });
+    if (hits.size() > limit) {
+        hits.resize(limit);
+    }
+    return hits;
+}
+
+// 获取任务数据的时间范围
+bool DatabaseManager::getTaskTimeRange(int taskId, QDateTime* first, QDateTime* last) {
+    if (dataBackend() == DataBackend::Segment) {
+        qint64 firstMs = 0;
+        qint64 lastMs = 0;
+        if (!SegmentStore::instance().timeRange(taskId, &firstMs, &lastMs)) {
+            return false;
+        }
+        if (first) *first = QDateTime::fromMSecsSinceEpoch(firstMs);
+        if (last) *last = QDateTime::fromMSecsSinceEpoch(lastMs);
+        return true;
+    }
+
+    QSqlDatabase db = getDataDatabase(taskId);
+    if (!db.isOpen()) {
+        qCritical() << "查询时间范围失败：数据库未打开";
+        return false;
+    }
+
+    qint64 firstSecs = 0;
+    qint64 lastSecs = 0;
+    if (!RollupStore::timeRange(db, taskId, &firstSecs, &lastSecs)) {
+        return false;
+    }
+    if (first) *first = QDateTime::fromSecsSinceEpoch(firstSecs);
+    if (last) *last = QDateTime::fromSecsSinceEpoch(lastSecs);
+    return true;
+}
+
+// 全部任务的最新值
+QHash<int, TaskLatest> DatabaseManager::getLatestValues() {
+    QHash<int, TaskLatest> result;
+    if (dataBackend() == DataBackend::Segment) {
+        SegmentLatest& latest = SegmentLatest::get();
+        {
+            QMutexLocker locker(&latest.mutex);
+            if (latest.seeded) {
+                return latest.values;
+            }
+        }
+        // 首次查询：读取段文件末尾的数据点（不持锁，与写入并发时按时间合并）
+        QHash<int, TaskLatest> seeded;
+        for (const CrawlerTask& task : TaskRegistry::instance().tasks()) {
+            qint64 firstMs = 0;
+            qint64 lastMs = 0;
+            if (!SegmentStore::instance().timeRange(task.id, &firstMs, &lastMs)) continue;
+            SegmentStore::instance().scan(task.id, lastMs, lastMs, [&](qint64 timestampMs, double value) {
+                TaskLatest& item = seeded[task.id];
+                item.taskId = task.id;
+                item.value = value;
+                item.timestampMs = timestampMs;
+                return true;
+            });
+        }
+        QMutexLocker locker(&latest.mutex);
+        for (auto it = seeded.cbegin(); it != seeded.cend(); ++it) {
+            const TaskLatest& current = latest.values.value(it.key());
+            if (!current.isValid() || current.timestampMs < it.value().timestampMs) {
+                latest.values.insert(it.key(), it.value());
+            }
+        }
+        latest.seeded = true;
+        return latest.values;
+    }
+
+    for (QSqlDatabase& db : dataDatabases()) {
+        if (!db.isOpen()) {
+            qCritical() << "查询最新值失败：数据库未打开";
+            return result;
+        }
+        QSqlQuery query(db);
+        query.setForwardOnly(true);
+        if (!query.exec("SELECT taskId, value, timestampMs, previousValue FROM crawler_task_latest")) {
+            DbMetrics::recordError(query.lastError());
+            qWarning() << "查询最新值失败：" << query.lastError().text();
+            continue;
+        }
+        while (query.next()) {
+            TaskLatest latest;
+            latest.taskId = query.value(0).toInt();
+            latest.value = query.value(1).toDouble();
+            latest.timestampMs = query.value(2).toLongLong();
+            latest.hasPrevious = !query.value(3).isNull();
+            latest.previousValue = query.value(3).toDouble();
+            result.insert(latest.taskId, latest);
+        }
+    }
+    return result;
+}
+
+// 重建汇总表
+bool DatabaseManager::rebuildRollups() {
+    bool ok = true;
+    for (QSqlDatabase& db : dataDatabases()) {
+        if (!db.isOpen()) {
+            qCritical() << "重建汇总失败：数据库未打开";
+            return false;
+        }
+        ok = RollupStore::rebuild(db) && ok;
+    }
+    return ok;
+}
+
+// 按新规则重新提取归档的响应
+ReextractResult DatabaseManager::reextractTaskData(int taskId, const QString& rule, const QDateTime& from,
+                                                   const QDateTime& to, bool apply) {
+    QSqlDatabase db = getThreadDatabase();
+    if (!db.isOpen()) {
+        qCritical() << "重新提取失败：数据库未打开";
+        return ReextractResult();
+    }
+    if (apply && dataBackend() == DataBackend::Segment) {
+        qWarning() << "段存储后端不支持改写历史数据，重新提取结果不写回";
+        apply = false;
+    }
+    // 先写完积压的响应，避免漏掉最近一轮
+    ResponseArchive::instance().flush();
+    return ResponseArchive::reextract(db, taskId, rule, from, to, apply);
+}
+
+// 保存保留策略（新增或覆盖）
+bool DatabaseManager::saveRetentionPolicy(const RetentionPolicy& policy) {
+    QSqlDatabase db = getThreadDatabase();
+    if (!db.isOpen()) {
+        qCritical() << "保存保留策略失败：数据库未打开";
+        return false;
+    }
+
+    QSqlQuery query(db);
+    query.prepare(R"(
+        INSERT OR REPLACE INTO crawler_retention (taskId, rawDays, minuteDays, hourDays, dayDays)
+        VALUES (:taskId, :rawDays, :minuteDays, :hourDays, :dayDays)
+    )");
+    query.bindValue(":taskId", policy.taskId);
+    query.bindValue(":rawDays", qMax(0, policy.rawDays));
+    query.bindValue(":minuteDays", qMax(0, policy.minuteDays));
+    query.bindValue(":hourDays", qMax(0, policy.hourDays));
+    query.bindValue(":dayDays", qMax(0, policy.dayDays));
+
+    if (!query.exec()) {
+        DbMetrics::recordError(query.lastError());
+        qWarning() << "保存保留策略失败：" << query.lastError().text();
+        return false;
+    }
+    return true;
+}
+
+// 删除任务级保留策略（恢复使用全局策略），全局策略不可删除
+bool DatabaseManager::removeRetentionPolicy(int taskId) {
+    if (taskId == 0) {
+        qWarning() << "全局保留策略不可删除";
+        return false;
+    }
+    QSqlDatabase db = getThreadDatabase();
+    if (!db.isOpen()) {
+        qCritical() << "删除保留策略失败：数据库未打开";
+        return false;
+    }
+
+    QSqlQuery query(db);
+    query.prepare("DELETE FROM crawler_retention WHERE taskId = :taskId");
+    query.bindValue(":taskId", taskId);
+    if (!query.exec()) {
+        DbMetrics::recordError(query.lastError());
+        qWarning() << "删除保留策略失败：" << query.lastError().text();
+        return false;
+    }
+    return true;
+}
+
+// 获取全部保留策略（全局策略在首位）
+QList<RetentionPolicy> DatabaseManager::getRetentionPolicies() {
+    QList<RetentionPolicy> policies;
+    QSqlDatabase db = getThreadDatabase();
+    if (!db.isOpen()) {
+        qCritical() << "获取保留策略失败：数据库未打开";
+        return policies;
+    }
+
+    QSqlQuery query("SELECT taskId, rawDays, minuteDays, hourDays, dayDays FROM crawler_retention ORDER BY taskId", db);
+    while (query.next()) {
+        RetentionPolicy policy;
+        policy.taskId = query.value(0).toInt();
+        policy.rawDays = query.value(1).toInt();
+        policy.minuteDays = query.value(2).toInt();
+        policy.hourDays = query.value(3).toInt();
+        policy.dayDays = query.value(4).toInt();
+        policies.append(policy);
+    }
+    return policies;
+}
+
+// 封存 before 所在小时之前的全部原始数据
+qint64 DatabaseManager::sealTaskData(const QDateTime& before) {
+    qint64 sealed = 0;
+    for (QSqlDatabase& db : dataDatabases()) {
+        if (!db.isOpen()) {
+            qCritical() << "封存数据失败：数据库未打开";
+            return -1;
+        }
+
+        QList<int> taskIds;
+        {
+            QSqlQuery query("SELECT DISTINCT taskId FROM crawler_data", db);
+            while (query.next()) {
+                taskIds.append(query.value(0).toInt());
+            }
+        }
+
+        for (int taskId : taskIds) {
+            const qint64 count = ChunkStore::sealBefore(db, taskId, before.toSecsSinceEpoch());
+            if (count < 0) {
+                return -1;
+            }
+            sealed += count;
+        }
+    }
+    return sealed;
+}
+
+// 读取保留的原始提取文本
+QList<QPair<QDateTime, QString>> DatabaseManager::getTaskRawText(int taskId, const QDateTime& from, const QDateTime& to) {
+    QList<QPair<QDateTime, QString>> texts;
+    QSqlDatabase db = getDataDatabase(taskId);
+    if (!db.isOpen()) {
+        qCritical() << "查询原始文本失败：数据库未打开";
+        return texts;
+    }
+
+    QSqlQuery query(db);
+    query.setForwardOnly(true);
+    query.prepare(R"(
+        SELECT crawlTime, content FROM crawler_data
+        WHERE taskId = :taskId AND crawlTime BETWEEN :from AND :to AND hasRawText = 1
+        ORDER BY crawlTime
+    )");
+    query.bindValue(":taskId", taskId);
+    query.bindValue(":from", from.toString("yyyy-MM-dd HH:mm:ss"));
+    query.bindValue(":to", to.toString("yyyy-MM-dd HH:mm:ss"));
+    if (!query.exec()) {
+        DbMetrics::recordError(query.lastError());
+        qWarning() << "查询原始文本失败：" << query.lastError().text();
+        return texts;
+    }
+
+    while (query.next()) {
+        texts.append(qMakePair(QDateTime::fromString(query.value(0).toString(), "yyyy-MM-dd HH:mm:ss"),
+                               query.value(1).toString()));
+    }
+    return texts;
+}
@@ -1,61 +1,236 @@
-#ifndef DATABASEMANAGER_H
-#define DATABASEMANAGER_H
-
-#include <QObject>
-#include <QList>
-#include <QString>
-#include <QDateTime>
-#include <QSqlDatabase>
-#include <QSqlQuery>
-#include <QSqlError>
-#include <QDebug>
-#include <QMutex>
-#include <QThread>
-#include <QUuid>
-
-// 爬虫任务结构体
-struct CrawlerTask {
-    int id = 0;
-    QString name = "";
-    QString url = "";
-    int interval = 5;
-    QString rule = "";
-};
-
-// 爬虫数据结构体
-struct CrawlerData {
-    int taskId = 0;
-    QString content = "";
-    double value = 0.0;
-    QDateTime crawlTime = QDateTime::currentDateTime();
-};
-
-// 数据库管理类（多线程安全）
-class DatabaseManager {
-public:
-    // 获取当前线程的独立数据库连接
-    static QSqlDatabase getThreadDatabase();
-
-    // 初始化数据表结构（主线程调用一次）
-    static bool initDatabaseSchema();
-
-    // 任务管理接口
-    static bool saveCrawlerTask(const CrawlerTask& task);
-    static QList<CrawlerTask> getAllTasks();
-    static CrawlerTask getTaskById(int taskId);
-
-    // 数据管理接口
-    static bool saveCrawlerData(const CrawlerData& data);
-    static QList<CrawlerData> getTaskData(int taskId);
-
-private:
-    // 禁止实例化
-    DatabaseManager() = delete;
-    ~DatabaseManager() = delete;
-    DatabaseManager(const DatabaseManager&) = delete;
-    DatabaseManager& operator=(const DatabaseManager&) = delete;
-
-    static QMutex m_mutex; // 线程安全锁
-};
-
-#endif // DATABASEMANAGER_H
+#ifndef DATABASEMANAGER_H
+#define DATABASEMANAGER_H
+
+#include <QObject>
+#include <QList>
+#include <QString>
+#include <QDateTime>
+#include <QSqlDatabase>
+#include <QSqlQuery>
+#include <QSqlError>
+#include <QDebug>
+#include <QMutex>
+#include <QThread>
+#include <QUuid>
+#include <QPair>
+#include <QHash>
+#include <QFuture>
+#include <QPromise>
+#include <QThreadPool>
+#include <memory>
+#include <type_traits>
+#include "rollupstore.h"
+#include "responsearchive.h"
+#include "fulltextindex.h"
+
+// 爬虫任务结构体
+struct CrawlerTask {
+    int id = 0;
+    QString name = "";
+    QString url = "";
+    int interval = 5;
+    QString rule = "";
+    // 变化存储容差：<0 表示每次爬取都存储；>=0 时仅在数值变化超过容差时新增一行，
+    // 否则延长上一行的 lastSeen（读取时展开为阶梯）
+    double changeTolerance = -1.0;
+    // 是否在 crawler_data.content 中保留页面上提取出的原始文本（默认不保留）
+    bool keepRawText = false;
+};
+
+// 数据点标志位
+enum CrawlerDataFlag : quint32 {
+    DataFlagNone = 0,
+    DataFlagRunEnd = 0x1,      // 变化存储区间的末端（由 lastSeen 展开）
+    DataFlagSealed = 0x2,      // 来自已封存的压缩块
+    DataFlagSimulated = 0x4,   // 模拟数据
+    DataFlagHasRawText = 0x8,  // 库中保留了原始提取文本（getTaskRawText 读取）
+};
+
+// 爬虫数据点（可平凡复制，24 字节，经队列信号传递时无堆分配）
+struct CrawlerData {
+    int taskId = 0;
+    quint32 flags = DataFlagNone;
+    qint64 timestampMs = 0;   // 爬取时间（Unix 毫秒）
+    double value = 0.0;
+
+    QDateTime crawlTime() const { return QDateTime::fromMSecsSinceEpoch(timestampMs); }
+};
+static_assert(std::is_trivially_copyable<CrawlerData>::value, "CrawlerData 必须可平凡复制");
+static_assert(sizeof(CrawlerData) == 24, "CrawlerData 应保持 24 字节");
+
+// 任务的最新值（crawler_task_latest，写入数据时在同一事务内更新），任务表据此显示最新值、时间与趋势
+struct TaskLatest {
+    int taskId = 0;
+    double value = 0.0;
+    double previousValue = 0.0;
+    bool hasPrevious = false;
+    qint64 timestampMs = 0;
+
+    bool isValid() const { return timestampMs > 0; }
+    // 相对上一个样本：1 上升，-1 下降，0 持平或没有上一个样本
+    int trend() const { return !hasPrevious || value == previousValue ? 0 : (value > previousValue ? 1 : -1); }
+};
+
+// 爬取数据的存储后端：SQLite 表，或内存映射的追加式段文件（SegmentStore）
+// 任务、保留策略与汇总表始终在 SQLite 中
+enum class DataBackend {
+    Sqlite,
+    Segment
+};
+
+// 数据保留策略（天数，0 表示永久保留）
+struct RetentionPolicy {
+    int taskId = 0;      // 0 表示全局默认策略
+    int rawDays = 90;    // 原始数据
+    int minuteDays = 180;
+    int hourDays = 730;
+    int dayDays = 0;
+};
+
+// 数据库管理类（多线程安全）
+class DatabaseManager {
+public:
+    // 获取当前线程的独立数据库连接（主库：任务、调度、保留策略等元数据）
+    static QSqlDatabase getThreadDatabase();
+
+    // 数据分片：爬取数据按 taskId % K 分到 K 个库文件（K=1 时与主库同一文件）
+    // 不同分片的写入互不等待；分片数记录在主库中，须在 initDatabaseSchema 之前设置
+    static void setDataShardCount(int shards);
+    static int dataShardCount();
+    static int dataShardOf(int taskId);
+    static QString dataShardPath(int shard);
+    // 当前线程连到某个分片 / 某任务所在分片的连接
+    static QSqlDatabase getShardDatabase(int shard);
+    static QSqlDatabase getDataDatabase(int taskId);
+    // 当前线程到全部数据分片的连接（跨任务的封存、重建汇总、统计）
+    static QList<QSqlDatabase> dataDatabases();
+
+    // 数据库文件路径（默认 crawler_data.db，需在首次建立连接前设置）
+    static void setDatabasePath(const QString& path);
+    static QString databasePath();
+
+    // 数据存储后端（默认 SQLite，需在启动爬虫线程前设置）
+    static void setDataBackend(DataBackend backend);
+    static DataBackend dataBackend();
+
+    // 全文索引（FTS5，默认关闭，须在 initDatabaseSchema 之前设置）：索引保留的提取文本与归档的响应体
+    // 建立后由触发器与归档线程维护；关闭开关只是不再新建，已有索引继续维护
+    static void setFullTextIndexEnabled(bool enabled);
+    static bool fullTextIndexEnabled();
+
+    // 初始化数据表结构（主线程调用一次）
+    static bool initDatabaseSchema();
+    // 切换为 WAL 日志：读不阻塞写，写入仍逐个进行（设置保存在库文件中）
+    // 多进程共享同一数据库文件与在线备份都依赖这一点
+    static bool enableWriteAheadLog();
+
+    // 任务管理接口
+    static bool saveCrawlerTask(const CrawlerTask& task);
+    // 批量新增任务（单事务），返回新任务ID，失败时整体回滚并返回空列表
+    static QList<int> saveCrawlerTasks(const QList<CrawlerTask>& tasks);
+    static QList<CrawlerTask> getAllTasks();
+    static CrawlerTask getTaskById(int taskId);
+
+    // 数据管理接口
+    // changeTolerance >= 0 时按变化存储模式写入；rawText 非空时一并保存原始提取文本（仅 SQLite 后端）
+    static bool saveCrawlerData(const CrawlerData& data, double changeTolerance = -1.0,
+                                const QString& rawText = QString());
+    static QList<CrawlerData> getTaskData(int taskId);
+    // 最新的 limit 个数据点（按时间升序），只读取表尾与最后的压缩块，不加载全部历史
+    static QList<CrawlerData> getLatestTaskData(int taskId, int limit);
+    // 读取 [from, to] 内保留的原始提取文本（仅 keepRawText 的任务有数据）
+    static QList<QPair<QDateTime, QString>> getTaskRawText(int taskId, const QDateTime& from, const QDateTime& to);
+    // 全文检索：在全部数据库文件的提取文本与主库的响应体中按子串检索，按相关度返回最多 limit 条
+    // 未建立索引或检索词短于 FullTextIndex::kMinQueryLength 时返回空
+    static QList<SearchHit> searchText(const QString& text, int limit = 100);
+
+    // 汇总查询接口：返回 [from, to] 内不超过 maxPoints 个点的序列
+    // 原始数据量足够小时按原始粒度返回（每点 count=1），否则使用分钟/小时/天汇总
+    static QList<RollupPoint> getTaskSeries(int taskId, const QDateTime& from, const QDateTime& to,
+                                            int maxPoints, RollupResolution* usedResolution = nullptr);
+    // 任务数据的首末时间，无数据返回 false
+    static bool getTaskTimeRange(int taskId, QDateTime* first, QDateTime* last);
+    // [from, to] 内的统计量（数量、极值、均值、标准差、最新值、P50/P95）
+    // SQLite 后端由汇总表计算，不读取原始数据；段存储后端流式扫描窗口，不缓存数据点
+    static TaskStatistics getTaskStatistics(int taskId, const QDateTime& from, const QDateTime& to);
+    // 多个任务同一窗口的统计量（任务表使用），没有数据的任务不在结果中
+    static QHash<int, TaskStatistics> getTasksStatistics(const QList<int>& taskIds, const QDateTime& from,
+                                                         const QDateTime& to);
+    // 全部任务的最新值（每个数据库文件一次查询，不读取原始数据），没有数据的任务不在结果中
+    static QHash<int, TaskLatest> getLatestValues();
+    // 按原始数据重建全部汇总
+    static bool rebuildRollups();
+    // 把 before 所在小时之前的原始数据封存为 Gorilla 压缩块（仅 SQLite 后端），返回封存的点数，失败返回 -1
+    // 封存后的数据仍由 getTaskData / getTaskSeries 透明读取
+    static qint64 sealTaskData(const QDateTime& before);
+
+    // 用新规则重新解析 [from, to] 内归档的原始响应（需开启响应归档）
+    // apply=true 时写回数据点并重建该任务的汇总；段存储后端只返回结果不写回
+    static ReextractResult reextractTaskData(int taskId, const QString& rule, const QDateTime& from,
+                                             const QDateTime& to, bool apply);
+
+    // 异步读取接口：查询在专用读取线程池中执行，供界面线程使用，避免锁等待或大范围扫描卡住界面
+    // 对返回的 QFuture 调用 cancel() 即丢弃该查询：尚未开始的直接跳过，已在执行的完成后不再提交结果
+    template <typename Fn>
+    static QFuture<std::invoke_result_t<Fn>> readAsync(Fn fn);
+    static QFuture<QList<CrawlerTask>> getAllTasksAsync();
+    static QFuture<CrawlerTask> getTaskByIdAsync(int taskId);
+    static QFuture<QList<CrawlerData>> getTaskDataAsync(int taskId);
+    static QFuture<QList<RollupPoint>> getTaskSeriesAsync(int taskId, const QDateTime& from, const QDateTime& to,
+                                                          int maxPoints);
+    static QFuture<QHash<int, TaskLatest>> getLatestValuesAsync();
+    static QFuture<QList<SearchHit>> searchTextAsync(const QString& text, int limit = 100);
+    static QFuture<QHash<int, TaskStatistics>> getTasksStatisticsAsync(const QList<int>& taskIds,
+                                                                       const QDateTime& from, const QDateTime& to);
+    // 等待进行中的异步查询结束并退出读取线程（程序退出前调用）
+    static void stopReaders();
+
+    // 保留策略接口（由 RetentionWorker 在后台执行）
+    static bool saveRetentionPolicy(const RetentionPolicy& policy);
+    static bool removeRetentionPolicy(int taskId);
+    static QList<RetentionPolicy> getRetentionPolicies();
+
+private:
+    // 禁止实例化
+    DatabaseManager() = delete;
+    ~DatabaseManager() = delete;
+    DatabaseManager(const DatabaseManager&) = delete;
+    DatabaseManager& operator=(const DatabaseManager&) = delete;
+
+    // 读取线程池（线程常驻，各自持有一个连接）
+    static QSqlDatabase openThreadConnection(const QString& path); // 调用方已持有 m_mutex
+    static QString dataShardPathLocked(int shard);
+    static bool resolveDataShards(QSqlDatabase& db);
+
+    static QThreadPool* readerPool();
+    static void asyncQueued();
+    static void asyncFinished(bool canceled);
+
+    static QMutex m_mutex; // 线程安全锁
+    static QString m_databasePath; // 共享数据库文件路径
+    static DataBackend m_dataBackend;
+    static int m_dataShards; // 数据分片数
+    static bool m_fullTextIndex;
+};
+
+template <typename Fn>
+QFuture<std::invoke_result_t<Fn>> DatabaseManager::readAsync(Fn fn)
+{
+    using Result = std::invoke_result_t<Fn>;
+    // QPromise 只能移动，由共享指针带入任务
+    auto promise = std::make_shared<QPromise<Result>>();
+    QFuture<Result> future = promise->future();
+    promise->start();
+    asyncQueued();
+    readerPool()->start([promise, fn]() {
+        const bool canceled = promise->isCanceled();
+        if (!canceled) {
+            promise->addResult(fn());
+        }
+        promise->finish();
+        asyncFinished(canceled || promise->isCanceled());
+    });
+    return future;
+}
+
+#endif // DATABASEMANAGER_H
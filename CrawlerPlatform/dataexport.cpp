@@ -0,0 +1,780 @@
+#include "dataexport.h"
+#include "databasemanager.h"
+#include "chunkstore.h"
+#include "segmentstore.h"
+#include "taskregistry.h"
+#include "metrics.h"
+#include <QSaveFile>
+#include <QFileInfo>
+#include <QSqlQuery>
+#include <QSqlError>
+#include <QElapsedTimer>
+#include <QLocale>
+#include <QHash>
+#include <QtEndian>
+#include <QDebug>
+#include <algorithm>
+#include <limits>
+#include <memory>
+#include <cstring>
+
+// 进度回调的最小间隔（毫秒）
+static const qint64 kProgressIntervalMs = 200;
+
+// 导出指标（首次使用时注册）
+struct ExportMetrics {
+    MetricCounter* rows;
+    MetricCounter* bytes;
+    MetricHistogram* duration;
+
+    static const ExportMetrics& get()
+    {
+        static const ExportMetrics metrics = []() {
+            MetricsRegistry& registry = MetricsRegistry::instance();
+            ExportMetrics m;
+            m.rows = registry.counter("crawler_export_rows_total", "导出的数据点数");
+            m.bytes = registry.counter("crawler_export_bytes_total", "导出文件的字节数");
+            m.duration = registry.histogram("crawler_export_duration_seconds", "单次导出耗时");
+            return m;
+        }();
+        return metrics;
+    }
+};
+
+// 一批待写出的数据点（按列存放，Arrow 直接把各列作为缓冲写出）
+struct ExportBatch {
+    QList<qint32> taskIds;
+    QList<qint64> timestampsMs;
+    QList<double> values;
+
+    void reserve(qsizetype rows)
+    {
+        taskIds.reserve(rows);
+        timestampsMs.reserve(rows);
+        values.reserve(rows);
+    }
+    void append(int taskId, qint64 timestampMs, double value)
+    {
+        taskIds.append(taskId);
+        timestampsMs.append(timestampMs);
+        values.append(value);
+    }
+    // 保留容量，下一批复用
+    void clear()
+    {
+        taskIds.clear();
+        timestampsMs.clear();
+        values.clear();
+    }
+    qsizetype size() const { return values.size(); }
+};
+
+// crawler_data.crawlTime 为本地时间 "yyyy-MM-dd HH:mm:ss"
+// 同一小时内只做一次时区换算，分秒直接计算，避免逐行构造 QDateTime
+class LocalTimeCache
+{
+public:
+    void format(QByteArray& out, qint64 ms)
+    {
+        if (ms < m_formatHourMs || ms >= m_formatHourMs + 3600000) {
+            const QDateTime time = QDateTime::fromMSecsSinceEpoch(ms);
+            const QDateTime hour(time.date(), QTime(time.time().hour(), 0));
+            m_formatHourMs = hour.toMSecsSinceEpoch();
+            m_formatPrefix = hour.toString("yyyy-MM-dd HH:").toLatin1();
+            if (ms < m_formatHourMs || ms >= m_formatHourMs + 3600000) {
+                // 夏令时切换附近的小时，逐个格式化
+                m_formatHourMs = std::numeric_limits<qint64>::max() / 2;
+                out += time.toString("yyyy-MM-dd HH:mm:ss").toLatin1();
+                return;
+            }
+        }
+        const int secs = static_cast<int>((ms - m_formatHourMs) / 1000);
+        const char digits[5] = {char('0' + secs / 600), char('0' + secs / 60 % 10), ':',
+                                char('0' + secs % 60 / 10), char('0' + secs % 10)};
+        out += m_formatPrefix;
+        out.append(digits, 5);
+    }
+
+    qint64 parse(const QString& text)
+    {
+        if (text.size() != 19 || text.at(16) != ':') {
+            return QDateTime::fromString(text, "yyyy-MM-dd HH:mm:ss").toMSecsSinceEpoch();
+        }
+        const QStringView hour = QStringView(text).left(13);
+        if (hour != m_parsePrefix) {
+            const QDateTime hourStart = QDateTime::fromString(hour.toString(), "yyyy-MM-dd HH");
+            if (!hourStart.isValid()) {
+                return QDateTime::fromString(text, "yyyy-MM-dd HH:mm:ss").toMSecsSinceEpoch();
+            }
+            m_parsePrefix = hour.toString();
+            m_parseHourMs = hourStart.toMSecsSinceEpoch();
+        }
+        const int minutes = text.at(14).digitValue() * 10 + text.at(15).digitValue();
+        const int seconds = text.at(17).digitValue() * 10 + text.at(18).digitValue();
+        return m_parseHourMs + (minutes * 60 + seconds) * 1000LL;
+    }
+
+private:
+    qint64 m_formatHourMs = std::numeric_limits<qint64>::max() / 2;
+    QByteArray m_formatPrefix;
+    QString m_parsePrefix;
+    qint64 m_parseHourMs = 0;
+};
+
+static bool writeAll(QIODevice* device, const QByteArray& data)
+{
+    return device->write(data) == data.size();
+}
+
+class ExportWriter
+{
+public:
+    virtual ~ExportWriter() = default;
+    virtual bool begin() = 0;
+    virtual bool write(const ExportBatch& batch) = 0;
+    virtual bool finish() = 0;
+};
+
+// CSV：task_id,time,value，时间为本地时间，数值取能精确还原的最短表示
+class CsvWriter : public ExportWriter
+{
+public:
+    explicit CsvWriter(QIODevice* device) : m_device(device) {}
+
+    bool begin() override { return writeAll(m_device, "task_id,time,value\n"); }
+
+    bool write(const ExportBatch& batch) override
+    {
+        m_buffer.resize(0);
+        for (qsizetype i = 0; i < batch.size(); i++) {
+            if (batch.taskIds.at(i) != m_taskId || m_taskPrefix.isEmpty()) {
+                m_taskId = batch.taskIds.at(i);
+                m_taskPrefix = QByteArray::number(m_taskId) + ',';
+            }
+            m_buffer += m_taskPrefix;
+            m_times.format(m_buffer, batch.timestampsMs.at(i));
+            m_buffer += ',';
+            m_buffer += QByteArray::number(batch.values.at(i), 'g', QLocale::FloatingPointShortest);
+            m_buffer += '\n';
+        }
+        return writeAll(m_device, m_buffer);
+    }
+
+    bool finish() override { return true; }
+
+private:
+    QIODevice* m_device;
+    QByteArray m_buffer;
+    QByteArray m_taskPrefix;
+    int m_taskId = 0;
+    LocalTimeCache m_times;
+};
+
+// ---- Arrow IPC 文件格式（不依赖 Arrow 库） ----
+// 元数据是 FlatBuffers 编码的 Schema / RecordBatch / Footer，这里只实现用到的表、结构体向量、字符串与联合。
+// 顺序写入：先写 vtable 与表，子对象随后写在更高的地址再回填偏移（uoffset 只能指向更高地址）
+class FlatWriter
+{
+public:
+    struct Field {
+        int id;
+        QByteArray bytes;      // 标量的小端字节；偏移字段为 4 字节占位
+        bool isOffset = false;
+    };
+
+    FlatWriter() { m_buf.append(4, '\0'); } // 根表偏移
+
+    template <typename T>
+    static Field scalar(int id, T value)
+    {
+        const T le = qToLittleEndian(value);
+        return {id, QByteArray(reinterpret_cast<const char*>(&le), sizeof(T)), false};
+    }
+    static Field offset(int id) { return {id, QByteArray(4, '\0'), true}; }
+
+    // 写一张表，返回表的位置；偏移字段的位置按字段 id 写入 slots，由调用方写完子对象后回填
+    int table(QList<Field> fields, QHash<int, int>* slots = nullptr)
+    {
+        // 表起点对齐到 8n+4，跳过 4 字节的 vtable 偏移后字段按大小降序排列即自然对齐
+        std::stable_sort(fields.begin(), fields.end(), [](const Field& a, const Field& b) {
+            return a.bytes.size() > b.bytes.size();
+        });
+        int maxId = -1;
+        int tableSize = 4;
+        for (const Field& field : std::as_const(fields)) {
+            maxId = qMax(maxId, field.id);
+            tableSize += static_cast<int>(field.bytes.size());
+        }
+        const int vtableSize = 4 + 2 * (maxId + 1);
+        while ((m_buf.size() + vtableSize) % 8 != 4) {
+            m_buf.append('\0');
+        }
+
+        const int vtablePos = static_cast<int>(m_buf.size());
+        QList<quint16> vtable(maxId + 3, 0);
+        vtable[0] = static_cast<quint16>(vtableSize);
+        vtable[1] = static_cast<quint16>(tableSize);
+        int fieldOffset = 4;
+        for (const Field& field : std::as_const(fields)) {
+            vtable[2 + field.id] = static_cast<quint16>(fieldOffset);
+            fieldOffset += static_cast<int>(field.bytes.size());
+        }
+        for (quint16 entry : std::as_const(vtable)) {
+            append<quint16>(entry);
+        }
+
+        const int tablePos = static_cast<int>(m_buf.size());
+        append<qint32>(tablePos - vtablePos);
+        for (const Field& field : std::as_const(fields)) {
+            if (field.isOffset && slots) {
+                slots->insert(field.id, static_cast<int>(m_buf.size()));
+            }
+            m_buf.append(field.bytes);
+        }
+        return tablePos;
+    }
+
+    int string(const QByteArray& text)
+    {
+        align(4);
+        const int pos = static_cast<int>(m_buf.size());
+        append<quint32>(static_cast<quint32>(text.size()));
+        m_buf.append(text);
+        m_buf.append('\0');
+        return pos;
+    }
+
+    // 结构体向量（Arrow 的结构体都按 8 字节对齐）
+    int structVector(const QByteArray& elements, int count)
+    {
+        while ((m_buf.size() + 4) % 8 != 0) {
+            m_buf.append('\0');
+        }
+        const int pos = static_cast<int>(m_buf.size());
+        append<quint32>(static_cast<quint32>(count));
+        m_buf.append(elements);
+        return pos;
+    }
+
+    // 表的向量：元素为偏移，位置写入 slots 待回填
+    int offsetVector(int count, QList<int>* slots)
+    {
+        align(4);
+        const int pos = static_cast<int>(m_buf.size());
+        append<quint32>(static_cast<quint32>(count));
+        for (int i = 0; i < count; i++) {
+            slots->append(static_cast<int>(m_buf.size()));
+            append<quint32>(0);
+        }
+        return pos;
+    }
+
+    void patch(int slot, int target)
+    {
+        const quint32 le = qToLittleEndian(static_cast<quint32>(target - slot));
+        std::memcpy(m_buf.data() + slot, &le, sizeof(le));
+    }
+
+    // 回填根表偏移，总长补齐到 8 字节
+    QByteArray finish(int root)
+    {
+        patch(0, root);
+        align(8);
+        return m_buf;
+    }
+
+    template <typename T>
+    static void appendTo(QByteArray& out, T value)
+    {
+        const T le = qToLittleEndian(value);
+        out.append(reinterpret_cast<const char*>(&le), sizeof(T));
+    }
+
+private:
+    template <typename T>
+    void append(T value) { appendTo<T>(m_buf, value); }
+
+    void align(int n)
+    {
+        while (m_buf.size() % n != 0) {
+            m_buf.append('\0');
+        }
+    }
+
+    QByteArray m_buf;
+};
+
+// Arrow 元数据常量（format/Schema.fbs、Message.fbs、File.fbs）
+static const qint16 kArrowMetadataV5 = 4;
+static const quint8 kArrowTypeInt = 2;
+static const quint8 kArrowTypeFloatingPoint = 3;
+static const quint8 kArrowTypeTimestamp = 10;
+static const quint8 kArrowHeaderSchema = 1;
+static const quint8 kArrowHeaderRecordBatch = 3;
+static const qint16 kArrowPrecisionDouble = 2;
+static const qint16 kArrowUnitMillisecond = 1;
+static const int kArrowColumns = 3;
+
+// 消息在文件中的位置（File.fbs 的 Block）
+struct ArrowBlock {
+    qint64 offset = 0;
+    qint32 metadataLength = 0;
+    qint64 bodyLength = 0;
+};
+
+template <typename TypeFn>
+static int writeArrowField(FlatWriter& fb, const QByteArray& name, quint8 typeType, TypeFn writeType)
+{
+    QHash<int, int> slots;
+    const int field = fb.table({FlatWriter::offset(0),                        // name
+                                FlatWriter::scalar<quint8>(1, 0),             // nullable
+                                FlatWriter::scalar<quint8>(2, typeType),      // type_type
+                                FlatWriter::offset(3),                        // type
+                                FlatWriter::offset(5)},                       // children
+                               &slots);
+    fb.patch(slots.value(0), fb.string(name));
+    fb.patch(slots.value(3), writeType());
+    QList<int> noChildren;
+    fb.patch(slots.value(5), fb.offsetVector(0, &noChildren));
+    return field;
+}
+
+// task_id int32, time timestamp[ms, UTC], value double，均不可为空
+static int writeArrowSchema(FlatWriter& fb)
+{
+    QHash<int, int> slots;
+    const qint16 endianness = Q_BYTE_ORDER == Q_LITTLE_ENDIAN ? 0 : 1;
+    const int schema = fb.table({FlatWriter::scalar<qint16>(0, endianness), FlatWriter::offset(1)}, &slots);
+    QList<int> fieldSlots;
+    fb.patch(slots.value(1), fb.offsetVector(kArrowColumns, &fieldSlots));
+
+    fb.patch(fieldSlots.at(0), writeArrowField(fb, "task_id", kArrowTypeInt, [&fb]() {
+        return fb.table({FlatWriter::scalar<qint32>(0, 32), FlatWriter::scalar<quint8>(1, 1)});
+    }));
+    fb.patch(fieldSlots.at(1), writeArrowField(fb, "time", kArrowTypeTimestamp, [&fb]() {
+        QHash<int, int> typeSlots;
+        const int type = fb.table({FlatWriter::scalar<qint16>(0, kArrowUnitMillisecond), FlatWriter::offset(1)},
+                                  &typeSlots);
+        fb.patch(typeSlots.value(1), fb.string("UTC"));
+        return type;
+    }));
+    fb.patch(fieldSlots.at(2), writeArrowField(fb, "value", kArrowTypeFloatingPoint, [&fb]() {
+        return fb.table({FlatWriter::scalar<qint16>(0, kArrowPrecisionDouble)});
+    }));
+    return schema;
+}
+
+static QByteArray arrowSchemaMessage()
+{
+    FlatWriter fb;
+    QHash<int, int> slots;
+    const int message = fb.table({FlatWriter::scalar<qint16>(0, kArrowMetadataV5),
+                                  FlatWriter::scalar<quint8>(1, kArrowHeaderSchema),
+                                  FlatWriter::offset(2),
+                                  FlatWriter::scalar<qint64>(3, 0)},
+                                 &slots);
+    fb.patch(slots.value(2), writeArrowSchema(fb));
+    return fb.finish(message);
+}
+
+// buffers：消息体内各缓冲的 (偏移, 长度)，每列一个有效位缓冲（长度 0）和一个数据缓冲
+static QByteArray arrowRecordBatchMessage(qint64 rows, const QList<QPair<qint64, qint64>>& buffers, qint64 bodyLength)
+{
+    FlatWriter fb;
+    QHash<int, int> slots;
+    const int message = fb.table({FlatWriter::scalar<qint16>(0, kArrowMetadataV5),
+                                  FlatWriter::scalar<quint8>(1, kArrowHeaderRecordBatch),
+                                  FlatWriter::offset(2),
+                                  FlatWriter::scalar<qint64>(3, bodyLength)},
+                                 &slots);
+    QHash<int, int> batchSlots;
+    const int batch = fb.table({FlatWriter::scalar<qint64>(0, rows), FlatWriter::offset(1), FlatWriter::offset(2)},
+                               &batchSlots);
+    fb.patch(slots.value(2), batch);
+
+    QByteArray nodes;
+    for (int i = 0; i < kArrowColumns; i++) {
+        FlatWriter::appendTo<qint64>(nodes, rows); // length
+        FlatWriter::appendTo<qint64>(nodes, 0);    // null_count
+    }
+    fb.patch(batchSlots.value(1), fb.structVector(nodes, kArrowColumns));
+
+    QByteArray bufferBytes;
+    for (const auto& buffer : buffers) {
+        FlatWriter::appendTo<qint64>(bufferBytes, buffer.first);
+        FlatWriter::appendTo<qint64>(bufferBytes, buffer.second);
+    }
+    fb.patch(batchSlots.value(2), fb.structVector(bufferBytes, static_cast<int>(buffers.size())));
+    return fb.finish(message);
+}
+
+static QByteArray arrowFooter(const QList<ArrowBlock>& blocks)
+{
+    FlatWriter fb;
+    QHash<int, int> slots;
+    const int footer = fb.table({FlatWriter::scalar<qint16>(0, kArrowMetadataV5),
+                                 FlatWriter::offset(1),   // schema
+                                 FlatWriter::offset(2),   // dictionaries
+                                 FlatWriter::offset(3)},  // recordBatches
+                                &slots);
+    fb.patch(slots.value(1), writeArrowSchema(fb));
+    fb.patch(slots.value(2), fb.structVector(QByteArray(), 0));
+
+    QByteArray blockBytes;
+    for (const ArrowBlock& block : blocks) {
+        FlatWriter::appendTo<qint64>(blockBytes, block.offset);
+        FlatWriter::appendTo<qint32>(blockBytes, block.metadataLength);
+        FlatWriter::appendTo<qint32>(blockBytes, 0); // 结构体填充
+        FlatWriter::appendTo<qint64>(blockBytes, block.bodyLength);
+    }
+    fb.patch(slots.value(3), fb.structVector(blockBytes, static_cast<int>(blocks.size())));
+    return fb.finish(footer);
+}
+
+// 文件布局：魔数 | Schema 消息 | RecordBatch 消息... | 流结束标记 | Footer | Footer 长度 | 魔数
+class ArrowWriter : public ExportWriter
+{
+public:
+    explicit ArrowWriter(QIODevice* device) : m_device(device) {}
+
+    bool begin() override
+    {
+        return write(QByteArray("ARROW1\0\0", 8)) && writeMessage(arrowSchemaMessage(), QByteArray(), nullptr);
+    }
+
+    bool write(const ExportBatch& batch) override
+    {
+        // 各列缓冲依次放入消息体，每个按 8 字节对齐；没有空值，有效位缓冲长度为 0
+        const qint64 rows = batch.size();
+        QList<QPair<qint64, qint64>> buffers;
+        m_body.resize(0);
+        auto appendColumn = [&](const void* data, qint64 bytes) {
+            buffers.append(qMakePair(static_cast<qint64>(m_body.size()), qint64(0)));
+            buffers.append(qMakePair(static_cast<qint64>(m_body.size()), bytes));
+            m_body.append(static_cast<const char*>(data), bytes);
+            while (m_body.size() % 8 != 0) {
+                m_body.append('\0');
+            }
+        };
+        appendColumn(batch.taskIds.constData(), rows * static_cast<qint64>(sizeof(qint32)));
+        appendColumn(batch.timestampsMs.constData(), rows * static_cast<qint64>(sizeof(qint64)));
+        appendColumn(batch.values.constData(), rows * static_cast<qint64>(sizeof(double)));
+
+        ArrowBlock block;
+        if (!writeMessage(arrowRecordBatchMessage(rows, buffers, m_body.size()), m_body, &block)) {
+            return false;
+        }
+        m_blocks.append(block);
+        return true;
+    }
+
+    bool finish() override
+    {
+        QByteArray tail;
+        FlatWriter::appendTo<quint32>(tail, 0xFFFFFFFFu); // 流结束标记
+        FlatWriter::appendTo<qint32>(tail, 0);
+        const QByteArray footer = arrowFooter(m_blocks);
+        tail += footer;
+        FlatWriter::appendTo<qint32>(tail, static_cast<qint32>(footer.size()));
+        tail += "ARROW1";
+        return write(tail);
+    }
+
+private:
+    bool write(const QByteArray& data)
+    {
+        m_offset += data.size();
+        return writeAll(m_device, data);
+    }
+
+    // 封装消息：续接标记 0xFFFFFFFF | 元数据长度 | FlatBuffers 元数据（已补齐到 8 字节）| 消息体
+    bool writeMessage(const QByteArray& metadata, const QByteArray& body, ArrowBlock* block)
+    {
+        if (block) {
+            block->offset = m_offset;
+            block->metadataLength = static_cast<qint32>(8 + metadata.size());
+            block->bodyLength = body.size();
+        }
+        QByteArray header;
+        FlatWriter::appendTo<quint32>(header, 0xFFFFFFFFu);
+        FlatWriter::appendTo<qint32>(header, static_cast<qint32>(metadata.size()));
+        return write(header) && write(metadata) && (body.isEmpty() || write(body));
+    }
+
+    QIODevice* m_device;
+    QByteArray m_body;
+    QList<ArrowBlock> m_blocks;
+    qint64 m_offset = 0;
+};
+
+// ---- 数据读取 ----
+
+// 按时间顺序把一个任务在 [fromMs, toMs] 内的数据点交给 emitPoint（返回 false 表示停止）
+// 顺序与 getTaskData 一致：已封存的压缩块在前，迟到的原始行按时间并入，其余原始行用只进游标逐行读取
+template <typename EmitFn>
+static bool exportTask(int taskId, qint64 fromMs, qint64 toMs, LocalTimeCache& times, EmitFn emitPoint)
+{
+    if (DatabaseManager::dataBackend() == DataBackend::Segment) {
+        SegmentStore::instance().scan(taskId, fromMs, toMs, [&](qint64 timestampMs, double value) {
+            return emitPoint(timestampMs, value);
+        });
+        return true;
+    }
+
+    QSqlDatabase db = DatabaseManager::getDataDatabase(taskId);
+    if (!db.isOpen()) {
+        return false;
+    }
+    const QString timeFormat = "yyyy-MM-dd HH:mm:ss";
+    const bool fromSet = fromMs > std::numeric_limits<qint64>::min() / 2;
+    const QString fromText = fromSet ? QDateTime::fromMSecsSinceEpoch(fromMs).toString(timeFormat) : QString("");
+    const QString toText = toMs < std::numeric_limits<qint64>::max() / 2
+                         ? QDateTime::fromMSecsSinceEpoch(toMs).toString(timeFormat) : QString("9999-12-31 23:59:59");
+
+    // 变化存储合并的行展开为区间两端的同值点，并裁剪到导出区间内
+    QList<QPair<qint64, double>> early;
+    auto expandRow = [&](const QSqlQuery& row, QList<QPair<qint64, double>>* out) -> bool {
+        const double value = row.value(0).toDouble();
+        const qint64 startMs = times.parse(row.value(1).toString());
+        const QString lastSeen = row.value(2).toString();
+        const qint64 endMs = lastSeen.isEmpty() ? startMs : qMin(times.parse(lastSeen), toMs);
+        if (out) {
+            out->append(qMakePair(qMax(startMs, fromMs), value));
+            if (endMs > startMs) {
+                out->append(qMakePair(endMs, value));
+            }
+            return true;
+        }
+        bool more = emitPoint(qMax(startMs, fromMs), value);
+        if (more && endMs > startMs) {
+            more = emitPoint(endMs, value);
+        }
+        return more;
+    };
+
+    QSqlQuery query(db);
+    query.setForwardOnly(true);
+
+    // 起点之前开始、lastSeen 延续到区间内的那一行
+    if (fromSet) {
+        query.prepare(R"(
+            SELECT value, crawlTime, lastSeen FROM crawler_data
+            WHERE taskId = :taskId AND crawlTime < :from ORDER BY crawlTime DESC LIMIT 1
+        )");
+        query.bindValue(":taskId", taskId);
+        query.bindValue(":from", fromText);
+        if (query.exec() && query.next() && query.value(2).toString() >= fromText) {
+            expandRow(query, &early);
+        }
+        query.finish();
+    }
+
+    // 迟到的原始行（不晚于最后一个封存点）很少见，先读出来与压缩块按时间合并
+    const qint64 lastSealedSecs = ChunkStore::lastSealedSecs(db, taskId);
+    QString rawFromText = fromText;
+    bool rawFromInclusive = true;
+    if (lastSealedSecs > 0) {
+        const QString sealedText = QDateTime::fromSecsSinceEpoch(lastSealedSecs).toString(timeFormat);
+        if (sealedText >= fromText) {
+            query.prepare(R"(
+                SELECT value, crawlTime, lastSeen FROM crawler_data
+                WHERE taskId = :taskId AND crawlTime BETWEEN :from AND :to ORDER BY crawlTime
+            )");
+            query.bindValue(":taskId", taskId);
+            query.bindValue(":from", fromText);
+            query.bindValue(":to", qMin(sealedText, toText));
+            if (!query.exec()) {
+                qWarning() << "导出时读取原始数据失败：" << query.lastError().text();
+                return false;
+            }
+            while (query.next()) {
+                expandRow(query, &early);
+            }
+            query.finish();
+            rawFromText = sealedText;
+            rawFromInclusive = false;
+        }
+
+        std::stable_sort(early.begin(), early.end(), [](const QPair<qint64, double>& a, const QPair<qint64, double>& b) {
+            return a.first < b.first;
+        });
+        qsizetype next = 0;
+        bool more = true;
+        const bool scanned = ChunkStore::scan(db, taskId, fromMs / 1000, toMs / 1000, [&](qint64 secs, double value) {
+            // 压缩块的遍历无法中途停止，停止后只跳过剩余的点
+            while (more && next < early.size() && early.at(next).first <= secs * 1000) {
+                more = emitPoint(early.at(next).first, early.at(next).second);
+                next++;
+            }
+            if (more) {
+                more = emitPoint(secs * 1000, value);
+            }
+        });
+        if (!scanned) {
+            return false;
+        }
+        early.remove(0, next);
+        if (!more) {
+            return true;
+        }
+    }
+    for (const auto& point : std::as_const(early)) {
+        if (!emitPoint(point.first, point.second)) {
+            return true;
+        }
+    }
+
+    query.prepare(QString(R"(
+        SELECT value, crawlTime, lastSeen FROM crawler_data
+        WHERE taskId = :taskId AND crawlTime %1 :from AND crawlTime <= :to ORDER BY crawlTime
+    )").arg(rawFromInclusive ? ">=" : ">"));
+    query.bindValue(":taskId", taskId);
+    query.bindValue(":from", rawFromText);
+    query.bindValue(":to", toText);
+    if (!query.exec()) {
+        qWarning() << "导出时读取原始数据失败：" << query.lastError().text();
+        return false;
+    }
+    while (query.next()) {
+        if (!expandRow(query, nullptr)) {
+            break;
+        }
+    }
+    return true;
+}
+
+ExportOptions::Format ExportOptions::formatForPath(const QString& path)
+{
+    const QString suffix = QFileInfo(path).suffix().toLower();
+    return (suffix == "arrow" || suffix == "feather" || suffix == "ipc") ? Format::Arrow : Format::Csv;
+}
+
+DataExporter::DataExporter(const ExportOptions& options, QObject *parent)
+    : QThread(parent)
+    , m_options(options)
+{
+}
+
+DataExporter::~DataExporter()
+{
+    cancel();
+    wait();
+}
+
+void DataExporter::cancel()
+{
+    m_canceled = true;
+}
+
+void DataExporter::run()
+{
+    m_result = exportData(m_options, [this](qint64 rows, int tasksDone, int tasksTotal) {
+        emit progressChanged(rows, tasksDone, tasksTotal);
+        return !m_canceled.load();
+    });
+    emit exportFinished(m_result.ok, m_result.rows, m_result.error);
+}
+
+ExportResult DataExporter::exportData(const ExportOptions& options, const ProgressFn& progress)
+{
+    ExportResult result;
+    MetricTimer exportTimer(ExportMetrics::get().duration);
+
+    QList<int> taskIds = options.taskIds;
+    if (taskIds.isEmpty()) {
+        for (const auto& task : TaskRegistry::instance().tasks()) {
+            taskIds.append(task.id);
+        }
+    }
+    std::sort(taskIds.begin(), taskIds.end());
+    const qint64 fromMs = options.from.isValid() ? options.from.toMSecsSinceEpoch()
+                                                 : std::numeric_limits<qint64>::min() / 2;
+    const qint64 toMs = options.to.isValid() ? options.to.toMSecsSinceEpoch()
+                                             : std::numeric_limits<qint64>::max() / 2;
+
+    QSaveFile file(options.path);
+    if (!file.open(QIODevice::WriteOnly)) {
+        result.error = QString("无法写入文件：%1").arg(file.errorString());
+        return result;
+    }
+    std::unique_ptr<ExportWriter> writer;
+    if (options.format == ExportOptions::Format::Arrow) {
+        writer.reset(new ArrowWriter(&file));
+    } else {
+        writer.reset(new CsvWriter(&file));
+    }
+
+    const int batchRows = qMax(1, options.batchRows);
+    ExportBatch batch;
+    batch.reserve(batchRows);
+    bool canceled = false;
+    bool failed = !writer->begin();
+    int tasksDone = 0;
+    QElapsedTimer reportTimer;
+    reportTimer.start();
+
+    auto report = [&](bool force) {
+        if (!progress || (!force && reportTimer.elapsed() < kProgressIntervalMs)) {
+            return;
+        }
+        reportTimer.restart();
+        if (!progress(result.rows, tasksDone, static_cast<int>(taskIds.size()))) {
+            canceled = true;
+        }
+    };
+    auto flush = [&]() {
+        if (batch.size() == 0 || failed) {
+            return;
+        }
+        failed = !writer->write(batch);
+        result.rows += batch.size();
+        batch.clear();
+        report(false);
+    };
+
+    LocalTimeCache times;
+    for (int taskId : std::as_const(taskIds)) {
+        if (canceled || failed) {
+            break;
+        }
+        const bool ok = exportTask(taskId, fromMs, toMs, times, [&](qint64 timestampMs, double value) {
+            batch.append(taskId, timestampMs, value);
+            if (batch.size() >= batchRows) {
+                flush();
+            }
+            return !canceled && !failed;
+        });
+        if (!ok) {
+            result.error = QString("读取任务 %1 的数据失败").arg(taskId);
+            failed = true;
+            break;
+        }
+        tasksDone++;
+        report(false);
+    }
+    flush();
+    if (!canceled && !failed) {
+        failed = !writer->finish();
+    }
+
+    if (canceled || failed) {
+        file.cancelWriting();
+        if (canceled) {
+            result.error = "已取消";
+        } else if (result.error.isEmpty()) {
+            result.error = QString("写入文件失败：%1").arg(file.errorString());
+        }
+        return result;
+    }
+    if (!file.commit()) {
+        result.error = QString("写入文件失败：%1").arg(file.errorString());
+        return result;
+    }
+
+    result.ok = true;
+    result.bytes = QFileInfo(options.path).size();
+    ExportMetrics::get().rows->inc(static_cast<quint64>(result.rows));
+    ExportMetrics::get().bytes->inc(static_cast<quint64>(result.bytes));
+    report(true);
+    return result;
+}
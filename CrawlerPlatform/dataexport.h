@@ -0,0 +1,65 @@
+#ifndef DATAEXPORT_H
+#define DATAEXPORT_H
+
+#include <QThread>
+#include <QList>
+#include <QDateTime>
+#include <QString>
+#include <atomic>
+#include <functional>
+
+// 导出参数
+struct ExportOptions {
+    enum class Format { Csv, Arrow };
+
+    QString path;
+    Format format = Format::Csv;
+    QList<int> taskIds;      // 为空表示全部任务
+    QDateTime from;          // 无效表示不限
+    QDateTime to;
+    int batchRows = 65536;   // 每批读取并写出的行数（Arrow 即每个 RecordBatch 的行数）
+
+    // 按扩展名选择格式：.arrow / .feather / .ipc 为 Arrow IPC 文件，其余为 CSV
+    static Format formatForPath(const QString& path);
+};
+
+struct ExportResult {
+    bool ok = false;
+    qint64 rows = 0;
+    qint64 bytes = 0;
+    QString error;
+};
+
+// 历史数据流式导出（CSV 或 Arrow IPC 文件格式）
+// 按任务逐个用只进游标读取，攒满一批即写出，内存占用与总行数无关；
+// 输出先写临时文件，完成后替换目标文件，取消或失败时不留下半截文件
+class DataExporter : public QThread
+{
+    Q_OBJECT
+
+public:
+    explicit DataExporter(const ExportOptions& options, QObject *parent = nullptr);
+    ~DataExporter() override;
+
+    void cancel();
+    // 线程结束后读取
+    ExportResult result() const { return m_result; }
+
+    // 在调用线程中同步导出；progress 返回 false 时取消
+    using ProgressFn = std::function<bool(qint64 rows, int tasksDone, int tasksTotal)>;
+    static ExportResult exportData(const ExportOptions& options, const ProgressFn& progress = ProgressFn());
+
+signals:
+    void progressChanged(qint64 rows, int tasksDone, int tasksTotal);
+    void exportFinished(bool ok, qint64 rows, const QString& error);
+
+protected:
+    void run() override;
+
+private:
+    ExportOptions m_options;
+    ExportResult m_result;
+    std::atomic<bool> m_canceled{false};
+};
+
+#endif // DATAEXPORT_H
@@ -0,0 +1,79 @@
+#ifndef FASTRANDOM_H
+#define FASTRANDOM_H
+
+#include <QtGlobal>
+#include <cmath>
+
+// xoshiro256** 伪随机数发生器
+// 非线程安全：每个工作线程/任务持有独立实例，无全局锁，不影响其他线程的序列
+class FastRandom
+{
+public:
+    explicit FastRandom(quint64 seed = 0x9E3779B97F4A7C15ull) { reseed(seed); }
+
+    // 用 splitmix64 展开种子，避免全零状态
+    void reseed(quint64 seed)
+    {
+        for (quint64& s : m_state) {
+            seed += 0x9E3779B97F4A7C15ull;
+            quint64 z = seed;
+            z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ull;
+            z = (z ^ (z >> 27)) * 0x94D049BB133111EBull;
+            s = z ^ (z >> 31);
+        }
+        m_hasSpare = false;
+    }
+
+    quint64 next()
+    {
+        const quint64 result = rotl(m_state[1] * 5, 7) * 9;
+        const quint64 t = m_state[1] << 17;
+        m_state[2] ^= m_state[0];
+        m_state[3] ^= m_state[1];
+        m_state[1] ^= m_state[2];
+        m_state[0] ^= m_state[3];
+        m_state[2] ^= t;
+        m_state[3] = rotl(m_state[3], 45);
+        return result;
+    }
+
+    // [0, 1)
+    double nextDouble() { return static_cast<double>(next() >> 11) * (1.0 / 9007199254740992.0); }
+
+    // [lo, hi)
+    double uniform(double lo, double hi) { return lo + (hi - lo) * nextDouble(); }
+
+    // [0, n)
+    quint64 bounded(quint64 n) { return n == 0 ? 0 : static_cast<quint64>(nextDouble() * static_cast<double>(n)); }
+
+    // 标准正态分布（Marsaglia 极坐标法）
+    double normal()
+    {
+        if (m_hasSpare) {
+            m_hasSpare = false;
+            return m_spare;
+        }
+        double u, v, s;
+        do {
+            u = uniform(-1.0, 1.0);
+            v = uniform(-1.0, 1.0);
+            s = u * u + v * v;
+        } while (s >= 1.0 || s == 0.0);
+        double factor = std::sqrt(-2.0 * std::log(s) / s);
+        m_spare = v * factor;
+        m_hasSpare = true;
+        return u * factor;
+    }
+
+    // 指数分布（均值 mean）
+    double exponential(double mean) { return -mean * std::log(1.0 - nextDouble()); }
+
+private:
+    static quint64 rotl(quint64 x, int k) { return (x << k) | (x >> (64 - k)); }
+
+    quint64 m_state[4];
+    double m_spare = 0.0;
+    bool m_hasSpare = false;
+};
+
+#endif // FASTRANDOM_H
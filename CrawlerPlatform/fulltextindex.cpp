@@ -0,0 +1,377 @@
+#include "fulltextindex.h"
+#include "metrics.h"
+#include "responsearchive.h"
+#include <QSqlQuery>
+#include <QSqlError>
+#include <QDateTime>
+#include <QHash>
+#include <QDebug>
+
+// 补建索引时每个事务写入的响应体数
+static const int kBackfillBatch = 200;
+// 响应体命中的片段：匹配处前后保留的字符数
+static const int kSnippetContext = 30;
+
+struct FullTextMetrics {
+    MetricCounter* bodiesIndexed;
+    MetricCounter* indexErrors;
+
+    static const FullTextMetrics& get()
+    {
+        static const FullTextMetrics metrics = []() {
+            MetricsRegistry& registry = MetricsRegistry::instance();
+            FullTextMetrics m;
+            m.bodiesIndexed = registry.counter("crawler_fulltext_bodies_indexed_total", "写入全文索引的响应体数");
+            m.indexErrors = registry.counter("crawler_fulltext_index_errors_total", "写入全文索引失败的次数");
+            return m;
+        }();
+        return metrics;
+    }
+};
+
+bool FullTextIndex::hasIndex(QSqlDatabase& db, const QString& table)
+{
+    QSqlQuery query(db);
+    query.prepare("SELECT 1 FROM sqlite_master WHERE type = 'table' AND name = :name");
+    query.bindValue(":name", table);
+    return query.exec() && query.next();
+}
+
+// 依次尝试建表参数，返回成功的序号，全部失败返回 -1
+static int createVirtualTable(QSqlDatabase& db, const QString& table, const QString& columns,
+                              const QStringList& variants)
+{
+    QSqlQuery query(db);
+    QString lastError;
+    for (int i = 0; i < variants.size(); i++) {
+        if (query.exec(QString("CREATE VIRTUAL TABLE %1 USING fts5(%2, %3)").arg(table, columns, variants.at(i)))) {
+            return i;
+        }
+        lastError = query.lastError().text();
+    }
+    qWarning() << "创建全文索引失败（SQLite 需支持 FTS5）：" << table << lastError;
+    return -1;
+}
+
+bool FullTextIndex::createContentIndex(QSqlDatabase& db)
+{
+    if (hasIndex(db, "crawler_content_fts")) {
+        return true;
+    }
+    const int variant = createVirtualTable(db, "crawler_content_fts", "content", {
+        "content='crawler_data', content_rowid='id', tokenize='trigram'",
+        "content='crawler_data', content_rowid='id'",
+    });
+    if (variant < 0) {
+        return false;
+    }
+
+    // 外部内容表：删除时须带上原文本；只有保留的原始文本进入索引
+    QSqlQuery query(db);
+    const QStringList statements = {
+        R"(
+        CREATE TRIGGER IF NOT EXISTS crawler_data_fts_insert AFTER INSERT ON crawler_data WHEN new.hasRawText = 1
+        BEGIN
+            INSERT INTO crawler_content_fts (rowid, content) VALUES (new.id, new.content);
+        END
+        )",
+        R"(
+        CREATE TRIGGER IF NOT EXISTS crawler_data_fts_delete AFTER DELETE ON crawler_data WHEN old.hasRawText = 1
+        BEGIN
+            INSERT INTO crawler_content_fts (crawler_content_fts, rowid, content) VALUES ('delete', old.id, old.content);
+        END
+        )",
+        R"(
+        CREATE TRIGGER IF NOT EXISTS crawler_data_fts_update AFTER UPDATE OF content, hasRawText ON crawler_data
+        BEGIN
+            INSERT INTO crawler_content_fts (crawler_content_fts, rowid, content)
+            SELECT 'delete', old.id, old.content WHERE old.hasRawText = 1;
+            INSERT INTO crawler_content_fts (rowid, content) SELECT new.id, new.content WHERE new.hasRawText = 1;
+        END
+        )",
+    };
+    for (const QString& sql : statements) {
+        if (!query.exec(sql)) {
+            qCritical() << "创建全文索引触发器失败：" << query.lastError().text();
+            return false;
+        }
+    }
+
+    qInfo() << "全文索引已建立（" << (variant == 0 ? "trigram" : "unicode61") << "），为已有的提取文本补建索引"
+            << db.databaseName();
+    if (!query.exec("INSERT INTO crawler_content_fts (rowid, content) SELECT id, content FROM crawler_data WHERE hasRawText = 1")) {
+        qWarning() << "补建提取文本索引失败：" << query.lastError().text();
+    }
+    return true;
+}
+
+void FullTextIndex::dropContentIndex(QSqlDatabase& db)
+{
+    QSqlQuery query(db);
+    for (const QString& name : {"crawler_data_fts_insert", "crawler_data_fts_delete", "crawler_data_fts_update"}) {
+        query.exec(QString("DROP TRIGGER IF EXISTS %1").arg(name));
+    }
+    if (hasIndex(db, "crawler_content_fts") && !query.exec("DROP TABLE crawler_content_fts")) {
+        qWarning() << "删除全文索引失败：" << query.lastError().text();
+    }
+}
+
+void FullTextIndex::dropBodyIndex(QSqlDatabase& db)
+{
+    QSqlQuery query(db);
+    query.exec("DROP TRIGGER IF EXISTS crawler_blobs_fts_delete");
+    if (hasIndex(db, "crawler_body_fts") && !query.exec("DROP TABLE crawler_body_fts")) {
+        qWarning() << "删除响应体全文索引失败：" << query.lastError().text();
+    }
+}
+
+bool FullTextIndex::createBodyIndex(QSqlDatabase& db)
+{
+    if (hasIndex(db, "crawler_body_fts")) {
+        return true;
+    }
+    // contentless_delete 需要 SQLite 3.43；不支持时过期响应体留在索引中，
+    // 因 crawler_blobs.id 不复用，检索时关联不到响应记录而被忽略
+    const int variant = createVirtualTable(db, "crawler_body_fts", "body", {
+        "content='', contentless_delete=1, tokenize='trigram'",
+        "content='', tokenize='trigram'",
+        "content='', contentless_delete=1",
+        "content=''",
+    });
+    if (variant < 0) {
+        return false;
+    }
+    QSqlQuery query(db);
+    if (variant == 0 || variant == 2) {
+        if (!query.exec(R"(
+            CREATE TRIGGER IF NOT EXISTS crawler_blobs_fts_delete AFTER DELETE ON crawler_blobs
+            BEGIN
+                DELETE FROM crawler_body_fts WHERE rowid = old.id;
+            END
+        )")) {
+            qCritical() << "创建全文索引触发器失败：" << query.lastError().text();
+            return false;
+        }
+    }
+
+    // 为已归档的响应体补建索引（逐个解压），分批提交
+    QList<qint64> blobIds;
+    if (query.exec("SELECT id FROM crawler_blobs ORDER BY id")) {
+        while (query.next()) {
+            blobIds.append(query.value(0).toLongLong());
+        }
+    }
+    query.finish();
+    if (blobIds.isEmpty()) {
+        return true;
+    }
+    qInfo() << "全文索引已建立，为已归档的" << blobIds.size() << "个响应体补建索引";
+    for (qsizetype offset = 0; offset < blobIds.size(); offset += kBackfillBatch) {
+        if (!db.transaction()) {
+            qWarning() << "补建响应体索引失败：无法开启事务" << db.lastError().text();
+            return true;
+        }
+        const qsizetype end = qMin<qsizetype>(blobIds.size(), offset + kBackfillBatch);
+        for (qsizetype i = offset; i < end; i++) {
+            const QByteArray body = ResponseArchive::load(db, blobIds.at(i));
+            if (!body.isEmpty()) {
+                indexBody(db, blobIds.at(i), body);
+            }
+        }
+        if (!db.commit()) {
+            qWarning() << "补建响应体索引失败：" << db.lastError().text();
+            db.rollback();
+            return true;
+        }
+    }
+    return true;
+}
+
+QString FullTextIndex::bodyText(const QByteArray& body)
+{
+    const QString html = QString::fromUtf8(body);
+    QString text;
+    text.reserve(html.size() / 2);
+
+    bool lastSpace = true;
+    auto appendChar = [&](QChar c) {
+        if (c.isSpace()) {
+            if (!lastSpace) text.append(QLatin1Char(' '));
+            lastSpace = true;
+        } else {
+            text.append(c);
+            lastSpace = false;
+        }
+    };
+
+    const qsizetype size = html.size();
+    qsizetype i = 0;
+    while (i < size) {
+        const QChar c = html.at(i);
+        if (c == QLatin1Char('<')) {
+            const qsizetype close = html.indexOf(QLatin1Char('>'), i + 1);
+            if (close < 0) break;
+            // 脚本与样式的内容不是可见文本，整段跳过
+            const QStringView tag = QStringView(html).mid(i + 1, qMin<qsizetype>(6, close - i - 1));
+            const bool script = tag.startsWith(QLatin1String("script"), Qt::CaseInsensitive);
+            const bool style = !script && tag.startsWith(QLatin1String("style"), Qt::CaseInsensitive);
+            i = close + 1;
+            if (script || style) {
+                const qsizetype end = html.indexOf(script ? QLatin1String("</script") : QLatin1String("</style"), i,
+                                                   Qt::CaseInsensitive);
+                if (end < 0) break;
+                i = end;
+            }
+            appendChar(QLatin1Char(' '));
+            continue;
+        }
+        if (c == QLatin1Char('&')) {
+            static const QList<QPair<QLatin1String, QChar>> entities = {
+                {QLatin1String("&nbsp;"), QLatin1Char(' ')}, {QLatin1String("&amp;"), QLatin1Char('&')},
+                {QLatin1String("&lt;"), QLatin1Char('<')}, {QLatin1String("&gt;"), QLatin1Char('>')},
+                {QLatin1String("&quot;"), QLatin1Char('"')}, {QLatin1String("&#39;"), QLatin1Char('\'')},
+            };
+            bool decoded = false;
+            for (const auto& entity : entities) {
+                if (QStringView(html).mid(i).startsWith(entity.first, Qt::CaseInsensitive)) {
+                    appendChar(entity.second);
+                    i += entity.first.size();
+                    decoded = true;
+                    break;
+                }
+            }
+            if (decoded) continue;
+        }
+        appendChar(c);
+        i++;
+    }
+    return text.trimmed();
+}
+
+bool FullTextIndex::indexBody(QSqlDatabase& db, qint64 blobId, const QByteArray& body)
+{
+    const QString text = bodyText(body);
+    if (text.isEmpty()) {
+        return true;
+    }
+    QSqlQuery query(db);
+    query.prepare("INSERT INTO crawler_body_fts (rowid, body) VALUES (:rowid, :body)");
+    query.bindValue(":rowid", blobId);
+    query.bindValue(":body", text);
+    if (!query.exec()) {
+        FullTextMetrics::get().indexErrors->inc();
+        qWarning() << "写入响应体全文索引失败：" << query.lastError().text() << "响应体：" << blobId;
+        return false;
+    }
+    FullTextMetrics::get().bodiesIndexed->inc();
+    return true;
+}
+
+// 整个检索词作为一个短语（按子串匹配），引号按 FTS5 规则转义
+static QString matchPhrase(const QString& text)
+{
+    QString escaped = text;
+    escaped.replace(QLatin1Char('"'), QLatin1String("\"\""));
+    return QLatin1Char('"') + escaped + QLatin1Char('"');
+}
+
+QList<SearchHit> FullTextIndex::searchContent(QSqlDatabase& db, const QString& text, int limit)
+{
+    QList<SearchHit> hits;
+    const QString trimmed = text.trimmed();
+    if (trimmed.size() < kMinQueryLength || limit <= 0 || !hasIndex(db, "crawler_content_fts")) {
+        return hits;
+    }
+
+    QSqlQuery query(db);
+    query.setForwardOnly(true);
+    query.prepare(R"(
+        SELECT d.taskId, d.crawlTime, f.rank, snippet(crawler_content_fts, 0, '【', '】', '…', 16)
+        FROM crawler_content_fts AS f JOIN crawler_data AS d ON d.id = f.rowid
+        WHERE crawler_content_fts MATCH :query
+        ORDER BY f.rank
+        LIMIT :limit
+    )");
+    query.bindValue(":query", matchPhrase(trimmed));
+    query.bindValue(":limit", limit);
+    if (!query.exec()) {
+        qWarning() << "检索提取文本失败：" << query.lastError().text();
+        return hits;
+    }
+    while (query.next()) {
+        SearchHit hit;
+        hit.source = SearchHit::Content;
+        hit.taskId = query.value(0).toInt();
+        hit.timestampMs = QDateTime::fromString(query.value(1).toString(), "yyyy-MM-dd HH:mm:ss").toMSecsSinceEpoch();
+        hit.firstTimestampMs = hit.timestampMs;
+        hit.rank = query.value(2).toDouble();
+        hit.snippet = query.value(3).toString();
+        hits.append(hit);
+    }
+    return hits;
+}
+
+QList<SearchHit> FullTextIndex::searchBodies(QSqlDatabase& db, const QString& text, int limit)
+{
+    QList<SearchHit> hits;
+    const QString trimmed = text.trimmed();
+    if (trimmed.size() < kMinQueryLength || limit <= 0 || !hasIndex(db, "crawler_body_fts")) {
+        return hits;
+    }
+
+    // 先按相关度取前 limit 个响应体，再展开为引用它们的任务（同一任务多次抓到同一响应只算一条）
+    QSqlQuery query(db);
+    query.setForwardOnly(true);
+    query.prepare(R"(
+        SELECT f.rowid, f.rank, r.taskId, MIN(r.fetchedAt), MAX(r.fetchedAt), COUNT(*)
+        FROM (SELECT rowid, rank FROM crawler_body_fts WHERE crawler_body_fts MATCH :query
+              ORDER BY rank LIMIT :blobLimit) AS f
+        JOIN crawler_responses AS r ON r.blobId = f.rowid
+        GROUP BY f.rowid, r.taskId
+        ORDER BY f.rank, MAX(r.fetchedAt) DESC
+        LIMIT :limit
+    )");
+    query.bindValue(":query", matchPhrase(trimmed));
+    query.bindValue(":blobLimit", limit);
+    query.bindValue(":limit", limit);
+    if (!query.exec()) {
+        qWarning() << "检索响应体失败：" << query.lastError().text();
+        return hits;
+    }
+    QList<qint64> blobIds;
+    while (query.next()) {
+        SearchHit hit;
+        hit.source = SearchHit::Body;
+        hit.rank = query.value(1).toDouble();
+        hit.taskId = query.value(2).toInt();
+        hit.firstTimestampMs = query.value(3).toLongLong();
+        hit.timestampMs = query.value(4).toLongLong();
+        hit.occurrences = query.value(5).toInt();
+        hits.append(hit);
+        blobIds.append(query.value(0).toLongLong());
+    }
+    query.finish();
+
+    // 无内容表不能生成片段，解压命中的响应体截取匹配处（同一响应体只解压一次）
+    QHash<qint64, QString> snippets;
+    for (qsizetype i = 0; i < hits.size(); i++) {
+        const qint64 blobId = blobIds.at(i);
+        auto it = snippets.find(blobId);
+        if (it == snippets.end()) {
+            const QString body = bodyText(ResponseArchive::load(db, blobId));
+            const qsizetype pos = body.indexOf(trimmed, 0, Qt::CaseInsensitive);
+            QString snippet;
+            if (pos >= 0) {
+                const qsizetype begin = qMax<qsizetype>(0, pos - kSnippetContext);
+                const qsizetype end = qMin<qsizetype>(body.size(), pos + trimmed.size() + kSnippetContext);
+                snippet = (begin > 0 ? QStringLiteral("…") : QString())
+                    + body.mid(begin, pos - begin) + QStringLiteral("【") + body.mid(pos, trimmed.size())
+                    + QStringLiteral("】") + body.mid(pos + trimmed.size(), end - pos - trimmed.size())
+                    + (end < body.size() ? QStringLiteral("…") : QString());
+            }
+            it = snippets.insert(blobId, snippet);
+        }
+        hits[i].snippet = it.value();
+    }
+    return hits;
+}
@@ -0,0 +1,54 @@
+#ifndef FULLTEXTINDEX_H
+#define FULLTEXTINDEX_H
+
+#include <QList>
+#include <QString>
+#include <QByteArray>
+#include <QSqlDatabase>
+
+// 全文检索的一条命中
+struct SearchHit {
+    enum Source {
+        Content,   // 保留的原始提取文本（crawler_data.content）
+        Body       // 归档的响应体
+    };
+    Source source = Content;
+    int taskId = 0;
+    qint64 timestampMs = 0;       // 数据点的爬取时间；响应体为该任务最近一次抓到该响应的时间
+    qint64 firstTimestampMs = 0;  // 响应体：该任务首次抓到该响应的时间（提取文本同 timestampMs）
+    int occurrences = 1;          // 响应体：该任务抓到相同响应的次数
+    double rank = 0.0;            // FTS5 bm25 得分，越小越相关
+    QString snippet;              // 命中附近的文本，匹配部分用【】标出
+};
+
+// 可选的 FTS5 全文索引
+// crawler_content_fts（各数据库文件）：外部内容表，索引 crawler_data 中保留的原始文本（hasRawText = 1）；
+//   由触发器在写入数据的同一事务中维护（这些行不封存为压缩块），按保留策略删除时一并移出索引
+// crawler_body_fts（主库）：无内容表，rowid 为 crawler_blobs.id，索引去掉标签后的响应体文本；
+//   归档线程写入每批响应时在同一事务中追加（内容寻址，相同响应体只索引一次）
+// 使用 trigram 分词，按任意连续 3 个字符匹配（中文无需分词）；SQLite 不支持时退回 unicode61 按词匹配
+class FullTextIndex {
+public:
+    // 检索词最短长度（trigram 无法匹配更短的子串）
+    static const int kMinQueryLength = 3;
+
+    // 建立索引与触发器，新建时为已有数据补建索引（数据量大时耗时较长）；SQLite 未编译 FTS5 时返回 false
+    static bool createContentIndex(QSqlDatabase& db);
+    static bool createBodyIndex(QSqlDatabase& db);
+    static bool hasIndex(QSqlDatabase& db, const QString& table);
+    // 删除提取文本索引与触发器（升级时按新条件重建）
+    static void dropContentIndex(QSqlDatabase& db);
+    // 删除响应体索引（响应体表升级后重建）
+    static void dropBodyIndex(QSqlDatabase& db);
+
+    // 归档线程调用（调用方已开启事务）
+    static bool indexBody(QSqlDatabase& db, qint64 blobId, const QByteArray& body);
+    // 响应体中的可见文本：去掉标签、脚本与样式，合并空白
+    static QString bodyText(const QByteArray& body);
+
+    // 按子串检索，按相关度返回最多 limit 条；没有对应索引时返回空
+    static QList<SearchHit> searchContent(QSqlDatabase& db, const QString& text, int limit);
+    static QList<SearchHit> searchBodies(QSqlDatabase& db, const QString& text, int limit);
+};
+
+#endif // FULLTEXTINDEX_H
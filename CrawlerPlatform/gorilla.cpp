@@ -0,0 +1,191 @@
+#include "gorilla.h"
+#include <QtAlgorithms>
+#include <cstring>
+
+static const quint8 kBlockVersion = 1;
+static const int kHeaderBytes = 5;
+
+static quint64 doubleBits(double value)
+{
+    quint64 bits;
+    memcpy(&bits, &value, sizeof(bits));
+    return bits;
+}
+
+static double bitsDouble(quint64 bits)
+{
+    double value;
+    memcpy(&value, &bits, sizeof(value));
+    return value;
+}
+
+void GorillaEncoder::writeBits(quint64 bits, int n)
+{
+    while (n > 0) {
+        const int take = qMin(8 - m_bitCount, n);
+        const quint8 chunk = static_cast<quint8>((bits >> (n - take)) & ((1u << take) - 1));
+        m_current = static_cast<quint8>((m_current << take) | chunk);
+        m_bitCount += take;
+        n -= take;
+        if (m_bitCount == 8) {
+            m_buffer.append(static_cast<char>(m_current));
+            m_current = 0;
+            m_bitCount = 0;
+        }
+    }
+}
+
+void GorillaEncoder::append(qint64 timestamp, double value)
+{
+    const quint64 valueBits = doubleBits(value);
+
+    if (m_count == 0) {
+        m_buffer.fill('\0', kHeaderBytes);
+        writeBits(static_cast<quint64>(timestamp), 64);
+        writeBits(valueBits, 64);
+    } else {
+        // 时间戳：二阶差分按区间选择 0/7/9/12/64 位
+        const qint64 delta = timestamp - m_prevTimestamp;
+        const qint64 dod = delta - m_prevDelta;
+        if (dod == 0) {
+            writeBits(0, 1);
+        } else if (dod >= -63 && dod <= 64) {
+            writeBits(0b10, 2);
+            writeBits(static_cast<quint64>(dod + 63), 7);
+        } else if (dod >= -255 && dod <= 256) {
+            writeBits(0b110, 3);
+            writeBits(static_cast<quint64>(dod + 255), 9);
+        } else if (dod >= -2047 && dod <= 2048) {
+            writeBits(0b1110, 4);
+            writeBits(static_cast<quint64>(dod + 2047), 12);
+        } else {
+            writeBits(0b1111, 4);
+            writeBits(static_cast<quint64>(dod), 64);
+        }
+        m_prevDelta = delta;
+
+        // 数值：与上一个值 XOR，相同记 1 位；有效位落在上一窗口内时复用窗口
+        const quint64 xorBits = valueBits ^ m_prevValue;
+        if (xorBits == 0) {
+            writeBits(0, 1);
+        } else {
+            const int leading = qMin(31, static_cast<int>(qCountLeadingZeroBits(xorBits)));
+            const int trailing = static_cast<int>(qCountTrailingZeroBits(xorBits));
+            if (m_prevLeading >= 0 && leading >= m_prevLeading && trailing >= m_prevTrailing) {
+                writeBits(0b10, 2);
+                writeBits(xorBits >> m_prevTrailing, 64 - m_prevLeading - m_prevTrailing);
+            } else {
+                const int meaningful = 64 - leading - trailing;
+                writeBits(0b11, 2);
+                writeBits(static_cast<quint64>(leading), 5);
+                writeBits(static_cast<quint64>(meaningful & 63), 6); // 64 记为 0
+                writeBits(xorBits >> trailing, meaningful);
+                m_prevLeading = leading;
+                m_prevTrailing = trailing;
+            }
+        }
+    }
+
+    m_prevTimestamp = timestamp;
+    m_prevValue = valueBits;
+    m_count++;
+}
+
+QByteArray GorillaEncoder::finish()
+{
+    if (m_count == 0) {
+        return QByteArray();
+    }
+    if (m_bitCount > 0) {
+        m_buffer.append(static_cast<char>(m_current << (8 - m_bitCount)));
+    }
+    m_buffer[0] = static_cast<char>(kBlockVersion);
+    for (int i = 0; i < 4; i++) {
+        m_buffer[1 + i] = static_cast<char>((static_cast<quint32>(m_count) >> (8 * i)) & 0xFF);
+    }
+
+    QByteArray block = m_buffer;
+    *this = GorillaEncoder();
+    return block;
+}
+
+GorillaDecoder::GorillaDecoder(const QByteArray& block)
+    : m_block(block)
+{
+    if (m_block.size() < kHeaderBytes || static_cast<quint8>(m_block.at(0)) != kBlockVersion) {
+        return;
+    }
+    m_data = reinterpret_cast<const uchar*>(m_block.constData());
+    quint32 count = 0;
+    for (int i = 0; i < 4; i++) {
+        count |= static_cast<quint32>(m_data[1 + i]) << (8 * i);
+    }
+    m_count = static_cast<int>(count);
+    m_sizeBits = static_cast<qint64>(m_block.size()) * 8;
+    m_pos = kHeaderBytes * 8;
+    m_valid = true;
+}
+
+quint64 GorillaDecoder::readBits(int n)
+{
+    quint64 bits = 0;
+    while (n > 0) {
+        if (m_pos >= m_sizeBits) {
+            m_valid = false;
+            return 0;
+        }
+        const int offset = static_cast<int>(m_pos & 7);
+        const int take = qMin(8 - offset, n);
+        const quint8 byte = m_data[m_pos >> 3];
+        bits = (bits << take) | ((byte >> (8 - offset - take)) & ((1u << take) - 1));
+        m_pos += take;
+        n -= take;
+    }
+    return bits;
+}
+
+bool GorillaDecoder::next(qint64* timestamp, double* value)
+{
+    if (!m_valid || m_index >= m_count) {
+        return false;
+    }
+
+    if (m_index == 0) {
+        m_prevTimestamp = static_cast<qint64>(readBits(64));
+        m_prevValue = readBits(64);
+    } else {
+        qint64 dod = 0;
+        if (readBit()) {
+            if (!readBit()) {
+                dod = static_cast<qint64>(readBits(7)) - 63;
+            } else if (!readBit()) {
+                dod = static_cast<qint64>(readBits(9)) - 255;
+            } else if (!readBit()) {
+                dod = static_cast<qint64>(readBits(12)) - 2047;
+            } else {
+                dod = static_cast<qint64>(readBits(64));
+            }
+        }
+        m_prevDelta += dod;
+        m_prevTimestamp += m_prevDelta;
+
+        if (readBit()) {
+            if (readBit()) {
+                m_leading = static_cast<int>(readBits(5));
+                int meaningful = static_cast<int>(readBits(6));
+                if (meaningful == 0) meaningful = 64;
+                m_trailing = 64 - m_leading - meaningful;
+            }
+            const int meaningful = 64 - m_leading - m_trailing;
+            m_prevValue ^= readBits(meaningful) << m_trailing;
+        }
+    }
+
+    if (!m_valid) {
+        return false;
+    }
+    m_index++;
+    *timestamp = m_prevTimestamp;
+    *value = bitsDouble(m_prevValue);
+    return true;
+}
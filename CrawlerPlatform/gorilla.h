@@ -0,0 +1,60 @@
+#ifndef GORILLA_H
+#define GORILLA_H
+
+#include <QByteArray>
+#include <QtGlobal>
+
+// Gorilla 时序压缩（时间戳二阶差分 + 浮点数 XOR 编码）
+// 块格式：1 字节版本 + 4 字节点数（小端）+ 按位写入的数据流（高位在前）
+// 时间戳单位由调用方决定，规则间隔采样时二阶差分多为 0，每点约 1~2 字节
+class GorillaEncoder {
+public:
+    void append(qint64 timestamp, double value);
+    // 结束编码并返回完整块，之后编码器可重新使用
+    QByteArray finish();
+    int count() const { return m_count; }
+
+private:
+    void writeBits(quint64 bits, int n);
+
+    QByteArray m_buffer;
+    quint8 m_current = 0;
+    int m_bitCount = 0;
+
+    int m_count = 0;
+    qint64 m_prevTimestamp = 0;
+    qint64 m_prevDelta = 0;
+    quint64 m_prevValue = 0;
+    int m_prevLeading = -1;
+    int m_prevTrailing = 0;
+};
+
+class GorillaDecoder {
+public:
+    explicit GorillaDecoder(const QByteArray& block);
+
+    bool isValid() const { return m_valid; }
+    int count() const { return m_count; }
+    // 依次读出数据点，读完或数据损坏时返回 false
+    bool next(qint64* timestamp, double* value);
+
+private:
+    quint64 readBits(int n);
+    bool readBit() { return readBits(1) != 0; }
+
+    QByteArray m_block;
+    const uchar* m_data = nullptr;
+    qint64 m_sizeBits = 0;
+    qint64 m_pos = 0;
+    bool m_valid = false;
+
+    int m_count = 0;
+    int m_index = 0;
+    qint64 m_prevTimestamp = 0;
+    qint64 m_prevDelta = 0;
+    quint64 m_prevValue = 0;
+    int m_leading = 0;
+    int m_trailing = 0;
+};
+
+#endif // GORILLA_H
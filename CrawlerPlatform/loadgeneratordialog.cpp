@@ -0,0 +1,92 @@
+#include "loadgeneratordialog.h"
+#include <QFormLayout>
+#include <QDialogButtonBox>
+#include <QVBoxLayout>
+
+LoadGeneratorDialog::LoadGeneratorDialog(QWidget *parent)
+    : QDialog(parent)
+{
+    setWindowTitle("生成模拟任务");
+
+    m_countSpin = new QSpinBox(this);
+    m_countSpin->setRange(1, 100000);
+    m_countSpin->setValue(1000);
+
+    m_prefixEdit = new QLineEdit("sim", this);
+
+    m_intervalCombo = new QComboBox(this);
+    m_intervalCombo->addItems({"固定", "均匀分布", "指数分布"});
+    m_intervalCombo->setCurrentIndex(1);
+
+    m_intervalMinSpin = new QSpinBox(this);
+    m_intervalMinSpin->setRange(1, 3600);
+    m_intervalMinSpin->setValue(1);
+
+    m_intervalMaxSpin = new QSpinBox(this);
+    m_intervalMaxSpin->setRange(1, 3600);
+    m_intervalMaxSpin->setValue(10);
+
+    m_processCombo = new QComboBox(this);
+    m_processCombo->addItems({"均匀随机", "随机游走", "阶跃变化"});
+    m_processCombo->setCurrentIndex(1);
+
+    auto makeDouble = [this](double min, double max, double value, int decimals) {
+        QDoubleSpinBox* spin = new QDoubleSpinBox(this);
+        spin->setRange(min, max);
+        spin->setDecimals(decimals);
+        spin->setValue(value);
+        return spin;
+    };
+    m_minValueSpin = makeDouble(-1e9, 1e9, 0.0, 2);
+    m_maxValueSpin = makeDouble(-1e9, 1e9, 100.0, 2);
+    m_sigmaSpin = makeDouble(0.0, 1e6, 0.5, 3);
+    m_stepProbSpin = makeDouble(0.0, 1.0, 0.05, 3);
+    m_jumpSpin = makeDouble(0.0, 1e6, 10.0, 2);
+
+    m_startCheck = new QCheckBox("创建后立即启动", this);
+
+    QFormLayout* form = new QFormLayout();
+    form->addRow("任务数量：", m_countSpin);
+    form->addRow("名称前缀：", m_prefixEdit);
+    form->addRow("间隔分布：", m_intervalCombo);
+    form->addRow("最小间隔(秒)：", m_intervalMinSpin);
+    form->addRow("最大间隔(秒)：", m_intervalMaxSpin);
+    form->addRow("数值过程：", m_processCombo);
+    form->addRow("数值下限：", m_minValueSpin);
+    form->addRow("数值上限：", m_maxValueSpin);
+    form->addRow("游走步长σ：", m_sigmaSpin);
+    form->addRow("阶跃概率：", m_stepProbSpin);
+    form->addRow("阶跃幅度：", m_jumpSpin);
+    form->addRow(m_startCheck);
+
+    QDialogButtonBox* buttons = new QDialogButtonBox(QDialogButtonBox::Ok | QDialogButtonBox::Cancel, this);
+    connect(buttons, &QDialogButtonBox::accepted, this, &QDialog::accept);
+    connect(buttons, &QDialogButtonBox::rejected, this, &QDialog::reject);
+
+    QVBoxLayout* layout = new QVBoxLayout(this);
+    layout->addLayout(form);
+    layout->addWidget(buttons);
+}
+
+LoadProfile LoadGeneratorDialog::profile() const
+{
+    LoadProfile profile;
+    profile.taskCount = m_countSpin->value();
+    profile.namePrefix = m_prefixEdit->text().trimmed().isEmpty() ? "sim" : m_prefixEdit->text().trimmed();
+    profile.intervalDistribution = static_cast<LoadProfile::IntervalDistribution>(m_intervalCombo->currentIndex());
+    profile.intervalMin = m_intervalMinSpin->value();
+    profile.intervalMax = m_intervalMaxSpin->value();
+
+    profile.process.kind = static_cast<SimulatedValueSource::Kind>(m_processCombo->currentIndex());
+    profile.process.minValue = m_minValueSpin->value();
+    profile.process.maxValue = m_maxValueSpin->value();
+    profile.process.sigma = m_sigmaSpin->value();
+    profile.process.stepProbability = m_stepProbSpin->value();
+    profile.process.jump = m_jumpSpin->value();
+    return profile;
+}
+
+bool LoadGeneratorDialog::startImmediately() const
+{
+    return m_startCheck->isChecked();
+}
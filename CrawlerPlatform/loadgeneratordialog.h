@@ -0,0 +1,38 @@
+#ifndef LOADGENERATORDIALOG_H
+#define LOADGENERATORDIALOG_H
+
+#include <QDialog>
+#include <QSpinBox>
+#include <QDoubleSpinBox>
+#include <QComboBox>
+#include <QCheckBox>
+#include <QLineEdit>
+#include "simulation.h"
+
+// 负载生成对话框：配置模拟任务数量、间隔分布与数值过程
+class LoadGeneratorDialog : public QDialog
+{
+    Q_OBJECT
+
+public:
+    explicit LoadGeneratorDialog(QWidget *parent = nullptr);
+
+    LoadProfile profile() const;
+    bool startImmediately() const;
+
+private:
+    QSpinBox* m_countSpin;
+    QLineEdit* m_prefixEdit;
+    QComboBox* m_intervalCombo;
+    QSpinBox* m_intervalMinSpin;
+    QSpinBox* m_intervalMaxSpin;
+    QComboBox* m_processCombo;
+    QDoubleSpinBox* m_minValueSpin;
+    QDoubleSpinBox* m_maxValueSpin;
+    QDoubleSpinBox* m_sigmaSpin;
+    QDoubleSpinBox* m_stepProbSpin;
+    QDoubleSpinBox* m_jumpSpin;
+    QCheckBox* m_startCheck;
+};
+
+#endif // LOADGENERATORDIALOG_H
@@ -1,19 +1,165 @@
-#include <QApplication>
-#include "mainwindow.h"
-#include "databasemanager.h"
-
-int main(int argc, char *argv[])
-{
-    QApplication a(argc, argv);
-
-    // 初始化数据库（主线程）
-    if (!DatabaseManager::initDatabaseSchema()) {
-        qCritical() << "数据库初始化失败，程序退出";
-        return -1;
-    }
-
-    MainWindow w;
-    w.show();
-
-    return a.exec();
-}
+#include <QApplication>
+#include <QCommandLineParser>
+#include <QTimer>
+#include <csignal>
+#include <atomic>
+#include "mainwindow.h"
+#include "databasemanager.h"
+#include "metricsserver.h"
+#include "retention.h"
+#include "segmentstore.h"
+#include "responsearchive.h"
+#include "workerhost.h"
+#include "backup.h"
+
+static std::atomic<bool> s_stopRequested{false};
+
+// 无界面工作进程：crawlerplatform --worker [--db 路径] [--shards 64] [--worker-id ID]
+// 多个进程共享同一数据库，按分片租约分担全部任务；SIGINT/SIGTERM 时释放租约后退出，其余进程随即接管
+static int runWorker(int argc, char *argv[])
+{
+    QCoreApplication app(argc, argv);
+
+    QCommandLineParser parser;
+    parser.setApplicationDescription("爬虫工作进程（无界面，按分片租约运行任务）");
+    parser.addHelpOption();
+    QCommandLineOption workerOpt("worker", "以无界面工作进程运行");
+    QCommandLineOption dbOpt("db", "共享的数据库文件", "path", "crawler_data.db");
+    QCommandLineOption shardsOpt("shards", "分片数（所有工作进程必须一致，首个进程记入数据库）", "n", "64");
+    QCommandLineOption idOpt("worker-id", "工作进程标识（默认按主机名与进程号生成）", "id");
+    parser.addOptions({workerOpt, dbOpt, shardsOpt, idOpt});
+    parser.process(app);
+
+    DatabaseManager::setDatabasePath(parser.value(dbOpt));
+    // 分片数沿用主库中的记录，无需与其他进程逐个对齐；全文索引一经建立由触发器维护，与开关无关
+    DatabaseManager::setFullTextIndexEnabled(qEnvironmentVariableIntValue("CRAWLER_FULLTEXT") > 0);
+    if (!DatabaseManager::initDatabaseSchema() || !DatabaseManager::enableWriteAheadLog()) {
+        qCritical() << "数据库初始化失败，工作进程退出";
+        return -1;
+    }
+    if (qEnvironmentVariable("CRAWLER_DATA_BACKEND").compare("segment", Qt::CaseInsensitive) == 0) {
+        qWarning() << "段文件后端不支持多进程写入，工作进程使用 SQLite 存储";
+    }
+
+    // 多个工作进程通常同时运行，指标端点默认关闭，需要时为每个进程单独指定端口
+    const quint16 metricsPort = static_cast<quint16>(qEnvironmentVariableIntValue("CRAWLER_METRICS_PORT"));
+    MetricsServer metricsServer(metricsPort);
+    if (metricsPort > 0 && metricsServer.start()) {
+        qInfo() << "指标端点已启动：" << QString("http://127.0.0.1:%1/metrics").arg(metricsServer.port());
+    }
+
+    if (qEnvironmentVariableIntValue("CRAWLER_ARCHIVE_RESPONSES") > 0) {
+        ResponseArchive::instance().startWorker();
+    }
+
+    LeaseConfig leaseConfig;
+    leaseConfig.workerId = parser.value(idOpt);
+    leaseConfig.shardCount = parser.value(shardsOpt).toInt();
+    WorkerHost host(leaseConfig);
+    if (!host.start()) {
+        ResponseArchive::instance().stopWorker();
+        return -1;
+    }
+
+    // 信号处理函数里只置标志，由事件循环轮询后正常退出
+    std::signal(SIGINT, [](int) { s_stopRequested = true; });
+    std::signal(SIGTERM, [](int) { s_stopRequested = true; });
+    QTimer stopPoll;
+    QObject::connect(&stopPoll, &QTimer::timeout, &app, []() {
+        if (s_stopRequested) {
+            QCoreApplication::quit();
+        }
+    });
+    stopPoll.start(200);
+
+    const int ret = app.exec();
+    host.stop();
+    ResponseArchive::instance().stopWorker();
+    return ret;
+}
+
+int main(int argc, char *argv[])
+{
+    for (int i = 1; i < argc; ++i) {
+        if (qstrcmp(argv[i], "--worker") == 0) {
+            return runWorker(argc, argv);
+        }
+    }
+
+    QApplication a(argc, argv);
+
+    // 爬取数据分片数由 CRAWLER_DATA_SHARDS 指定（默认1，即全部在主库中）；新库首次初始化时确定
+    if (qEnvironmentVariableIsSet("CRAWLER_DATA_SHARDS")) {
+        DatabaseManager::setDataShardCount(qEnvironmentVariableIntValue("CRAWLER_DATA_SHARDS"));
+    }
+    // 全文索引（CRAWLER_FULLTEXT=1 开启）：索引保留的提取文本，开启响应归档时也索引响应体
+    DatabaseManager::setFullTextIndexEnabled(qEnvironmentVariableIntValue("CRAWLER_FULLTEXT") > 0);
+
+    // 初始化数据库（主线程）
+    if (!DatabaseManager::initDatabaseSchema()) {
+        qCritical() << "数据库初始化失败，程序退出";
+        return -1;
+    }
+
+    // 数据存储后端：CRAWLER_DATA_BACKEND=segment 时写入段文件（目录由 CRAWLER_SEGMENT_DIR 指定）
+    if (qEnvironmentVariable("CRAWLER_DATA_BACKEND").compare("segment", Qt::CaseInsensitive) == 0) {
+        SegmentStore::instance().setDirectory(qEnvironmentVariable("CRAWLER_SEGMENT_DIR", "crawler_segments"));
+        DatabaseManager::setDataBackend(DataBackend::Segment);
+        qInfo() << "数据存储后端：段文件" << SegmentStore::instance().directory();
+    }
+
+    // WAL 日志下在线备份与分析查询的读事务不阻塞爬虫写入（回滚日志模式下写入频繁时分步备份无法完成）
+    if (!DatabaseManager::enableWriteAheadLog()) {
+        qWarning() << "未能切换到 WAL 日志模式，在线备份可能因写入频繁而失败";
+    }
+
+    // 回环地址上的 /metrics 端点，端口由 CRAWLER_METRICS_PORT 指定（默认9464，0 表示关闭）
+    quint16 metricsPort = static_cast<quint16>(qEnvironmentVariableIntValue("CRAWLER_METRICS_PORT"));
+    if (!qEnvironmentVariableIsSet("CRAWLER_METRICS_PORT")) {
+        metricsPort = 9464;
+    }
+    MetricsServer metricsServer(metricsPort);
+    bool metricsOk = metricsPort > 0 && metricsServer.start();
+    if (metricsOk) {
+        qInfo() << "指标端点已启动：" << QString("http://127.0.0.1:%1/metrics").arg(metricsServer.port());
+    }
+
+    // 后台数据保留任务，周期由 CRAWLER_RETENTION_INTERVAL 指定（秒，默认600，0 表示关闭）
+    int retentionInterval = qEnvironmentVariableIntValue("CRAWLER_RETENTION_INTERVAL");
+    if (!qEnvironmentVariableIsSet("CRAWLER_RETENTION_INTERVAL")) {
+        retentionInterval = 600;
+    }
+    RetentionWorker retentionWorker(retentionInterval);
+    // CRAWLER_VACUUM_CONVERT=1：保留任务在后台把未启用增量回收的旧库转换一次（重写整个文件）
+    retentionWorker.setConvertAutoVacuum(qEnvironmentVariableIntValue("CRAWLER_VACUUM_CONVERT") > 0);
+    if (retentionInterval > 0) {
+        retentionWorker.startWorker();
+    }
+
+    // 原始响应归档（CRAWLER_ARCHIVE_RESPONSES=1 开启），供规则变更后重新提取历史数据
+    if (qEnvironmentVariableIntValue("CRAWLER_ARCHIVE_RESPONSES") > 0) {
+        ResponseArchive::instance().startWorker();
+        qInfo() << "原始响应归档已开启";
+    }
+
+    // 在线备份：目录由 CRAWLER_BACKUP_DIR 指定（默认 crawler_backups），周期由 CRAWLER_BACKUP_INTERVAL 指定
+    // （秒，默认0，即只在界面上手动触发），保留最近 CRAWLER_BACKUP_KEEP 份（默认7）
+    int backupKeep = qEnvironmentVariableIntValue("CRAWLER_BACKUP_KEEP");
+    if (!qEnvironmentVariableIsSet("CRAWLER_BACKUP_KEEP")) {
+        backupKeep = 7;
+    }
+    BackupWorker backupWorker(qEnvironmentVariable("CRAWLER_BACKUP_DIR", "crawler_backups"),
+                              qEnvironmentVariableIntValue("CRAWLER_BACKUP_INTERVAL"), backupKeep);
+    backupWorker.startWorker();
+
+    MainWindow w;
+    w.setMetricsPort(metricsOk ? metricsServer.port() : 0);
+    w.setBackupWorker(&backupWorker);
+    w.show();
+
+    const int ret = a.exec();
+    backupWorker.stopWorker();
+    DatabaseManager::stopReaders();
+    ResponseArchive::instance().stopWorker();
+    return ret;
+}
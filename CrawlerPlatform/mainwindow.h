@@ -1,80 +1,160 @@
-#ifndef MAINWINDOW_H
-#define MAINWINDOW_H
-
-#include <QMainWindow>
-#include <QTextEdit>
-#include <QTableWidget>
-#include <QPushButton>
-#include <QVBoxLayout>
-#include <QHBoxLayout>
-#include <QMessageBox>
-#include <QInputDialog>
-#include <QLabel>
-#include <QDateTime>
-#include <QTextCursor>
-#include <QMap>
-#include <QComboBox>
-#include <QPainter>
-
-// Qt 6 QtCharts头文件（兼容写法）
-#include <QtCharts/QChart>
-#include <QtCharts/QLineSeries>
-#include <QtCharts/QBarSeries>
-#include <QtCharts/QBarSet>
-#include <QtCharts/QValueAxis>
-#include <QtCharts/QCategoryAxis>
-#include <QtCharts/QChartView>
-#include <QtCharts/QBarCategoryAxis>
-
-#include "crawlerthread.h"
-
-// 【删除这行】Qt 6不需要这个宏
-// QT_CHARTS_USE_NAMESPACE  // Qt 5需要，Qt 6可删除
-
-class MainWindow : public QMainWindow
-{
-    Q_OBJECT
-
-public:
-    explicit MainWindow(QWidget *parent = nullptr);
-    ~MainWindow() override;
-
-private slots:
-    void onAddTaskClicked();
-    void onEditTaskClicked();
-    void onDeleteTaskClicked();
-    void onStartTaskClicked();
-    void onStopTaskClicked();
-    void onTaskStatusUpdated(int taskId, const QString& status);
-    void onTaskDataCrawled(int taskId, const CrawlerData& data);
-    void onTaskLogMessage(const QString& message);
-    void onChartTypeChanged(int index);
-    void refreshChart();
-
-private:
-    void initUI();
-    void refreshTaskList();
-    void showTaskData(int taskId);
-    int getSelectedTaskId();
-    void addLog(const QString& text);
-
-    void initCharts();
-    void updateLineChart(int taskId);
-    void updateBarChart(int taskId);
-
-    QTableWidget* m_taskTable;
-    QTextEdit* m_logText;
-    QTextEdit* m_dataText;
-    QMap<int, CrawlerThread*> m_threadMap;
-
-    // 图表相关成员（直接使用类名，无需命名空间）
-    QChart* m_chart;
-    QChartView* m_chartView;
-    QLineSeries* m_lineSeries;
-    QBarSeries* m_barSeries;
-    QComboBox* m_chartTypeCombo;
-    QPushButton* m_refreshChartBtn;
-    int m_currentChartType; // 0-折线图，1-柱状图
-};
-
-#endif // MAINWINDOW_H
+#ifndef MAINWINDOW_H
+#define MAINWINDOW_H
+
+#include <QMainWindow>
+#include <QTextEdit>
+#include <QTableView>
+#include <QPushButton>
+#include <QVBoxLayout>
+#include <QHBoxLayout>
+#include <QMessageBox>
+#include <QInputDialog>
+#include <QLabel>
+#include <QDateTime>
+#include <QTextCursor>
+#include <QMap>
+#include <QComboBox>
+#include <QPainter>
+#include <QTimer>
+#include <QElapsedTimer>
+#include <QFutureWatcher>
+
+// Qt 6 QtCharts头文件（兼容写法）
+#include <QtCharts/QChart>
+#include <QtCharts/QLineSeries>
+#include <QtCharts/QBarSeries>
+#include <QtCharts/QBarSet>
+#include <QtCharts/QValueAxis>
+#include <QtCharts/QCategoryAxis>
+#include <QtCharts/QChartView>
+#include <QtCharts/QBarCategoryAxis>
+
+#include "crawlerthread.h"
+#include "metricspanel.h"
+#include "searchpanel.h"
+#include "tasktablemodel.h"
+
+class BackupWorker;
+
+// 【删除这行】Qt 6不需要这个宏
+// QT_CHARTS_USE_NAMESPACE  // Qt 5需要，Qt 6可删除
+
+class MainWindow : public QMainWindow
+{
+    Q_OBJECT
+    friend class MicroBench; // 基准测试直接测量刷新路径
+
+public:
+    explicit MainWindow(QWidget *parent = nullptr);
+    ~MainWindow() override;
+
+    // 指标端点端口（0 表示未启用），供调试面板展示
+    void setMetricsPort(quint16 port) { m_metricsPort = port; }
+    // 后台备份线程（由 main 创建并启动）
+    void setBackupWorker(BackupWorker* worker);
+
+private slots:
+    void onAddTaskClicked();
+    void onEditTaskClicked();
+    void onDeleteTaskClicked();
+    void onStartTaskClicked();
+    void onStopTaskClicked();
+    void onTaskStatusUpdated(int taskId, const QString& status);
+    void onTaskDataCrawled(int taskId, const CrawlerData& data);
+    void onTaskLogMessage(const QString& message);
+    void onChartTypeChanged(int index);
+    void refreshChart();
+    void onShowMetricsClicked();
+    void onExportTraceClicked();
+    void onExportDataClicked();
+    void onBackupClicked();
+    void onGenerateTasksClicked();
+    void onReextractClicked();
+    void onImportTasksClicked();
+    void onBulkStartStopClicked();
+    void onSearchClicked();
+    void onLagProbe();
+
+    void onTasksChanged(const QList<int>& taskIds);
+    void onTaskListLoaded();
+    void onTaskDataLoaded();
+    void onChartDataLoaded();
+    // 任务表的窗口统计列：定时在读取线程池中查询（只读汇总表），与任务列表刷新分开
+    void refreshTaskStats();
+    void onTaskStatsLoaded();
+    // 任务表的最新值列：本进程的数据随 dataCrawled 更新，另定时读取最新值表（其他进程写入的任务）
+    void refreshLatestValues();
+    void onLatestValuesLoaded();
+
+private:
+    // 数据面板与图表的查询结果（在读取线程池中查询，回到界面线程后绘制）
+    struct TaskDataView {
+        int taskId = 0;
+        QString taskName;
+        QList<CrawlerData> latest; // 最新 10 个点
+    };
+    struct ChartData {
+        int taskId = 0;
+        int chartType = 0;          // 0-折线图，1-柱状图
+        QString taskName;
+        QList<RollupPoint> points;  // 折线图：汇总后的序列
+        QList<CrawlerData> latest;  // 柱状图：最新 10 个点
+        TaskStatistics stats;       // 图表时间范围内的统计量，用于 Y 轴范围
+    };
+    static TaskDataView queryTaskData(int taskId);
+    static ChartData queryChartData(int taskId, int chartType);
+
+    void initUI();
+    // 刷新任务列表/数据面板：发起异步查询，结果返回后再更新界面，同一视图只保留最新一次查询
+    void refreshTaskList();
+    void showTaskData(int taskId);
+    void loadTaskList(const QList<CrawlerTask>& tasks);
+    int getSelectedTaskId();
+    void startTask(int taskId, qint64 initialDelayMs = 0);
+    // 批量启停（已在运行/已停止的任务跳过），返回实际处理的任务数
+    int startTasks(const QList<int>& taskIds, qint64 rampUpMs);
+    int stopTasks(const QList<int>& taskIds);
+    // 按持久化的调度状态恢复上次退出时在运行的任务
+    void restoreRunningTasks();
+    // 按名称或URL筛选任务（空筛选条件表示全部）
+    QList<int> matchTasks(const QString& filter);
+    void addLog(const QString& text);
+
+    void initCharts();
+    void updateLineChart(const ChartData& data);
+    void updateBarChart(const ChartData& data);
+
+    QTableView* m_taskTable;
+    TaskTableModel* m_taskModel;
+    QTextEdit* m_logText;
+    QTextEdit* m_dataText;
+    QMap<int, CrawlerThread*> m_threadMap;
+
+    // 图表相关成员（直接使用类名，无需命名空间）
+    QChart* m_chart;
+    QChartView* m_chartView;
+    QLineSeries* m_lineSeries;
+    QBarSeries* m_barSeries;
+    QComboBox* m_chartTypeCombo;
+    QPushButton* m_refreshChartBtn;
+    int m_currentChartType; // 0-折线图，1-柱状图
+
+    // 进行中的异步查询
+    QFutureWatcher<QList<CrawlerTask>>* m_taskListWatcher;
+    QFutureWatcher<TaskDataView>* m_taskDataWatcher;
+    QFutureWatcher<ChartData>* m_chartWatcher;
+    QFutureWatcher<QHash<int, TaskStatistics>>* m_taskStatsWatcher;
+    QFutureWatcher<QHash<int, TaskLatest>>* m_latestWatcher;
+    QTimer* m_taskStatsTimer;
+    QTimer* m_latestTimer;
+
+    // 调试指标
+    MetricsPanel* m_metricsPanel;
+    SearchPanel* m_searchPanel;
+    quint16 m_metricsPort;
+    BackupWorker* m_backupWorker;
+    QTimer* m_lagProbe;          // 事件循环延迟探针
+    QElapsedTimer m_lagClock;
+};
+
+#endif // MAINWINDOW_H
@@ -0,0 +1,229 @@
+#include "metrics.h"
+#include <QtAlgorithms>
+#include <QStringList>
+#include <QMutexLocker>
+
+MetricHistogram::MetricHistogram(double scale)
+    : m_scale(scale)
+{
+    for (auto& bucket : m_buckets) {
+        bucket.store(0, std::memory_order_relaxed);
+    }
+}
+
+int MetricHistogram::bucketIndex(quint64 v)
+{
+    if (v < static_cast<quint64>(kSubBuckets)) {
+        return static_cast<int>(v);
+    }
+    // 最高位所在的2的幂区间 + 其后4位作为子桶
+    int msb = 63 - qCountLeadingZeroBits(v);
+    int shift = msb - kSubBucketBits;
+    int sub = static_cast<int>(v >> shift) - kSubBuckets;
+    return (shift + 1) * kSubBuckets + sub;
+}
+
+quint64 MetricHistogram::bucketLowerBound(int index)
+{
+    int group = index / kSubBuckets;
+    int sub = index % kSubBuckets;
+    if (group == 0) {
+        return static_cast<quint64>(sub);
+    }
+    return static_cast<quint64>(kSubBuckets + sub) << (group - 1);
+}
+
+void MetricHistogram::record(quint64 v)
+{
+    m_buckets[bucketIndex(v)].fetch_add(1, std::memory_order_relaxed);
+    m_count.fetch_add(1, std::memory_order_relaxed);
+    m_sum.fetch_add(v, std::memory_order_relaxed);
+}
+
+quint64 MetricHistogram::quantile(double q) const
+{
+    quint64 total = count();
+    if (total == 0) return 0;
+
+    quint64 target = static_cast<quint64>(q * total + 0.5);
+    if (target == 0) target = 1;
+
+    quint64 seen = 0;
+    for (int i = 0; i < kBucketCount; i++) {
+        seen += m_buckets[i].load(std::memory_order_relaxed);
+        if (seen >= target) {
+            // 取桶的中点作为估计值
+            quint64 lower = bucketLowerBound(i);
+            quint64 upper = (i + 1 < kBucketCount) ? bucketLowerBound(i + 1) : lower;
+            return lower + (upper - lower) / 2;
+        }
+    }
+    return bucketLowerBound(kBucketCount - 1);
+}
+
+quint64 MetricHistogram::countAtOrBelow(quint64 bound) const
+{
+    quint64 total = 0;
+    for (int i = 0; i < kBucketCount; i++) {
+        // 桶上界不超过 bound 的整桶计入
+        quint64 upper = (i + 1 < kBucketCount) ? bucketLowerBound(i + 1) : ~quint64(0);
+        if (upper > bound + 1) break;
+        total += m_buckets[i].load(std::memory_order_relaxed);
+    }
+    return total;
+}
+
+MetricsRegistry& MetricsRegistry::instance()
+{
+    static MetricsRegistry registry;
+    return registry;
+}
+
+QList<quint64> MetricsRegistry::latencyBoundsUs()
+{
+    return {100, 250, 500, 1000, 2500, 5000, 10000, 25000, 50000, 100000,
+            250000, 500000, 1000000, 2500000, 5000000, 10000000};
+}
+
+QList<quint64> MetricsRegistry::sizeBounds()
+{
+    return {1, 4, 16, 64, 256, 1024, 4096, 16384, 65536, 262144, 1048576, 4194304};
+}
+
+QString MetricsRegistry::labelText(const MetricLabels& labels, const QString& extraKey, const QString& extraValue)
+{
+    QStringList parts;
+    for (const auto& label : labels) {
+        QString value = label.second;
+        value.replace("\\", "\\\\").replace("\"", "\\\"").replace("\n", "\\n");
+        parts.append(QString("%1=\"%2\"").arg(label.first, value));
+    }
+    if (!extraKey.isEmpty()) {
+        parts.append(QString("%1=\"%2\"").arg(extraKey, extraValue));
+    }
+    return parts.isEmpty() ? QString() : "{" + parts.join(",") + "}";
+}
+
+MetricsRegistry::Entry* MetricsRegistry::findOrCreate(const QString& name, const QString& help,
+                                                      const MetricLabels& labels, Type type,
+                                                      double scale, const QList<quint64>& bounds)
+{
+    QMutexLocker locker(&m_mutex);
+    // 名称后接 \0 再接标签，保证同名指标在有序表中相邻
+    QString key = name + QChar(u'\0') + labelText(labels);
+    auto it = m_entries.find(key);
+    if (it != m_entries.end()) {
+        Q_ASSERT_X(it.value()->type == type, "MetricsRegistry", "指标类型冲突");
+        return it.value().get();
+    }
+
+    auto entry = std::make_shared<Entry>();
+    entry->name = name;
+    entry->help = help;
+    entry->labels = labels;
+    entry->type = type;
+    switch (type) {
+    case Type::Counter:
+        entry->counter = std::make_unique<MetricCounter>();
+        break;
+    case Type::Gauge:
+        entry->gauge = std::make_unique<MetricGauge>();
+        break;
+    case Type::Histogram:
+        entry->histogram = std::make_unique<MetricHistogram>(scale);
+        entry->bounds = bounds;
+        break;
+    }
+    m_entries.insert(key, entry);
+    return entry.get();
+}
+
+MetricCounter* MetricsRegistry::counter(const QString& name, const QString& help, const MetricLabels& labels)
+{
+    return findOrCreate(name, help, labels, Type::Counter)->counter.get();
+}
+
+MetricGauge* MetricsRegistry::gauge(const QString& name, const QString& help, const MetricLabels& labels)
+{
+    return findOrCreate(name, help, labels, Type::Gauge)->gauge.get();
+}
+
+MetricHistogram* MetricsRegistry::histogram(const QString& name, const QString& help, const MetricLabels& labels,
+                                            double scale, const QList<quint64>& bounds)
+{
+    return findOrCreate(name, help, labels, Type::Histogram, scale, bounds)->histogram.get();
+}
+
+QString MetricsRegistry::toPrometheusText() const
+{
+    QMutexLocker locker(&m_mutex);
+    QString out;
+    QString lastName;
+
+    for (const auto& entry : m_entries) {
+        if (entry->name != lastName) {
+            lastName = entry->name;
+            QString type = entry->type == Type::Counter ? "counter"
+                         : entry->type == Type::Gauge ? "gauge" : "histogram";
+            out += QString("# HELP %1 %2\n# TYPE %1 %3\n").arg(entry->name, entry->help, type);
+        }
+
+        QString labels = labelText(entry->labels);
+        switch (entry->type) {
+        case Type::Counter:
+            out += QString("%1%2 %3\n").arg(entry->name, labels).arg(entry->counter->value());
+            break;
+        case Type::Gauge:
+            out += QString("%1%2 %3\n").arg(entry->name, labels).arg(entry->gauge->value());
+            break;
+        case Type::Histogram: {
+            const MetricHistogram* h = entry->histogram.get();
+            for (quint64 bound : entry->bounds) {
+                out += QString("%1_bucket%2 %3\n")
+                           .arg(entry->name,
+                                labelText(entry->labels, "le", QString::number(bound * h->scale(), 'g', 6)))
+                           .arg(h->countAtOrBelow(bound));
+            }
+            out += QString("%1_bucket%2 %3\n").arg(entry->name, labelText(entry->labels, "le", "+Inf")).arg(h->count());
+            out += QString("%1_sum%2 %3\n").arg(entry->name, labels).arg(h->sum() * h->scale(), 0, 'g', 10);
+            out += QString("%1_count%2 %3\n").arg(entry->name, labels).arg(h->count());
+            break;
+        }
+        }
+    }
+    return out;
+}
+
+QString MetricsRegistry::toSummaryText() const
+{
+    QMutexLocker locker(&m_mutex);
+    QString out;
+
+    for (const auto& entry : m_entries) {
+        QString name = entry->name + labelText(entry->labels);
+        switch (entry->type) {
+        case Type::Counter:
+            out += QString("%1 = %2\n").arg(name).arg(entry->counter->value());
+            break;
+        case Type::Gauge:
+            out += QString("%1 = %2\n").arg(name).arg(entry->gauge->value());
+            break;
+        case Type::Histogram: {
+            const MetricHistogram* h = entry->histogram.get();
+            double scale = h->scale();
+            // 延迟类直方图以毫秒展示
+            double display = qFuzzyCompare(scale, 1e-6) ? 1e-3 : scale;
+            QString unit = qFuzzyCompare(scale, 1e-6) ? "ms" : "";
+            out += QString("%1  count=%2  p50=%3%6  p99=%4%6  mean=%5%6\n")
+                       .arg(name)
+                       .arg(h->count())
+                       .arg(h->quantile(0.50) * display, 0, 'f', 2)
+                       .arg(h->quantile(0.99) * display, 0, 'f', 2)
+                       .arg(h->count() ? static_cast<double>(h->sum()) / h->count() * display : 0.0, 0, 'f', 2)
+                       .arg(unit);
+            break;
+        }
+        }
+    }
+    return out;
+}
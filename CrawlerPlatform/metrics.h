@@ -0,0 +1,121 @@
+#ifndef METRICS_H
+#define METRICS_H
+
+#include <QString>
+#include <QList>
+#include <QPair>
+#include <QMap>
+#include <QMutex>
+#include <QElapsedTimer>
+#include <atomic>
+#include <memory>
+
+// 计数器（单调递增）
+class MetricCounter {
+public:
+    void inc(quint64 n = 1) { m_value.fetch_add(n, std::memory_order_relaxed); }
+    quint64 value() const { return m_value.load(std::memory_order_relaxed); }
+
+private:
+    std::atomic<quint64> m_value{0};
+};
+
+// 仪表（可增可减）
+class MetricGauge {
+public:
+    void set(qint64 v) { m_value.store(v, std::memory_order_relaxed); }
+    void add(qint64 n) { m_value.fetch_add(n, std::memory_order_relaxed); }
+    qint64 value() const { return m_value.load(std::memory_order_relaxed); }
+
+private:
+    std::atomic<qint64> m_value{0};
+};
+
+// HDR风格直方图：每个2的幂区间再细分16个子桶（相对误差约6%），记录无锁
+class MetricHistogram {
+public:
+    static const int kSubBucketBits = 4;
+    static const int kSubBuckets = 1 << kSubBucketBits;
+    static const int kBucketCount = (64 - kSubBucketBits + 1) * kSubBuckets;
+
+    // scale：导出时的单位换算（如微秒 -> 秒为 1e-6）
+    explicit MetricHistogram(double scale = 1.0);
+
+    void record(quint64 v);
+    quint64 count() const { return m_count.load(std::memory_order_relaxed); }
+    quint64 sum() const { return m_sum.load(std::memory_order_relaxed); }
+    double scale() const { return m_scale; }
+
+    // 分位数估计（q 取 0~1，返回原始单位）
+    quint64 quantile(double q) const;
+    // 小于等于 bound（原始单位）的样本数
+    quint64 countAtOrBelow(quint64 bound) const;
+
+    static int bucketIndex(quint64 v);
+    static quint64 bucketLowerBound(int index);
+
+private:
+    double m_scale;
+    std::atomic<quint64> m_count{0};
+    std::atomic<quint64> m_sum{0};
+    std::atomic<quint64> m_buckets[kBucketCount];
+};
+
+// 作用域计时：析构时把经过的微秒数记入直方图
+class MetricTimer {
+public:
+    explicit MetricTimer(MetricHistogram* histogram) : m_histogram(histogram) { m_timer.start(); }
+    ~MetricTimer() { m_histogram->record(static_cast<quint64>(m_timer.nsecsElapsed() / 1000)); }
+
+private:
+    MetricHistogram* m_histogram;
+    QElapsedTimer m_timer;
+};
+
+using MetricLabels = QList<QPair<QString, QString>>;
+
+// 指标注册表（单例）
+// 注册走互斥锁（冷路径，调用方应缓存返回的指针），记录全部为原子操作
+class MetricsRegistry {
+public:
+    static MetricsRegistry& instance();
+
+    MetricCounter* counter(const QString& name, const QString& help, const MetricLabels& labels = {});
+    MetricGauge* gauge(const QString& name, const QString& help, const MetricLabels& labels = {});
+    // 延迟类直方图以微秒记录，按秒导出；bounds 为导出的桶上界（原始单位）
+    MetricHistogram* histogram(const QString& name, const QString& help, const MetricLabels& labels = {},
+                               double scale = 1e-6, const QList<quint64>& bounds = latencyBoundsUs());
+
+    // Prometheus 文本格式（version 0.0.4）
+    QString toPrometheusText() const;
+    // 调试面板用的可读摘要
+    QString toSummaryText() const;
+
+    static QList<quint64> latencyBoundsUs();
+    static QList<quint64> sizeBounds();
+
+private:
+    MetricsRegistry() = default;
+
+    enum class Type { Counter, Gauge, Histogram };
+    struct Entry {
+        QString name;
+        QString help;
+        MetricLabels labels;
+        Type type;
+        std::unique_ptr<MetricCounter> counter;
+        std::unique_ptr<MetricGauge> gauge;
+        std::unique_ptr<MetricHistogram> histogram;
+        QList<quint64> bounds;
+    };
+
+    Entry* findOrCreate(const QString& name, const QString& help, const MetricLabels& labels, Type type,
+                        double scale = 1.0, const QList<quint64>& bounds = {});
+    static QString labelText(const MetricLabels& labels, const QString& extraKey = QString(),
+                             const QString& extraValue = QString());
+
+    mutable QMutex m_mutex;
+    QMap<QString, std::shared_ptr<Entry>> m_entries; // 键：名称+标签，同名指标相邻便于分组导出
+};
+
+#endif // METRICS_H
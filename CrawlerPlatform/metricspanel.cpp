@@ -0,0 +1,46 @@
+#include "metricspanel.h"
+#include "metrics.h"
+#include <QVBoxLayout>
+#include <QScrollBar>
+
+MetricsPanel::MetricsPanel(quint16 endpointPort, QWidget *parent)
+    : QDialog(parent)
+    , m_text(new QPlainTextEdit(this))
+    , m_endpointLabel(new QLabel(this))
+    , m_timer(new QTimer(this))
+{
+    setWindowTitle("调试指标");
+    resize(760, 520);
+
+    if (endpointPort > 0) {
+        m_endpointLabel->setText(QString("Prometheus 端点：http://127.0.0.1:%1/metrics").arg(endpointPort));
+    } else {
+        m_endpointLabel->setText("Prometheus 端点未启用（CRAWLER_METRICS_PORT=0 或端口被占用）");
+    }
+    m_endpointLabel->setTextInteractionFlags(Qt::TextSelectableByMouse);
+
+    m_text->setReadOnly(true);
+    m_text->setLineWrapMode(QPlainTextEdit::NoWrap);
+    m_text->setStyleSheet(R"(
+        QPlainTextEdit {
+            font-family: Consolas;
+            font-size: 12px;
+        }
+    )");
+
+    QVBoxLayout* layout = new QVBoxLayout(this);
+    layout->addWidget(m_endpointLabel);
+    layout->addWidget(m_text, 1);
+
+    connect(m_timer, &QTimer::timeout, this, &MetricsPanel::refresh);
+    m_timer->start(1000);
+    refresh();
+}
+
+void MetricsPanel::refresh()
+{
+    // 保持滚动位置，避免每秒刷新时跳回顶部
+    int scroll = m_text->verticalScrollBar()->value();
+    m_text->setPlainText(MetricsRegistry::instance().toSummaryText());
+    m_text->verticalScrollBar()->setValue(scroll);
+}
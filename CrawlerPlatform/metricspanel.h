@@ -0,0 +1,26 @@
+#ifndef METRICSPANEL_H
+#define METRICSPANEL_H
+
+#include <QDialog>
+#include <QPlainTextEdit>
+#include <QLabel>
+#include <QTimer>
+
+// 调试面板：定时展示指标注册表摘要
+class MetricsPanel : public QDialog
+{
+    Q_OBJECT
+
+public:
+    explicit MetricsPanel(quint16 endpointPort, QWidget *parent = nullptr);
+
+private slots:
+    void refresh();
+
+private:
+    QPlainTextEdit* m_text;
+    QLabel* m_endpointLabel;
+    QTimer* m_timer;
+};
+
+#endif // METRICSPANEL_H
@@ -0,0 +1,117 @@
+#include "metricsserver.h"
+#include "metrics.h"
+#include "tracing.h"
+#include <QHostAddress>
+#include <QDebug>
+
+MetricsServer::MetricsServer(quint16 port)
+    : m_port(port)
+    , m_context(nullptr)
+    , m_server(nullptr)
+{
+}
+
+MetricsServer::~MetricsServer()
+{
+    stop();
+}
+
+bool MetricsServer::start()
+{
+    if (m_context) {
+        return true;
+    }
+
+    m_context = new QObject();
+    m_context->moveToThread(&m_thread);
+    m_thread.setObjectName("MetricsServer");
+    m_thread.start(QThread::LowPriority);
+
+    bool ok = false;
+    QMetaObject::invokeMethod(m_context, [this, &ok]() {
+        m_server = new QTcpServer(m_context);
+        QObject::connect(m_server, &QTcpServer::newConnection, m_context, [this]() { onNewConnection(); });
+        ok = m_server->listen(QHostAddress::LocalHost, m_port);
+        if (ok) {
+            m_port = m_server->serverPort();
+        } else {
+            qWarning() << "指标端点监听失败：" << m_server->errorString();
+        }
+    }, Qt::BlockingQueuedConnection);
+
+    if (!ok) {
+        stop();
+    }
+    return ok;
+}
+
+void MetricsServer::stop()
+{
+    if (!m_context) {
+        return;
+    }
+
+    QMetaObject::invokeMethod(m_context, [this]() {
+        m_buffers.clear();
+        m_server->close();
+        m_context->deleteLater();
+    }, Qt::BlockingQueuedConnection);
+    m_context = nullptr;
+    m_server = nullptr;
+
+    m_thread.quit();
+    m_thread.wait();
+}
+
+void MetricsServer::onNewConnection()
+{
+    while (m_server->hasPendingConnections()) {
+        QTcpSocket* socket = m_server->nextPendingConnection();
+        QObject::connect(socket, &QTcpSocket::readyRead, socket, [this, socket]() { onReadyRead(socket); });
+        QObject::connect(socket, &QTcpSocket::disconnected, socket, [this, socket]() {
+            m_buffers.remove(socket);
+            socket->deleteLater();
+        });
+    }
+}
+
+void MetricsServer::onReadyRead(QTcpSocket* socket)
+{
+    QByteArray& buffer = m_buffers[socket];
+    buffer.append(socket->readAll());
+    if (!buffer.contains("\r\n\r\n")) {
+        if (buffer.size() > 8192) socket->abort(); // 异常请求
+        return;
+    }
+
+    // 请求行：GET /metrics HTTP/1.1
+    QList<QByteArray> requestLine = buffer.left(buffer.indexOf("\r\n")).split(' ');
+    QByteArray path = requestLine.size() >= 2 && requestLine[0] == "GET" ? requestLine[1] : QByteArray();
+    path = path.left(path.indexOf('?'));
+
+    QByteArray status = "200 OK";
+    QByteArray contentType = "text/plain; version=0.0.4; charset=utf-8";
+    QByteArray body;
+    if (path == "/metrics") {
+        body = MetricsRegistry::instance().toPrometheusText().toUtf8();
+    } else if (path == "/trace") {
+        // 按需导出采样追踪（Chrome Trace Event JSON）
+        contentType = "application/json";
+        body = Tracer::instance().exportChromeTrace();
+    } else {
+        status = "404 Not Found";
+        body = "not found\n";
+    }
+
+    QByteArray response;
+    response.reserve(body.size() + 160);
+    response += "HTTP/1.1 " + status + "\r\n";
+    response += "Content-Type: " + contentType + "\r\n";
+    response += "Content-Length: " + QByteArray::number(body.size()) + "\r\n";
+    response += "Connection: close\r\n\r\n";
+    response += body;
+
+    m_buffers.remove(socket);
+    socket->write(response);
+    socket->disconnectFromHost();
+}
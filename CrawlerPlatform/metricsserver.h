@@ -0,0 +1,34 @@
+#ifndef METRICSSERVER_H
+#define METRICSSERVER_H
+
+#include <QObject>
+#include <QThread>
+#include <QTcpServer>
+#include <QTcpSocket>
+#include <QHash>
+#include <QByteArray>
+
+// 回环地址上的 /metrics 端点（Prometheus 文本格式）与 /trace 追踪导出
+// 独立线程监听，GUI 卡顿时仍可抓取
+class MetricsServer
+{
+public:
+    explicit MetricsServer(quint16 port);
+    ~MetricsServer();
+
+    bool start();
+    void stop();
+    quint16 port() const { return m_port; }
+
+private:
+    void onNewConnection();
+    void onReadyRead(QTcpSocket* socket);
+
+    quint16 m_port;
+    QThread m_thread;
+    QObject* m_context;       // 归属服务线程的上下文对象
+    QTcpServer* m_server;
+    QHash<QTcpSocket*, QByteArray> m_buffers;
+};
+
+#endif // METRICSSERVER_H
@@ -0,0 +1,154 @@
+#include "quantilesketch.h"
+#include <cmath>
+
+static const quint8 kSketchVersion = 1;
+// 绝对值小于该值的样本计入零值桶
+static const double kMinIndexable = 1e-9;
+static const double kGamma = (1.0 + QuantileSketch::kRelativeAccuracy) / (1.0 - QuantileSketch::kRelativeAccuracy);
+static const double kLogGamma = std::log(kGamma);
+
+int QuantileSketch::binIndex(double magnitude)
+{
+    return static_cast<int>(std::ceil(std::log(magnitude) / kLogGamma));
+}
+
+// 桶 (γ^(i-1), γ^i] 的代表值，使桶内任意值的相对误差不超过 kRelativeAccuracy
+double QuantileSketch::binValue(int index)
+{
+    return 2.0 * std::pow(kGamma, index) / (kGamma + 1.0);
+}
+
+void QuantileSketch::collapse(QMap<int, quint64>& bins)
+{
+    while (bins.size() > kMaxBins) {
+        auto lowest = bins.begin();
+        const quint64 count = lowest.value();
+        lowest = bins.erase(lowest);
+        lowest.value() += count;
+    }
+}
+
+void QuantileSketch::add(double value, quint64 count)
+{
+    if (count == 0 || std::isnan(value)) return;
+    m_count += count;
+    if (std::fabs(value) < kMinIndexable) {
+        m_zero += count;
+        return;
+    }
+    QMap<int, quint64>& bins = value > 0 ? m_positive : m_negative;
+    bins[binIndex(std::fabs(value))] += count;
+    if (bins.size() > kMaxBins) {
+        collapse(bins);
+    }
+}
+
+void QuantileSketch::merge(const QuantileSketch& other)
+{
+    for (auto it = other.m_positive.cbegin(); it != other.m_positive.cend(); ++it) {
+        m_positive[it.key()] += it.value();
+    }
+    for (auto it = other.m_negative.cbegin(); it != other.m_negative.cend(); ++it) {
+        m_negative[it.key()] += it.value();
+    }
+    collapse(m_positive);
+    collapse(m_negative);
+    m_zero += other.m_zero;
+    m_count += other.m_count;
+}
+
+double QuantileSketch::quantile(double q) const
+{
+    if (m_count == 0) return 0.0;
+    // 第 rank 个样本（从 0 计）所在的桶；负值从绝对值最大的桶开始
+    const quint64 rank = static_cast<quint64>(qBound(0.0, q, 1.0) * (m_count - 1));
+    quint64 seen = 0;
+    for (auto it = m_negative.cend(); it != m_negative.cbegin();) {
+        --it;
+        seen += it.value();
+        if (seen > rank) return -binValue(it.key());
+    }
+    seen += m_zero;
+    if (seen > rank) return 0.0;
+    for (auto it = m_positive.cbegin(); it != m_positive.cend(); ++it) {
+        seen += it.value();
+        if (seen > rank) return binValue(it.key());
+    }
+    return m_positive.isEmpty() ? 0.0 : binValue(m_positive.lastKey());
+}
+
+static void writeVarint(QByteArray& out, quint64 v)
+{
+    while (v >= 0x80) {
+        out.append(static_cast<char>((v & 0x7F) | 0x80));
+        v >>= 7;
+    }
+    out.append(static_cast<char>(v));
+}
+
+static bool readVarint(const QByteArray& in, qsizetype* pos, quint64* v)
+{
+    *v = 0;
+    for (int shift = 0; shift < 64 && *pos < in.size(); shift += 7) {
+        const quint8 byte = static_cast<quint8>(in.at((*pos)++));
+        *v |= static_cast<quint64>(byte & 0x7F) << shift;
+        if (!(byte & 0x80)) return true;
+    }
+    return false;
+}
+
+static void writeBins(QByteArray& out, const QMap<int, quint64>& bins)
+{
+    writeVarint(out, static_cast<quint64>(bins.size()));
+    qint64 previous = 0;
+    for (auto it = bins.cbegin(); it != bins.cend(); ++it) {
+        const qint64 delta = it.key() - previous;
+        writeVarint(out, (static_cast<quint64>(delta) << 1) ^ static_cast<quint64>(delta >> 63)); // zigzag
+        writeVarint(out, it.value());
+        previous = it.key();
+    }
+}
+
+static bool readBins(const QByteArray& in, qsizetype* pos, QMap<int, quint64>* bins, quint64* total)
+{
+    quint64 size = 0;
+    if (!readVarint(in, pos, &size) || size > static_cast<quint64>(in.size())) return false;
+    qint64 previous = 0;
+    for (quint64 i = 0; i < size; i++) {
+        quint64 zigzag = 0;
+        quint64 count = 0;
+        if (!readVarint(in, pos, &zigzag) || !readVarint(in, pos, &count)) return false;
+        previous += static_cast<qint64>(zigzag >> 1) ^ -static_cast<qint64>(zigzag & 1);
+        bins->insert(static_cast<int>(previous), count);
+        *total += count;
+    }
+    return true;
+}
+
+QByteArray QuantileSketch::toBytes() const
+{
+    QByteArray out;
+    out.reserve(8 + 3 * (m_positive.size() + m_negative.size()));
+    out.append(static_cast<char>(kSketchVersion));
+    writeVarint(out, m_zero);
+    writeBins(out, m_positive);
+    writeBins(out, m_negative);
+    return out;
+}
+
+QuantileSketch QuantileSketch::fromBytes(const QByteArray& bytes)
+{
+    QuantileSketch sketch;
+    if (bytes.isEmpty() || static_cast<quint8>(bytes.at(0)) != kSketchVersion) {
+        return sketch;
+    }
+    qsizetype pos = 1;
+    quint64 total = 0;
+    if (!readVarint(bytes, &pos, &sketch.m_zero)
+        || !readBins(bytes, &pos, &sketch.m_positive, &total)
+        || !readBins(bytes, &pos, &sketch.m_negative, &total)) {
+        return QuantileSketch();
+    }
+    sketch.m_count = total + sketch.m_zero;
+    return sketch;
+}
@@ -0,0 +1,40 @@
+#ifndef QUANTILESKETCH_H
+#define QUANTILESKETCH_H
+
+#include <QByteArray>
+#include <QMap>
+#include <QtGlobal>
+
+// 可合并的分位数草图（DDSketch）：按对数间隔分桶，分位数的相对误差不超过 kRelativeAccuracy
+// 合并即对应桶计数相加，小时草图可以任意拼成更长的窗口
+// 序列化格式：1 字节版本 + 零值计数 + 正/负两组（桶数，再逐个写 桶号差值、计数），整数均为变长编码
+class QuantileSketch {
+public:
+    static constexpr double kRelativeAccuracy = 0.01;
+    // 每组桶数上限，超出时合并绝对值最小的桶（高分位数保持精度）
+    static const int kMaxBins = 2048;
+
+    void add(double value, quint64 count = 1);
+    void merge(const QuantileSketch& other);
+
+    quint64 count() const { return m_count; }
+    bool isEmpty() const { return m_count == 0; }
+    // q 取 0~1，空草图返回 0
+    double quantile(double q) const;
+
+    QByteArray toBytes() const;
+    // 无法解析时返回空草图
+    static QuantileSketch fromBytes(const QByteArray& bytes);
+
+private:
+    static int binIndex(double magnitude);
+    static double binValue(int index);
+    static void collapse(QMap<int, quint64>& bins);
+
+    QMap<int, quint64> m_positive; // 桶号 -> 计数（按绝对值分桶）
+    QMap<int, quint64> m_negative;
+    quint64 m_zero = 0;
+    quint64 m_count = 0;
+};
+
+#endif // QUANTILESKETCH_H
@@ -0,0 +1,751 @@
+#include "responsearchive.h"
+#include "databasemanager.h"
+#include "crawlerthread.h"
+#include "chunkstore.h"
+#include "fulltextindex.h"
+#include "metrics.h"
+#include <QSqlQuery>
+#include <QSqlError>
+#include <QCryptographicHash>
+#include <QRegularExpression>
+#include <QThreadPool>
+#include <QHash>
+#include <QSet>
+#include <QMap>
+#include <QDebug>
+#include <algorithm>
+#include <vector>
+
+#ifdef CRAWLER_HAVE_ZSTD
+#include <zstd.h>
+#include <zdict.h>
+#endif
+
+// 响应体的存储编码
+enum ArchiveCodec {
+    CodecStored = 0, // 未压缩（压缩后反而更大时）
+    CodecZlib = 1,   // qCompress，未启用 zstd 的构建使用
+    CodecZstd = 2,   // zstd，dictId 非 0 时使用对应主机的字典
+};
+
+// 每个写入事务处理的响应数与积压上限
+static const int kWriteBatch = 64;
+static const qint64 kMaxQueuedBytes = 64LL * 1024 * 1024;
+// zstd 压缩级别与字典训练参数
+static const int kZstdLevel = 6;
+static const int kDictTrainSamples = 128;
+static const int kDictSampleBytes = 64 * 1024;
+static const int kDictCapacity = 32 * 1024;
+static const int kDictMaxAttempts = 3;
+// 重新提取时每批读取的响应体数
+static const int kReextractBatch = 512;
+
+// 归档指标（首次使用时注册）
+struct ArchiveMetrics {
+    MetricCounter* responses;
+    MetricCounter* dedupHits;
+    MetricCounter* rawBytes;
+    MetricCounter* storedBytes;
+    MetricCounter* dropped;
+    MetricCounter* dictsTrained;
+    MetricGauge* queuedBytes;
+    MetricHistogram* batchDuration;
+
+    static const ArchiveMetrics& get()
+    {
+        static const ArchiveMetrics metrics = []() {
+            MetricsRegistry& registry = MetricsRegistry::instance();
+            const QString bytes = "crawler_archive_bytes_total";
+            const QString bytesHelp = "归档响应体字节数";
+            ArchiveMetrics m;
+            m.responses = registry.counter("crawler_archive_responses_total", "写入归档的响应数");
+            m.dedupHits = registry.counter("crawler_archive_dedup_hits_total", "内容与已归档响应体相同的响应数");
+            m.rawBytes = registry.counter(bytes, bytesHelp, {{"kind", "raw"}});
+            m.storedBytes = registry.counter(bytes, bytesHelp, {{"kind", "stored"}});
+            m.dropped = registry.counter("crawler_archive_dropped_total", "积压超限被丢弃的响应数");
+            m.dictsTrained = registry.counter("crawler_archive_dicts_trained_total", "训练出的压缩字典数");
+            m.queuedBytes = registry.gauge("crawler_archive_queued_bytes", "等待写入归档的响应字节数");
+            m.batchDuration = registry.histogram("crawler_archive_batch_duration_seconds", "单批归档写入耗时");
+            return m;
+        }();
+        return metrics;
+    }
+};
+
+// 后台写入线程独占的压缩状态
+struct ArchiveWriterState {
+    bool bodyIndex = false; // 主库中建有响应体全文索引
+
+#ifdef CRAWLER_HAVE_ZSTD
+    struct HostDict {
+        int id = 0;
+        ZSTD_CDict* cdict = nullptr;
+    };
+    ZSTD_CCtx* cctx = ZSTD_createCCtx();
+    QHash<QString, HostDict> dicts;
+    QHash<QString, QList<QByteArray>> samples; // 尚无字典的主机收集的训练样本
+    QHash<QString, int> attempts;
+
+    ~ArchiveWriterState()
+    {
+        for (const HostDict& dict : std::as_const(dicts)) {
+            ZSTD_freeCDict(dict.cdict);
+        }
+        ZSTD_freeCCtx(cctx);
+    }
+#endif
+};
+
+// 解压用字典，按 dictId 加载后只读共享给各解析线程
+class ArchiveDicts {
+public:
+    ArchiveDicts() = default;
+    ArchiveDicts(const ArchiveDicts&) = delete;
+    ArchiveDicts& operator=(const ArchiveDicts&) = delete;
+
+#ifdef CRAWLER_HAVE_ZSTD
+    ~ArchiveDicts()
+    {
+        for (ZSTD_DDict* dict : std::as_const(m_dicts)) {
+            ZSTD_freeDDict(dict);
+        }
+    }
+
+    void load(QSqlDatabase& db, int dictId)
+    {
+        if (dictId == 0 || m_dicts.contains(dictId)) return;
+        QSqlQuery query(db);
+        query.prepare("SELECT data FROM crawler_archive_dicts WHERE id = :id");
+        query.bindValue(":id", dictId);
+        ZSTD_DDict* dict = nullptr;
+        if (query.exec() && query.next()) {
+            const QByteArray data = query.value(0).toByteArray();
+            dict = ZSTD_createDDict(data.constData(), static_cast<size_t>(data.size()));
+        } else {
+            qWarning() << "压缩字典不存在：" << dictId;
+        }
+        m_dicts.insert(dictId, dict);
+    }
+
+    const ZSTD_DDict* get(int dictId) const { return m_dicts.value(dictId, nullptr); }
+
+private:
+    QHash<int, ZSTD_DDict*> m_dicts;
+#else
+    void load(QSqlDatabase&, int) {}
+#endif
+};
+
+// 解压上下文，每个线程一个
+class ArchiveDecoder {
+public:
+    ArchiveDecoder() = default;
+    ArchiveDecoder(const ArchiveDecoder&) = delete;
+    ArchiveDecoder& operator=(const ArchiveDecoder&) = delete;
+#ifdef CRAWLER_HAVE_ZSTD
+    ~ArchiveDecoder() { ZSTD_freeDCtx(m_dctx); }
+#endif
+
+    bool decode(const ArchiveDicts& dicts, int codec, int dictId, const QByteArray& data, qint64 rawSize,
+                QByteArray* body)
+    {
+        switch (codec) {
+        case CodecStored:
+            *body = data;
+            return true;
+        case CodecZlib:
+            *body = qUncompress(data);
+            return body->size() == rawSize;
+#ifdef CRAWLER_HAVE_ZSTD
+        case CodecZstd: {
+            const ZSTD_DDict* dict = dictId != 0 ? dicts.get(dictId) : nullptr;
+            if (dictId != 0 && !dict) return false;
+            body->resize(static_cast<qsizetype>(rawSize));
+            const size_t size = dict
+                ? ZSTD_decompress_usingDDict(m_dctx, body->data(), static_cast<size_t>(body->size()),
+                                             data.constData(), static_cast<size_t>(data.size()), dict)
+                : ZSTD_decompressDCtx(m_dctx, body->data(), static_cast<size_t>(body->size()),
+                                      data.constData(), static_cast<size_t>(data.size()));
+            return !ZSTD_isError(size) && static_cast<qint64>(size) == rawSize;
+        }
+#endif
+        default:
+            Q_UNUSED(dicts);
+            Q_UNUSED(dictId);
+            return false;
+        }
+    }
+
+private:
+#ifdef CRAWLER_HAVE_ZSTD
+    ZSTD_DCtx* m_dctx = ZSTD_createDCtx();
+#endif
+};
+
+// 压缩单个响应体；有该主机的字典时使用字典
+static QByteArray compressBody(ArchiveWriterState& state, const QString& host, const QByteArray& body,
+                               int* codec, int* dictId)
+{
+    *dictId = 0;
+    QByteArray out;
+#ifdef CRAWLER_HAVE_ZSTD
+    out.resize(static_cast<qsizetype>(ZSTD_compressBound(static_cast<size_t>(body.size()))));
+    const auto dict = state.dicts.constFind(host);
+    const bool useDict = dict != state.dicts.constEnd() && dict->cdict;
+    const size_t size = useDict
+        ? ZSTD_compress_usingCDict(state.cctx, out.data(), static_cast<size_t>(out.size()),
+                                   body.constData(), static_cast<size_t>(body.size()), dict->cdict)
+        : ZSTD_compressCCtx(state.cctx, out.data(), static_cast<size_t>(out.size()),
+                            body.constData(), static_cast<size_t>(body.size()), kZstdLevel);
+    if (!ZSTD_isError(size)) {
+        out.resize(static_cast<qsizetype>(size));
+        *codec = CodecZstd;
+        *dictId = useDict ? dict->id : 0;
+    } else {
+        qWarning() << "zstd 压缩失败，改用 zlib：" << ZSTD_getErrorName(size);
+        out = qCompress(body);
+        *codec = CodecZlib;
+    }
+#else
+    Q_UNUSED(state);
+    Q_UNUSED(host);
+    out = qCompress(body);
+    *codec = CodecZlib;
+#endif
+    if (out.size() >= body.size()) {
+        *codec = CodecStored;
+        *dictId = 0;
+        return body;
+    }
+    return out;
+}
+
+#ifdef CRAWLER_HAVE_ZSTD
+// 收集训练样本，样本足够时为该主机训练字典并持久化
+static void collectSample(QSqlDatabase& db, ArchiveWriterState& state, const QString& host, const QByteArray& body)
+{
+    if (host.isEmpty() || state.dicts.contains(host) || state.attempts.value(host) >= kDictMaxAttempts) {
+        return;
+    }
+    QList<QByteArray>& samples = state.samples[host];
+    samples.append(body.left(kDictSampleBytes));
+    if (samples.size() < kDictTrainSamples) {
+        return;
+    }
+
+    QByteArray buffer;
+    std::vector<size_t> sizes;
+    sizes.reserve(static_cast<size_t>(samples.size()));
+    for (const QByteArray& sample : std::as_const(samples)) {
+        buffer.append(sample);
+        sizes.push_back(static_cast<size_t>(sample.size()));
+    }
+    samples.clear();
+
+    QByteArray dict(kDictCapacity, Qt::Uninitialized);
+    const size_t size = ZDICT_trainFromBuffer(dict.data(), static_cast<size_t>(dict.size()), buffer.constData(),
+                                              sizes.data(), static_cast<unsigned>(sizes.size()));
+    if (ZDICT_isError(size)) {
+        state.attempts[host]++;
+        qWarning() << "训练压缩字典失败：" << host << ZDICT_getErrorName(size);
+        return;
+    }
+    dict.resize(static_cast<qsizetype>(size));
+
+    QSqlQuery insert(db);
+    insert.prepare("INSERT INTO crawler_archive_dicts (host, createdAt, data) VALUES (:host, :createdAt, :data)");
+    insert.bindValue(":host", host);
+    insert.bindValue(":createdAt", QDateTime::currentSecsSinceEpoch());
+    insert.bindValue(":data", dict);
+    if (!insert.exec()) {
+        state.attempts[host]++;
+        qWarning() << "保存压缩字典失败：" << insert.lastError().text();
+        return;
+    }
+
+    ArchiveWriterState::HostDict entry;
+    entry.id = insert.lastInsertId().toInt();
+    entry.cdict = ZSTD_createCDict(dict.constData(), static_cast<size_t>(dict.size()), kZstdLevel);
+    state.dicts.insert(host, entry);
+    ArchiveMetrics::get().dictsTrained->inc();
+    qInfo() << "已为" << host << "训练压缩字典，大小" << dict.size() << "字节";
+}
+#endif
+
+ResponseArchive& ResponseArchive::instance()
+{
+    static ResponseArchive archive;
+    return archive;
+}
+
+ResponseArchive::ResponseArchive()
+    : QThread(nullptr)
+{
+    setObjectName("ResponseArchive");
+}
+
+ResponseArchive::~ResponseArchive()
+{
+    stopWorker();
+}
+
+// id 用 AUTOINCREMENT：删除的响应体 id 不再复用，全文索引中的残留项不会指向新的响应体
+static const char* const kBlobsTableSql = R"(
+    CREATE TABLE IF NOT EXISTS %1 (
+        id INTEGER PRIMARY KEY AUTOINCREMENT,
+        hash BLOB NOT NULL UNIQUE,
+        codec INTEGER NOT NULL,
+        dictId INTEGER NOT NULL DEFAULT 0,
+        rawSize INTEGER NOT NULL,
+        data BLOB NOT NULL
+    )
+)";
+
+// 旧版 crawler_blobs 的 id 可能复用：整表复制到新表（保留原 id），并重建响应体全文索引
+static bool upgradeBlobsTable(QSqlDatabase& db)
+{
+    QSqlQuery query(db);
+    if (!query.exec("SELECT sql FROM sqlite_master WHERE type = 'table' AND name = 'crawler_blobs'")
+        || !query.next() || query.value(0).toString().contains("AUTOINCREMENT", Qt::CaseInsensitive)) {
+        return true;
+    }
+    query.finish();
+
+    qInfo() << "升级响应体表：id 改为不复用";
+    if (!db.transaction()) {
+        qCritical() << "升级响应体表失败：无法开启事务" << db.lastError().text();
+        return false;
+    }
+    const QStringList statements = {
+        QString(kBlobsTableSql).arg("crawler_blobs_new"),
+        "INSERT INTO crawler_blobs_new (id, hash, codec, dictId, rawSize, data) "
+        "SELECT id, hash, codec, dictId, rawSize, data FROM crawler_blobs",
+        "DROP TABLE crawler_blobs",
+        "ALTER TABLE crawler_blobs_new RENAME TO crawler_blobs",
+    };
+    for (const QString& sql : statements) {
+        if (!query.exec(sql)) {
+            qCritical() << "升级响应体表失败：" << query.lastError().text();
+            db.rollback();
+            return false;
+        }
+    }
+    // 旧索引里可能已有复用 id 的错误项，删除后由 createBodyIndex 重建
+    FullTextIndex::dropBodyIndex(db);
+    if (!db.commit()) {
+        qCritical() << "升级响应体表失败：" << db.lastError().text();
+        db.rollback();
+        return false;
+    }
+    return true;
+}
+
+bool ResponseArchive::createSchema(QSqlDatabase& db)
+{
+    if (!upgradeBlobsTable(db)) {
+        return false;
+    }
+
+    QSqlQuery query(db);
+    const QStringList statements = {
+        QString(kBlobsTableSql).arg("crawler_blobs"),
+        R"(
+        CREATE TABLE IF NOT EXISTS crawler_responses (
+            taskId INTEGER NOT NULL,
+            fetchedAt INTEGER NOT NULL,
+            blobId INTEGER NOT NULL,
+            PRIMARY KEY (taskId, fetchedAt)
+        ) WITHOUT ROWID
+        )",
+        "CREATE INDEX IF NOT EXISTS idx_crawler_responses_blob ON crawler_responses(blobId)",
+        R"(
+        CREATE TABLE IF NOT EXISTS crawler_archive_dicts (
+            id INTEGER PRIMARY KEY AUTOINCREMENT,
+            host TEXT NOT NULL,
+            createdAt INTEGER NOT NULL,
+            data BLOB NOT NULL
+        )
+        )",
+    };
+    for (const QString& sql : statements) {
+        if (!query.exec(sql)) {
+            qCritical() << "创建响应归档表失败：" << query.lastError().text();
+            return false;
+        }
+    }
+    return true;
+}
+
+void ResponseArchive::startWorker()
+{
+    if (m_enabled) return;
+    m_enabled = true;
+    start(QThread::LowPriority);
+}
+
+void ResponseArchive::stopWorker()
+{
+    if (!m_enabled) return;
+    {
+        QMutexLocker locker(&m_mutex);
+        m_enabled = false;
+        m_queued.wakeAll();
+    }
+    wait();
+}
+
+bool ResponseArchive::enqueue(int taskId, qint64 timestampMs, const QString& host, const QByteArray& body)
+{
+    if (!m_enabled || body.isEmpty()) {
+        return false;
+    }
+    QMutexLocker locker(&m_mutex);
+    if (m_queuedBytes + body.size() > kMaxQueuedBytes) {
+        ArchiveMetrics::get().dropped->inc();
+        return false;
+    }
+    // QByteArray 隐式共享，入队不复制响应体
+    m_queue.enqueue({taskId, timestampMs, host, body});
+    m_queuedBytes += body.size();
+    ArchiveMetrics::get().queuedBytes->set(m_queuedBytes);
+    m_queued.wakeOne();
+    return true;
+}
+
+void ResponseArchive::flush()
+{
+    QMutexLocker locker(&m_mutex);
+    while (isRunning() && (!m_queue.isEmpty() || m_writing)) {
+        m_drained.wait(&m_mutex);
+    }
+}
+
+void ResponseArchive::run()
+{
+    QSqlDatabase db = DatabaseManager::getThreadDatabase();
+    if (!db.isOpen()) {
+        qCritical() << "响应归档无法获取数据库连接，线程退出";
+        QMutexLocker locker(&m_mutex);
+        m_enabled = false;
+        m_queue.clear();
+        m_queuedBytes = 0;
+        m_drained.wakeAll();
+        return;
+    }
+
+    // 恢复已训练的字典（同一主机以最新的为准）
+    ArchiveWriterState state;
+    state.bodyIndex = FullTextIndex::hasIndex(db, "crawler_body_fts");
+#ifdef CRAWLER_HAVE_ZSTD
+    {
+        QSqlQuery query("SELECT id, host, data FROM crawler_archive_dicts ORDER BY id", db);
+        while (query.next()) {
+            const QByteArray data = query.value(2).toByteArray();
+            ArchiveWriterState::HostDict& entry = state.dicts[query.value(1).toString()];
+            ZSTD_freeCDict(entry.cdict);
+            entry.id = query.value(0).toInt();
+            entry.cdict = ZSTD_createCDict(data.constData(), static_cast<size_t>(data.size()), kZstdLevel);
+        }
+    }
+#endif
+
+    while (true) {
+        QList<Pending> batch;
+        {
+            QMutexLocker locker(&m_mutex);
+            while (m_queue.isEmpty() && m_enabled) {
+                m_queued.wait(&m_mutex);
+            }
+            if (m_queue.isEmpty()) {
+                break; // 已停止且队列已写完
+            }
+            while (!m_queue.isEmpty() && batch.size() < kWriteBatch) {
+                batch.append(m_queue.dequeue());
+                m_queuedBytes -= batch.last().body.size();
+            }
+            ArchiveMetrics::get().queuedBytes->set(m_queuedBytes);
+            m_writing = true;
+        }
+
+        writeBatch(db, state, batch);
+
+        QMutexLocker locker(&m_mutex);
+        m_writing = false;
+        m_drained.wakeAll();
+    }
+
+    QMutexLocker locker(&m_mutex);
+    m_drained.wakeAll();
+}
+
+// 一批响应在同一事务中写入：已存在的内容只写引用
+bool ResponseArchive::writeBatch(QSqlDatabase& db, ArchiveWriterState& state, const QList<Pending>& batch)
+{
+    MetricTimer batchTimer(ArchiveMetrics::get().batchDuration);
+    if (!db.transaction()) {
+        qWarning() << "写入响应归档失败：无法开启事务" << db.lastError().text();
+        return false;
+    }
+
+    QSqlQuery lookup(db);
+    lookup.prepare("SELECT id FROM crawler_blobs WHERE hash = :hash");
+    QSqlQuery insertBlob(db);
+    insertBlob.prepare(R"(
+        INSERT INTO crawler_blobs (hash, codec, dictId, rawSize, data)
+        VALUES (:hash, :codec, :dictId, :rawSize, :data)
+    )");
+    QSqlQuery insertResponse(db);
+    insertResponse.prepare(R"(
+        INSERT OR REPLACE INTO crawler_responses (taskId, fetchedAt, blobId) VALUES (:taskId, :fetchedAt, :blobId)
+    )");
+
+    quint64 dedupHits = 0;
+    quint64 rawBytes = 0;
+    quint64 storedBytes = 0;
+    QList<const Pending*> newBodies;
+    for (const Pending& pending : batch) {
+        const QByteArray hash = QCryptographicHash::hash(pending.body, QCryptographicHash::Sha256);
+        rawBytes += static_cast<quint64>(pending.body.size());
+
+        qint64 blobId = 0;
+        lookup.bindValue(":hash", hash);
+        if (lookup.exec() && lookup.next()) {
+            blobId = lookup.value(0).toLongLong();
+            dedupHits++;
+        }
+        lookup.finish();
+
+        if (blobId == 0) {
+            int codec = CodecStored;
+            int dictId = 0;
+            const QByteArray data = compressBody(state, pending.host, pending.body, &codec, &dictId);
+            insertBlob.bindValue(":hash", hash);
+            insertBlob.bindValue(":codec", codec);
+            insertBlob.bindValue(":dictId", dictId);
+            insertBlob.bindValue(":rawSize", static_cast<qint64>(pending.body.size()));
+            insertBlob.bindValue(":data", data);
+            if (!insertBlob.exec()) {
+                qWarning() << "写入响应体失败：" << insertBlob.lastError().text();
+                db.rollback();
+                return false;
+            }
+            blobId = insertBlob.lastInsertId().toLongLong();
+            storedBytes += static_cast<quint64>(data.size());
+            newBodies.append(&pending);
+            if (state.bodyIndex) {
+                FullTextIndex::indexBody(db, blobId, pending.body);
+            }
+        }
+
+        insertResponse.bindValue(":taskId", pending.taskId);
+        insertResponse.bindValue(":fetchedAt", pending.timestampMs);
+        insertResponse.bindValue(":blobId", blobId);
+        if (!insertResponse.exec()) {
+            qWarning() << "写入响应记录失败：" << insertResponse.lastError().text();
+            db.rollback();
+            return false;
+        }
+    }
+
+    if (!db.commit()) {
+        qWarning() << "响应归档提交失败：" << db.lastError().text();
+        db.rollback();
+        return false;
+    }
+
+    const ArchiveMetrics& metrics = ArchiveMetrics::get();
+    metrics.responses->inc(static_cast<quint64>(batch.size()));
+    metrics.dedupHits->inc(dedupHits);
+    metrics.rawBytes->inc(rawBytes);
+    metrics.storedBytes->inc(storedBytes);
+
+    // 字典在提交之后训练，避免回滚后留下引用不存在字典的数据
+#ifdef CRAWLER_HAVE_ZSTD
+    for (const Pending* pending : std::as_const(newBodies)) {
+        collectSample(db, state, pending->host, pending->body);
+    }
+#endif
+    return true;
+}
+
+QByteArray ResponseArchive::load(QSqlDatabase& db, qint64 blobId)
+{
+    QSqlQuery query(db);
+    query.prepare("SELECT codec, dictId, rawSize, data FROM crawler_blobs WHERE id = :id");
+    query.bindValue(":id", blobId);
+    if (!query.exec() || !query.next()) {
+        return QByteArray();
+    }
+
+    ArchiveDicts dicts;
+    const int dictId = query.value(1).toInt();
+    const QByteArray data = query.value(3).toByteArray();
+    const qint64 rawSize = query.value(2).toLongLong();
+    const int codec = query.value(0).toInt();
+    query.finish();
+    dicts.load(db, dictId);
+
+    QByteArray body;
+    ArchiveDecoder decoder;
+    if (!decoder.decode(dicts, codec, dictId, data, rawSize, &body)) {
+        qWarning() << "响应体解压失败：" << blobId;
+        return QByteArray();
+    }
+    return body;
+}
+
+ReextractResult ResponseArchive::reextract(QSqlDatabase& db, int taskId, const QString& rule,
+                                           const QDateTime& from, const QDateTime& to, bool apply)
+{
+    ReextractResult result;
+
+    // 区间内的响应及其引用的响应体（去重后只解析一次）
+    QList<QPair<qint64, qint64>> responses;
+    QList<qint64> blobIds;
+    {
+        QSqlQuery query(db);
+        query.setForwardOnly(true);
+        query.prepare(R"(
+            SELECT fetchedAt, blobId FROM crawler_responses
+            WHERE taskId = :taskId AND fetchedAt BETWEEN :from AND :to ORDER BY fetchedAt
+        )");
+        query.bindValue(":taskId", taskId);
+        query.bindValue(":from", from.toMSecsSinceEpoch());
+        query.bindValue(":to", to.toMSecsSinceEpoch());
+        if (!query.exec()) {
+            qWarning() << "读取归档响应失败：" << query.lastError().text();
+            return result;
+        }
+        QSet<qint64> seen;
+        while (query.next()) {
+            const qint64 blobId = query.value(1).toLongLong();
+            responses.append(qMakePair(query.value(0).toLongLong(), blobId));
+            if (!seen.contains(blobId)) {
+                seen.insert(blobId);
+                blobIds.append(blobId);
+            }
+        }
+    }
+    result.responses = responses.size();
+    result.uniqueBodies = blobIds.size();
+    if (responses.isEmpty()) {
+        return result;
+    }
+
+    // 解压与正则匹配分片到线程池；数据库只在调用线程读取
+    struct Blob {
+        int codec = CodecStored;
+        int dictId = 0;
+        qint64 rawSize = 0;
+        QByteArray data;
+        bool ok = false;
+        double value = 0.0;
+    };
+    const QString pattern = CrawlerThread::rulePattern(rule);
+    const int workers = qMax(1, QThread::idealThreadCount());
+    QThreadPool pool;
+    pool.setMaxThreadCount(workers);
+    ArchiveDicts dicts;
+    QHash<qint64, double> values;
+
+    QSqlQuery blobQuery(db);
+    blobQuery.prepare("SELECT codec, dictId, rawSize, data FROM crawler_blobs WHERE id = :id");
+    for (qsizetype offset = 0; offset < blobIds.size(); offset += kReextractBatch) {
+        const qsizetype count = qMin<qsizetype>(kReextractBatch, blobIds.size() - offset);
+        QList<Blob> blobs(count);
+        for (qsizetype i = 0; i < count; i++) {
+            blobQuery.bindValue(":id", blobIds.at(offset + i));
+            if (blobQuery.exec() && blobQuery.next()) {
+                Blob& blob = blobs[i];
+                blob.codec = blobQuery.value(0).toInt();
+                blob.dictId = blobQuery.value(1).toInt();
+                blob.rawSize = blobQuery.value(2).toLongLong();
+                blob.data = blobQuery.value(3).toByteArray();
+                dicts.load(db, blob.dictId);
+            }
+            blobQuery.finish();
+        }
+
+        // 各线程只写自己分片内的元素
+        Blob* blobData = blobs.data();
+        const qsizetype slice = (count + workers - 1) / workers;
+        for (qsizetype begin = 0; begin < count; begin += slice) {
+            const qsizetype end = qMin(count, begin + slice);
+            pool.start([blobData, &dicts, &pattern, begin, end]() {
+                const QRegularExpression re(pattern);
+                ArchiveDecoder decoder;
+                QByteArray body;
+                for (qsizetype i = begin; i < end; i++) {
+                    Blob& blob = blobData[i];
+                    if (blob.data.isEmpty()
+                        || !decoder.decode(dicts, blob.codec, blob.dictId, blob.data, blob.rawSize, &body)) {
+                        continue;
+                    }
+                    blob.ok = CrawlerThread::extractValue(QString::fromUtf8(body), re, &blob.value);
+                }
+            });
+        }
+        pool.waitForDone();
+
+        for (qsizetype i = 0; i < count; i++) {
+            if (blobs.at(i).ok) {
+                values.insert(blobIds.at(offset + i), blobs.at(i).value);
+            }
+        }
+    }
+
+    for (const auto& response : std::as_const(responses)) {
+        const auto it = values.constFind(response.second);
+        if (it == values.constEnd()) {
+            result.failed++;
+            continue;
+        }
+        result.extracted++;
+        result.values.append(qMakePair(response.first, it.value()));
+    }
+
+    if (!apply || result.values.isEmpty()) {
+        return result;
+    }
+
+    // 写回：先按爬取时间更新原始行，找不到的再到已封存的压缩块中替换（写到任务所在的数据分片）
+    QSqlDatabase dataDb = DatabaseManager::getDataDatabase(taskId);
+    if (!dataDb.transaction()) {
+        qWarning() << "写回重新提取结果失败：无法开启事务" << dataDb.lastError().text();
+        return result;
+    }
+    QSqlQuery update(dataDb);
+    update.prepare("UPDATE crawler_data SET value = :value WHERE taskId = :taskId AND crawlTime = :crawlTime");
+    QMap<qint64, double> sealedValues;
+    qint64 updatedRows = 0;
+    for (const auto& point : std::as_const(result.values)) {
+        const QDateTime time = QDateTime::fromMSecsSinceEpoch(point.first);
+        update.bindValue(":value", point.second);
+        update.bindValue(":taskId", taskId);
+        update.bindValue(":crawlTime", time.toString("yyyy-MM-dd HH:mm:ss"));
+        if (!update.exec()) {
+            qWarning() << "写回重新提取结果失败：" << update.lastError().text();
+            dataDb.rollback();
+            return result;
+        }
+        if (update.numRowsAffected() > 0) {
+            updatedRows += update.numRowsAffected();
+        } else {
+            sealedValues.insert(time.toSecsSinceEpoch(), point.second);
+        }
+    }
+    const qint64 replaced = ChunkStore::replaceValues(dataDb, taskId, sealedValues);
+    if (replaced < 0 || !dataDb.commit()) {
+        qWarning() << "写回重新提取结果失败：" << dataDb.lastError().text();
+        dataDb.rollback();
+        return result;
+    }
+    result.updated = updatedRows + replaced;
+    result.unmatched = sealedValues.size() - replaced;
+
+    // 原始值已变，重建该任务的汇总
+    if (!RollupStore::rebuild(dataDb, taskId)) {
+        qWarning() << "重新提取后重建汇总失败：任务ID" << taskId;
+    }
+    return result;
+}
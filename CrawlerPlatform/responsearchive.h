@@ -0,0 +1,82 @@
+#ifndef RESPONSEARCHIVE_H
+#define RESPONSEARCHIVE_H
+
+#include <QThread>
+#include <QMutex>
+#include <QWaitCondition>
+#include <QQueue>
+#include <QList>
+#include <QPair>
+#include <QDateTime>
+#include <QSqlDatabase>
+#include <atomic>
+
+struct ArchiveWriterState;
+
+// 按新规则重新提取的结果
+struct ReextractResult {
+    qint64 responses = 0;     // 区间内归档的响应数
+    qint64 uniqueBodies = 0;  // 去重后实际解析的响应体数
+    qint64 extracted = 0;     // 规则匹配成功的响应数
+    qint64 failed = 0;        // 未匹配或无法解压的响应数
+    qint64 updated = 0;       // 写回的数据点数（原始行 + 压缩块）
+    qint64 unmatched = 0;     // 库中没有对应数据点的响应数（变化存储合并、已过保留期）
+    QList<QPair<qint64, double>> values; // (timestampMs, 新值)，按时间升序
+};
+
+// 原始响应归档（crawler_responses -> crawler_blobs）
+// 响应体按 SHA-256 内容寻址，相同页面只存一份；同一主机积累足够样本后训练 zstd 字典再压缩
+// 爬虫线程只负责入队，哈希、压缩与写库都在低优先级后台线程中完成
+class ResponseArchive : public QThread
+{
+    Q_OBJECT
+
+public:
+    static ResponseArchive& instance();
+    ~ResponseArchive() override;
+
+    static bool createSchema(QSqlDatabase& db);
+
+    void startWorker();
+    // 写完已入队的响应后退出
+    void stopWorker();
+    bool isEnabled() const { return m_enabled.load(std::memory_order_relaxed); }
+
+    // 爬虫线程调用：入队后立即返回；未启用或积压超过上限时丢弃并返回 false
+    bool enqueue(int taskId, qint64 timestampMs, const QString& host, const QByteArray& body);
+
+    // 等待已入队的响应全部写入
+    void flush();
+
+    // 读取并解压单个响应体，失败返回空
+    static QByteArray load(QSqlDatabase& db, qint64 blobId);
+
+    // 用新规则并行重新解析 [from, to] 内归档的响应（同一响应体只解析一次）
+    // apply=true 时把新值写回原始行与压缩块，并重建该任务的汇总（db 为归档所在的主库，写回到任务所在的数据分片）
+    static ReextractResult reextract(QSqlDatabase& db, int taskId, const QString& rule,
+                                     const QDateTime& from, const QDateTime& to, bool apply);
+
+protected:
+    void run() override;
+
+private:
+    ResponseArchive();
+
+    struct Pending {
+        int taskId;
+        qint64 timestampMs;
+        QString host;
+        QByteArray body;
+    };
+    bool writeBatch(QSqlDatabase& db, ArchiveWriterState& state, const QList<Pending>& batch);
+
+    std::atomic<bool> m_enabled{false};
+    QMutex m_mutex;
+    QWaitCondition m_queued;
+    QWaitCondition m_drained;
+    QQueue<Pending> m_queue;
+    qint64 m_queuedBytes = 0;
+    bool m_writing = false;
+};
+
+#endif // RESPONSEARCHIVE_H
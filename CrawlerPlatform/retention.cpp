@@ -0,0 +1,387 @@
+#include "retention.h"
+#include "metrics.h"
+#include "segmentstore.h"
+#include "chunkstore.h"
+#include <QHash>
+#include <QDebug>
+
+// 每批删除的行数与批间停顿：单批事务控制在毫秒级
+static const int kDeleteBatchRows = 500;
+static const int kBatchPauseMs = 20;
+// 每次 incremental_vacuum 回收的页数
+static const int kVacuumStepPages = 256;
+// 数据结束后多久封存为压缩块（秒），留出迟到写入的余量
+static const qint64 kSealDelaySecs = 3600;
+
+// 数据保留指标（首次使用时注册）
+struct RetentionMetrics {
+    MetricCounter* rawPruned;
+    MetricCounter* rollupPruned;
+    MetricCounter* responsesPruned;
+    MetricCounter* blobsPruned;
+    MetricCounter* bytesReclaimed;
+    MetricGauge* freelistBytes;
+    MetricHistogram* passDuration;
+
+    static const RetentionMetrics& get()
+    {
+        static const RetentionMetrics metrics = []() {
+            MetricsRegistry& registry = MetricsRegistry::instance();
+            const QString pruned = "crawler_retention_rows_pruned_total";
+            const QString prunedHelp = "保留策略删除的行数";
+            RetentionMetrics m;
+            m.rawPruned = registry.counter(pruned, prunedHelp, {{"table", "crawler_data"}});
+            m.rollupPruned = registry.counter(pruned, prunedHelp, {{"table", "crawler_rollup"}});
+            m.responsesPruned = registry.counter(pruned, prunedHelp, {{"table", "crawler_responses"}});
+            m.blobsPruned = registry.counter(pruned, prunedHelp, {{"table", "crawler_blobs"}});
+            m.bytesReclaimed = registry.counter("crawler_retention_bytes_reclaimed_total",
+                                                "incremental_vacuum 回收的字节数");
+            m.freelistBytes = registry.gauge("crawler_db_freelist_bytes", "数据库文件中的空闲页字节数");
+            m.passDuration = registry.histogram("crawler_retention_pass_duration_seconds", "单轮保留任务耗时");
+            return m;
+        }();
+        return metrics;
+    }
+};
+
+RetentionWorker::RetentionWorker(int intervalSecs, QObject *parent)
+    : QThread(parent)
+    , m_intervalSecs(qMax(1, intervalSecs))
+{
+    setObjectName("RetentionWorker");
+}
+
+RetentionWorker::~RetentionWorker()
+{
+    stopWorker();
+}
+
+void RetentionWorker::startWorker()
+{
+    if (m_isRunning) return;
+    m_isRunning = true;
+    start(QThread::LowestPriority);
+}
+
+void RetentionWorker::stopWorker()
+{
+    if (!m_isRunning) return;
+    m_isRunning = false;
+    {
+        QMutexLocker locker(&m_wakeMutex);
+        m_wakeCondition.wakeAll();
+    }
+    wait();
+}
+
+void RetentionWorker::triggerNow()
+{
+    QMutexLocker locker(&m_wakeMutex);
+    m_triggered = true;
+    m_wakeCondition.wakeAll();
+}
+
+void RetentionWorker::run()
+{
+    QSqlDatabase db = DatabaseManager::getThreadDatabase();
+    if (!db.isOpen()) {
+        qCritical() << "保留任务无法获取数据库连接，线程退出";
+        return;
+    }
+
+    while (m_isRunning) {
+        runPass(db);
+
+        QMutexLocker locker(&m_wakeMutex);
+        if (m_isRunning && !m_triggered) {
+            m_wakeCondition.wait(&m_wakeMutex, static_cast<unsigned long>(m_intervalSecs) * 1000);
+        }
+        m_triggered = false;
+    }
+}
+
+// 可被停止打断的批间停顿，返回 false 表示已停止
+bool RetentionWorker::pause(unsigned long ms)
+{
+    QMutexLocker locker(&m_wakeMutex);
+    if (m_isRunning) {
+        m_wakeCondition.wait(&m_wakeMutex, ms);
+    }
+    return m_isRunning;
+}
+
+void RetentionWorker::runPass(QSqlDatabase& db)
+{
+    MetricTimer passTimer(RetentionMetrics::get().passDuration);
+
+    // 读取策略：taskId=0 为全局默认，任务级策略覆盖全局
+    RetentionPolicy global;
+    QHash<int, RetentionPolicy> overrides;
+    {
+        QSqlQuery query("SELECT taskId, rawDays, minuteDays, hourDays, dayDays FROM crawler_retention", db);
+        while (query.next()) {
+            RetentionPolicy policy;
+            policy.taskId = query.value(0).toInt();
+            policy.rawDays = query.value(1).toInt();
+            policy.minuteDays = query.value(2).toInt();
+            policy.hourDays = query.value(3).toInt();
+            policy.dayDays = query.value(4).toInt();
+            if (policy.taskId == 0) {
+                global = policy;
+            } else {
+                overrides.insert(policy.taskId, policy);
+            }
+        }
+    }
+
+    QList<int> taskIds;
+    {
+        QSqlQuery query("SELECT id FROM crawler_tasks", db);
+        while (query.next()) {
+            taskIds.append(query.value(0).toInt());
+        }
+    }
+
+    const QDateTime now = QDateTime::currentDateTime();
+    const bool sqliteBackend = DatabaseManager::dataBackend() == DataBackend::Sqlite;
+    qint64 sealed = 0;
+    qint64 rawPruned = 0;
+    qint64 rollupPruned = 0;
+    qint64 archivePruned = 0;
+    for (int taskId : taskIds) {
+        if (!m_isRunning) return;
+        const RetentionPolicy policy = overrides.value(taskId, global);
+        // 原始数据、压缩块与汇总在任务所在的数据分片，归档在主库
+        QSqlDatabase dataDb = DatabaseManager::getDataDatabase(taskId);
+
+        // 已结束一小时以上的原始数据封存为压缩块（保留了原始文本的行除外），块之间停顿让出写锁
+        if (sqliteBackend) {
+            sealed += qMax<qint64>(0, ChunkStore::sealBefore(dataDb, taskId, now.toSecsSinceEpoch() - kSealDelaySecs,
+                                                             [this]() { return pause(kBatchPauseMs); }));
+        }
+
+        if (policy.rawDays > 0) {
+            rawPruned += pruneRaw(dataDb, taskId, now.addDays(-policy.rawDays));
+            // 归档的原始响应与原始数据同期过期
+            archivePruned += pruneArchive(db, taskId, now.addDays(-policy.rawDays));
+        }
+        const QList<QPair<int, int>> rollups = {
+            {60, policy.minuteDays}, {3600, policy.hourDays}, {86400, policy.dayDays}
+        };
+        for (const auto& rollup : rollups) {
+            if (rollup.second > 0 && m_isRunning) {
+                rollupPruned += pruneRollup(dataDb, taskId, rollup.first, now.addDays(-rollup.second));
+            }
+        }
+    }
+
+    const qint64 blobsPruned = archivePruned > 0 && m_isRunning ? pruneOrphanBlobs(db) : 0;
+    // 空闲页按库文件累加
+    RetentionMetrics::get().freelistBytes->set(0);
+    qint64 reclaimed = reclaimPages(db);
+    if (DatabaseManager::dataShardCount() > 1) {
+        for (QSqlDatabase& dataDb : DatabaseManager::dataDatabases()) {
+            reclaimed += m_isRunning ? reclaimPages(dataDb) : 0;
+        }
+    }
+    if (sealed > 0 || rawPruned > 0 || rollupPruned > 0 || archivePruned > 0 || reclaimed > 0) {
+        qInfo() << "保留任务完成：封存" << sealed << "点，删除原始数据" << rawPruned << "点，汇总" << rollupPruned
+                << "行，归档响应" << archivePruned << "条（响应体" << blobsPruned << "个），回收" << reclaimed << "字节";
+    }
+}
+
+qint64 RetentionWorker::pruneRaw(QSqlDatabase& db, int taskId, const QDateTime& cutoff)
+{
+    // 段存储按整段删除
+    if (DatabaseManager::dataBackend() == DataBackend::Segment) {
+        const qint64 removed = SegmentStore::instance().pruneBefore(taskId, cutoff.toMSecsSinceEpoch());
+        RetentionMetrics::get().rawPruned->inc(static_cast<quint64>(removed));
+        return removed;
+    }
+
+    // 已封存的压缩块按整块删除
+    qint64 total = ChunkStore::pruneBefore(db, taskId, cutoff.toSecsSinceEpoch(),
+                                           [this]() { return pause(kBatchPauseMs); });
+    RetentionMetrics::get().rawPruned->inc(static_cast<quint64>(total));
+
+    // 子查询走 (taskId, crawlTime) 索引，每批只锁定少量行
+    QSqlQuery query(db);
+    query.prepare(R"(
+        DELETE FROM crawler_data WHERE id IN (
+            SELECT id FROM crawler_data
+            WHERE taskId = :taskId AND crawlTime < :cutoff AND COALESCE(lastSeen, crawlTime) < :lastCutoff
+            LIMIT :batch
+        )
+    )");
+
+    while (m_isRunning) {
+        query.bindValue(":taskId", taskId);
+        query.bindValue(":cutoff", cutoff.toString("yyyy-MM-dd HH:mm:ss"));
+        query.bindValue(":lastCutoff", cutoff.toString("yyyy-MM-dd HH:mm:ss"));
+        query.bindValue(":batch", kDeleteBatchRows);
+        if (!query.exec()) {
+            qWarning() << "删除过期数据失败：" << query.lastError().text() << "任务ID：" << taskId;
+            break;
+        }
+        const int affected = query.numRowsAffected();
+        total += affected;
+        RetentionMetrics::get().rawPruned->inc(static_cast<quint64>(qMax(0, affected)));
+        if (affected < kDeleteBatchRows || !pause(kBatchPauseMs)) {
+            break;
+        }
+    }
+    return total;
+}
+
+qint64 RetentionWorker::pruneArchive(QSqlDatabase& db, int taskId, const QDateTime& cutoff)
+{
+    QSqlQuery query(db);
+    query.prepare(R"(
+        DELETE FROM crawler_responses WHERE taskId = :taskId AND fetchedAt IN (
+            SELECT fetchedAt FROM crawler_responses WHERE taskId = :subTaskId AND fetchedAt < :cutoff LIMIT :batch
+        )
+    )");
+
+    qint64 total = 0;
+    while (m_isRunning) {
+        query.bindValue(":taskId", taskId);
+        query.bindValue(":subTaskId", taskId);
+        query.bindValue(":cutoff", cutoff.toMSecsSinceEpoch());
+        query.bindValue(":batch", kDeleteBatchRows);
+        if (!query.exec()) {
+            qWarning() << "删除过期归档响应失败：" << query.lastError().text() << "任务ID：" << taskId;
+            break;
+        }
+        const int affected = query.numRowsAffected();
+        total += affected;
+        RetentionMetrics::get().responsesPruned->inc(static_cast<quint64>(qMax(0, affected)));
+        if (affected < kDeleteBatchRows || !pause(kBatchPauseMs)) {
+            break;
+        }
+    }
+    return total;
+}
+
+// 删除不再被任何响应引用的响应体（走 blobId 索引判断引用）
+qint64 RetentionWorker::pruneOrphanBlobs(QSqlDatabase& db)
+{
+    QSqlQuery query(db);
+    query.prepare(R"(
+        DELETE FROM crawler_blobs WHERE id IN (
+            SELECT b.id FROM crawler_blobs b
+            WHERE NOT EXISTS (SELECT 1 FROM crawler_responses r WHERE r.blobId = b.id)
+            LIMIT :batch
+        )
+    )");
+
+    qint64 total = 0;
+    while (m_isRunning) {
+        query.bindValue(":batch", kDeleteBatchRows);
+        if (!query.exec()) {
+            qWarning() << "删除无引用的响应体失败：" << query.lastError().text();
+            break;
+        }
+        const int affected = query.numRowsAffected();
+        total += affected;
+        RetentionMetrics::get().blobsPruned->inc(static_cast<quint64>(qMax(0, affected)));
+        if (affected < kDeleteBatchRows || !pause(kBatchPauseMs)) {
+            break;
+        }
+    }
+    return total;
+}
+
+qint64 RetentionWorker::pruneRollup(QSqlDatabase& db, int taskId, int resolution, const QDateTime& cutoff)
+{
+    // 只删除整个桶都早于截止时间的汇总
+    const qint64 cutoffBucket = cutoff.toSecsSinceEpoch() - resolution;
+    QSqlQuery query(db);
+    query.prepare(R"(
+        DELETE FROM crawler_rollup WHERE taskId = :taskId AND resolution = :resolution AND bucketStart IN (
+            SELECT bucketStart FROM crawler_rollup
+            WHERE taskId = :subTaskId AND resolution = :subResolution AND bucketStart < :cutoff LIMIT :batch
+        )
+    )");
+
+    qint64 total = 0;
+    while (m_isRunning) {
+        query.bindValue(":taskId", taskId);
+        query.bindValue(":resolution", resolution);
+        query.bindValue(":subTaskId", taskId);
+        query.bindValue(":subResolution", resolution);
+        query.bindValue(":cutoff", cutoffBucket);
+        query.bindValue(":batch", kDeleteBatchRows);
+        if (!query.exec()) {
+            qWarning() << "删除过期汇总失败：" << query.lastError().text() << "任务ID：" << taskId;
+            break;
+        }
+        const int affected = query.numRowsAffected();
+        total += affected;
+        RetentionMetrics::get().rollupPruned->inc(static_cast<quint64>(qMax(0, affected)));
+        if (affected < kDeleteBatchRows || !pause(kBatchPauseMs)) {
+            break;
+        }
+    }
+    return total;
+}
+
+qint64 RetentionWorker::pragmaValue(QSqlDatabase& db, const QString& pragma)
+{
+    QSqlQuery query(db);
+    if (query.exec(QString("PRAGMA %1").arg(pragma)) && query.next()) {
+        return query.value(0).toLongLong();
+    }
+    return 0;
+}
+
+// 未启用增量回收的旧库：开启转换时在本线程 VACUUM 一次，否则跳过回收
+bool RetentionWorker::ensureIncrementalVacuum(QSqlDatabase& db)
+{
+    if (pragmaValue(db, "auto_vacuum") == 2) {
+        return true;
+    }
+    if (!m_convertAutoVacuum || !m_isRunning) {
+        return false;
+    }
+    qInfo() << "转换为增量回收（auto_vacuum=INCREMENTAL），重写数据库文件" << db.databaseName();
+    QSqlQuery query(db);
+    if (!query.exec("PRAGMA auto_vacuum = INCREMENTAL") || !query.exec("VACUUM")) {
+        qWarning() << "转换增量回收失败，下一轮重试：" << query.lastError().text();
+        return false;
+    }
+    qInfo() << "增量回收已启用" << db.databaseName();
+    return true;
+}
+
+// 分步回收空闲页，返回回收的字节数（需 auto_vacuum=INCREMENTAL）
+qint64 RetentionWorker::reclaimPages(QSqlDatabase& db)
+{
+    const qint64 pageSize = pragmaValue(db, "page_size");
+    const qint64 before = pragmaValue(db, "freelist_count");
+    qint64 freePages = before;
+    if (!ensureIncrementalVacuum(db)) {
+        RetentionMetrics::get().freelistBytes->add(freePages * pageSize);
+        return 0;
+    }
+
+    QSqlQuery query(db);
+    while (freePages > 0 && m_isRunning) {
+        if (!query.exec(QString("PRAGMA incremental_vacuum(%1)").arg(kVacuumStepPages))) {
+            qWarning() << "incremental_vacuum 失败：" << query.lastError().text();
+            break;
+        }
+        // 逐步执行到结束，否则只回收一页
+        while (query.next()) {}
+        query.finish();
+
+        const qint64 remaining = pragmaValue(db, "freelist_count");
+        if (remaining >= freePages) break; // 未启用增量模式时不会减少
+        freePages = remaining;
+        if (!pause(kBatchPauseMs)) break;
+    }
+
+    const qint64 reclaimed = qMax<qint64>(0, before - freePages) * pageSize;
+    RetentionMetrics::get().bytesReclaimed->inc(static_cast<quint64>(reclaimed));
+    RetentionMetrics::get().freelistBytes->add(freePages * pageSize);
+    return reclaimed;
+}
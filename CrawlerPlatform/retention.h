@@ -0,0 +1,54 @@
+#ifndef RETENTION_H
+#define RETENTION_H
+
+#include <QThread>
+#include <QMutex>
+#include <QWaitCondition>
+#include <QSqlDatabase>
+#include <atomic>
+#include "databasemanager.h"
+
+// 数据保留后台任务（低优先级线程）
+// 按保留策略分批删除过期的原始数据与汇总，再用 incremental_vacuum 逐步回收空闲页
+// 每批使用独立的短事务，批次之间让出写锁，避免阻塞爬虫线程的写入
+class RetentionWorker : public QThread
+{
+    Q_OBJECT
+
+public:
+    explicit RetentionWorker(int intervalSecs, QObject *parent = nullptr);
+    ~RetentionWorker() override;
+
+    // 旧库转换为 auto_vacuum=INCREMENTAL（VACUUM 重写整个文件，期间写入等待），默认关闭
+    void setConvertAutoVacuum(bool convert) { m_convertAutoVacuum = convert; }
+
+    void startWorker();
+    void stopWorker();
+
+    // 立即执行一轮（不等待下一个周期）
+    void triggerNow();
+
+protected:
+    void run() override;
+
+private:
+    void runPass(QSqlDatabase& db);
+    qint64 pruneRaw(QSqlDatabase& db, int taskId, const QDateTime& cutoff);
+    qint64 pruneArchive(QSqlDatabase& db, int taskId, const QDateTime& cutoff);
+    qint64 pruneOrphanBlobs(QSqlDatabase& db);
+    qint64 pruneRollup(QSqlDatabase& db, int taskId, int resolution, const QDateTime& cutoff);
+    qint64 reclaimPages(QSqlDatabase& db);
+    bool ensureIncrementalVacuum(QSqlDatabase& db);
+    qint64 pragmaValue(QSqlDatabase& db, const QString& pragma);
+    bool pause(unsigned long ms);
+
+    int m_intervalSecs;
+    std::atomic<bool> m_isRunning{false};
+    std::atomic<bool> m_convertAutoVacuum{false};
+    bool m_triggered = false;
+
+    QMutex m_wakeMutex;
+    QWaitCondition m_wakeCondition;
+};
+
+#endif // RETENTION_H
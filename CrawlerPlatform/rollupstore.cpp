@@ -0,0 +1,431 @@
+#include "rollupstore.h"
+#include <QSqlQuery>
+#include <QSqlError>
+#include <QMap>
+#include <QDebug>
+#include <limits>
+#include <cmath>
+#include "chunkstore.h"
+#include "quantilesketch.h"
+
+// 汇总表内部额外保存桶内首/末样本时间，用于合并 first/last
+bool RollupStore::createSchema(QSqlDatabase& db)
+{
+    QSqlQuery query(db);
+    QString sql = R"(
+        CREATE TABLE IF NOT EXISTS crawler_rollup (
+            taskId INTEGER NOT NULL,
+            resolution INTEGER NOT NULL,
+            bucketStart INTEGER NOT NULL,
+            count INTEGER NOT NULL,
+            minValue REAL NOT NULL,
+            maxValue REAL NOT NULL,
+            sumValue REAL NOT NULL,
+            firstValue REAL NOT NULL,
+            lastValue REAL NOT NULL,
+            firstTime INTEGER NOT NULL,
+            lastTime INTEGER NOT NULL,
+            sumSquares REAL,
+            sketch BLOB,
+            PRIMARY KEY (taskId, resolution, bucketStart)
+        ) WITHOUT ROWID
+    )";
+    if (!query.exec(sql)) {
+        qCritical() << "创建汇总表失败：" << query.lastError().text();
+        return false;
+    }
+    return true;
+}
+
+qint64 RollupStore::bucketStart(const QDateTime& time, int resolution)
+{
+    // 按本地时区对齐（天桶从本地零点开始）
+    const qint64 offset = time.offsetFromUtc();
+    const qint64 local = time.toSecsSinceEpoch() + offset;
+    qint64 bucket = local - (local % resolution);
+    if (local < 0 && local % resolution != 0) {
+        bucket -= resolution;
+    }
+    return bucket - offset;
+}
+
+bool RollupStore::record(QSqlDatabase& db, int taskId, double value, const QDateTime& time)
+{
+    const qint64 hour = bucketStart(time, 3600);
+
+    // 小时桶的草图在本事务内读出、加入新值后随下面的语句写回
+    QSqlQuery sketchQuery(db);
+    sketchQuery.prepare(R"(
+        SELECT count, sumValue, sketch FROM crawler_rollup
+        WHERE taskId = :taskId AND resolution = 3600 AND bucketStart = :hour
+    )");
+    sketchQuery.bindValue(":taskId", taskId);
+    sketchQuery.bindValue(":hour", hour);
+    if (!sketchQuery.exec()) {
+        qCritical() << "读取分位数草图失败：" << sketchQuery.lastError().text() << "任务ID：" << taskId;
+        return false;
+    }
+    QuantileSketch sketch;
+    if (sketchQuery.next()) {
+        if (sketchQuery.value(2).isNull()) {
+            // 升级前的桶没有草图，已有样本按均值补入
+            const qint64 count = sketchQuery.value(0).toLongLong();
+            if (count > 0) {
+                sketch.add(sketchQuery.value(1).toDouble() / count, static_cast<quint64>(count));
+            }
+        } else {
+            sketch = QuantileSketch::fromBytes(sketchQuery.value(2).toByteArray());
+        }
+    }
+    sketchQuery.finish();
+    sketch.add(value);
+
+    // 三个粒度一条语句完成；SET 中的列引用均为更新前的旧值
+    QSqlQuery query(db);
+    query.prepare(R"(
+        INSERT INTO crawler_rollup (taskId, resolution, bucketStart, count, minValue, maxValue, sumValue,
+                                    firstValue, lastValue, firstTime, lastTime, sumSquares, sketch)
+        SELECT :taskId, b.resolution, b.bucketStart, 1, s.v, s.v, s.v, s.v, s.v, s.t, s.t, s.v * s.v,
+               CASE WHEN b.resolution = 3600 THEN :sketch END
+        FROM (SELECT 60 AS resolution, :minute AS bucketStart
+              UNION ALL SELECT 3600, :hour
+              UNION ALL SELECT 86400, :day) AS b,
+             (SELECT :v AS v, :t AS t) AS s
+        WHERE 1
+        ON CONFLICT (taskId, resolution, bucketStart) DO UPDATE SET
+            count = count + 1,
+            minValue = MIN(minValue, excluded.minValue),
+            maxValue = MAX(maxValue, excluded.maxValue),
+            sumValue = sumValue + excluded.sumValue,
+            firstValue = CASE WHEN excluded.firstTime < firstTime THEN excluded.firstValue ELSE firstValue END,
+            firstTime = MIN(firstTime, excluded.firstTime),
+            lastValue = CASE WHEN excluded.lastTime >= lastTime THEN excluded.lastValue ELSE lastValue END,
+            lastTime = MAX(lastTime, excluded.lastTime),
+            sumSquares = COALESCE(sumSquares, sumValue * sumValue / count) + excluded.sumSquares,
+            sketch = excluded.sketch
+    )");
+    query.bindValue(":taskId", taskId);
+    query.bindValue(":minute", bucketStart(time, 60));
+    query.bindValue(":hour", hour);
+    query.bindValue(":day", bucketStart(time, 86400));
+    query.bindValue(":v", value);
+    query.bindValue(":t", time.toSecsSinceEpoch());
+    query.bindValue(":sketch", sketch.toBytes());
+
+    if (!query.exec()) {
+        qCritical() << "更新汇总失败：" << query.lastError().text() << "任务ID：" << taskId;
+        return false;
+    }
+    return true;
+}
+
+bool RollupStore::rebuild(QSqlDatabase& db, int onlyTaskId)
+{
+    if (!db.transaction()) {
+        qWarning() << "重建汇总失败：无法开启事务" << db.lastError().text();
+        return false;
+    }
+
+    QSqlQuery clearQuery(db);
+    if (onlyTaskId != 0) {
+        clearQuery.prepare("DELETE FROM crawler_rollup WHERE taskId = :taskId");
+        clearQuery.bindValue(":taskId", onlyTaskId);
+    } else {
+        clearQuery.prepare("DELETE FROM crawler_rollup");
+    }
+    if (!clearQuery.exec()) {
+        qWarning() << "重建汇总失败：" << clearQuery.lastError().text();
+        db.rollback();
+        return false;
+    }
+
+    QSqlQuery insert(db);
+    insert.prepare(R"(
+        INSERT INTO crawler_rollup (taskId, resolution, bucketStart, count, minValue, maxValue, sumValue,
+                                    firstValue, lastValue, firstTime, lastTime, sumSquares, sketch)
+        VALUES (?, ?, ?, ?, ?, ?, ?, ?, ?, ?, ?, ?, ?)
+    )");
+
+    // 按任务逐个聚合（已封存的压缩块 + 原始数据），内存只占用单个任务的桶
+    struct Bucket {
+        RollupPoint point;
+        qint64 firstTime = 0;
+        qint64 lastTime = 0;
+        double sumSquares = 0.0;
+        QuantileSketch sketch;   // 仅小时桶
+    };
+    QMap<QPair<int, qint64>, Bucket> buckets;
+    bool ok = true;
+
+    auto accumulate = [&](qint64 secs, double value) {
+        const QDateTime time = QDateTime::fromSecsSinceEpoch(secs);
+        for (int resolution : resolutions()) {
+            Bucket& b = buckets[qMakePair(resolution, bucketStart(time, resolution))];
+            if (b.point.count == 0) {
+                b.point.minValue = b.point.maxValue = value;
+                b.point.firstValue = b.point.lastValue = value;
+                b.firstTime = b.lastTime = secs;
+            } else {
+                if (secs < b.firstTime) {
+                    b.point.firstValue = value;
+                    b.firstTime = secs;
+                }
+                if (secs >= b.lastTime) {
+                    b.point.lastValue = value;
+                    b.lastTime = secs;
+                }
+            }
+            b.point.count++;
+            b.point.minValue = qMin(b.point.minValue, value);
+            b.point.maxValue = qMax(b.point.maxValue, value);
+            b.point.sumValue += value;
+            b.sumSquares += value * value;
+            if (resolution == 3600) {
+                b.sketch.add(value);
+            }
+        }
+    };
+
+    auto flush = [&](int taskId) {
+        for (auto it = buckets.cbegin(); it != buckets.cend() && ok; ++it) {
+            const Bucket& b = it.value();
+            insert.addBindValue(taskId);
+            insert.addBindValue(it.key().first);
+            insert.addBindValue(it.key().second);
+            insert.addBindValue(b.point.count);
+            insert.addBindValue(b.point.minValue);
+            insert.addBindValue(b.point.maxValue);
+            insert.addBindValue(b.point.sumValue);
+            insert.addBindValue(b.point.firstValue);
+            insert.addBindValue(b.point.lastValue);
+            insert.addBindValue(b.firstTime);
+            insert.addBindValue(b.lastTime);
+            insert.addBindValue(b.sumSquares);
+            insert.addBindValue(it.key().first == 3600 ? b.sketch.toBytes() : QByteArray()); // 空 QByteArray 绑定为 NULL
+            if (!insert.exec()) {
+                qWarning() << "重建汇总写入失败：" << insert.lastError().text();
+                ok = false;
+            }
+        }
+        buckets.clear();
+    };
+
+    QList<int> taskIds;
+    if (onlyTaskId != 0) {
+        taskIds.append(onlyTaskId);
+    } else {
+        QSqlQuery taskQuery("SELECT taskId FROM crawler_data UNION SELECT taskId FROM crawler_chunks", db);
+        while (taskQuery.next()) {
+            taskIds.append(taskQuery.value(0).toInt());
+        }
+    }
+
+    QSqlQuery scan(db);
+    scan.setForwardOnly(true);
+    scan.prepare("SELECT value, crawlTime, lastSeen FROM crawler_data WHERE taskId = :taskId");
+
+    qint64 rows = 0;
+    for (int taskId : taskIds) {
+        if (!ok) break;
+        ChunkStore::scan(db, taskId, std::numeric_limits<qint64>::min() / 2, std::numeric_limits<qint64>::max(),
+                         [&](qint64 secs, double value) {
+            accumulate(secs, value);
+            rows++;
+        });
+
+        scan.bindValue(":taskId", taskId);
+        if (!scan.exec()) {
+            qWarning() << "重建汇总读取失败：" << scan.lastError().text();
+            ok = false;
+            break;
+        }
+        while (scan.next()) {
+            QDateTime time = QDateTime::fromString(scan.value(1).toString(), "yyyy-MM-dd HH:mm:ss");
+            if (!time.isValid()) continue;
+            accumulate(time.toSecsSinceEpoch(), scan.value(0).toDouble());
+            rows++;
+            // 变化存储合并的采样已无法还原，区间末端计为一个同值点
+            const QDateTime lastSeen = QDateTime::fromString(scan.value(2).toString(), "yyyy-MM-dd HH:mm:ss");
+            if (lastSeen.isValid() && lastSeen > time) {
+                accumulate(lastSeen.toSecsSinceEpoch(), scan.value(0).toDouble());
+            }
+        }
+        scan.finish();
+        flush(taskId);
+    }
+
+    if (!ok || !db.commit()) {
+        db.rollback();
+        return false;
+    }
+    qInfo() << "汇总重建完成，原始数据行数：" << rows;
+    return true;
+}
+
+TaskStatistics RollupStore::statistics(QSqlDatabase& db, int taskId, qint64 fromSecs, qint64 toSecs)
+{
+    TaskStatistics stats;
+    if (toSecs < fromSecs) return stats;
+
+    // 窗口按分钟桶对齐（与 query 一样包含起点所在的桶）；其中完整的小时 [hourFrom, hourTo) 用小时桶
+    const qint64 minuteFrom = bucketStart(QDateTime::fromSecsSinceEpoch(fromSecs), 60);
+    qint64 hourFrom = bucketStart(QDateTime::fromSecsSinceEpoch(fromSecs), 3600);
+    if (hourFrom < minuteFrom) {
+        hourFrom += 3600;
+    }
+    qint64 hourTo = bucketStart(QDateTime::fromSecsSinceEpoch(toSecs), 3600);
+    if (hourTo <= hourFrom) {
+        hourFrom = hourTo = minuteFrom; // 不足一小时，全部用分钟桶
+    }
+
+    QSqlQuery query(db);
+    query.setForwardOnly(true);
+    query.prepare(R"(
+        SELECT count, minValue, maxValue, sumValue, COALESCE(sumSquares, sumValue * sumValue / count),
+               lastValue, lastTime, sketch
+        FROM crawler_rollup
+        WHERE taskId = :taskId AND resolution = 3600 AND bucketStart >= :hourFrom AND bucketStart < :hourTo
+        UNION ALL
+        SELECT count, minValue, maxValue, sumValue, COALESCE(sumSquares, sumValue * sumValue / count),
+               lastValue, lastTime, NULL
+        FROM crawler_rollup
+        WHERE taskId = :headTaskId AND resolution = 60 AND bucketStart >= :minuteFrom AND bucketStart < :headTo
+        UNION ALL
+        SELECT count, minValue, maxValue, sumValue, COALESCE(sumSquares, sumValue * sumValue / count),
+               lastValue, lastTime, NULL
+        FROM crawler_rollup
+        WHERE taskId = :tailTaskId AND resolution = 60 AND bucketStart >= :tailFrom AND bucketStart <= :to
+    )");
+    query.bindValue(":taskId", taskId);
+    query.bindValue(":hourFrom", hourFrom);
+    query.bindValue(":hourTo", hourTo);
+    query.bindValue(":headTaskId", taskId);
+    query.bindValue(":minuteFrom", minuteFrom);
+    query.bindValue(":headTo", hourFrom);
+    query.bindValue(":tailTaskId", taskId);
+    query.bindValue(":tailFrom", hourTo);
+    query.bindValue(":to", toSecs);
+
+    if (!query.exec()) {
+        qWarning() << "查询统计量失败：" << query.lastError().text() << "任务ID：" << taskId;
+        return stats;
+    }
+
+    double sum = 0.0;
+    double sumSquares = 0.0;
+    QuantileSketch sketch;
+    while (query.next()) {
+        const qint64 count = query.value(0).toLongLong();
+        if (count <= 0) continue;
+        const double minValue = query.value(1).toDouble();
+        const double maxValue = query.value(2).toDouble();
+        if (stats.count == 0) {
+            stats.minValue = minValue;
+            stats.maxValue = maxValue;
+        } else {
+            stats.minValue = qMin(stats.minValue, minValue);
+            stats.maxValue = qMax(stats.maxValue, maxValue);
+        }
+        stats.count += count;
+        sum += query.value(3).toDouble();
+        sumSquares += query.value(4).toDouble();
+
+        const qint64 lastTime = query.value(6).toLongLong();
+        if (lastTime >= stats.lastSecs) {
+            stats.lastValue = query.value(5).toDouble();
+            stats.lastSecs = lastTime;
+        }
+
+        if (query.value(7).isNull()) {
+            sketch.add(query.value(3).toDouble() / count, static_cast<quint64>(count));
+        } else {
+            sketch.merge(QuantileSketch::fromBytes(query.value(7).toByteArray()));
+        }
+    }
+
+    if (stats.count > 0) {
+        stats.mean = sum / stats.count;
+        stats.stddev = std::sqrt(qMax(0.0, sumSquares / stats.count - stats.mean * stats.mean));
+        // 草图代表值有 1% 误差，限制在实际取值范围内
+        stats.p50 = qBound(stats.minValue, sketch.quantile(0.5), stats.maxValue);
+        stats.p95 = qBound(stats.minValue, sketch.quantile(0.95), stats.maxValue);
+    }
+    return stats;
+}
+
+QList<RollupPoint> RollupStore::query(QSqlDatabase& db, int taskId, RollupResolution resolution,
+                                      qint64 fromSecs, qint64 toSecs)
+{
+    QList<RollupPoint> points;
+    const int res = static_cast<int>(resolution);
+    if (res <= 0) return points;
+
+    QSqlQuery query(db);
+    query.setForwardOnly(true);
+    query.prepare(R"(
+        SELECT bucketStart, count, minValue, maxValue, sumValue, firstValue, lastValue
+        FROM crawler_rollup
+        WHERE taskId = :taskId AND resolution = :resolution AND bucketStart BETWEEN :from AND :to
+        ORDER BY bucketStart
+    )");
+    query.bindValue(":taskId", taskId);
+    query.bindValue(":resolution", res);
+    query.bindValue(":from", fromSecs - res + 1); // 包含起点所在的桶
+    query.bindValue(":to", toSecs);
+
+    if (!query.exec()) {
+        qWarning() << "查询汇总失败：" << query.lastError().text();
+        return points;
+    }
+
+    while (query.next()) {
+        RollupPoint point;
+        point.bucketStart = query.value(0).toLongLong();
+        point.count = query.value(1).toInt();
+        point.minValue = query.value(2).toDouble();
+        point.maxValue = query.value(3).toDouble();
+        point.sumValue = query.value(4).toDouble();
+        point.firstValue = query.value(5).toDouble();
+        point.lastValue = query.value(6).toDouble();
+        points.append(point);
+    }
+    return points;
+}
+
+RollupResolution RollupStore::chooseResolution(QSqlDatabase& db, int taskId, qint64 fromSecs, qint64 toSecs,
+                                               int maxPoints)
+{
+    // 用天汇总估算窗口内原始数据量（部分覆盖的天整桶计入，估算偏大）
+    QSqlQuery query(db);
+    query.prepare(R"(
+        SELECT COALESCE(SUM(count), 0) FROM crawler_rollup
+        WHERE taskId = :taskId AND resolution = 86400 AND bucketStart BETWEEN :from AND :to
+    )");
+    query.bindValue(":taskId", taskId);
+    query.bindValue(":from", fromSecs - 86400 + 1);
+    query.bindValue(":to", toSecs);
+    if (query.exec() && query.next() && query.value(0).toLongLong() <= maxPoints) {
+        return RollupResolution::Raw;
+    }
+
+    const qint64 span = qMax<qint64>(1, toSecs - fromSecs);
+    for (int resolution : resolutions()) {
+        if (span / resolution <= maxPoints) {
+            return static_cast<RollupResolution>(resolution);
+        }
+    }
+    return RollupResolution::Day;
+}
+
+bool RollupStore::timeRange(QSqlDatabase& db, int taskId, qint64* firstSecs, qint64* lastSecs)
+{
+    QSqlQuery query(db);
+    query.prepare("SELECT MIN(firstTime), MAX(lastTime) FROM crawler_rollup WHERE taskId = :taskId AND resolution = 86400");
+    query.bindValue(":taskId", taskId);
+    if (!query.exec() || !query.next() || query.value(0).isNull()) {
+        return false;
+    }
+    if (firstSecs) *firstSecs = query.value(0).toLongLong();
+    if (lastSecs) *lastSecs = query.value(1).toLongLong();
+    return true;
+}
@@ -0,0 +1,78 @@
+#ifndef ROLLUPSTORE_H
+#define ROLLUPSTORE_H
+
+#include <QList>
+#include <QDateTime>
+#include <QSqlDatabase>
+
+// 汇总粒度（秒），Raw 表示原始数据
+enum class RollupResolution {
+    Raw = 0,
+    Minute = 60,
+    Hour = 3600,
+    Day = 86400
+};
+
+// 单个时间桶的汇总值
+struct RollupPoint {
+    qint64 bucketStart = 0;  // 桶起点（Unix秒，按本地时区对齐）
+    int count = 0;
+    double minValue = 0.0;
+    double maxValue = 0.0;
+    double sumValue = 0.0;
+    double firstValue = 0.0;
+    double lastValue = 0.0;
+
+    double mean() const { return count > 0 ? sumValue / count : 0.0; }
+    QDateTime time() const { return QDateTime::fromSecsSinceEpoch(bucketStart); }
+};
+
+// 时间窗口内的统计量（由汇总计算，不读取原始数据）
+struct TaskStatistics {
+    qint64 count = 0;
+    double minValue = 0.0;
+    double maxValue = 0.0;
+    double mean = 0.0;
+    double stddev = 0.0;     // 总体标准差
+    double lastValue = 0.0;
+    qint64 lastSecs = 0;     // 最后一个样本的时间（Unix秒）
+    double p50 = 0.0;        // 分位数来自小时桶的分位数草图，相对误差约 1%
+    double p95 = 0.0;
+
+    bool isEmpty() const { return count == 0; }
+};
+
+// 分钟/小时/天汇总表（crawler_rollup）
+// 写入方在插入原始数据的同一事务中调用 record()，保证汇总与原始数据一致
+// 各桶另存平方和（算标准差），小时桶另存分位数草图（QuantileSketch 序列化）；
+// 升级前写入的桶这两列为 NULL，统计时按桶内方差为 0、全部样本等于均值处理
+class RollupStore {
+public:
+    static bool createSchema(QSqlDatabase& db);
+
+    // 把一条数据累加到各粒度的汇总桶
+    static bool record(QSqlDatabase& db, int taskId, double value, const QDateTime& time);
+
+    // 从原始数据重建汇总（迁移旧库或批量导入后使用）；onlyTaskId 为 0 时重建全部任务
+    static bool rebuild(QSqlDatabase& db, int onlyTaskId = 0);
+
+    // 读取 [fromSecs, toSecs] 内的汇总桶，按时间升序
+    static QList<RollupPoint> query(QSqlDatabase& db, int taskId, RollupResolution resolution,
+                                    qint64 fromSecs, qint64 toSecs);
+
+    // 选择不超过 maxPoints 个点的最细粒度；原始数据量由天汇总估算
+    static RollupResolution chooseResolution(QSqlDatabase& db, int taskId, qint64 fromSecs, qint64 toSecs,
+                                             int maxPoints);
+
+    // [fromSecs, toSecs] 内的统计量：整小时用小时桶（含分位数草图），窗口两端不足一小时的部分用分钟桶
+    // 分钟桶没有草图，按桶均值计入分位数；两端的分钟汇总已被保留策略删除时只统计整小时部分
+    static TaskStatistics statistics(QSqlDatabase& db, int taskId, qint64 fromSecs, qint64 toSecs);
+
+    // 任务数据的时间范围（来自天汇总），无数据返回 false
+    static bool timeRange(QSqlDatabase& db, int taskId, qint64* firstSecs, qint64* lastSecs);
+
+    static qint64 bucketStart(const QDateTime& time, int resolution);
+    static QList<int> resolutions() { return {60, 3600, 86400}; }
+};
+
+#endif // ROLLUPSTORE_H
@@ -0,0 +1,236 @@
+#include "schedulestore.h"
+#include "databasemanager.h"
+#include "metrics.h"
+#include <QSqlQuery>
+#include <QSqlError>
+#include <QDateTime>
+#include <QDebug>
+
+// 写回周期（毫秒）：崩溃时最多丢失这段时间内的调度进度
+static const qint64 kFlushIntervalMs = 5000;
+
+// 调度状态指标（首次使用时注册）
+struct ScheduleMetrics {
+    MetricHistogram* flushDuration;
+    MetricHistogram* flushRows;
+
+    static const ScheduleMetrics& get()
+    {
+        static const ScheduleMetrics metrics = []() {
+            MetricsRegistry& registry = MetricsRegistry::instance();
+            ScheduleMetrics m;
+            m.flushDuration = registry.histogram("crawler_schedule_flush_duration_seconds", "调度状态写回耗时");
+            m.flushRows = registry.histogram("crawler_schedule_flush_rows", "每次写回的任务数", {}, 1.0,
+                                             MetricsRegistry::sizeBounds());
+            return m;
+        }();
+        return metrics;
+    }
+};
+
+ScheduleStore& ScheduleStore::instance()
+{
+    static ScheduleStore store;
+    return store;
+}
+
+bool ScheduleStore::createSchema(QSqlDatabase& db)
+{
+    QSqlQuery query(db);
+    const QString sql = R"(
+        CREATE TABLE IF NOT EXISTS crawler_schedule (
+            taskId INTEGER PRIMARY KEY,
+            running INTEGER NOT NULL DEFAULT 0,
+            lastRunAt INTEGER NOT NULL DEFAULT 0,
+            nextDueAt INTEGER NOT NULL DEFAULT 0
+        )
+    )";
+    if (!query.exec(sql)) {
+        qCritical() << "创建调度状态表失败：" << query.lastError().text();
+        return false;
+    }
+    return true;
+}
+
+void ScheduleStore::ensureLoaded()
+{
+    // 调用方已持有 m_mutex
+    if (m_loaded) {
+        return;
+    }
+    m_loaded = true;
+    m_lastFlushMs = QDateTime::currentMSecsSinceEpoch();
+    loadLocked();
+}
+
+void ScheduleStore::loadLocked()
+{
+    QSqlDatabase db = DatabaseManager::getThreadDatabase();
+    if (!db.isOpen()) {
+        qCritical() << "读取调度状态失败：数据库未打开";
+        return;
+    }
+    QSqlQuery query(db);
+    query.setForwardOnly(true);
+    if (!query.exec("SELECT taskId, running, lastRunAt, nextDueAt FROM crawler_schedule")) {
+        qWarning() << "读取调度状态失败：" << query.lastError().text();
+        return;
+    }
+    while (query.next()) {
+        TaskSchedule schedule;
+        schedule.taskId = query.value(0).toInt();
+        schedule.running = query.value(1).toBool();
+        schedule.lastRunAt = query.value(2).toLongLong();
+        schedule.nextDueAt = query.value(3).toLongLong();
+        if (!m_dirty.contains(schedule.taskId)) {
+            m_states.insert(schedule.taskId, schedule);
+        }
+    }
+}
+
+void ScheduleStore::recordRound(int taskId, qint64 lastRunAt, qint64 nextDueAt)
+{
+    {
+        QMutexLocker locker(&m_mutex);
+        ensureLoaded();
+        TaskSchedule& schedule = m_states[taskId];
+        schedule.taskId = taskId;
+        schedule.lastRunAt = lastRunAt;
+        schedule.nextDueAt = nextDueAt;
+        DirtySchedule& dirty = m_dirty[taskId];
+        dirty.schedule = schedule;
+    }
+    maybeFlush();
+}
+
+void ScheduleStore::setRunning(int taskId, bool running)
+{
+    QMutexLocker locker(&m_mutex);
+    ensureLoaded();
+    TaskSchedule& schedule = m_states[taskId];
+    if (schedule.taskId == taskId && schedule.running == running) {
+        return;
+    }
+    schedule.taskId = taskId;
+    schedule.running = running;
+    DirtySchedule& dirty = m_dirty[taskId];
+    dirty.schedule = schedule;
+    dirty.runningChanged = true;
+}
+
+void ScheduleStore::maybeFlush()
+{
+    {
+        QMutexLocker locker(&m_mutex);
+        if (QDateTime::currentMSecsSinceEpoch() - m_lastFlushMs < kFlushIntervalMs) {
+            return;
+        }
+    }
+    // 其他线程正在写回时直接返回，脏记录留到下一次
+    if (!m_flushMutex.tryLock()) {
+        return;
+    }
+    flushLocked();
+    m_flushMutex.unlock();
+}
+
+bool ScheduleStore::flush()
+{
+    QMutexLocker flushLocker(&m_flushMutex);
+    return flushLocked();
+}
+
+bool ScheduleStore::flushLocked()
+{
+    QHash<int, DirtySchedule> dirty;
+    {
+        QMutexLocker locker(&m_mutex);
+        m_lastFlushMs = QDateTime::currentMSecsSinceEpoch();
+        dirty.swap(m_dirty);
+    }
+    if (dirty.isEmpty()) {
+        return true;
+    }
+
+    MetricTimer flushTimer(ScheduleMetrics::get().flushDuration);
+    QSqlDatabase db = DatabaseManager::getThreadDatabase();
+    bool ok = db.isOpen() && db.transaction();
+    if (ok) {
+        QSqlQuery query(db);
+        // 其他进程可能共用同一张表：只有本进程改过运行标志时才覆盖它
+        query.prepare("INSERT INTO crawler_schedule (taskId, running, lastRunAt, nextDueAt) VALUES (?, ?, ?, ?) "
+                      "ON CONFLICT(taskId) DO UPDATE SET lastRunAt = excluded.lastRunAt, "
+                      "nextDueAt = excluded.nextDueAt, "
+                      "running = CASE WHEN ? THEN excluded.running ELSE crawler_schedule.running END");
+        for (const DirtySchedule& entry : std::as_const(dirty)) {
+            const TaskSchedule& schedule = entry.schedule;
+            query.addBindValue(schedule.taskId);
+            query.addBindValue(schedule.running ? 1 : 0);
+            query.addBindValue(schedule.lastRunAt);
+            query.addBindValue(schedule.nextDueAt);
+            query.addBindValue(entry.runningChanged ? 1 : 0);
+            if (!query.exec()) {
+                qWarning() << "写回调度状态失败：" << query.lastError().text();
+                ok = false;
+                break;
+            }
+        }
+        if (ok && !db.commit()) {
+            qWarning() << "写回调度状态提交失败：" << db.lastError().text();
+            ok = false;
+        }
+        if (!ok) {
+            db.rollback();
+        }
+    }
+
+    if (!ok) {
+        // 写回失败时放回脏集合，期间更新过的记录以新值为准
+        QMutexLocker locker(&m_mutex);
+        for (auto it = dirty.constBegin(); it != dirty.constEnd(); ++it) {
+            auto existing = m_dirty.find(it.key());
+            if (existing == m_dirty.end()) {
+                m_dirty.insert(it.key(), it.value());
+            } else {
+                existing->runningChanged = existing->runningChanged || it->runningChanged;
+            }
+        }
+        return false;
+    }
+    ScheduleMetrics::get().flushRows->record(static_cast<quint64>(dirty.size()));
+    return true;
+}
+
+QHash<int, TaskSchedule> ScheduleStore::snapshot()
+{
+    QMutexLocker locker(&m_mutex);
+    ensureLoaded();
+    return m_states;
+}
+
+QHash<int, TaskSchedule> ScheduleStore::reload()
+{
+    QMutexLocker locker(&m_mutex);
+    if (!m_loaded) {
+        ensureLoaded();
+    } else {
+        loadLocked();
+    }
+    return m_states;
+}
+
+qint64 ScheduleStore::resumeDelayMs(const TaskSchedule& schedule, int intervalSecs, qint64 nowMs)
+{
+    const qint64 intervalMs = static_cast<qint64>(qMax(1, intervalSecs)) * 1000;
+    if (schedule.nextDueAt <= 0) {
+        // 没有记录过轮次（启动后尚未跑完第一轮就退出）：按任务ID散列到间隔内
+        return static_cast<qint64>((static_cast<quint64>(schedule.taskId) * 2654435761ULL) % static_cast<quint64>(intervalMs));
+    }
+    if (schedule.nextDueAt >= nowMs) {
+        // 计划时间还没到；间隔被调小时不超过一个间隔
+        return qMin(schedule.nextDueAt - nowMs, intervalMs);
+    }
+    // 错过的轮次不补，顺延整数个间隔到原相位上的下一个时间点
+    const qint64 behind = nowMs - schedule.nextDueAt;
+    return (intervalMs - behind % intervalMs) % intervalMs;
+}
@@ -0,0 +1,62 @@
+#ifndef SCHEDULESTORE_H
+#define SCHEDULESTORE_H
+
+#include <QHash>
+#include <QMutex>
+#include <QSqlDatabase>
+
+// 单个任务的调度状态（时间均为 Unix 毫秒）
+struct TaskSchedule {
+    int taskId = 0;
+    bool running = false;  // 退出时是否在运行（启动后据此自动恢复）
+    qint64 lastRunAt = 0;  // 最近一轮开始时间
+    qint64 nextDueAt = 0;  // 下一轮计划时间
+};
+
+// 调度状态持久化（crawler_schedule）
+// 爬虫线程每轮结束只更新内存，脏记录攒够一个周期后由恰好在记录的线程单事务写回；
+// 重启后按原来的相位恢复，而不是所有任务同时开始第一轮
+class ScheduleStore
+{
+public:
+    static ScheduleStore& instance();
+
+    static bool createSchema(QSqlDatabase& db);
+
+    // 爬虫线程调用：记录一轮的开始时间与下一轮计划时间
+    void recordRound(int taskId, qint64 lastRunAt, qint64 nextDueAt);
+    // 界面启动/停止任务时调用（程序退出时的停止不记录，以便下次恢复）
+    void setRunning(int taskId, bool running);
+    // 写回全部未保存的状态（退出前调用）
+    bool flush();
+
+    // 全部任务的调度状态（首次调用时从数据库加载）
+    QHash<int, TaskSchedule> snapshot();
+    // 重新读取数据库中的状态（多进程共享数据库时取得其他进程写回的进度），未写回的本地记录优先
+    QHash<int, TaskSchedule> reload();
+
+    // 恢复运行时第一轮的延迟：错过的轮次不补，顺延到原相位上的下一个时间点
+    static qint64 resumeDelayMs(const TaskSchedule& schedule, int intervalSecs, qint64 nowMs);
+
+private:
+    // 待写回的记录；运行标志只在本进程改过时才覆盖库中的值
+    struct DirtySchedule {
+        TaskSchedule schedule;
+        bool runningChanged = false;
+    };
+
+    ScheduleStore() = default;
+    void ensureLoaded();
+    void loadLocked(); // 调用方已持有 m_mutex
+    void maybeFlush();
+    bool flushLocked(); // 调用方已持有 m_flushMutex
+
+    QMutex m_mutex;                    // 保护 m_states / m_dirty
+    QMutex m_flushMutex;               // 同一时刻只有一个线程写回
+    QHash<int, TaskSchedule> m_states;
+    QHash<int, DirtySchedule> m_dirty;
+    bool m_loaded = false;
+    qint64 m_lastFlushMs = 0;
+};
+
+#endif // SCHEDULESTORE_H
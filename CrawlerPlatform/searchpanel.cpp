@@ -0,0 +1,109 @@
+#include "searchpanel.h"
+#include "fulltextindex.h"
+#include "taskregistry.h"
+#include <QVBoxLayout>
+#include <QHBoxLayout>
+#include <QHeaderView>
+
+// 单次检索返回的最多结果数
+static const int kSearchLimit = 200;
+
+SearchPanel::SearchPanel(QWidget *parent)
+    : QDialog(parent)
+    , m_queryEdit(new QLineEdit(this))
+    , m_searchBtn(new QPushButton("搜索", this))
+    , m_statusLabel(new QLabel(this))
+    , m_resultTable(new QTableWidget(this))
+    , m_watcher(new QFutureWatcher<QList<SearchHit>>(this))
+{
+    setWindowTitle("全文检索");
+    resize(900, 560);
+
+    m_queryEdit->setPlaceholderText(QString("检索保留的提取文本与归档的响应体（至少 %1 个字符）")
+                                        .arg(FullTextIndex::kMinQueryLength));
+    if (!DatabaseManager::fullTextIndexEnabled()) {
+        m_statusLabel->setText("全文索引未开启（设置 CRAWLER_FULLTEXT=1 后重启），只能检索已建立的索引");
+    }
+
+    m_resultTable->setColumnCount(6);
+    m_resultTable->setHorizontalHeaderLabels({"相关度", "任务ID", "任务名称", "时间", "来源", "片段"});
+    m_resultTable->setEditTriggers(QAbstractItemView::NoEditTriggers);
+    m_resultTable->setSelectionBehavior(QAbstractItemView::SelectRows);
+    m_resultTable->setSelectionMode(QAbstractItemView::SingleSelection);
+    m_resultTable->verticalHeader()->setVisible(false);
+    m_resultTable->horizontalHeader()->setStretchLastSection(true);
+
+    QHBoxLayout* queryLayout = new QHBoxLayout();
+    queryLayout->addWidget(m_queryEdit, 1);
+    queryLayout->addWidget(m_searchBtn);
+
+    QVBoxLayout* layout = new QVBoxLayout(this);
+    layout->addLayout(queryLayout);
+    layout->addWidget(m_statusLabel);
+    layout->addWidget(m_resultTable, 1);
+
+    connect(m_searchBtn, &QPushButton::clicked, this, &SearchPanel::onSearchClicked);
+    connect(m_queryEdit, &QLineEdit::returnPressed, this, &SearchPanel::onSearchClicked);
+    connect(m_watcher, &QFutureWatcherBase::finished, this, &SearchPanel::onSearchFinished);
+    connect(m_resultTable, &QTableWidget::cellDoubleClicked, this, &SearchPanel::onResultActivated);
+}
+
+void SearchPanel::onSearchClicked()
+{
+    const QString text = m_queryEdit->text().trimmed();
+    if (text.size() < FullTextIndex::kMinQueryLength) {
+        m_statusLabel->setText(QString("检索词至少 %1 个字符").arg(FullTextIndex::kMinQueryLength));
+        return;
+    }
+    // 新的检索取代进行中的检索
+    if (m_watcher->isRunning()) {
+        m_watcher->cancel();
+    }
+    m_statusLabel->setText("检索中…");
+    m_clock.start();
+    m_watcher->setFuture(DatabaseManager::searchTextAsync(text, kSearchLimit));
+}
+
+void SearchPanel::onSearchFinished()
+{
+    if (m_watcher->isCanceled() || m_watcher->future().resultCount() == 0) {
+        return;
+    }
+    const QList<SearchHit> hits = m_watcher->result();
+
+    m_resultTable->setRowCount(0);
+    m_resultTable->setRowCount(static_cast<int>(hits.size()));
+    for (int row = 0; row < hits.size(); row++) {
+        const SearchHit& hit = hits.at(row);
+        QString time = QDateTime::fromMSecsSinceEpoch(hit.timestampMs).toString("yyyy-MM-dd HH:mm:ss");
+        QString source = "提取文本";
+        if (hit.source == SearchHit::Body) {
+            source = hit.occurrences > 1 ? QString("响应体 ×%1").arg(hit.occurrences) : QString("响应体");
+            if (hit.firstTimestampMs != hit.timestampMs) {
+                time = QDateTime::fromMSecsSinceEpoch(hit.firstTimestampMs).toString("yyyy-MM-dd HH:mm:ss")
+                    + " ~ " + time;
+            }
+        }
+        QTableWidgetItem* taskItem = new QTableWidgetItem(QString::number(hit.taskId));
+        taskItem->setData(Qt::UserRole, hit.taskId);
+        m_resultTable->setItem(row, 0, new QTableWidgetItem(QString::number(-hit.rank, 'f', 2)));
+        m_resultTable->setItem(row, 1, taskItem);
+        m_resultTable->setItem(row, 2, new QTableWidgetItem(TaskRegistry::instance().taskName(hit.taskId)));
+        m_resultTable->setItem(row, 3, new QTableWidgetItem(time));
+        m_resultTable->setItem(row, 4, new QTableWidgetItem(source));
+        m_resultTable->setItem(row, 5, new QTableWidgetItem(hit.snippet));
+    }
+    m_resultTable->resizeColumnsToContents();
+    m_resultTable->horizontalHeader()->setStretchLastSection(true);
+    m_statusLabel->setText(QString("共 %1 条结果，耗时 %2 毫秒%3")
+                               .arg(hits.size()).arg(m_clock.elapsed())
+                               .arg(hits.size() >= kSearchLimit ? "（只显示最相关的部分）" : ""));
+}
+
+void SearchPanel::onResultActivated(int row, int column)
+{
+    Q_UNUSED(column);
+    if (QTableWidgetItem* item = m_resultTable->item(row, 1)) {
+        emit taskActivated(item->data(Qt::UserRole).toInt());
+    }
+}
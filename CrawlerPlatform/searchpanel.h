@@ -0,0 +1,38 @@
+#ifndef SEARCHPANEL_H
+#define SEARCHPANEL_H
+
+#include <QDialog>
+#include <QLineEdit>
+#include <QPushButton>
+#include <QLabel>
+#include <QTableWidget>
+#include <QElapsedTimer>
+#include <QFutureWatcher>
+#include "databasemanager.h"
+
+// 全文检索面板：在读取线程池中检索，双击结果跳转到对应任务
+class SearchPanel : public QDialog
+{
+    Q_OBJECT
+
+public:
+    explicit SearchPanel(QWidget *parent = nullptr);
+
+signals:
+    void taskActivated(int taskId);
+
+private slots:
+    void onSearchClicked();
+    void onSearchFinished();
+    void onResultActivated(int row, int column);
+
+private:
+    QLineEdit* m_queryEdit;
+    QPushButton* m_searchBtn;
+    QLabel* m_statusLabel;
+    QTableWidget* m_resultTable;
+    QFutureWatcher<QList<SearchHit>>* m_watcher;
+    QElapsedTimer m_clock;
+};
+
+#endif // SEARCHPANEL_H
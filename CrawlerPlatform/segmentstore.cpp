@@ -0,0 +1,359 @@
+#include "segmentstore.h"
+#include <QDir>
+#include <QDirIterator>
+#include <QFileInfo>
+#include <QDebug>
+#include <algorithm>
+#include <cstring>
+#include <limits>
+
+// 段文件头（32字节）
+struct SegmentHeader {
+    char magic[4];
+    quint32 version;
+    qint32 taskId;
+    quint32 recordSize;
+    char reserved[16];
+};
+static_assert(sizeof(SegmentHeader) == 32, "SegmentHeader 必须为32字节");
+
+static const char kSegmentMagic[4] = {'C', 'S', 'E', 'G'};
+static const quint32 kSegmentVersion = 1;
+static const qint64 kHeaderSize = sizeof(SegmentHeader);
+
+// 只读映射一个段文件的记录区，析构时解除映射
+class MappedSegment {
+public:
+    bool open(const QString& path, qint64 records)
+    {
+        m_file.setFileName(path);
+        if (!m_file.open(QIODevice::ReadOnly)) {
+            qWarning() << "打开段文件失败：" << path << m_file.errorString();
+            return false;
+        }
+        if (records <= 0) return true;
+        uchar* data = m_file.map(kHeaderSize, records * static_cast<qint64>(sizeof(SegmentRecord)));
+        if (!data) {
+            qWarning() << "映射段文件失败：" << path << m_file.errorString();
+            return false;
+        }
+        m_records = reinterpret_cast<const SegmentRecord*>(data);
+        return true;
+    }
+    const SegmentRecord* records() const { return m_records; }
+
+private:
+    QFile m_file;
+    const SegmentRecord* m_records = nullptr;
+};
+
+// 第一个时间戳 >= ms 的记录下标：先用稀疏索引定位块，再在块内二分
+static qint64 lowerBound(const SegmentRecord* records, qint64 count, const QList<qint64>& index, qint64 ms)
+{
+    const qint64 k = std::lower_bound(index.cbegin(), index.cend(), ms) - index.cbegin();
+    if (k == 0) return 0;
+    const qint64 lo = (k - 1) * SegmentStore::kIndexStride;
+    const qint64 hi = k < index.size() ? k * SegmentStore::kIndexStride : count;
+    const SegmentRecord* it = std::lower_bound(records + lo, records + hi, ms,
+        [](const SegmentRecord& record, qint64 value) { return record.timestampMs < value; });
+    return it - records;
+}
+
+SegmentStore& SegmentStore::instance()
+{
+    static SegmentStore store;
+    return store;
+}
+
+SegmentStore::~SegmentStore()
+{
+    close();
+}
+
+void SegmentStore::setDirectory(const QString& directory)
+{
+    QMutexLocker locker(&m_mutex);
+    m_tasks.clear();
+    m_directory = directory;
+}
+
+QString SegmentStore::directory() const
+{
+    QMutexLocker locker(&m_mutex);
+    return m_directory;
+}
+
+void SegmentStore::close()
+{
+    QMutexLocker locker(&m_mutex);
+    m_tasks.clear();
+}
+
+QString SegmentStore::taskDirectory(int taskId) const
+{
+    return QDir(m_directory).filePath(QString("task_%1").arg(taskId));
+}
+
+// 读取段文件：校验文件头，扫描一遍记录区建立稀疏索引与时间范围
+bool SegmentStore::loadSegment(const QString& path, int sequence, Segment* segment)
+{
+    QFile file(path);
+    if (!file.open(QIODevice::ReadOnly)) {
+        qWarning() << "打开段文件失败：" << path << file.errorString();
+        return false;
+    }
+
+    SegmentHeader header;
+    if (file.read(reinterpret_cast<char*>(&header), kHeaderSize) != kHeaderSize
+        || memcmp(header.magic, kSegmentMagic, sizeof(kSegmentMagic)) != 0
+        || header.version != kSegmentVersion || header.recordSize != sizeof(SegmentRecord)) {
+        qWarning() << "段文件头无效，已忽略：" << path;
+        return false;
+    }
+    file.close();
+
+    segment->path = path;
+    segment->sequence = sequence;
+    // 末尾不完整的记录（写入中断）不计入
+    segment->records = (QFileInfo(path).size() - kHeaderSize) / static_cast<qint64>(sizeof(SegmentRecord));
+    segment->sparseIndex.clear();
+    segment->sorted = true;
+
+    MappedSegment mapped;
+    if (!mapped.open(path, segment->records)) {
+        return false;
+    }
+    const SegmentRecord* records = mapped.records();
+    for (qint64 i = 0; i < segment->records; i++) {
+        const qint64 ms = records[i].timestampMs;
+        if (i % kIndexStride == 0) {
+            segment->sparseIndex.append(ms);
+        }
+        if (i == 0) {
+            segment->minMs = segment->maxMs = ms;
+        } else {
+            if (ms < segment->maxMs) segment->sorted = false;
+            segment->minMs = qMin(segment->minMs, ms);
+            segment->maxMs = qMax(segment->maxMs, ms);
+        }
+    }
+    return true;
+}
+
+// 调用方持有 m_mutex
+SegmentStore::TaskSegments* SegmentStore::loadTask(int taskId)
+{
+    auto it = m_tasks.find(taskId);
+    if (it != m_tasks.end()) {
+        return it->second.get();
+    }
+
+    auto task = std::make_unique<TaskSegments>();
+    QDir dir(taskDirectory(taskId));
+    const QFileInfoList files = dir.entryInfoList({"*.seg"}, QDir::Files, QDir::Name);
+    for (const QFileInfo& info : files) {
+        Segment segment;
+        if (loadSegment(info.filePath(), info.baseName().toInt(), &segment)) {
+            task->segments.append(segment);
+        }
+    }
+
+    TaskSegments* result = task.get();
+    m_tasks[taskId] = std::move(task);
+    return result;
+}
+
+// 打开最后一段用于追加，已写满或不存在时创建新段（调用方持有 m_mutex）
+bool SegmentStore::openWriter(int taskId, TaskSegments* task)
+{
+    task->writer.reset();
+
+    if (!task->segments.isEmpty() && task->segments.last().records < kRecordsPerSegment) {
+        Segment& last = task->segments.last();
+        auto file = std::make_unique<QFile>(last.path);
+        if (!file->open(QIODevice::ReadWrite)) {
+            qWarning() << "打开段文件失败：" << last.path << file->errorString();
+            return false;
+        }
+        // 截掉不完整的尾部记录，保证追加位置对齐
+        const qint64 size = kHeaderSize + last.records * static_cast<qint64>(sizeof(SegmentRecord));
+        if (!file->resize(size) || !file->seek(size)) {
+            qWarning() << "截断段文件失败：" << last.path << file->errorString();
+            return false;
+        }
+        task->writer = std::move(file);
+        return true;
+    }
+
+    const QString dirPath = taskDirectory(taskId);
+    if (!QDir().mkpath(dirPath)) {
+        qWarning() << "创建段目录失败：" << dirPath;
+        return false;
+    }
+
+    Segment segment;
+    segment.sequence = task->segments.isEmpty() ? 1 : task->segments.last().sequence + 1;
+    segment.path = QDir(dirPath).filePath(QString("%1.seg").arg(segment.sequence, 8, 10, QChar('0')));
+
+    auto file = std::make_unique<QFile>(segment.path);
+    if (!file->open(QIODevice::ReadWrite | QIODevice::Truncate)) {
+        qWarning() << "创建段文件失败：" << segment.path << file->errorString();
+        return false;
+    }
+    SegmentHeader header = {};
+    memcpy(header.magic, kSegmentMagic, sizeof(kSegmentMagic));
+    header.version = kSegmentVersion;
+    header.taskId = taskId;
+    header.recordSize = sizeof(SegmentRecord);
+    if (file->write(reinterpret_cast<const char*>(&header), kHeaderSize) != kHeaderSize) {
+        qWarning() << "写入段文件头失败：" << segment.path << file->errorString();
+        file->close();
+        QFile::remove(segment.path);
+        return false;
+    }
+
+    task->segments.append(segment);
+    task->writer = std::move(file);
+    return true;
+}
+
+bool SegmentStore::append(int taskId, qint64 timestampMs, double value)
+{
+    QMutexLocker locker(&m_mutex);
+    TaskSegments* task = loadTask(taskId);
+    if (!task->writer || task->segments.last().records >= kRecordsPerSegment) {
+        if (!openWriter(taskId, task)) {
+            return false;
+        }
+    }
+
+    const SegmentRecord record = {timestampMs, value};
+    if (task->writer->write(reinterpret_cast<const char*>(&record), sizeof(record)) != sizeof(record)
+        || !task->writer->flush()) {
+        qWarning() << "写入段文件失败：" << task->writer->fileName() << task->writer->errorString();
+        // 下次写入时重新打开并截断残缺记录
+        task->writer.reset();
+        return false;
+    }
+
+    Segment& segment = task->segments.last();
+    if (segment.records % kIndexStride == 0) {
+        segment.sparseIndex.append(timestampMs);
+    }
+    if (segment.records == 0) {
+        segment.minMs = segment.maxMs = timestampMs;
+    } else {
+        if (timestampMs < segment.maxMs) segment.sorted = false;
+        segment.minMs = qMin(segment.minMs, timestampMs);
+        segment.maxMs = qMax(segment.maxMs, timestampMs);
+    }
+    segment.records++;
+    return true;
+}
+
+// 复制段元数据，读取在锁外进行（只读取快照中的记录数，不受并发追加影响）
+QList<SegmentStore::Segment> SegmentStore::snapshot(int taskId)
+{
+    QMutexLocker locker(&m_mutex);
+    return loadTask(taskId)->segments;
+}
+
+qint64 SegmentStore::scan(int taskId, qint64 fromMs, qint64 toMs, const Visitor& visitor)
+{
+    const QList<Segment> segments = snapshot(taskId);
+    qint64 visited = 0;
+
+    for (const Segment& segment : segments) {
+        if (segment.records == 0 || segment.maxMs < fromMs || segment.minMs > toMs) {
+            continue;
+        }
+        MappedSegment mapped;
+        if (!mapped.open(segment.path, segment.records)) {
+            continue;
+        }
+        const SegmentRecord* records = mapped.records();
+
+        qint64 begin = 0;
+        qint64 end = segment.records;
+        if (segment.sorted) {
+            begin = lowerBound(records, segment.records, segment.sparseIndex, fromMs);
+            if (toMs < std::numeric_limits<qint64>::max()) {
+                end = lowerBound(records, segment.records, segment.sparseIndex, toMs + 1);
+            }
+            if (!visitor) {
+                visited += end - begin;
+                continue;
+            }
+        }
+
+        for (qint64 i = begin; i < end; i++) {
+            const SegmentRecord& record = records[i];
+            if (!segment.sorted && (record.timestampMs < fromMs || record.timestampMs > toMs)) {
+                continue;
+            }
+            visited++;
+            if (visitor && !visitor(record.timestampMs, record.value)) {
+                return visited;
+            }
+        }
+    }
+    return visited;
+}
+
+qint64 SegmentStore::count(int taskId, qint64 fromMs, qint64 toMs)
+{
+    return scan(taskId, fromMs, toMs, Visitor());
+}
+
+bool SegmentStore::timeRange(int taskId, qint64* firstMs, qint64* lastMs)
+{
+    bool found = false;
+    qint64 first = 0;
+    qint64 last = 0;
+    for (const Segment& segment : snapshot(taskId)) {
+        if (segment.records == 0) continue;
+        first = found ? qMin(first, segment.minMs) : segment.minMs;
+        last = found ? qMax(last, segment.maxMs) : segment.maxMs;
+        found = true;
+    }
+    if (found) {
+        if (firstMs) *firstMs = first;
+        if (lastMs) *lastMs = last;
+    }
+    return found;
+}
+
+qint64 SegmentStore::pruneBefore(int taskId, qint64 cutoffMs)
+{
+    QMutexLocker locker(&m_mutex);
+    TaskSegments* task = loadTask(taskId);
+    qint64 removed = 0;
+
+    // 最后一段可能仍在写入，保留
+    for (int i = task->segments.size() - 2; i >= 0; i--) {
+        const Segment& segment = task->segments.at(i);
+        if (segment.records > 0 && segment.maxMs >= cutoffMs) {
+            continue;
+        }
+        // 读取方可能仍映射着该文件，删除失败（如 Windows）时留待下一轮
+        if (!QFile::remove(segment.path)) {
+            qWarning() << "删除过期段文件失败：" << segment.path;
+            continue;
+        }
+        removed += segment.records;
+        task->segments.removeAt(i);
+    }
+    return removed;
+}
+
+qint64 SegmentStore::diskBytes() const
+{
+    const QString root = directory();
+    qint64 bytes = 0;
+    QDirIterator it(root, {"*.seg"}, QDir::Files, QDirIterator::Subdirectories);
+    while (it.hasNext()) {
+        it.next();
+        bytes += it.fileInfo().size();
+    }
+    return bytes;
+}
@@ -0,0 +1,78 @@
+#ifndef SEGMENTSTORE_H
+#define SEGMENTSTORE_H
+
+#include <QString>
+#include <QList>
+#include <QMutex>
+#include <QFile>
+#include <functional>
+#include <map>
+#include <memory>
+
+// 定长数据点：毫秒时间戳 + 数值（按本机字节序存储）
+struct SegmentRecord {
+    qint64 timestampMs;
+    double value;
+};
+static_assert(sizeof(SegmentRecord) == 16, "SegmentRecord 必须为16字节定长");
+
+// 内存映射的追加式时序段存储
+// 目录结构：<root>/task_<id>/<序号>.seg，每段 32 字节头 + 定长记录，写满后滚动到新段
+// 读取通过 QFile::map 映射段文件，稀疏时间索引（每 kIndexStride 条一个时间戳）用于定位起点
+class SegmentStore {
+public:
+    static SegmentStore& instance();
+
+    // 根目录（需在首次读写前设置，切换时关闭已打开的段）
+    void setDirectory(const QString& directory);
+    QString directory() const;
+
+    bool append(int taskId, qint64 timestampMs, double value);
+
+    // 按存储顺序访问 [fromMs, toMs] 内的数据点，visitor 返回 false 时提前结束，返回访问的点数
+    using Visitor = std::function<bool(qint64 timestampMs, double value)>;
+    qint64 scan(int taskId, qint64 fromMs, qint64 toMs, const Visitor& visitor);
+    qint64 count(int taskId, qint64 fromMs, qint64 toMs);
+    bool timeRange(int taskId, qint64* firstMs, qint64* lastMs);
+
+    // 删除整段都早于 cutoffMs 的段文件（不含正在写入的段），返回删除的点数
+    qint64 pruneBefore(int taskId, qint64 cutoffMs);
+
+    qint64 diskBytes() const;
+    void close();
+
+    static const qint64 kRecordsPerSegment = 1 << 20; // 每段 16MB
+    static const int kIndexStride = 1024;
+
+private:
+    SegmentStore() = default;
+    ~SegmentStore();
+    SegmentStore(const SegmentStore&) = delete;
+    SegmentStore& operator=(const SegmentStore&) = delete;
+
+    struct Segment {
+        QString path;
+        int sequence = 0;
+        qint64 records = 0;
+        qint64 minMs = 0;
+        qint64 maxMs = 0;
+        bool sorted = true;          // 段内时间戳非递减时可用稀疏索引二分
+        QList<qint64> sparseIndex;   // 第 i*kIndexStride 条记录的时间戳
+    };
+    struct TaskSegments {
+        QList<Segment> segments;     // 按序号升序
+        std::unique_ptr<QFile> writer; // 最后一段的追加句柄
+    };
+
+    TaskSegments* loadTask(int taskId);
+    bool loadSegment(const QString& path, int sequence, Segment* segment);
+    bool openWriter(int taskId, TaskSegments* task);
+    QList<Segment> snapshot(int taskId);
+    QString taskDirectory(int taskId) const;
+
+    mutable QMutex m_mutex;
+    QString m_directory = "crawler_segments";
+    std::map<int, std::unique_ptr<TaskSegments>> m_tasks;
+};
+
+#endif // SEGMENTSTORE_H
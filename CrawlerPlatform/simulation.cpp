@@ -0,0 +1,116 @@
+#include "simulation.h"
+#include "databasemanager.h"
+#include <QUrl>
+#include <QUrlQuery>
+#include <QRandomGenerator>
+#include <cmath>
+
+SimulatedValueSource SimulatedValueSource::fromUrl(const QString& url)
+{
+    SimulatedValueSource source;
+    QUrl parsed(url);
+    if (parsed.scheme() != "sim") {
+        // 兼容旧的模拟地址：默认参数即 0~99.9 均匀分布
+        return source;
+    }
+
+    QString kind = parsed.host().toLower();
+    if (kind == "walk") {
+        source.kind = Kind::RandomWalk;
+    } else if (kind == "step") {
+        source.kind = Kind::StepChange;
+    }
+
+    QUrlQuery query(parsed);
+    auto number = [&query](const QString& key, double fallback) {
+        bool ok = false;
+        double v = query.queryItemValue(key).toDouble(&ok);
+        return ok ? v : fallback;
+    };
+    source.minValue = number("min", source.minValue);
+    source.maxValue = number("max", source.maxValue);
+    source.start = number("start", (source.minValue + source.maxValue) / 2);
+    source.sigma = number("sigma", source.sigma);
+    source.stepProbability = number("p", source.stepProbability);
+    source.jump = number("jump", source.jump);
+    if (source.maxValue < source.minValue) {
+        qSwap(source.minValue, source.maxValue);
+    }
+    return source;
+}
+
+QString SimulatedValueSource::toUrl() const
+{
+    switch (kind) {
+    case Kind::RandomWalk:
+        return QString("sim://walk?start=%1&sigma=%2&min=%3&max=%4")
+            .arg(start).arg(sigma).arg(minValue).arg(maxValue);
+    case Kind::StepChange:
+        return QString("sim://step?start=%1&p=%2&jump=%3&min=%4&max=%5")
+            .arg(start).arg(stepProbability).arg(jump).arg(minValue).arg(maxValue);
+    case Kind::Uniform:
+    default:
+        return QString("sim://uniform?min=%1&max=%2").arg(minValue).arg(maxValue);
+    }
+}
+
+double SimulatedValueSource::next(FastRandom& rng)
+{
+    if (!m_started) {
+        m_current = qBound(minValue, start, maxValue);
+        m_started = true;
+    }
+
+    switch (kind) {
+    case Kind::RandomWalk:
+        m_current += sigma * rng.normal();
+        break;
+    case Kind::StepChange:
+        if (rng.nextDouble() < stepProbability) {
+            m_current += rng.nextDouble() < 0.5 ? -jump : jump;
+        }
+        break;
+    case Kind::Uniform:
+    default:
+        // 保留一位小数，与原 rand()%1000/10 的取值粒度一致
+        return std::floor(rng.uniform(minValue, maxValue) * 10.0) / 10.0;
+    }
+
+    m_current = qBound(minValue, m_current, maxValue);
+    return m_current;
+}
+
+QList<int> LoadGenerator::createTasks(const LoadProfile& profile)
+{
+    FastRandom rng(profile.seed != 0 ? profile.seed : QRandomGenerator::global()->generate64());
+    const int lo = qMax(1, qMin(profile.intervalMin, profile.intervalMax));
+    const int hi = qMax(lo, qMax(profile.intervalMin, profile.intervalMax));
+
+    QList<CrawlerTask> tasks;
+    tasks.reserve(profile.taskCount);
+    for (int i = 0; i < profile.taskCount; i++) {
+        int interval = lo;
+        switch (profile.intervalDistribution) {
+        case LoadProfile::IntervalDistribution::Uniform:
+            interval = lo + static_cast<int>(rng.bounded(static_cast<quint64>(hi - lo + 1)));
+            break;
+        case LoadProfile::IntervalDistribution::Exponential:
+            interval = qBound(lo, static_cast<int>(std::lround(rng.exponential((lo + hi) / 2.0))), hi);
+            break;
+        case LoadProfile::IntervalDistribution::Fixed:
+            break;
+        }
+
+        // 各任务起始值在区间内随机，避免所有曲线重合
+        SimulatedValueSource process = profile.process;
+        process.start = rng.uniform(process.minValue, process.maxValue);
+
+        CrawlerTask task;
+        task.name = QString("%1-%2").arg(profile.namePrefix).arg(i + 1);
+        task.url = process.toUrl();
+        task.interval = interval;
+        tasks.append(task);
+    }
+
+    return DatabaseManager::saveCrawlerTasks(tasks);
+}
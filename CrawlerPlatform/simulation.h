@@ -0,0 +1,57 @@
+#ifndef SIMULATION_H
+#define SIMULATION_H
+
+#include <QString>
+#include <QList>
+#include "fastrandom.h"
+
+// 模拟数值过程，参数编码在任务URL中：
+//   sim://uniform?min=0&max=100
+//   sim://walk?start=50&sigma=0.5&min=0&max=100      随机游走
+//   sim://step?start=50&p=0.05&jump=10&min=0&max=100 以概率 p 阶跃 ±jump
+// 其他非HTTP地址按 uniform 0~99.9 处理（与原模拟行为一致）
+class SimulatedValueSource
+{
+public:
+    enum class Kind { Uniform, RandomWalk, StepChange };
+
+    static SimulatedValueSource fromUrl(const QString& url);
+    QString toUrl() const;
+
+    double next(FastRandom& rng);
+
+    Kind kind = Kind::Uniform;
+    double start = 50.0;
+    double sigma = 0.5;          // 随机游走步长标准差
+    double stepProbability = 0.05;
+    double jump = 10.0;          // 阶跃幅度
+    double minValue = 0.0;
+    double maxValue = 100.0;
+
+private:
+    double m_current = 0.0;
+    bool m_started = false;
+};
+
+// 模拟任务批量生成配置
+struct LoadProfile {
+    enum class IntervalDistribution { Fixed, Uniform, Exponential };
+
+    int taskCount = 1000;
+    QString namePrefix = "sim";
+    IntervalDistribution intervalDistribution = IntervalDistribution::Uniform;
+    int intervalMin = 1;         // 秒；Fixed 取 intervalMin
+    int intervalMax = 10;        // 秒；Exponential 以 (min+max)/2 为均值并截断到 [min, max]
+    SimulatedValueSource process;
+    quint64 seed = 0;            // 0 表示随机种子
+};
+
+// 负载生成器：按配置批量创建模拟任务（无需网络），用于压测调度、写入与界面
+class LoadGenerator
+{
+public:
+    // 单事务写入，返回新任务ID（失败返回空列表）
+    static QList<int> createTasks(const LoadProfile& profile);
+};
+
+#endif // SIMULATION_H
@@ -0,0 +1,284 @@
+#include "taskimport.h"
+#include "crawlerthread.h"
+#include <QFile>
+#include <QFileInfo>
+#include <QJsonDocument>
+#include <QJsonArray>
+#include <QJsonObject>
+#include <QJsonParseError>
+#include <QRegularExpression>
+#include <QStringList>
+#include <QDebug>
+
+// 列名（CSV 表头与 JSON 字段名一致）
+static const QStringList kColumns = {"name", "url", "interval", "rule", "changeTolerance", "keepRawText"};
+
+// 列名不区分大小写
+static int columnIndex(const QString& name)
+{
+    for (int i = 0; i < kColumns.size(); ++i) {
+        if (kColumns.at(i).compare(name.trimmed(), Qt::CaseInsensitive) == 0) return i;
+    }
+    return -1;
+}
+
+static void setError(QString* error, const QString& message)
+{
+    if (error) *error = message;
+}
+
+// 布尔字段兼容 1/0、true/false、是/否
+static bool parseBool(const QString& text, bool* ok)
+{
+    const QString value = text.trimmed().toLower();
+    *ok = true;
+    if (value.isEmpty() || value == "0" || value == "false" || value == "no" || value == "否") return false;
+    if (value == "1" || value == "true" || value == "yes" || value == "是") return true;
+    *ok = false;
+    return false;
+}
+
+// 按列名填充任务字段，返回空字符串表示成功，否则为错误原因
+static QString fillTask(CrawlerTask* task, const QString& column, const QString& text)
+{
+    bool ok = true;
+    if (column == "name") {
+        task->name = text.trimmed();
+    } else if (column == "url") {
+        task->url = text.trimmed();
+    } else if (column == "interval") {
+        if (!text.trimmed().isEmpty()) {
+            task->interval = text.trimmed().toInt(&ok);
+            if (!ok || task->interval < 1) return QString("爬取间隔无效：%1").arg(text);
+        }
+    } else if (column == "rule") {
+        task->rule = text; // 规则是正则，保留首尾空白
+    } else if (column == "changeTolerance") {
+        if (!text.trimmed().isEmpty()) {
+            const double tolerance = text.trimmed().toDouble(&ok);
+            if (!ok) return QString("变化存储容差无效：%1").arg(text);
+            task->changeTolerance = tolerance < 0 ? -1.0 : tolerance;
+        }
+    } else if (column == "keepRawText") {
+        task->keepRawText = parseBool(text, &ok);
+        if (!ok) return QString("keepRawText 无效：%1").arg(text);
+    }
+    return QString();
+}
+
+static QString validateTask(const CrawlerTask& task)
+{
+    if (task.name.isEmpty()) return "任务名称为空";
+    if (task.url.isEmpty()) return "URL为空";
+    const QRegularExpression re(CrawlerThread::rulePattern(task.rule));
+    if (!re.isValid()) return QString("提取规则无效：%1").arg(re.errorString());
+    return QString();
+}
+
+QList<CrawlerTask> TaskImporter::parse(const QByteArray& data, Format format, QString* error)
+{
+    if (format == Format::Auto) {
+        // 以第一个非空白字符判断：[ 或 { 为 JSON，否则按 CSV
+        format = Format::Csv;
+        for (char c : data) {
+            if (c == ' ' || c == '\t' || c == '\r' || c == '\n') continue;
+            if (c == '[' || c == '{') format = Format::Json;
+            break;
+        }
+    }
+    return format == Format::Json ? parseJson(data, error) : parseCsv(data, error);
+}
+
+QList<CrawlerTask> TaskImporter::parseCsv(const QByteArray& data, QString* error)
+{
+    // 去掉 UTF-8 BOM（表格软件导出的 CSV 常带）
+    QString text = QString::fromUtf8(data);
+    if (text.startsWith(QChar(0xFEFF))) text.remove(0, 1);
+
+    // 逐字符切分记录（引号内的逗号与换行属于字段内容）
+    QList<QStringList> records;
+    QList<int> recordLines;
+    QStringList fields;
+    QString field;
+    bool quoted = false;
+    bool fieldStarted = false;
+    int line = 1;
+    int recordLine = 1;
+    auto endRecord = [&]() {
+        fields.append(field);
+        // 跳过空行
+        if (fields.size() > 1 || !fields.first().trimmed().isEmpty()) {
+            records.append(fields);
+            recordLines.append(recordLine);
+        }
+        fields.clear();
+        field.clear();
+        fieldStarted = false;
+    };
+    for (qsizetype i = 0; i < text.size(); ++i) {
+        const QChar c = text.at(i);
+        if (quoted) {
+            if (c == '"') {
+                if (i + 1 < text.size() && text.at(i + 1) == '"') {
+                    field.append('"');
+                    ++i;
+                } else {
+                    quoted = false;
+                }
+            } else {
+                if (c == '\n') ++line;
+                field.append(c);
+            }
+            continue;
+        }
+        if (c == '"' && !fieldStarted) {
+            quoted = true;
+            fieldStarted = true;
+        } else if (c == ',') {
+            fields.append(field);
+            field.clear();
+            fieldStarted = false;
+        } else if (c == '\r') {
+            continue;
+        } else if (c == '\n') {
+            endRecord();
+            ++line;
+            recordLine = line;
+        } else {
+            field.append(c);
+            fieldStarted = true;
+        }
+    }
+    if (quoted) {
+        setError(error, QString("第 %1 行：引号未闭合").arg(recordLine));
+        return QList<CrawlerTask>();
+    }
+    if (fieldStarted || !fields.isEmpty()) {
+        endRecord();
+    }
+    if (records.isEmpty()) {
+        setError(error, "文件中没有任务");
+        return QList<CrawlerTask>();
+    }
+
+    // 表头：首行第一列为已知列名时按表头映射，否则按默认列顺序
+    QStringList columns = kColumns;
+    int first = 0;
+    if (columnIndex(records.first().first()) >= 0) {
+        columns.clear();
+        for (const QString& name : records.first()) {
+            const int index = columnIndex(name);
+            if (index < 0) {
+                setError(error, QString("第 1 行：未知列 %1").arg(name.trimmed()));
+                return QList<CrawlerTask>();
+            }
+            columns.append(kColumns.at(index));
+        }
+        first = 1;
+    }
+
+    QList<CrawlerTask> tasks;
+    tasks.reserve(records.size() - first);
+    for (int r = first; r < records.size(); ++r) {
+        const QStringList& record = records.at(r);
+        if (record.size() > columns.size()) {
+            setError(error, QString("第 %1 行：列数 %2 超过 %3").arg(recordLines.at(r)).arg(record.size()).arg(columns.size()));
+            return QList<CrawlerTask>();
+        }
+        CrawlerTask task;
+        for (int c = 0; c < record.size(); ++c) {
+            const QString reason = fillTask(&task, columns.at(c), record.at(c));
+            if (!reason.isEmpty()) {
+                setError(error, QString("第 %1 行：%2").arg(recordLines.at(r)).arg(reason));
+                return QList<CrawlerTask>();
+            }
+        }
+        const QString reason = validateTask(task);
+        if (!reason.isEmpty()) {
+            setError(error, QString("第 %1 行：%2").arg(recordLines.at(r)).arg(reason));
+            return QList<CrawlerTask>();
+        }
+        tasks.append(task);
+    }
+    // 只有表头没有数据行
+    if (tasks.isEmpty()) {
+        setError(error, "文件中没有任务");
+    }
+    return tasks;
+}
+
+QList<CrawlerTask> TaskImporter::parseJson(const QByteArray& data, QString* error)
+{
+    QJsonParseError parseError;
+    const QJsonDocument doc = QJsonDocument::fromJson(data, &parseError);
+    if (doc.isNull()) {
+        setError(error, QString("JSON 解析失败（偏移 %1）：%2").arg(parseError.offset).arg(parseError.errorString()));
+        return QList<CrawlerTask>();
+    }
+    const QJsonArray array = doc.isArray() ? doc.array() : doc.object().value("tasks").toArray();
+    if (array.isEmpty()) {
+        setError(error, "文件中没有任务（需要任务数组或 {\"tasks\": [...]}）");
+        return QList<CrawlerTask>();
+    }
+
+    QList<CrawlerTask> tasks;
+    tasks.reserve(array.size());
+    for (qsizetype i = 0; i < array.size(); ++i) {
+        if (!array.at(i).isObject()) {
+            setError(error, QString("第 %1 个任务不是对象").arg(i + 1));
+            return QList<CrawlerTask>();
+        }
+        const QJsonObject object = array.at(i).toObject();
+        CrawlerTask task;
+        for (auto it = object.constBegin(); it != object.constEnd(); ++it) {
+            const int index = columnIndex(it.key());
+            if (index < 0) {
+                setError(error, QString("第 %1 个任务：未知字段 %2").arg(i + 1).arg(it.key()));
+                return QList<CrawlerTask>();
+            }
+            // 数值与布尔按文本统一走 CSV 的校验
+            const QJsonValue value = it.value();
+            QString text;
+            if (value.isBool()) {
+                text = value.toBool() ? "1" : "0";
+            } else if (value.isDouble()) {
+                text = QString::number(value.toDouble(), 'g', 17);
+            } else {
+                text = value.toString();
+            }
+            const QString reason = fillTask(&task, kColumns.at(index), text);
+            if (!reason.isEmpty()) {
+                setError(error, QString("第 %1 个任务：%2").arg(i + 1).arg(reason));
+                return QList<CrawlerTask>();
+            }
+        }
+        const QString reason = validateTask(task);
+        if (!reason.isEmpty()) {
+            setError(error, QString("第 %1 个任务：%2").arg(i + 1).arg(reason));
+            return QList<CrawlerTask>();
+        }
+        tasks.append(task);
+    }
+    return tasks;
+}
+
+QList<int> TaskImporter::importFile(const QString& path, QString* error)
+{
+    QFile file(path);
+    if (!file.open(QIODevice::ReadOnly)) {
+        setError(error, QString("无法打开文件：%1").arg(file.errorString()));
+        return QList<int>();
+    }
+    const QString suffix = QFileInfo(path).suffix().toLower();
+    const Format format = suffix == "json" ? Format::Json : (suffix == "csv" ? Format::Csv : Format::Auto);
+    const QList<CrawlerTask> tasks = parse(file.readAll(), format, error);
+    if (tasks.isEmpty()) {
+        return QList<int>();
+    }
+
+    const QList<int> ids = DatabaseManager::saveCrawlerTasks(tasks);
+    if (ids.isEmpty()) {
+        setError(error, "写入数据库失败，已回滚");
+    }
+    return ids;
+}
@@ -0,0 +1,30 @@
+#ifndef TASKIMPORT_H
+#define TASKIMPORT_H
+
+#include <QByteArray>
+#include <QList>
+#include <QString>
+#include "databasemanager.h"
+
+// 批量导入任务（CSV / JSON）
+// CSV：首行可为表头（name,url,interval,rule,changeTolerance,keepRawText，顺序任意、后四列可省略），
+//      无表头时按上述顺序解析；字段含逗号、引号或换行时用双引号包裹，内部引号写作 ""
+// JSON：任务对象数组，或 {"tasks": [...]}，字段名同 CSV 表头（不区分大小写）
+// 任一行无效（含提取规则不是合法正则）时整体失败，不写入任何任务
+class TaskImporter
+{
+public:
+    enum class Format { Auto, Csv, Json };
+
+    // 解析任务列表，失败返回空列表并在 error 中给出行号/位置与原因
+    static QList<CrawlerTask> parse(const QByteArray& data, Format format = Format::Auto,
+                                    QString* error = nullptr);
+    // 读取文件并在单个事务中写入，返回新任务ID（失败返回空列表）
+    static QList<int> importFile(const QString& path, QString* error = nullptr);
+
+private:
+    static QList<CrawlerTask> parseCsv(const QByteArray& data, QString* error);
+    static QList<CrawlerTask> parseJson(const QByteArray& data, QString* error);
+};
+
+#endif // TASKIMPORT_H
@@ -0,0 +1,175 @@
+#include "taskregistry.h"
+#include "metrics.h"
+#include <algorithm>
+
+// 任务缓存指标（首次使用时注册）
+struct TaskRegistryMetrics {
+    MetricCounter* hits;
+    MetricCounter* misses;
+    MetricCounter* loads;
+    MetricGauge* size;
+
+    static const TaskRegistryMetrics& get()
+    {
+        static const TaskRegistryMetrics metrics = []() {
+            MetricsRegistry& registry = MetricsRegistry::instance();
+            const QString name = "crawler_task_registry_lookups_total";
+            const QString help = "任务元数据查询次数（命中缓存/回查数据库）";
+            TaskRegistryMetrics m;
+            m.hits = registry.counter(name, help, {{"result", "hit"}});
+            m.misses = registry.counter(name, help, {{"result", "miss"}});
+            m.loads = registry.counter("crawler_task_registry_loads_total", "任务缓存整体加载次数");
+            m.size = registry.gauge("crawler_task_registry_tasks", "任务缓存中的任务数");
+            return m;
+        }();
+        return metrics;
+    }
+};
+
+TaskRegistry& TaskRegistry::instance()
+{
+    static TaskRegistry registry;
+    return registry;
+}
+
+void TaskRegistry::ensureLoaded()
+{
+    {
+        QReadLocker locker(&m_lock);
+        if (m_loaded) {
+            return;
+        }
+    }
+
+    QWriteLocker locker(&m_lock);
+    if (m_loaded) {
+        return;
+    }
+    const QList<CrawlerTask> tasks = DatabaseManager::getAllTasks();
+    m_tasks.clear();
+    m_tasks.reserve(tasks.size());
+    for (const auto& task : tasks) {
+        m_tasks.insert(task.id, task);
+    }
+    m_loaded = true;
+    TaskRegistryMetrics::get().loads->inc();
+    TaskRegistryMetrics::get().size->set(m_tasks.size());
+}
+
+CrawlerTask TaskRegistry::task(int taskId)
+{
+    ensureLoaded();
+    {
+        QReadLocker locker(&m_lock);
+        auto it = m_tasks.constFind(taskId);
+        if (it != m_tasks.constEnd()) {
+            TaskRegistryMetrics::get().hits->inc();
+            return it.value();
+        }
+    }
+
+    TaskRegistryMetrics::get().misses->inc();
+    const CrawlerTask task = DatabaseManager::getTaskById(taskId);
+    if (task.id != 0) {
+        QWriteLocker locker(&m_lock);
+        m_tasks.insert(task.id, task);
+        TaskRegistryMetrics::get().size->set(m_tasks.size());
+    }
+    return task;
+}
+
+QString TaskRegistry::taskName(int taskId)
+{
+    return task(taskId).name;
+}
+
+QList<CrawlerTask> TaskRegistry::tasks()
+{
+    ensureLoaded();
+    QList<CrawlerTask> tasks;
+    {
+        QReadLocker locker(&m_lock);
+        tasks = m_tasks.values();
+    }
+    std::sort(tasks.begin(), tasks.end(),
+              [](const CrawlerTask& a, const CrawlerTask& b) { return a.id < b.id; });
+    return tasks;
+}
+
+void TaskRegistry::update(const CrawlerTask& task)
+{
+    update(QList<CrawlerTask>{task});
+}
+
+void TaskRegistry::update(const QList<CrawlerTask>& tasks)
+{
+    if (tasks.isEmpty()) {
+        return;
+    }
+    QList<int> ids;
+    ids.reserve(tasks.size());
+    {
+        QWriteLocker locker(&m_lock);
+        // 尚未加载时不必写入，首次查询会整体加载
+        if (m_loaded) {
+            for (const auto& task : tasks) {
+                m_tasks.insert(task.id, task);
+            }
+            TaskRegistryMetrics::get().size->set(m_tasks.size());
+        }
+    }
+    for (const auto& task : tasks) {
+        ids.append(task.id);
+    }
+    emit tasksChanged(ids);
+}
+
+static bool sameTask(const CrawlerTask& a, const CrawlerTask& b)
+{
+    return a.name == b.name && a.url == b.url && a.interval == b.interval && a.rule == b.rule
+        && a.changeTolerance == b.changeTolerance && a.keepRawText == b.keepRawText;
+}
+
+void TaskRegistry::sync(const QList<CrawlerTask>& tasks)
+{
+    QList<int> ids;
+    {
+        QWriteLocker locker(&m_lock);
+        QHash<int, CrawlerTask> latest;
+        latest.reserve(tasks.size());
+        for (const auto& task : tasks) {
+            latest.insert(task.id, task);
+        }
+        // 尚未加载时直接作为首次加载，此前没有订阅者见过缓存内容
+        if (m_loaded) {
+            for (auto it = latest.constBegin(); it != latest.constEnd(); ++it) {
+                auto old = m_tasks.constFind(it.key());
+                if (old == m_tasks.constEnd() || !sameTask(old.value(), it.value())) {
+                    ids.append(it.key());
+                }
+            }
+            for (auto it = m_tasks.constBegin(); it != m_tasks.constEnd(); ++it) {
+                if (!latest.contains(it.key())) {
+                    ids.append(it.key());
+                }
+            }
+        }
+        m_tasks = std::move(latest);
+        m_loaded = true;
+        TaskRegistryMetrics::get().size->set(m_tasks.size());
+    }
+    if (!ids.isEmpty()) {
+        std::sort(ids.begin(), ids.end());
+        emit tasksChanged(ids);
+    }
+}
+
+void TaskRegistry::invalidate()
+{
+    {
+        QWriteLocker locker(&m_lock);
+        m_loaded = false;
+        m_tasks.clear();
+    }
+    emit tasksChanged(QList<int>());
+}
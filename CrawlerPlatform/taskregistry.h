@@ -0,0 +1,48 @@
+#ifndef TASKREGISTRY_H
+#define TASKREGISTRY_H
+
+#include <QObject>
+#include <QHash>
+#include <QList>
+#include <QReadWriteLock>
+#include "databasemanager.h"
+
+// 任务元数据缓存（进程内）
+// 首次使用时一次性加载全部任务，之后的查询直接读内存；读多写少，用读写锁保护
+// DatabaseManager 保存任务成功后更新缓存并发出 tasksChanged，界面与爬虫线程订阅该信号
+class TaskRegistry : public QObject
+{
+    Q_OBJECT
+
+public:
+    static TaskRegistry& instance();
+
+    // 查询任务，未找到返回 id=0 的空任务
+    // 缓存未命中时回查一次数据库（其他进程新增的任务），找到后加入缓存
+    CrawlerTask task(int taskId);
+    QString taskName(int taskId);
+    // 全部任务（按ID升序）
+    QList<CrawlerTask> tasks();
+
+    // 任务保存成功后由 DatabaseManager 调用
+    void update(const CrawlerTask& task);
+    void update(const QList<CrawlerTask>& tasks);
+    // 用数据库中的完整任务列表同步缓存：只对新增、修改或已删除的任务发出 tasksChanged
+    void sync(const QList<CrawlerTask>& tasks);
+    // 丢弃缓存，下次查询时重新加载（外部直接改库后使用）
+    void invalidate();
+
+signals:
+    // 任务新增、修改或删除（跨线程订阅时以队列方式送达），taskIds 为空表示缓存整体失效
+    void tasksChanged(const QList<int>& taskIds);
+
+private:
+    TaskRegistry() = default;
+    void ensureLoaded();
+
+    QReadWriteLock m_lock;
+    QHash<int, CrawlerTask> m_tasks;
+    bool m_loaded = false;
+};
+
+#endif // TASKREGISTRY_H
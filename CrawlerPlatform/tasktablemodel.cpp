@@ -0,0 +1,174 @@
+#include "tasktablemodel.h"
+#include <QDateTime>
+
+// "更新于"列的刷新周期（毫秒）
+static const int kAgeTickMs = 1000;
+
+TaskTableModel::TaskTableModel(QObject *parent)
+    : QAbstractTableModel(parent)
+{
+    connect(&m_ageTimer, &QTimer::timeout, this, &TaskTableModel::onAgeTick);
+    m_ageTimer.start(kAgeTickMs);
+}
+
+int TaskTableModel::rowCount(const QModelIndex& parent) const
+{
+    return parent.isValid() ? 0 : int(m_tasks.size());
+}
+
+int TaskTableModel::columnCount(const QModelIndex& parent) const
+{
+    return parent.isValid() ? 0 : ColumnCount;
+}
+
+static QString formatAge(qint64 ageMs)
+{
+    const qint64 secs = qMax<qint64>(0, ageMs / 1000);
+    if (secs < 60) return QString("%1秒前").arg(secs);
+    if (secs < 3600) return QString("%1分钟前").arg(secs / 60);
+    if (secs < 86400) return QString("%1小时前").arg(secs / 3600);
+    return QString("%1天前").arg(secs / 86400);
+}
+
+QVariant TaskTableModel::data(const QModelIndex& index, int role) const
+{
+    if (!index.isValid() || index.row() >= m_tasks.size()) {
+        return QVariant();
+    }
+    const CrawlerTask& task = m_tasks.at(index.row());
+
+    if (role == Qt::TextAlignmentRole && index.column() >= LatestColumn) {
+        return QVariant(Qt::AlignRight | Qt::AlignVCenter);
+    }
+    if (role != Qt::DisplayRole) {
+        return QVariant();
+    }
+
+    switch (index.column()) {
+    case IdColumn:
+        return task.id;
+    case NameColumn:
+        return task.name;
+    case UrlColumn:
+        return task.url;
+    case IntervalColumn:
+        return task.interval;
+    case StatusColumn:
+        return m_running.contains(task.id) ? QString("运行中") : QString("已停止");
+    case LatestColumn:
+    case AgeColumn: {
+        const auto it = m_latest.constFind(task.id);
+        if (it == m_latest.constEnd()) return QString("-");
+        if (index.column() == AgeColumn) {
+            return formatAge(QDateTime::currentMSecsSinceEpoch() - it->timestampMs);
+        }
+        static const char* const arrows[] = {"↓", "→", "↑"};
+        return QString("%1 %2").arg(it->value, 0, 'f', 2).arg(arrows[it->trend() + 1]);
+    }
+    case CountColumn:
+    case MeanColumn:
+    case QuantileColumn: {
+        const auto it = m_statistics.constFind(task.id);
+        if (it == m_statistics.constEnd()) return QString("-");
+        if (index.column() == CountColumn) return it->count;
+        if (index.column() == MeanColumn) {
+            return QString("%1 ± %2").arg(it->mean, 0, 'f', 2).arg(it->stddev, 0, 'f', 2);
+        }
+        return QString("%1 / %2").arg(it->p50, 0, 'f', 2).arg(it->p95, 0, 'f', 2);
+    }
+    default:
+        return QVariant();
+    }
+}
+
+QVariant TaskTableModel::headerData(int section, Qt::Orientation orientation, int role) const
+{
+    if (orientation != Qt::Horizontal || role != Qt::DisplayRole) {
+        return QAbstractTableModel::headerData(section, orientation, role);
+    }
+    static const char* const headers[ColumnCount] = {
+        "任务ID", "任务名称", "目标URL", "爬取间隔(秒)", "运行状态",
+        "最新值", "更新于", "24h 点数", "24h 均值±标准差", "24h P50/P95"
+    };
+    return section >= 0 && section < ColumnCount ? QString(headers[section]) : QVariant();
+}
+
+void TaskTableModel::setTasks(const QList<CrawlerTask>& tasks, const QSet<int>& runningTaskIds)
+{
+    beginResetModel();
+    m_tasks = tasks;
+    m_running = runningTaskIds;
+    m_rows.clear();
+    m_rows.reserve(m_tasks.size());
+    for (int row = 0; row < m_tasks.size(); row++) {
+        m_rows.insert(m_tasks.at(row).id, row);
+    }
+    endResetModel();
+}
+
+int TaskTableModel::taskId(int row) const
+{
+    return row >= 0 && row < m_tasks.size() ? m_tasks.at(row).id : -1;
+}
+
+int TaskTableModel::rowOf(int taskId) const
+{
+    return m_rows.value(taskId, -1);
+}
+
+void TaskTableModel::emitRowChanged(int row, int firstColumn, int lastColumn)
+{
+    if (row >= 0) {
+        emit dataChanged(index(row, firstColumn), index(row, lastColumn), {Qt::DisplayRole});
+    }
+}
+
+void TaskTableModel::setRunning(int taskId, bool running)
+{
+    if (m_running.contains(taskId) == running) return;
+    if (running) {
+        m_running.insert(taskId);
+    } else {
+        m_running.remove(taskId);
+    }
+    emitRowChanged(rowOf(taskId), StatusColumn, StatusColumn);
+}
+
+void TaskTableModel::updateLatest(int taskId, double value, qint64 timestampMs)
+{
+    TaskLatest& latest = m_latest[taskId];
+    if (latest.isValid()) {
+        if (timestampMs < latest.timestampMs) return;
+        latest.previousValue = latest.value;
+        latest.hasPrevious = true;
+    }
+    latest.taskId = taskId;
+    latest.value = value;
+    latest.timestampMs = timestampMs;
+    emitRowChanged(rowOf(taskId), LatestColumn, AgeColumn);
+}
+
+void TaskTableModel::setLatestValues(const QHash<int, TaskLatest>& latest)
+{
+    for (auto it = latest.cbegin(); it != latest.cend(); ++it) {
+        const auto current = m_latest.constFind(it.key());
+        if (current != m_latest.constEnd() && current->timestampMs >= it->timestampMs) continue;
+        m_latest.insert(it.key(), it.value());
+        emitRowChanged(rowOf(it.key()), LatestColumn, AgeColumn);
+    }
+}
+
+void TaskTableModel::setStatistics(const QHash<int, TaskStatistics>& statistics)
+{
+    m_statistics = statistics;
+    if (!m_tasks.isEmpty()) {
+        emit dataChanged(index(0, CountColumn), index(int(m_tasks.size()) - 1, QuantileColumn), {Qt::DisplayRole});
+    }
+}
+
+void TaskTableModel::onAgeTick()
+{
+    if (!m_tasks.isEmpty() && !m_latest.isEmpty()) {
+        emit dataChanged(index(0, AgeColumn), index(int(m_tasks.size()) - 1, AgeColumn), {Qt::DisplayRole});
+    }
+}
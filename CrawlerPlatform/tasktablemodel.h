@@ -0,0 +1,65 @@
+#ifndef TASKTABLEMODEL_H
+#define TASKTABLEMODEL_H
+
+#include <QAbstractTableModel>
+#include <QHash>
+#include <QSet>
+#include <QTimer>
+#include "databasemanager.h"
+
+// 任务表的数据模型
+// 视图只对可见行调用 data()，任务数上千时刷新开销只与可见行数有关：
+// 运行状态、最新值、统计量变化时只发出对应单元格的 dataChanged，不重建整张表；
+// "更新于"列按秒刷新，只通知该列
+class TaskTableModel : public QAbstractTableModel
+{
+    Q_OBJECT
+
+public:
+    enum Column {
+        IdColumn,
+        NameColumn,
+        UrlColumn,
+        IntervalColumn,
+        StatusColumn,
+        LatestColumn,     // 最新值 + 趋势箭头
+        AgeColumn,        // 最新值距今
+        CountColumn,      // 以下三列为 24 小时统计
+        MeanColumn,
+        QuantileColumn,
+        ColumnCount
+    };
+
+    explicit TaskTableModel(QObject *parent = nullptr);
+
+    int rowCount(const QModelIndex& parent = QModelIndex()) const override;
+    int columnCount(const QModelIndex& parent = QModelIndex()) const override;
+    QVariant data(const QModelIndex& index, int role = Qt::DisplayRole) const override;
+    QVariant headerData(int section, Qt::Orientation orientation, int role = Qt::DisplayRole) const override;
+
+    // 整体替换任务列表（保留已知的最新值与统计量）
+    void setTasks(const QList<CrawlerTask>& tasks, const QSet<int>& runningTaskIds);
+    int taskId(int row) const;
+    // 任务所在行，不在表中返回 -1
+    int rowOf(int taskId) const;
+
+    void setRunning(int taskId, bool running);
+    // 本进程采集到的新数据点
+    void updateLatest(int taskId, double value, qint64 timestampMs);
+    // 数据库中的最新值（含其他进程写入的任务），与本进程已收到的按时间取新
+    void setLatestValues(const QHash<int, TaskLatest>& latest);
+    void setStatistics(const QHash<int, TaskStatistics>& statistics);
+
+private:
+    void onAgeTick();
+    void emitRowChanged(int row, int firstColumn, int lastColumn);
+
+    QList<CrawlerTask> m_tasks;
+    QHash<int, int> m_rows;              // 任务ID -> 行
+    QSet<int> m_running;
+    QHash<int, TaskLatest> m_latest;
+    QHash<int, TaskStatistics> m_statistics;
+    QTimer m_ageTimer;
+};
+
+#endif // TASKTABLEMODEL_H
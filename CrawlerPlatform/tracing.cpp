@@ -0,0 +1,260 @@
+#include "tracing.h"
+#include <QThread>
+#include <QElapsedTimer>
+#include <QFile>
+#include <QJsonArray>
+#include <QJsonObject>
+#include <QJsonDocument>
+#include <QRandomGenerator>
+#include <QCoreApplication>
+#include <QDebug>
+#include <cmath>
+
+// 追踪内存的总上限：全部线程共享的事件预算（每个事件 40 字节，约 2.5MB），与线程数无关
+static const int kMaxTotalEvents = 64 * 1024;
+// 单线程缓冲区的容量上限与每次增长的段大小
+static const int kBufferCapacity = 1024;
+static const int kGrowEvents = 64;
+// 保留的缓冲区上限（已退出线程的缓冲区超限时淘汰）
+static const int kMaxBuffers = 256;
+
+namespace {
+
+struct ThreadTraceState {
+    std::shared_ptr<TraceBuffer> buffer;
+    quint32 roundCounter = QRandomGenerator::global()->generate(); // 错开各线程的采样相位
+    int taskId = 0;
+    bool active = false;
+
+    ~ThreadTraceState()
+    {
+        if (buffer) buffer->setOrphaned();
+    }
+};
+
+thread_local ThreadTraceState t_state;
+
+// 尚未分配给任何缓冲区的事件数
+std::atomic<int> g_freeEvents{kMaxTotalEvents};
+
+bool acquireEvents(int count)
+{
+    int free = g_freeEvents.load(std::memory_order_relaxed);
+    while (free >= count) {
+        if (g_freeEvents.compare_exchange_weak(free, free - count, std::memory_order_relaxed)) {
+            return true;
+        }
+    }
+    return false;
+}
+
+} // namespace
+
+TraceBuffer::TraceBuffer(int tid, const QString& threadName)
+    : m_tid(tid)
+    , m_threadName(threadName)
+{
+}
+
+TraceBuffer::~TraceBuffer()
+{
+    g_freeEvents.fetch_add(static_cast<int>(m_events.size()), std::memory_order_relaxed);
+}
+
+void TraceBuffer::append(const TraceEvent& event)
+{
+    QMutexLocker locker(&m_mutex);
+    if (m_next == m_events.size()) {
+        // 用满：未到单线程上限时申请下一段，申请不到就从头覆盖
+        if (!m_wrapped && m_events.size() < kBufferCapacity && acquireEvents(kGrowEvents)) {
+            m_events.resize(m_events.size() + kGrowEvents);
+        } else if (m_events.isEmpty()) {
+            return;
+        } else {
+            m_next = 0;
+            m_wrapped = true;
+        }
+    }
+    m_events[m_next] = event;
+    m_next++;
+}
+
+QList<TraceEvent> TraceBuffer::snapshot() const
+{
+    QMutexLocker locker(&m_mutex);
+    if (!m_wrapped) {
+        return m_events.mid(0, m_next);
+    }
+    // 按时间顺序：先旧后新
+    return m_events.mid(m_next) + m_events.mid(0, m_next);
+}
+
+Tracer& Tracer::instance()
+{
+    static Tracer tracer;
+    return tracer;
+}
+
+Tracer::Tracer()
+    : m_samplePeriod(0)
+{
+    bool ok = false;
+    double rate = qEnvironmentVariable("CRAWLER_TRACE_SAMPLE").toDouble(&ok);
+    setSampleRate(ok ? rate : 0.01);
+}
+
+void Tracer::setSampleRate(double rate)
+{
+    quint32 period = 0;
+    if (rate > 0) {
+        period = static_cast<quint32>(qMax(1.0, std::round(1.0 / qMin(rate, 1.0))));
+    }
+    m_samplePeriod.store(period, std::memory_order_relaxed);
+}
+
+double Tracer::sampleRate() const
+{
+    quint32 period = m_samplePeriod.load(std::memory_order_relaxed);
+    return period == 0 ? 0.0 : 1.0 / period;
+}
+
+qint64 Tracer::nowUs()
+{
+    static const QElapsedTimer clock = []() {
+        QElapsedTimer timer;
+        timer.start();
+        return timer;
+    }();
+    return clock.nsecsElapsed() / 1000;
+}
+
+bool Tracer::beginRound(int taskId)
+{
+    quint32 period = m_samplePeriod.load(std::memory_order_relaxed);
+    t_state.taskId = taskId;
+    t_state.active = period > 0 && (++t_state.roundCounter % period) == 0;
+    return t_state.active;
+}
+
+void Tracer::endRound()
+{
+    t_state.active = false;
+}
+
+bool Tracer::active() const
+{
+    return t_state.active;
+}
+
+TraceBuffer* Tracer::threadBuffer()
+{
+    if (t_state.buffer) {
+        return t_state.buffer.get();
+    }
+
+    QMutexLocker locker(&m_mutex);
+    // 预算不足一段时释放全部已退出线程的缓冲区；缓冲区数超限时淘汰最早的一个，没有可淘汰的就不再分配
+    if (g_freeEvents.load(std::memory_order_relaxed) < kGrowEvents) {
+        evictOrphans(true);
+    }
+    if (m_buffers.size() >= kMaxBuffers) {
+        evictOrphans(false);
+        if (m_buffers.size() >= kMaxBuffers) {
+            return nullptr;
+        }
+    }
+
+    int tid = m_nextTid++;
+    QString name = QThread::currentThread()->objectName();
+    if (QCoreApplication::instance() && QThread::currentThread() == QCoreApplication::instance()->thread()) {
+        name = "GUI";
+    } else if (name.isEmpty()) {
+        name = QString("thread-%1").arg(tid);
+    }
+
+    t_state.buffer = std::make_shared<TraceBuffer>(tid, name);
+    m_buffers.append(t_state.buffer);
+    return t_state.buffer.get();
+}
+
+void Tracer::evictOrphans(bool all)
+{
+    for (qsizetype i = 0; i < m_buffers.size();) {
+        if (m_buffers[i]->orphaned()) {
+            m_buffers.removeAt(i);
+            if (!all) return;
+        } else {
+            i++;
+        }
+    }
+}
+
+void Tracer::record(const char* name, const char* category, qint64 startUs, qint64 endUs)
+{
+    if (!t_state.active) return;
+    recordFor(t_state.taskId, name, category, startUs, endUs);
+}
+
+void Tracer::recordFor(int taskId, const char* name, const char* category, qint64 startUs, qint64 endUs)
+{
+    TraceEvent event;
+    event.name = name;
+    event.category = category;
+    event.startUs = startUs;
+    event.durationUs = qMax<qint64>(0, endUs - startUs);
+    event.taskId = taskId;
+    if (TraceBuffer* buffer = threadBuffer()) {
+        buffer->append(event);
+    }
+}
+
+QByteArray Tracer::exportChromeTrace() const
+{
+    QList<std::shared_ptr<TraceBuffer>> buffers;
+    {
+        QMutexLocker locker(&m_mutex);
+        buffers = m_buffers;
+    }
+
+    const qint64 pid = QCoreApplication::applicationPid();
+    QJsonArray events;
+    for (const auto& buffer : buffers) {
+        // 线程名元数据，Perfetto 中按线程分轨显示
+        QJsonObject meta;
+        meta["name"] = "thread_name";
+        meta["ph"] = "M";
+        meta["pid"] = pid;
+        meta["tid"] = buffer->tid();
+        meta["args"] = QJsonObject{{"name", buffer->threadName()}};
+        events.append(meta);
+
+        for (const TraceEvent& event : buffer->snapshot()) {
+            QJsonObject obj;
+            obj["name"] = QString::fromLatin1(event.name);
+            obj["cat"] = QString::fromLatin1(event.category);
+            obj["ph"] = "X";
+            obj["ts"] = event.startUs;
+            obj["dur"] = event.durationUs;
+            obj["pid"] = pid;
+            obj["tid"] = buffer->tid();
+            obj["args"] = QJsonObject{{"taskId", event.taskId}};
+            events.append(obj);
+        }
+    }
+
+    QJsonObject root;
+    root["traceEvents"] = events;
+    root["displayTimeUnit"] = "ms";
+    return QJsonDocument(root).toJson(QJsonDocument::Compact);
+}
+
+bool Tracer::exportToFile(const QString& path) const
+{
+    QFile file(path);
+    if (!file.open(QIODevice::WriteOnly | QIODevice::Truncate)) {
+        qWarning() << "导出追踪文件失败：" << path << file.errorString();
+        return false;
+    }
+    file.write(exportChromeTrace());
+    return true;
+}
@@ -0,0 +1,103 @@
+#ifndef TRACING_H
+#define TRACING_H
+
+#include <QString>
+#include <QByteArray>
+#include <QList>
+#include <QMutex>
+#include <memory>
+#include <atomic>
+
+// 单个追踪片段（Chrome Trace Event 的 "X" 完整事件）
+struct TraceEvent {
+    const char* name = nullptr;     // 静态字符串，避免热路径分配
+    const char* category = nullptr;
+    qint64 startUs = 0;
+    qint64 durationUs = 0;
+    int taskId = 0;
+};
+
+// 每线程环形缓冲区：按需分段增长，每段从全进程共享的事件预算中申请；
+// 增长到单线程上限或预算用尽后覆盖最旧事件，析构时把占用的预算归还
+class TraceBuffer {
+public:
+    TraceBuffer(int tid, const QString& threadName);
+    ~TraceBuffer();
+
+    void append(const TraceEvent& event);
+    QList<TraceEvent> snapshot() const;
+
+    int tid() const { return m_tid; }
+    QString threadName() const { return m_threadName; }
+
+    // 所属线程已退出
+    void setOrphaned() { m_orphaned.store(true, std::memory_order_relaxed); }
+    bool orphaned() const { return m_orphaned.load(std::memory_order_relaxed); }
+
+private:
+    const int m_tid;
+    const QString m_threadName;
+    mutable QMutex m_mutex;     // 仅与导出竞争，写入线程之间互不争用
+    QList<TraceEvent> m_events;   // 已申请到的容量，size() 即占用的预算
+    qsizetype m_next = 0;
+    bool m_wrapped = false;
+    std::atomic<bool> m_orphaned{false};
+};
+
+// 爬取阶段追踪器（单例）
+// 按轮次采样：被采中的轮次在所属线程上记录各阶段片段，按需导出为 Perfetto 可加载的 JSON
+class Tracer {
+public:
+    static Tracer& instance();
+
+    // 采样率（0 关闭，1 全量），默认取环境变量 CRAWLER_TRACE_SAMPLE
+    void setSampleRate(double rate);
+    double sampleRate() const;
+
+    // 单调时钟（微秒，进程内起点）
+    static qint64 nowUs();
+
+    // 开始/结束当前线程上的一轮爬取，返回本轮是否被采样
+    bool beginRound(int taskId);
+    void endRound();
+    // 当前线程本轮是否处于采样中
+    bool active() const;
+
+    // 记录片段：仅在当前线程本轮被采样时写入
+    void record(const char* name, const char* category, qint64 startUs, qint64 endUs);
+    // 记录片段：不依赖当前轮次（跨线程片段，如界面投递延迟）
+    // 线程数超出缓冲区上限、且没有可淘汰的已退出线程时丢弃
+    void recordFor(int taskId, const char* name, const char* category, qint64 startUs, qint64 endUs);
+
+    // 导出 Chrome Trace Event JSON
+    QByteArray exportChromeTrace() const;
+    bool exportToFile(const QString& path) const;
+
+private:
+    Tracer();
+    TraceBuffer* threadBuffer();
+    void evictOrphans(bool all); // 调用方已持有 m_mutex
+
+    std::atomic<quint32> m_samplePeriod; // 每 N 轮采样一次（0 表示关闭）
+    mutable QMutex m_mutex;
+    QList<std::shared_ptr<TraceBuffer>> m_buffers;
+    int m_nextTid = 1;
+};
+
+// 作用域片段：析构时记录
+class TraceSpan {
+public:
+    TraceSpan(const char* name, const char* category)
+        : m_name(name), m_category(category), m_startUs(Tracer::instance().active() ? Tracer::nowUs() : -1) {}
+    ~TraceSpan()
+    {
+        if (m_startUs >= 0) Tracer::instance().record(m_name, m_category, m_startUs, Tracer::nowUs());
+    }
+
+private:
+    const char* m_name;
+    const char* m_category;
+    qint64 m_startUs;
+};
+
+#endif // TRACING_H
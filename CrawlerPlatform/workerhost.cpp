@@ -0,0 +1,417 @@
+#include "workerhost.h"
+#include "crawlerthread.h"
+#include "databasemanager.h"
+#include "taskregistry.h"
+#include "schedulestore.h"
+#include "metrics.h"
+#include <QSqlQuery>
+#include <QSqlError>
+#include <QDateTime>
+#include <QHostInfo>
+#include <QCoreApplication>
+#include <QUuid>
+#include <QDebug>
+
+// 分片租约指标（首次使用时注册）
+struct LeaseMetrics {
+    MetricCounter* claimed;
+    MetricCounter* released;
+    MetricCounter* heartbeatFailures;
+    MetricHistogram* heartbeatDuration;
+    MetricGauge* shardsOwned;
+    MetricGauge* liveWorkers;
+    MetricGauge* tasksRunning;
+
+    static const LeaseMetrics& get()
+    {
+        static const LeaseMetrics metrics = []() {
+            MetricsRegistry& registry = MetricsRegistry::instance();
+            const QString changes = "crawler_worker_lease_changes_total";
+            const QString changesHelp = "本进程认领/释放的分片租约数";
+            LeaseMetrics m;
+            m.claimed = registry.counter(changes, changesHelp, {{"change", "claimed"}});
+            m.released = registry.counter(changes, changesHelp, {{"change", "released"}});
+            m.heartbeatFailures = registry.counter("crawler_worker_heartbeat_failures_total", "心跳事务失败次数");
+            m.heartbeatDuration = registry.histogram("crawler_worker_heartbeat_duration_seconds", "心跳事务耗时");
+            m.shardsOwned = registry.gauge("crawler_worker_shards_owned", "本进程持有的分片数");
+            m.liveWorkers = registry.gauge("crawler_worker_live_workers", "最近一次心跳时存活的工作进程数");
+            m.tasksRunning = registry.gauge("crawler_worker_tasks_running", "本进程运行中的爬虫线程数");
+            return m;
+        }();
+        return metrics;
+    }
+};
+
+LeaseManager::LeaseManager(const LeaseConfig& config)
+    : m_config(config)
+{
+    m_config.shardCount = qMax(1, m_config.shardCount);
+    m_config.heartbeatMs = qMax(100, m_config.heartbeatMs);
+    m_config.leaseTtlMs = qMax(m_config.heartbeatMs * 2, m_config.leaseTtlMs);
+    if (m_config.workerId.isEmpty()) {
+        m_config.workerId = QString("%1-%2-%3")
+                                .arg(QHostInfo::localHostName())
+                                .arg(QCoreApplication::applicationPid())
+                                .arg(QUuid::createUuid().toString(QUuid::Id128).left(8));
+    }
+}
+
+bool LeaseManager::createSchema(QSqlDatabase& db)
+{
+    QSqlQuery query(db);
+    const QString workerSql = R"(
+        CREATE TABLE IF NOT EXISTS crawler_workers (
+            id TEXT PRIMARY KEY,
+            pid INTEGER NOT NULL DEFAULT 0,
+            startedAt INTEGER NOT NULL DEFAULT 0,
+            heartbeatAt INTEGER NOT NULL DEFAULT 0
+        )
+    )";
+    if (!query.exec(workerSql)) {
+        qCritical() << "创建工作进程表失败：" << query.lastError().text();
+        return false;
+    }
+
+    const QString leaseSql = R"(
+        CREATE TABLE IF NOT EXISTS crawler_leases (
+            shard INTEGER PRIMARY KEY,
+            owner TEXT NOT NULL DEFAULT '',
+            expiresAt INTEGER NOT NULL DEFAULT 0
+        )
+    )";
+    if (!query.exec(leaseSql)) {
+        qCritical() << "创建分片租约表失败：" << query.lastError().text();
+        return false;
+    }
+    return true;
+}
+
+int LeaseManager::shardOf(int taskId) const
+{
+    return static_cast<int>(static_cast<uint>(taskId) % static_cast<uint>(m_config.shardCount));
+}
+
+bool LeaseManager::checkShardCount()
+{
+    QSqlDatabase db = DatabaseManager::getThreadDatabase();
+    if (!db.isOpen()) {
+        return false;
+    }
+
+    // 分片数不同的进程对同一任务算出不同的分片，会各自认领并重复爬取
+    QSqlQuery query(db);
+    if (!query.exec("BEGIN IMMEDIATE")) {
+        qCritical() << "核对分片数失败：" << query.lastError().text();
+        return false;
+    }
+    int recorded = 0;
+    bool ok = query.exec("SELECT value FROM crawler_meta WHERE key = 'lease_shards'");
+    if (ok && query.next()) {
+        recorded = query.value(0).toInt();
+    }
+    query.finish();
+    if (ok && recorded == 0) {
+        query.prepare("INSERT OR REPLACE INTO crawler_meta (key, value) VALUES ('lease_shards', ?)");
+        query.addBindValue(QString::number(m_config.shardCount));
+        ok = query.exec();
+    }
+    if (!ok) {
+        qCritical() << "核对分片数失败：" << query.lastError().text();
+    } else if (recorded > 0 && recorded != m_config.shardCount) {
+        qCritical() << "数据库的工作进程按" << recorded << "个分片运行，本进程设置为" << m_config.shardCount
+                    << "，拒绝启动（更改分片数需先停止全部工作进程并清空 crawler_leases 与 crawler_meta 中的 lease_shards）";
+        ok = false;
+    }
+    if (ok && !query.exec("COMMIT")) {
+        qCritical() << "核对分片数失败：" << query.lastError().text();
+        ok = false;
+    }
+    if (!ok) {
+        query.exec("ROLLBACK");
+    }
+    return ok;
+}
+
+bool LeaseManager::heartbeat(QSet<int>* owned)
+{
+    MetricTimer heartbeatTimer(LeaseMetrics::get().heartbeatDuration);
+    QSqlDatabase db = DatabaseManager::getThreadDatabase();
+    if (!db.isOpen()) {
+        LeaseMetrics::get().heartbeatFailures->inc();
+        return false;
+    }
+
+    // IMMEDIATE：事务开始即取得写锁，避免多个进程同时由读锁升级而互相等待
+    QSqlQuery query(db);
+    if (!query.exec("BEGIN IMMEDIATE")) {
+        qWarning() << "心跳事务开始失败：" << query.lastError().text();
+        LeaseMetrics::get().heartbeatFailures->inc();
+        return false;
+    }
+
+    QSet<int> shards;
+    bool ok = heartbeatLocked(query, QDateTime::currentMSecsSinceEpoch(), &shards);
+    if (ok && !query.exec("COMMIT")) {
+        qWarning() << "心跳事务提交失败：" << query.lastError().text();
+        ok = false;
+    }
+    if (!ok) {
+        query.exec("ROLLBACK");
+        LeaseMetrics::get().heartbeatFailures->inc();
+        return false;
+    }
+
+    *owned = shards;
+    LeaseMetrics::get().shardsOwned->set(shards.size());
+    LeaseMetrics::get().liveWorkers->set(m_liveWorkers);
+    return true;
+}
+
+bool LeaseManager::heartbeatLocked(QSqlQuery& query, qint64 nowMs, QSet<int>* owned)
+{
+    const QString& me = m_config.workerId;
+    const int shardCount = m_config.shardCount;
+    const qint64 expiresAt = nowMs + m_config.leaseTtlMs;
+
+    auto run = [&query](const QString& sql, const QVariantList& values) {
+        query.prepare(sql);
+        for (const QVariant& value : values) {
+            query.addBindValue(value);
+        }
+        if (!query.exec()) {
+            qWarning() << "分片租约更新失败：" << sql << query.lastError().text();
+            return false;
+        }
+        return true;
+    };
+
+    // 首次心跳补齐分片行
+    if (!m_shardsSeeded) {
+        query.prepare("INSERT OR IGNORE INTO crawler_leases (shard) VALUES (?)");
+        for (int shard = 0; shard < shardCount; ++shard) {
+            query.addBindValue(shard);
+            if (!query.exec()) {
+                qWarning() << "初始化分片租约失败：" << query.lastError().text();
+                return false;
+            }
+        }
+    }
+
+    // 登记存活，清理超时的进程及其过期租约
+    if (!run("INSERT INTO crawler_workers (id, pid, startedAt, heartbeatAt) VALUES (?, ?, ?, ?) "
+             "ON CONFLICT(id) DO UPDATE SET heartbeatAt = excluded.heartbeatAt",
+             {me, QCoreApplication::applicationPid(), nowMs, nowMs})
+        || !run("DELETE FROM crawler_workers WHERE heartbeatAt < ?", {nowMs - m_config.leaseTtlMs})
+        || !run("UPDATE crawler_leases SET owner = '', expiresAt = 0 WHERE owner <> '' AND expiresAt < ?", {nowMs})
+        || !run("UPDATE crawler_leases SET expiresAt = ? WHERE owner = ?", {expiresAt, me})) {
+        return false;
+    }
+
+    // 存活进程按ID排序，余数分给排在前面的进程，各进程的目标之和恰好等于分片数
+    if (!run("SELECT id FROM crawler_workers ORDER BY id", {})) {
+        return false;
+    }
+    int live = 0;
+    int rank = 0;
+    while (query.next()) {
+        if (query.value(0).toString() == me) {
+            rank = live;
+        }
+        ++live;
+    }
+    live = qMax(1, live);
+    m_liveWorkers = live;
+    const int target = shardCount / live + (rank < shardCount % live ? 1 : 0);
+
+    if (!run("SELECT shard FROM crawler_leases WHERE owner = ? AND shard < ? ORDER BY shard", {me, shardCount})) {
+        return false;
+    }
+    QList<int> mine;
+    while (query.next()) {
+        mine.append(query.value(0).toInt());
+    }
+
+    if (mine.size() > target) {
+        // 新进程加入：释放多出的分片，由它在下一次心跳认领
+        while (mine.size() > target) {
+            const int shard = mine.takeLast();
+            if (!run("UPDATE crawler_leases SET owner = '', expiresAt = 0 WHERE shard = ? AND owner = ?", {shard, me})) {
+                return false;
+            }
+            LeaseMetrics::get().released->inc();
+        }
+    } else if (mine.size() < target) {
+        // 认领空闲分片（进程退出后释放或租约过期的）
+        if (!run("SELECT shard FROM crawler_leases WHERE owner = '' AND shard < ? ORDER BY shard LIMIT ?",
+                 {shardCount, target - static_cast<int>(mine.size())})) {
+            return false;
+        }
+        QList<int> free;
+        while (query.next()) {
+            free.append(query.value(0).toInt());
+        }
+        for (int shard : std::as_const(free)) {
+            if (!run("UPDATE crawler_leases SET owner = ?, expiresAt = ? WHERE shard = ? AND owner = ''",
+                     {me, expiresAt, shard})) {
+                return false;
+            }
+            if (query.numRowsAffected() > 0) {
+                mine.append(shard);
+                LeaseMetrics::get().claimed->inc();
+            }
+        }
+    }
+
+    m_shardsSeeded = true;
+    *owned = QSet<int>(mine.cbegin(), mine.cend());
+    return true;
+}
+
+bool LeaseManager::releaseAll()
+{
+    QSqlDatabase db = DatabaseManager::getThreadDatabase();
+    if (!db.isOpen() || !db.transaction()) {
+        return false;
+    }
+    QSqlQuery query(db);
+    query.prepare("UPDATE crawler_leases SET owner = '', expiresAt = 0 WHERE owner = ?");
+    query.addBindValue(m_config.workerId);
+    bool ok = query.exec();
+    if (ok) {
+        query.prepare("DELETE FROM crawler_workers WHERE id = ?");
+        query.addBindValue(m_config.workerId);
+        ok = query.exec();
+    }
+    if (ok && !db.commit()) {
+        ok = false;
+    }
+    if (!ok) {
+        qWarning() << "释放分片租约失败：" << query.lastError().text();
+        db.rollback();
+        return false;
+    }
+    LeaseMetrics::get().shardsOwned->set(0);
+    return true;
+}
+
+WorkerHost::WorkerHost(const LeaseConfig& config, QObject* parent)
+    : QObject(parent)
+    , m_leases(config)
+{
+    m_timer.setInterval(m_leases.config().heartbeatMs);
+    connect(&m_timer, &QTimer::timeout, this, &WorkerHost::onHeartbeat);
+}
+
+WorkerHost::~WorkerHost()
+{
+    stop();
+}
+
+bool WorkerHost::start()
+{
+    if (!m_leases.checkShardCount()) {
+        return false;
+    }
+    qInfo() << "工作进程" << m_leases.config().workerId << "启动，分片数" << m_leases.config().shardCount;
+    m_started = true;
+    onHeartbeat();
+    m_timer.start();
+    return true;
+}
+
+void WorkerHost::stop()
+{
+    if (!m_started) {
+        return;
+    }
+    m_started = false;
+    m_timer.stop();
+    if (!m_threads.isEmpty()) {
+        CrawlerThread::stopAll(m_threads.values());
+        qDeleteAll(m_threads);
+        m_threads.clear();
+        LeaseMetrics::get().tasksRunning->set(0);
+    }
+    // 先写回进度再释放租约，接管的进程才能按原相位继续
+    ScheduleStore::instance().flush();
+    m_leases.releaseAll();
+    if (!m_shards.isEmpty()) {
+        m_shards.clear();
+        emit shardsChanged(m_shards);
+    }
+}
+
+void WorkerHost::onHeartbeat()
+{
+    const qint64 nowMs = QDateTime::currentMSecsSinceEpoch();
+    QSet<int> shards;
+    if (m_leases.heartbeat(&shards)) {
+        m_leaseValidUntil = nowMs + m_leases.config().leaseTtlMs - m_leases.config().heartbeatMs;
+    } else if (nowMs < m_leaseValidUntil) {
+        // 本次续租失败（如数据库忙），租约仍在有效期内，继续运行
+        shards = m_shards;
+    } else if (!m_shards.isEmpty()) {
+        // 租约可能已被其他进程接管，停止本地线程，避免重复爬取
+        qWarning() << "工作进程" << m_leases.config().workerId << "续租失败且租约已过期，停止全部分片";
+    }
+
+    if (shards != m_shards) {
+        qInfo() << "工作进程" << m_leases.config().workerId << "持有分片" << shards.size() << "/"
+                << m_leases.config().shardCount << "，存活进程" << m_leases.liveWorkers();
+        m_shards = shards;
+        emit shardsChanged(m_shards);
+    }
+    reconcile();
+}
+
+void WorkerHost::reconcile()
+{
+    // 任务表可能被其他进程（界面或导入）修改：每次心跳重新读取并刷新本进程的任务缓存
+    const QList<CrawlerTask> tasks = m_shards.isEmpty() ? QList<CrawlerTask>() : DatabaseManager::getAllTasks();
+    QHash<int, CrawlerTask> wanted;
+    for (const auto& task : tasks) {
+        if (m_shards.contains(m_leases.shardOf(task.id))) {
+            wanted.insert(task.id, task);
+        }
+    }
+    // 空列表也可能是读库失败，此时保留原缓存
+    if (!tasks.isEmpty()) {
+        TaskRegistry::instance().sync(tasks);
+    }
+
+    // 停止失去分片或已删除的任务
+    QList<CrawlerThread*> stopping;
+    for (auto it = m_threads.begin(); it != m_threads.end();) {
+        if (!wanted.contains(it.key())) {
+            stopping.append(it.value());
+            it = m_threads.erase(it);
+        } else {
+            it.value()->reconfigure(wanted.value(it.key()));
+            ++it;
+        }
+    }
+    if (!stopping.isEmpty()) {
+        CrawlerThread::stopAll(stopping);
+        qDeleteAll(stopping);
+    }
+
+    // 新认领的任务按原相位接续：调度进度由上一个持有者写回，这里重新读取
+    QList<CrawlerTask> starting;
+    for (const auto& task : std::as_const(wanted)) {
+        if (!m_threads.contains(task.id)) {
+            starting.append(task);
+        }
+    }
+    if (!starting.isEmpty()) {
+        const QHash<int, TaskSchedule> schedules = ScheduleStore::instance().reload();
+        const qint64 nowMs = QDateTime::currentMSecsSinceEpoch();
+        for (const auto& task : std::as_const(starting)) {
+            TaskSchedule schedule = schedules.value(task.id);
+            schedule.taskId = task.id;
+            CrawlerThread* thread = new CrawlerThread(task.id);
+            m_threads.insert(task.id, thread);
+            thread->startCrawling(ScheduleStore::resumeDelayMs(schedule, task.interval, nowMs));
+        }
+    }
+    LeaseMetrics::get().tasksRunning->set(m_threads.size());
+}
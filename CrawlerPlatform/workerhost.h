@@ -0,0 +1,85 @@
+#ifndef WORKERHOST_H
+#define WORKERHOST_H
+
+#include <QObject>
+#include <QTimer>
+#include <QMap>
+#include <QSet>
+#include <QSqlDatabase>
+
+class CrawlerThread;
+class QSqlQuery;
+
+// 多进程分片配置（同一数据库上的所有工作进程必须使用相同的分片数，首个进程记入 crawler_meta）
+struct LeaseConfig {
+    QString workerId;          // 为空时按主机名与进程号生成
+    int shardCount = 64;       // 任务按 taskId % shardCount 分片
+    int heartbeatMs = 2000;    // 心跳（续租与再平衡）周期
+    int leaseTtlMs = 10000;    // 超过该时长未续租即视为进程已退出，分片可被接管
+};
+
+// 分片租约（crawler_workers / crawler_leases）
+// 每次心跳在一个 IMMEDIATE 事务中完成：登记存活、清理过期进程与租约、续租，
+// 再按存活进程数计算应持有的分片数，多了释放、少了认领空闲分片
+class LeaseManager
+{
+public:
+    explicit LeaseManager(const LeaseConfig& config);
+
+    static bool createSchema(QSqlDatabase& db);
+
+    const LeaseConfig& config() const { return m_config; }
+    int shardOf(int taskId) const;
+    // 核对 crawler_meta 中记录的分片数（新库时写入本进程的分片数），不一致时返回 false
+    bool checkShardCount();
+    int liveWorkers() const { return m_liveWorkers; }
+
+    // 一次心跳；成功时 owned 为本进程当前持有的分片，失败时保持不变
+    bool heartbeat(QSet<int>* owned);
+    // 释放全部分片并注销（正常退出时调用，其他进程下一次心跳即可接管）
+    bool releaseAll();
+
+private:
+    bool heartbeatLocked(QSqlQuery& query, qint64 nowMs, QSet<int>* owned);
+
+    LeaseConfig m_config;
+    bool m_shardsSeeded = false;
+    int m_liveWorkers = 0;
+};
+
+// 无界面工作进程：按持有的分片运行爬虫线程
+// 分片变化（进程加入/退出）或任务表被其他进程修改后，在下一次心跳时启停或热更新对应线程
+class WorkerHost : public QObject
+{
+    Q_OBJECT
+
+public:
+    explicit WorkerHost(const LeaseConfig& config, QObject* parent = nullptr);
+    ~WorkerHost() override;
+
+    // 分片数与库中记录不一致时不启动，返回 false
+    bool start();
+    // 停止全部爬虫线程、写回调度状态并释放租约
+    void stop();
+
+    QSet<int> ownedShards() const { return m_shards; }
+    int runningTasks() const { return m_threads.size(); }
+
+signals:
+    void shardsChanged(const QSet<int>& shards);
+
+private slots:
+    void onHeartbeat();
+
+private:
+    void reconcile();
+
+    LeaseManager m_leases;
+    QTimer m_timer;
+    QSet<int> m_shards;
+    QMap<int, CrawlerThread*> m_threads;
+    bool m_started = false;
+    qint64 m_leaseValidUntil = 0; // 最近一次成功续租后租约的有效期（留出一个心跳周期的余量）
+};
+
+#endif // WORKERHOST_H
@@ -0,0 +1,139 @@
+#include "xxhash64.h"
+#include <QtEndian>
+#include <cstring>
+
+static const quint64 kPrime1 = 11400714785074694791ULL;
+static const quint64 kPrime2 = 14029467366897019727ULL;
+static const quint64 kPrime3 = 1609587929392839161ULL;
+static const quint64 kPrime4 = 9650029242287828579ULL;
+static const quint64 kPrime5 = 2870177450012600261ULL;
+
+static inline quint64 rotl(quint64 x, int r)
+{
+    return (x << r) | (x >> (64 - r));
+}
+
+// 按小端读取，与参考实现在任意平台上结果一致
+static inline quint64 read64(const unsigned char* p)
+{
+    quint64 v;
+    memcpy(&v, p, sizeof(v));
+    return qFromLittleEndian(v);
+}
+
+static inline quint32 read32(const unsigned char* p)
+{
+    quint32 v;
+    memcpy(&v, p, sizeof(v));
+    return qFromLittleEndian(v);
+}
+
+static inline quint64 xxRound(quint64 acc, quint64 input)
+{
+    acc += input * kPrime2;
+    acc = rotl(acc, 31);
+    return acc * kPrime1;
+}
+
+static inline quint64 xxMergeRound(quint64 acc, quint64 value)
+{
+    acc ^= xxRound(0, value);
+    return acc * kPrime1 + kPrime4;
+}
+
+void XxHash64::reset(quint64 seed)
+{
+    m_seed = seed;
+    m_acc[0] = seed + kPrime1 + kPrime2;
+    m_acc[1] = seed + kPrime2;
+    m_acc[2] = seed;
+    m_acc[3] = seed - kPrime1;
+    m_totalLength = 0;
+    m_buffered = 0;
+}
+
+void XxHash64::update(const char* data, qsizetype size)
+{
+    if (size <= 0) return;
+    const unsigned char* p = reinterpret_cast<const unsigned char*>(data);
+    const unsigned char* end = p + size;
+    m_totalLength += static_cast<quint64>(size);
+
+    // 先补满上次剩下的不完整分组
+    if (m_buffered > 0) {
+        const int take = static_cast<int>(qMin<qsizetype>(32 - m_buffered, size));
+        memcpy(m_buffer + m_buffered, p, static_cast<size_t>(take));
+        m_buffered += take;
+        p += take;
+        if (m_buffered < 32) return;
+        for (int i = 0; i < 4; i++) {
+            m_acc[i] = xxRound(m_acc[i], read64(m_buffer + i * 8));
+        }
+        m_buffered = 0;
+    }
+
+    // 累加器放在局部变量中，便于编译器保持在寄存器里
+    quint64 v1 = m_acc[0], v2 = m_acc[1], v3 = m_acc[2], v4 = m_acc[3];
+    while (end - p >= 32) {
+        v1 = xxRound(v1, read64(p));
+        v2 = xxRound(v2, read64(p + 8));
+        v3 = xxRound(v3, read64(p + 16));
+        v4 = xxRound(v4, read64(p + 24));
+        p += 32;
+    }
+    m_acc[0] = v1;
+    m_acc[1] = v2;
+    m_acc[2] = v3;
+    m_acc[3] = v4;
+
+    if (p < end) {
+        m_buffered = static_cast<int>(end - p);
+        memcpy(m_buffer, p, static_cast<size_t>(m_buffered));
+    }
+}
+
+quint64 XxHash64::digest() const
+{
+    quint64 h;
+    if (m_totalLength >= 32) {
+        h = rotl(m_acc[0], 1) + rotl(m_acc[1], 7) + rotl(m_acc[2], 12) + rotl(m_acc[3], 18);
+        for (int i = 0; i < 4; i++) {
+            h = xxMergeRound(h, m_acc[i]);
+        }
+    } else {
+        h = m_seed + kPrime5;
+    }
+    h += m_totalLength;
+
+    const unsigned char* p = m_buffer;
+    const unsigned char* end = m_buffer + m_buffered;
+    while (end - p >= 8) {
+        h ^= xxRound(0, read64(p));
+        h = rotl(h, 27) * kPrime1 + kPrime4;
+        p += 8;
+    }
+    if (end - p >= 4) {
+        h ^= quint64(read32(p)) * kPrime1;
+        h = rotl(h, 23) * kPrime2 + kPrime3;
+        p += 4;
+    }
+    while (p < end) {
+        h ^= quint64(*p) * kPrime5;
+        h = rotl(h, 11) * kPrime1;
+        p++;
+    }
+
+    h ^= h >> 33;
+    h *= kPrime2;
+    h ^= h >> 29;
+    h *= kPrime3;
+    h ^= h >> 32;
+    return h;
+}
+
+quint64 XxHash64::hash(const QByteArray& data, quint64 seed)
+{
+    XxHash64 hasher(seed);
+    hasher.update(data);
+    return hasher.digest();
+}
@@ -0,0 +1,28 @@
+#ifndef XXHASH64_H
+#define XXHASH64_H
+
+#include <QByteArray>
+#include <QtGlobal>
+
+// 流式 XXH64（与 xxHash 参考实现输出一致），用于判断响应体是否与上次相同
+// 每 32 字节一轮、4 路并行累加，吞吐远高于加密哈希；不可用于防篡改
+class XxHash64 {
+public:
+    explicit XxHash64(quint64 seed = 0) { reset(seed); }
+
+    void reset(quint64 seed = 0);
+    void update(const char* data, qsizetype size);
+    void update(const QByteArray& data) { update(data.constData(), data.size()); }
+    quint64 digest() const;
+
+    static quint64 hash(const QByteArray& data, quint64 seed = 0);
+
+private:
+    quint64 m_acc[4];
+    quint64 m_seed = 0;
+    quint64 m_totalLength = 0;
+    unsigned char m_buffer[32];
+    int m_buffered = 0;
+};
+
+#endif // XXHASH64_H